@@ -134,12 +134,14 @@ static int error_cb(fdo_sdk_status type, fdo_sdk_error errorcode)
 	static unsigned int to1_err;
 	static unsigned int to2_err;
 
-	(void)type;
+	/* the SDK reports each failed DI/TO1/TO2 attempt as FDO_WARNING
+	 * before retrying it; keep retrying as before and only count them */
+	bool may_abort = (type != FDO_WARNING);
 
 	switch (errorcode) {
 	case FDO_RV_TIMEOUT:
 		rv_timeout++;
-		if (rv_timeout > ERROR_RETRY_COUNT) {
+		if (may_abort && rv_timeout > ERROR_RETRY_COUNT) {
 			LOG(LOG_INFO, "Sending ABORT RV connection from app\n");
 			return FDO_ABORT;
 		}
@@ -147,7 +149,7 @@ static int error_cb(fdo_sdk_status type, fdo_sdk_error errorcode)
 
 	case FDO_CONN_TIMEOUT:
 		conn_timeout++;
-		if (conn_timeout > ERROR_RETRY_COUNT) {
+		if (may_abort && conn_timeout > ERROR_RETRY_COUNT) {
 			LOG(LOG_INFO, "Sending ABORT connection from app\n");
 			return FDO_ABORT;
 		}
@@ -155,7 +157,7 @@ static int error_cb(fdo_sdk_status type, fdo_sdk_error errorcode)
 
 	case FDO_DI_ERROR:
 		di_err++;
-		if (di_err > ERROR_RETRY_COUNT) {
+		if (may_abort && di_err > ERROR_RETRY_COUNT) {
 			LOG(LOG_INFO, "Sending ABORT DI from app\n");
 			return FDO_ABORT;
 		}
@@ -163,7 +165,7 @@ static int error_cb(fdo_sdk_status type, fdo_sdk_error errorcode)
 
 	case FDO_TO1_ERROR:
 		to1_err++;
-		if (to1_err > ERROR_RETRY_COUNT) {
+		if (may_abort && to1_err > ERROR_RETRY_COUNT) {
 			LOG(LOG_INFO, "Sending ABORT T01 from app\n");
 			return FDO_ABORT;
 		}
@@ -171,7 +173,7 @@ static int error_cb(fdo_sdk_status type, fdo_sdk_error errorcode)
 
 	case FDO_TO2_ERROR:
 		to2_err++;
-		if (to2_err > ERROR_RETRY_COUNT) {
+		if (may_abort && to2_err > ERROR_RETRY_COUNT) {
 			LOG(LOG_INFO, "Sending ABORT T02 from app\n");
 			return FDO_ABORT;
 		}
@@ -304,6 +306,16 @@ int app_main(bool is_resale)
 
 	ret = 0;
 end:
+#ifdef FDO_ALLOC_STATS
+	{
+		uint64_t allocs = 0, bytes = 0;
+
+		fdo_alloc_stats(&allocs, &bytes);
+		/* totals of the run, fdo-bench splits them per protocol */
+		printf("fdo_alloc: %llu allocations, %llu bytes\n",
+		       (unsigned long long)allocs, (unsigned long long)bytes);
+	}
+#endif
 	/* free the module related info
 	 * FDO has created the required DB
 	 */
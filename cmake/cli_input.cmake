@@ -28,6 +28,10 @@ set (BLOB_PATH .)
 set (TPM2_TCTI_TYPE tabrmd)
 set (RESALE true)
 set (REUSE true)
+set (KEX_PRECOMPUTE false)
+set (TO1D_CACHE_SEC 600)
+set (BUFFER_POOL_SZ 0)
+set (BENCH false)
 
 #following are specific to only mbedos
 set (DATASTORE sd)
@@ -737,3 +741,121 @@ set(CACHED_REUSE ${REUSE} CACHE STRING "Selected REUSE")
 message("Selected REUSE ${REUSE}")
 
 ###########################################
+# FOR KEX_PRECOMPUTE
+get_property(cached_kex_precompute_value CACHE KEX_PRECOMPUTE PROPERTY VALUE)
+
+set(kex_precompute_cli_arg ${cached_kex_precompute_value})
+if(kex_precompute_cli_arg STREQUAL CACHED_KEX_PRECOMPUTE)
+  unset(kex_precompute_cli_arg)
+endif()
+
+set(kex_precompute_app_cmake_lists ${KEX_PRECOMPUTE})
+if(cached_kex_precompute_value STREQUAL KEX_PRECOMPUTE)
+  unset(kex_precompute_app_cmake_lists)
+endif()
+
+if(DEFINED CACHED_KEX_PRECOMPUTE)
+  if ((DEFINED kex_precompute_cli_arg) AND (NOT(CACHED_KEX_PRECOMPUTE STREQUAL kex_precompute_cli_arg)))
+    message(WARNING "Need to do make pristine before cmake args can change.")
+  endif()
+  set(KEX_PRECOMPUTE ${CACHED_KEX_PRECOMPUTE})
+elseif(DEFINED kex_precompute_cli_arg)
+  set(KEX_PRECOMPUTE ${kex_precompute_cli_arg})
+elseif(DEFINED kex_precompute_app_cmake_lists)
+  set(KEX_PRECOMPUTE ${kex_precompute_app_cmake_lists})
+endif()
+
+set(CACHED_KEX_PRECOMPUTE ${KEX_PRECOMPUTE} CACHE STRING "Selected KEX_PRECOMPUTE")
+message("Selected KEX_PRECOMPUTE ${KEX_PRECOMPUTE}")
+
+###########################################
+
+###########################################
+# FOR TO1D_CACHE_SEC
+get_property(cached_to1d_cache_sec_value CACHE TO1D_CACHE_SEC PROPERTY VALUE)
+
+set(to1d_cache_sec_cli_arg ${cached_to1d_cache_sec_value})
+if(to1d_cache_sec_cli_arg STREQUAL CACHED_TO1D_CACHE_SEC)
+  unset(to1d_cache_sec_cli_arg)
+endif()
+
+set(to1d_cache_sec_app_cmake_lists ${TO1D_CACHE_SEC})
+if(cached_to1d_cache_sec_value STREQUAL TO1D_CACHE_SEC)
+  unset(to1d_cache_sec_app_cmake_lists)
+endif()
+
+if(DEFINED CACHED_TO1D_CACHE_SEC)
+  if ((DEFINED to1d_cache_sec_cli_arg) AND (NOT(CACHED_TO1D_CACHE_SEC STREQUAL to1d_cache_sec_cli_arg)))
+    message(WARNING "Need to do make pristine before cmake args can change.")
+  endif()
+  set(TO1D_CACHE_SEC ${CACHED_TO1D_CACHE_SEC})
+elseif(DEFINED to1d_cache_sec_cli_arg)
+  set(TO1D_CACHE_SEC ${to1d_cache_sec_cli_arg})
+elseif(DEFINED to1d_cache_sec_app_cmake_lists)
+  set(TO1D_CACHE_SEC ${to1d_cache_sec_app_cmake_lists})
+endif()
+
+set(CACHED_TO1D_CACHE_SEC ${TO1D_CACHE_SEC} CACHE STRING "Selected TO1D_CACHE_SEC")
+message("Selected TO1D_CACHE_SEC ${TO1D_CACHE_SEC}")
+
+###########################################
+
+###########################################
+# FOR BUFFER_POOL_SZ
+get_property(cached_buffer_pool_sz_value CACHE BUFFER_POOL_SZ PROPERTY VALUE)
+
+set(buffer_pool_sz_cli_arg ${cached_buffer_pool_sz_value})
+if(buffer_pool_sz_cli_arg STREQUAL CACHED_BUFFER_POOL_SZ)
+  unset(buffer_pool_sz_cli_arg)
+endif()
+
+set(buffer_pool_sz_app_cmake_lists ${BUFFER_POOL_SZ})
+if(cached_buffer_pool_sz_value STREQUAL BUFFER_POOL_SZ)
+  unset(buffer_pool_sz_app_cmake_lists)
+endif()
+
+if(DEFINED CACHED_BUFFER_POOL_SZ)
+  if ((DEFINED buffer_pool_sz_cli_arg) AND (NOT(CACHED_BUFFER_POOL_SZ STREQUAL buffer_pool_sz_cli_arg)))
+    message(WARNING "Need to do make pristine before cmake args can change.")
+  endif()
+  set(BUFFER_POOL_SZ ${CACHED_BUFFER_POOL_SZ})
+elseif(DEFINED buffer_pool_sz_cli_arg)
+  set(BUFFER_POOL_SZ ${buffer_pool_sz_cli_arg})
+elseif(DEFINED buffer_pool_sz_app_cmake_lists)
+  set(BUFFER_POOL_SZ ${buffer_pool_sz_app_cmake_lists})
+endif()
+
+set(CACHED_BUFFER_POOL_SZ ${BUFFER_POOL_SZ} CACHE STRING "Selected BUFFER_POOL_SZ")
+message("Selected BUFFER_POOL_SZ ${BUFFER_POOL_SZ}")
+
+###########################################
+
+###########################################
+# FOR BENCH
+get_property(cached_bench_value CACHE BENCH PROPERTY VALUE)
+
+set(bench_cli_arg ${cached_bench_value})
+if(bench_cli_arg STREQUAL CACHED_BENCH)
+  unset(bench_cli_arg)
+endif()
+
+set(bench_app_cmake_lists ${BENCH})
+if(cached_bench_value STREQUAL BENCH)
+  unset(bench_app_cmake_lists)
+endif()
+
+if(DEFINED CACHED_BENCH)
+  if ((DEFINED bench_cli_arg) AND (NOT(CACHED_BENCH STREQUAL bench_cli_arg)))
+    message(WARNING "Need to do make pristine before cmake args can change.")
+  endif()
+  set(BENCH ${CACHED_BENCH})
+elseif(DEFINED bench_cli_arg)
+  set(BENCH ${bench_cli_arg})
+elseif(DEFINED bench_app_cmake_lists)
+  set(BENCH ${bench_app_cmake_lists})
+endif()
+
+set(CACHED_BENCH ${BENCH} CACHE STRING "Selected BENCH")
+message("Selected BENCH ${BENCH}")
+
+###########################################
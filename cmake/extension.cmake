@@ -246,4 +246,15 @@ if(${REUSE} STREQUAL true)
   client_sdk_compile_definitions(-DREUSE_SUPPORTED)
 endif()
 
+client_sdk_compile_definitions(-DTO1D_CACHE_SEC=${TO1D_CACHE_SEC})
+client_sdk_compile_definitions(-DBUFFER_POOL_SZ=${BUFFER_POOL_SZ})
+
+if((${KEX_PRECOMPUTE} STREQUAL true) AND (${TLS} STREQUAL openssl))
+  client_sdk_compile_definitions(-DKEX_PRECOMPUTE_ENABLED)
+endif()
+
+if((${TARGET_OS} MATCHES linux) AND (${BENCH} STREQUAL true))
+  client_sdk_compile_definitions(-DFDO_ALLOC_STATS)
+endif()
+
 ############################################################
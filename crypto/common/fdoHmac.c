@@ -195,6 +195,64 @@ int32_t fdo_crypto_hash(const uint8_t *message, size_t message_length,
 	return 0;
 }
 
+/**
+ * fdo_crypto_hash_init starts an incremental hash, of the same type as
+ * fdo_crypto_hash(), for data that is not contiguous in memory, e.g. byte
+ * ranges of a received message hashed as they are parsed.
+ *
+ * @return
+ *        hash context on success, NULL on failure.
+ */
+void *fdo_crypto_hash_init(void)
+{
+	return crypto_hal_hash_init(FDO_CRYPTO_HASH_TYPE_USED);
+}
+
+/**
+ * fdo_crypto_hash_update feeds the next range of data into the hash.
+ *
+ * @param ctx - hash context returned by fdo_crypto_hash_init().
+ * @param message - pointer to input data buffer of uint8_t type.
+ * @param message_length - input data buffer size
+ *
+ * @return
+ *        return 0 on success. -ve value on failure.
+ */
+int32_t fdo_crypto_hash_update(void *ctx, const uint8_t *message,
+			       size_t message_length)
+{
+	if (!ctx || !message || !message_length) {
+		return -1;
+	}
+	return crypto_hal_hash_update(ctx, message, message_length);
+}
+
+/**
+ * fdo_crypto_hash_final writes the digest of all the data fed so far, and
+ * releases the context, whether it succeeds or not. A NULL hash only
+ * releases the context, e.g. when parsing fails half-way.
+ *
+ * @param ctx - hash context returned by fdo_crypto_hash_init().
+ * @param hash - pointer to output data buffer of uint8_t type.
+ * @param hash_length - output data buffer size
+ *
+ * @return
+ *        return 0 on success. -ve value on failure.
+ */
+int32_t fdo_crypto_hash_final(void *ctx, uint8_t *hash, size_t hash_length)
+{
+	int32_t ret = -1;
+
+	if (!ctx) {
+		return -1;
+	}
+	if (hash && hash_length) {
+		ret = crypto_hal_hash_final(ctx, hash, hash_length);
+	}
+	crypto_hal_hash_free(ctx);
+	return ret;
+}
+
 /**
  * fdo_generate_ov_hmac_key function generates OV HMAC key
  *
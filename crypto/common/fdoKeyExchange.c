@@ -3,7 +3,6 @@
  * SPDX-License-Identifier: Apache 2.0
  */
 
-#include <math.h>
 #include "fdokeyexchange.h"
 #include "fdoCryptoHal.h"
 #include "util.h"
@@ -359,17 +358,21 @@ static int32_t kex_kdf(void)
 	// length of 1 byte in bits
 	int byte_size = 8;
 	// Length of Output Keying Material, in bytes = SEK size for AES-GCM and AES-CCM modes
-	size_t keymat_bytes_sz = SEK_KEY_SIZE;
+	const size_t keymat_bytes_sz = SEK_KEY_SIZE;
 	// Output Keying Material
-	uint8_t keymat[keymat_bytes_sz];
-	// number of iterations of PRF
-	int n = 0;
+	uint8_t keymat[SEK_KEY_SIZE];
+	// PRF (HMAC-SHA256) output
+	uint8_t hmac[SHA256_DIGEST_SIZE] = {0};
+	const size_t hmac_sha256_sz = sizeof(hmac);
+	// number of iterations of PRF, n = ceil (L/h), where,
+	// L = Keying Material length in bits, and
+	// h = PRF output length in bits
+	// Both are fixed by the build's crypto suite.
+	const int n = (SEK_KEY_SIZE + SHA256_DIGEST_SIZE - 1) / SHA256_DIGEST_SIZE;
 	// counter, that is an input to each iteration of PRF
 	int i = 0;
 	size_t keymat_bytes_index = 0;
 	size_t keymat_bytes_to_copy = 0;
-	uint8_t *hmac = NULL;
-	size_t hmac_sha256_sz = BUFF_SIZE_32_BYTES;
 	size_t kdf_label_len = 0;
 	size_t context_label_len = 0;
 
@@ -396,12 +399,6 @@ static int32_t kex_kdf(void)
 		goto err;
 	}
 
-	// total number of rounds (n) to iterate for generating the total number of key bits
-	// n = ceil (L/h), where,
-	// L = Keying Material length in bits, and
-	// h = PRF output length in bits
-	n = ceil((double)(keymat_bytes_sz * byte_size) / (hmac_sha256_sz * byte_size));
-
 	// Input to the KDF, KDFInput = (byte)i||"FIDO-KDF"||(byte)0||Context||Lstr, where
 	// Context = "AutomaticOnboardTunnel"||ContextRand, ContextRand is NULL for ECDH key-exchange,
 	// Lstr = (byte)L1||(byte)L2, i.e, 16-bit number, depending on L=key-bits to generate
@@ -415,13 +412,6 @@ static int32_t kex_kdf(void)
 		goto err;
 	}
 
-	// Allocate memory to store hmac
-	hmac = fdo_alloc(hmac_sha256_sz);
-	if (!hmac) {
-		LOG(LOG_ERROR, "Failed to allocate hmac buffer\n");
-		goto err;
-	}
-
 	// iterate for the calculated number of iterations (n) to generate key bits
 	// once the iterations are done, keymat contains the generated key
 	for (i = 1; i <= n; i++) {
@@ -482,8 +472,10 @@ static int32_t kex_kdf(void)
 	ret = 0;
 
 err:
-	if (hmac) {
-		fdo_free(hmac);
+	if (memset_s(hmac, sizeof(hmac), 0) ||
+	    memset_s(keymat, sizeof(keymat), 0)) {
+		LOG(LOG_ERROR, "Failed to clear key material\n");
+		ret = -1;
 	}
 	if (kdf_input) {
 		fdo_free(kdf_input);
@@ -49,3 +49,64 @@ int32_t fdo_ov_verify(uint8_t *message, uint32_t message_length,
 	*result = (0 == ret) ? true : false;
 	return ret;
 }
+
+/**
+ * This function starts verifying a signature over data that is not contiguous
+ * in memory, e.g. a COSE Sig_structure assembled from parts of a message. It
+ * returns a hash context of the suite's type, which is fed with
+ * fdo_crypto_hash_update() and completed with fdo_ov_verify_final().
+ * @param pubkey In Pointer to the public key used to verify the signature
+ * @return hash context on success, NULL on failure.
+ */
+void *fdo_ov_verify_init(fdo_public_key_t *pubkey)
+{
+	if (!pubkey || pubkey->pkalg != FDO_PK_ALGO) {
+		return NULL;
+	}
+	return crypto_hal_hash_init(FDO_CRYPTO_HASH_TYPE_USED);
+}
+
+/**
+ * This function completes the verification started with fdo_ov_verify_init(),
+ * and releases the hash context in all cases.
+ * @param ctx In hash context returned by fdo_ov_verify_init()
+ * @param message_signature In Pointer to the signature of the message that is
+ * to be verified
+ * @param signature_length In Size of the message signature
+ * @param pubkey In Pointer to the public key used to verify the signature
+ * @param result Out TRUE if the signature is successfully verified, FALSE
+ * if the signature does not match
+ * @return 0 on success; -1 on failure. The result parameter must be checked
+ * only when return value is 0.
+ */
+int32_t fdo_ov_verify_final(void *ctx, uint8_t *message_signature,
+			    uint32_t signature_length,
+			    fdo_public_key_t *pubkey, bool *result)
+{
+	int32_t ret = -1;
+	uint8_t digest[FDO_SHA_DIGEST_SIZE_USED] = {0};
+
+	if (!ctx) {
+		return -1;
+	}
+	if (!message_signature || !pubkey || !pubkey->key1 || !result) {
+		goto end;
+	}
+
+	if (0 != crypto_hal_hash_final(ctx, digest, sizeof(digest))) {
+		goto end;
+	}
+
+	ret = crypto_hal_sig_verify_digest(
+	    pubkey->pkenc, pubkey->pkalg, digest, sizeof(digest),
+	    message_signature, signature_length, pubkey->key1->bytes,
+	    pubkey->key1->byte_sz,
+	    /* X.509 encoded pubkeys only have key1 parameter */
+	    (pubkey->key2 ? pubkey->key2->bytes : NULL),
+	    (pubkey->key2 ? pubkey->key2->byte_sz : 0));
+
+	*result = (0 == ret) ? true : false;
+end:
+	crypto_hal_hash_free(ctx);
+	return ret;
+}
@@ -33,6 +33,10 @@ int32_t fdo_commit_ov_replacement_hmac_key(void);
 int32_t fdo_ov_verify(uint8_t *message, uint32_t message_length,
 		      uint8_t *message_signature, uint32_t signature_length,
 		      fdo_public_key_t *pubkey, bool *result);
+void *fdo_ov_verify_init(fdo_public_key_t *pubkey);
+int32_t fdo_ov_verify_final(void *ctx, uint8_t *message_signature,
+			    uint32_t signature_length,
+			    fdo_public_key_t *pubkey, bool *result);
 
 int32_t fdo_msg_encrypt_get_cipher_len(uint32_t clear_length,
 				       uint32_t *cipher_length);
@@ -50,6 +54,10 @@ int32_t fdo_device_ov_hmac(uint8_t *OVHdr, size_t OVHdr_len, uint8_t *hmac,
 			   size_t hmac_len, bool is_replacement_hmac);
 int32_t fdo_crypto_hash(const uint8_t *message, size_t message_length,
 			uint8_t *hash, size_t hash_length);
+void *fdo_crypto_hash_init(void);
+int32_t fdo_crypto_hash_update(void *ctx, const uint8_t *message,
+			       size_t message_length);
+int32_t fdo_crypto_hash_final(void *ctx, uint8_t *hash, size_t hash_length);
 int32_t fdo_to2_chained_hmac(uint8_t *to2Msg, size_t to2Msg_len, uint8_t *hmac,
 			     size_t hmac_len, const uint8_t *previousHMAC,
 			     size_t previousHMACLength);
@@ -18,6 +18,11 @@
 // 2. Encryption/Decryption
 // 3. Hash/HMAC
 // See Section 3.6 in the FIDO Device Onboard Specification
+//
+// The suite is fixed at build time, and the crypto HAL implements only its
+// algorithms: public keys of the other ECDSA type are rejected when read, so
+// the code for them is left out. SHA-256 is always built in, since the KDF and
+// the platform blob HMAC use it with both suites.
 #if defined(ECDSA256_DA)
 
 // Device Attestation: ECDSA256
@@ -48,6 +53,7 @@
 #define KEX "ECDH384"
 #define FDO_SHA_DIGEST_SIZE_USED BUFF_SIZE_48_BYTES
 #define FDO_HMAC_KEY_LENGTH BUFF_SIZE_64_BYTES
+#define FDO_SHA384_ENABLED
 
 // Encryption/Decryption Algorithms: AES256
 #define AES_256_BIT
@@ -58,6 +58,17 @@ int32_t crypto_hal_hash(uint8_t hash_type, const uint8_t *buffer,
 			 size_t buffer_length, uint8_t *output,
 			 size_t output_length);
 
+/* Incremental hash: crypto_hal_hash_init() returns a context (NULL on
+ * failure) that is fed with crypto_hal_hash_update(), produces the digest
+ * with crypto_hal_hash_final() and is released with crypto_hal_hash_free().
+ */
+void *crypto_hal_hash_init(int hash_type);
+int32_t crypto_hal_hash_update(void *ctx, const uint8_t *buffer,
+			       size_t buffer_length);
+int32_t crypto_hal_hash_final(void *ctx, uint8_t *output,
+			      size_t output_length);
+void crypto_hal_hash_free(void *ctx);
+
 /* Calculate hmac of "buffer" using "key", and place the result in "output".
  * "output" must be allocated already.
  */
@@ -93,6 +104,24 @@ int32_t crypto_hal_sig_verify(uint8_t key_encoding, int key_algorithm,
 			      const uint8_t *key_param2,
 			      uint32_t key_param2Length);
 
+/* crypto_hal_sig_verify_digest
+ * Same as crypto_hal_sig_verify(), but over the digest of the message, for
+ * data hashed with crypto_hal_hash_init/update/final() as it is produced.
+ * The digest is SHA-256 for ECDSA P-256 keys and SHA-384 for P-384 keys.
+ *
+ * @param digest[in] - pointer of type uint8_t, holds the message digest.
+ * @param digest_length[in] - size of digest.
+ * @return 0 if true, else -1.
+ */
+int32_t crypto_hal_sig_verify_digest(uint8_t key_encoding, int key_algorithm,
+				     const uint8_t *digest, size_t digest_length,
+				     const uint8_t *message_signature,
+				     uint32_t signature_length,
+				     const uint8_t *key_param1,
+				     uint32_t key_param1Length,
+				     const uint8_t *key_param2,
+				     uint32_t key_param2Length);
+
 /* ECDSA P-256/384 curve signature length, can be to used while allocating
  * buffer
  */
@@ -21,10 +21,19 @@
 #include "stdlib.h"
 #include "storage_al.h"
 
+/* Only the curve and digest of the build's Device Attestation are compiled in */
+#if defined(ECDSA256_DA)
+#define KEY_CURVE MBEDTLS_ECP_DP_SECP256R1
+#define KEY_HASH_TYPE MBEDTLS_MD_SHA256
+#else
+#define KEY_CURVE MBEDTLS_ECP_DP_SECP384R1
+#define KEY_HASH_TYPE MBEDTLS_MD_SHA384
+#endif
+
 /**
  * Verify an ECC P-256/P-384 signature using provided ECDSA Public Keys.
  * @param key_encoding - encoding typee.
- * @param key_algorithm - public key algorithm.
+ * @param key_algorithm - public key algorithm, must be FDO_PK_ALGO.
  * @param message - pointer of type uint8_t, holds the encoded message.
  * @param message_length - size of message, type size_t.
  * @param message_signature - pointer of type uint8_t, holds a valid
@@ -45,28 +54,76 @@ int32_t crypto_hal_sig_verify(uint8_t key_encoding, int key_algorithm,
 			      uint32_t key_param1Length,
 			      const uint8_t *key_param2,
 			      uint32_t key_param2Length)
+{
+	unsigned char hash[FDO_SHA_DIGEST_SIZE_USED] = {0};
+
+	if (NULL == message || 0 == message_length) {
+		LOG(LOG_ERROR, "Invalid arguments!\n");
+		return -1;
+	}
+
+	if (key_algorithm != FDO_PK_ALGO) {
+		LOG(LOG_ERROR, "Incorrect key type!\n");
+		return -1;
+	}
+
+	/* Calculate the hash over message and verify the signature over it */
+	if (mbedtls_md(mbedtls_md_info_from_type(KEY_HASH_TYPE),
+		       (const uint8_t *)message, message_length, hash) != 0) {
+		LOG(LOG_ERROR, " mbedtls_md FAILED:\n");
+		return -1;
+	}
+
+	return crypto_hal_sig_verify_digest(key_encoding, key_algorithm, hash,
+					    sizeof(hash), message_signature,
+					    signature_length, key_param1,
+					    key_param1Length, key_param2,
+					    key_param2Length);
+}
+
+/**
+ * Verify an ECC P-256/P-384 signature over a message digest, for callers that
+ * hash the signed data as it is produced, using provided ECDSA Public Keys.
+ * @param key_encoding - encoding typee.
+ * @param key_algorithm - public key algorithm, must be FDO_PK_ALGO.
+ * @param digest - SHA-256 (P-256) or SHA-384 (P-384) digest of the message.
+ * @param digest_length - size of digest.
+ * @param message_signature - pointer of type uint8_t, holds a valid
+ *			ecdsa signature in big-endian format
+ * @param signature_length - size of signature, type unsigned int.
+ * @param key_param1 - pointer of type uint8_t, holds the EC public key.
+ * @param key_param1Length - size of EC public key, type size_t.
+ * @param key_param2 - not used.
+ * @param key_param2Length - not used
+ * @return 0 if true, else -1.
+ */
+int32_t crypto_hal_sig_verify_digest(uint8_t key_encoding, int key_algorithm,
+				     const uint8_t *digest, size_t digest_length,
+				     const uint8_t *message_signature,
+				     uint32_t signature_length,
+				     const uint8_t *key_param1,
+				     uint32_t key_param1Length,
+				     const uint8_t *key_param2,
+				     uint32_t key_param2Length)
 {
 	int32_t ret = -1;
 	int result = 0;
-	unsigned char hash[SHA512_DIGEST_SIZE] = {0};
-	size_t hash_length = 0;
 	mbedtls_ecdsa_context ec_ctx = {0};
 	mbedtls_pk_context pk_ctx = {0};
-	mbedtls_md_type_t mbedhash_type = MBEDTLS_MD_NONE;
 
 	(void)key_param2;
 	(void)key_param2Length;
 
 	if (key_encoding != FDO_CRYPTO_PUB_KEY_ENCODING_X509 ||
-	    (key_algorithm != FDO_CRYPTO_PUB_KEY_ALGO_ECDSAp256 &&
-	     key_algorithm != FDO_CRYPTO_PUB_KEY_ALGO_ECDSAp384)) {
+	    key_algorithm != FDO_PK_ALGO) {
 		LOG(LOG_ERROR, "Incorrect key type!\n");
 		goto end;
 	}
 
 	if (NULL == key_param1 || 0 == key_param1Length ||
 	    NULL == message_signature || 0 == signature_length ||
-	    NULL == message || 0 == message_length) {
+	    NULL == digest ||
+	    digest_length != FDO_SHA_DIGEST_SIZE_USED) {
 		LOG(LOG_ERROR, "Invalid arguments!\n");
 		goto end;
 	}
@@ -74,20 +131,7 @@ int32_t crypto_hal_sig_verify(uint8_t key_encoding, int key_algorithm,
 	/* Initialize mbedtls_ecdsa_context with EC group */
 	mbedtls_ecdsa_init(&ec_ctx);
 
-	if (key_algorithm == FDO_CRYPTO_PUB_KEY_ALGO_ECDSAp256) { // P-256 NIST
-		LOG(LOG_DEBUG, "ECDSA256 verify\n");
-		result = mbedtls_ecp_group_load(&(ec_ctx.grp),
-						MBEDTLS_ECP_DP_SECP256R1);
-		mbedhash_type = MBEDTLS_MD_SHA256;
-		hash_length = SHA256_DIGEST_SIZE;
-	} else { // P-384 NIST curve
-		LOG(LOG_DEBUG, "ECDSA384 verify\n");
-		result = mbedtls_ecp_group_load(&(ec_ctx.grp),
-						MBEDTLS_ECP_DP_SECP384R1);
-
-		mbedhash_type = MBEDTLS_MD_SHA384;
-		hash_length = SHA384_DIGEST_SIZE;
-	}
+	result = mbedtls_ecp_group_load(&(ec_ctx.grp), KEY_CURVE);
 	if (result) {
 		LOG(LOG_ERROR, "Initializing with required EC group failed!\n");
 		goto end;
@@ -104,20 +148,15 @@ int32_t crypto_hal_sig_verify(uint8_t key_encoding, int key_algorithm,
 		goto end;
 	}
 
-	/* Calculate the hash over message and sign that hash */
-	if (mbedtls_md(mbedtls_md_info_from_type(mbedhash_type),
-		       (const uint8_t *)message, message_length, hash) != 0) {
-		LOG(LOG_ERROR, " mbedtls_md FAILED:\n");
-		goto end;
-	}
 	/* Verify ECDSA signature with 'updated mbedtls_ecdsa_context with
 	 * pubkey info'
 	 */
-	ret = mbedtls_ecdsa_read_signature(mbedtls_pk_ec(pk_ctx), hash,
-					   hash_length, message_signature,
+	ret = mbedtls_ecdsa_read_signature(mbedtls_pk_ec(pk_ctx), digest,
+					   digest_length, message_signature,
 					   signature_length);
 	if (ret != 0) {
 		LOG(LOG_ERROR, "ECDSA Signature-verification failed!\n");
+		ret = -1;
 		goto end;
 	}
 
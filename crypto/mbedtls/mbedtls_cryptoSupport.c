@@ -193,33 +193,18 @@ int32_t crypto_hal_hash(uint8_t _hash_type, const uint8_t *buffer,
 			 size_t buffer_length, uint8_t *output,
 			 size_t output_length)
 {
-	mbedtls_md_type_t mbedhash_type = MBEDTLS_MD_NONE;
-	uint8_t hash_type = FDO_CRYPTO_HASH_TYPE_USED;
+#if defined(ECDSA256_DA)
+	const mbedtls_md_type_t mbedhash_type = MBEDTLS_MD_SHA256;
+#else
+	const mbedtls_md_type_t mbedhash_type = MBEDTLS_MD_SHA384;
+#endif
 
-	if (NULL == output || 0 == output_length || NULL == buffer ||
-	    0 == buffer_length) {
+	if (NULL == output || output_length < FDO_SHA_DIGEST_SIZE_USED ||
+	    NULL == buffer || 0 == buffer_length) {
 		return -1;
 	}
 
-	(void)_hash_type;
-
-	switch (hash_type) {
-	case FDO_CRYPTO_HASH_TYPE_SHA_256:
-		if (output_length < SHA256_DIGEST_SIZE) {
-			return -1;
-		}
-		mbedhash_type = MBEDTLS_MD_SHA256;
-		break;
-	case FDO_CRYPTO_HASH_TYPE_SHA_384:
-		if (output_length < SHA384_DIGEST_SIZE) {
-			return -1;
-		}
-		mbedhash_type = MBEDTLS_MD_SHA384;
-		break;
-
-	default:
-		return -1;
-	}
+	(void)_hash_type; /* Always the suite's FDO_CRYPTO_HASH_TYPE_USED */
 	/* Calculate the hash over message and sign that hash */
 	if (mbedtls_md(mbedtls_md_info_from_type(mbedhash_type),
 		       (const uint8_t *)buffer, buffer_length, output) != 0) {
@@ -266,6 +251,7 @@ int32_t crypto_hal_hmac(uint8_t hmac_type, const uint8_t *buffer,
 		    (const uint8_t *)key, key_length, buffer, buffer_length,
 		    output);
 		break;
+#if defined(FDO_SHA384_ENABLED)
 	case FDO_CRYPTO_HMAC_TYPE_SHA_384:
 		if (output_length < SHA384_DIGEST_SIZE) {
 			return -1;
@@ -275,6 +261,7 @@ int32_t crypto_hal_hmac(uint8_t hmac_type, const uint8_t *buffer,
 		    (const uint8_t *)key, key_length, buffer, buffer_length,
 		    output);
 		break;
+#endif
 
 	default:
 		return -1;
@@ -283,3 +270,125 @@ int32_t crypto_hal_hmac(uint8_t hmac_type, const uint8_t *buffer,
 	return -1;
 }
 #endif /* SECURE_ELEMENT */
+
+/* Incremental hash context, digest size kept alongside the md context */
+typedef struct {
+	mbedtls_md_context_t md;
+	size_t digest_sz;
+} mbedtls_hash_ctx_t;
+
+/**
+ * crypto_hal_hash_init allocates and starts an incremental hash context.
+ * Data is then fed with crypto_hal_hash_update() and the digest produced
+ * with crypto_hal_hash_final(). The context is released with
+ * crypto_hal_hash_free().
+ *
+ * @param hash_type - Hash type (FDO_CRYPTO_HASH_TYPE_SHA_256/
+ *				FDO_CRYPTO_HASH_TYPE_SHA_384)
+ *
+ * @return
+ *        return hash context on success. NULL on failure.
+ */
+void *crypto_hal_hash_init(int hash_type)
+{
+	mbedtls_md_type_t mbedhash_type = MBEDTLS_MD_NONE;
+	mbedtls_hash_ctx_t *ctx = NULL;
+	size_t digest_sz = 0;
+
+	switch (hash_type) {
+	case FDO_CRYPTO_HASH_TYPE_SHA_256:
+		mbedhash_type = MBEDTLS_MD_SHA256;
+		digest_sz = SHA256_DIGEST_SIZE;
+		break;
+#if defined(FDO_SHA384_ENABLED)
+	case FDO_CRYPTO_HASH_TYPE_SHA_384:
+		mbedhash_type = MBEDTLS_MD_SHA384;
+		digest_sz = SHA384_DIGEST_SIZE;
+		break;
+#endif
+	default:
+		return NULL;
+	}
+
+	ctx = fdo_alloc(sizeof(*ctx));
+	if (!ctx) {
+		return NULL;
+	}
+	ctx->digest_sz = digest_sz;
+	mbedtls_md_init(&ctx->md);
+	if (mbedtls_md_setup(&ctx->md, mbedtls_md_info_from_type(mbedhash_type),
+			     0) != 0 ||
+	    mbedtls_md_starts(&ctx->md) != 0) {
+		LOG(LOG_ERROR, "mbedtls_md_starts FAILED\n");
+		mbedtls_md_free(&ctx->md);
+		fdo_free(ctx);
+		return NULL;
+	}
+	return ctx;
+}
+
+/**
+ * crypto_hal_hash_update feeds the next chunk of data into the hash.
+ *
+ * @param ctx - hash context returned by crypto_hal_hash_init().
+ * @param buffer - pointer to input data buffer of uint8_t type.
+ * @param buffer_length - input data buffer size
+ *
+ * @return
+ *        return 0 on success. -ve value on failure.
+ */
+int32_t crypto_hal_hash_update(void *ctx, const uint8_t *buffer,
+			       size_t buffer_length)
+{
+	mbedtls_hash_ctx_t *hash_ctx = ctx;
+
+	if (!hash_ctx || (!buffer && buffer_length)) {
+		return -1;
+	}
+	if (buffer_length == 0) {
+		return 0;
+	}
+	if (mbedtls_md_update(&hash_ctx->md, buffer, buffer_length) != 0) {
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * crypto_hal_hash_final writes the digest of all data fed so far.
+ *
+ * @param ctx - hash context returned by crypto_hal_hash_init().
+ * @param output - pointer to output data buffer of uint8_t type.
+ * @param output_length - output data buffer size
+ *
+ * @return
+ *        return 0 on success. -ve value on failure.
+ */
+int32_t crypto_hal_hash_final(void *ctx, uint8_t *output,
+			      size_t output_length)
+{
+	mbedtls_hash_ctx_t *hash_ctx = ctx;
+
+	if (!hash_ctx || !output || output_length < hash_ctx->digest_sz) {
+		return -1;
+	}
+	if (mbedtls_md_finish(&hash_ctx->md, output) != 0) {
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * crypto_hal_hash_free releases a hash context.
+ *
+ * @param ctx - hash context returned by crypto_hal_hash_init().
+ */
+void crypto_hal_hash_free(void *ctx)
+{
+	mbedtls_hash_ctx_t *hash_ctx = ctx;
+
+	if (hash_ctx) {
+		mbedtls_md_free(&hash_ctx->md);
+		fdo_free(hash_ctx);
+	}
+}
@@ -18,10 +18,17 @@
 #include "storage_al.h"
 #include "safe_lib.h"
 
+/* Only the curve and digest of the build's Device Attestation are compiled in */
+#if defined(ECDSA256_DA)
+#define KEY_CURVE NID_X9_62_prime256v1
+#else
+#define KEY_CURVE NID_secp384r1
+#endif
+
 /**
  * Verify an ECC P-256/P-384 signature using provided ECDSA Public Keys.
  * @param key_encoding - encoding typee.
- * @param key_algorithm - public key algorithm.
+ * @param key_algorithm - public key algorithm, must be FDO_PK_ALGO.
  * @param message - pointer of type uint8_t, holds the encoded message.
  * @param message_length - size of message, type size_t.
  * @param message_signature - pointer of type uint8_t, holds a valid
@@ -42,11 +49,69 @@ int32_t crypto_hal_sig_verify(uint8_t key_encoding, int key_algorithm,
 			      uint32_t key_param1Length,
 			      const uint8_t *key_param2,
 			      uint32_t key_param2Length)
+{
+	uint8_t hash[FDO_SHA_DIGEST_SIZE_USED] = {0};
+
+	if (NULL == message || 0 == message_length) {
+		LOG(LOG_ERROR, "Invalid arguments!\n");
+		return -1;
+	}
+
+	if (key_algorithm != FDO_PK_ALGO) {
+		LOG(LOG_ERROR, "Incorrect key type\n");
+		return -1;
+	}
+
+#if defined(ECDSA256_DA)
+	/* Perform SHA-256 digest of the message */
+	if (SHA256((const unsigned char *)message, message_length,
+		   hash) == NULL) {
+		LOG(LOG_ERROR, "SHA-256 calculation failed!\n");
+		return -1;
+	}
+#else
+	/* Perform SHA-384 digest of the message */
+	if (SHA384((const unsigned char *)message, message_length,
+		   hash) == NULL) {
+		LOG(LOG_ERROR, "SHA-384 calculation failed!\n");
+		return -1;
+	}
+#endif
+
+	return crypto_hal_sig_verify_digest(key_encoding, key_algorithm, hash,
+					    sizeof(hash), message_signature,
+					    signature_length, key_param1,
+					    key_param1Length, key_param2,
+					    key_param2Length);
+}
+
+/**
+ * Verify an ECC P-256/P-384 signature over a message digest, for callers that
+ * hash the signed data as it is produced, using provided ECDSA Public Keys.
+ * @param key_encoding - encoding typee.
+ * @param key_algorithm - public key algorithm, must be FDO_PK_ALGO.
+ * @param digest - SHA-256 (P-256) or SHA-384 (P-384) digest of the message.
+ * @param digest_length - size of digest.
+ * @param message_signature - pointer of type uint8_t, holds a valid
+ *			ecdsa signature in big-endian format
+ * @param signature_length - size of signature, type unsigned int.
+ * @param key_param1 - pointer of type uint8_t, holds the public key.
+ * @param key_param1Length - size of public key, type size_t.
+ * @param key_param2 - not used.
+ * @param key_param2Length - not used
+ * @return 0 if true, else -1.
+ */
+int32_t crypto_hal_sig_verify_digest(uint8_t key_encoding, int key_algorithm,
+				     const uint8_t *digest, size_t digest_length,
+				     const uint8_t *message_signature,
+				     uint32_t signature_length,
+				     const uint8_t *key_param1,
+				     uint32_t key_param1Length,
+				     const uint8_t *key_param2,
+				     uint32_t key_param2Length)
 {
 	int32_t ret = -1;
 	EC_KEY *eckey = NULL;
-	uint8_t hash[SHA512_DIGEST_LENGTH] = {0};
-	size_t hash_length = 0;
 	const unsigned char *pub_key = (const unsigned char *)key_param1;
 	unsigned char *sig_r = NULL;
 	unsigned char *sig_s = NULL;
@@ -60,47 +125,22 @@ int32_t crypto_hal_sig_verify(uint8_t key_encoding, int key_algorithm,
 	// Only COSEKEY and X509 are currently supported
 	if ((key_encoding != FDO_CRYPTO_PUB_KEY_ENCODING_X509 &&
 		 key_encoding != FDO_CRYPTO_PUB_KEY_ENCODING_COSEKEY) ||
-	    (key_algorithm != FDO_CRYPTO_PUB_KEY_ALGO_ECDSAp256 &&
-	     key_algorithm != FDO_CRYPTO_PUB_KEY_ALGO_ECDSAp384)) {
+	    key_algorithm != FDO_PK_ALGO) {
 		LOG(LOG_ERROR, "Incorrect key type\n");
 		goto end;
 	}
 
 	if (NULL == message_signature || 0 == signature_length ||
-		0 != (signature_length % 2) ||
-	    NULL == message || 0 == message_length) {
+		0 != (signature_length % 2) || NULL == digest ||
+	    digest_length != FDO_SHA_DIGEST_SIZE_USED) {
 		LOG(LOG_ERROR, "Invalid arguments!\n");
 		goto end;
 	}
 
-	/* generate required EC_KEY based on type */
-	if (key_algorithm == FDO_CRYPTO_PUB_KEY_ALGO_ECDSAp256) { // P-256 NIST
-		eckey = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1);
-		if (NULL == eckey) {
-			LOG(LOG_ERROR, "EC_KEY allocation failed!\n");
-			goto end;
-		}
-		/* Perform SHA-256 digest of the message */
-		if (SHA256((const unsigned char *)message, message_length,
-			   hash) == NULL) {
-			LOG(LOG_ERROR, "SHA-256 calculation failed!\n");
-			goto end;
-		}
-		hash_length = SHA256_DIGEST_LENGTH;
-
-	} else { // P-384
-		eckey = EC_KEY_new_by_curve_name(NID_secp384r1);
-		if (NULL == eckey) {
-			LOG(LOG_ERROR, "EC_KEY allocation failed!\n");
-			goto end;
-		}
-		/* Perform SHA-384 digest of the message */
-		if (SHA384((const unsigned char *)message, message_length,
-			   hash) == NULL) {
-			LOG(LOG_ERROR, "SHA-384 calculation failed!\n");
-			goto end;
-		}
-		hash_length = SHA384_DIGEST_LENGTH;
+	eckey = EC_KEY_new_by_curve_name(KEY_CURVE);
+	if (NULL == eckey) {
+		LOG(LOG_ERROR, "EC_KEY allocation failed!\n");
+		goto end;
 	}
 
 	if (key_encoding == FDO_CRYPTO_PUB_KEY_ENCODING_X509) {
@@ -186,7 +226,7 @@ int32_t crypto_hal_sig_verify(uint8_t key_encoding, int key_algorithm,
 		goto end;
 	}
 
-	if (1 != ECDSA_do_verify(hash, hash_length, sig, eckey)) {
+	if (1 != ECDSA_do_verify(digest, (int)digest_length, sig, eckey)) {
 		LOG(LOG_ERROR, "ECDSA Sig verification failed\n");
 		goto end;
 	}
@@ -246,37 +246,30 @@ int32_t crypto_hal_hash(uint8_t _hash_type, const uint8_t *buffer,
 			 size_t buffer_length, uint8_t *output,
 			 size_t output_length)
 {
-	int hash_type = FDO_CRYPTO_HASH_TYPE_USED;
-
-	(void)_hash_type; /* Unused parameter */
+	(void)_hash_type; /* Always the suite's FDO_CRYPTO_HASH_TYPE_USED */
 
 	if (NULL == output || 0 == output_length || NULL == buffer ||
 	    0 == buffer_length) {
 		return -1;
 	}
 
-	switch (hash_type) {
-	case FDO_CRYPTO_HASH_TYPE_SHA_256:
-		if (output_length < SHA256_DIGEST_SIZE) {
-			return -1;
-		}
-		if (NULL == SHA256((const unsigned char *)buffer, buffer_length,
-				   output)) {
-			return -1;
-		}
-		break;
-	case FDO_CRYPTO_HASH_TYPE_SHA_384:
-		if (output_length < SHA384_DIGEST_SIZE) {
-			return -1;
-		}
-		if (NULL == SHA384((const unsigned char *)buffer, buffer_length,
-				   output)) {
-			return -1;
-		}
-		break;
-	default:
+#if defined(ECDSA256_DA)
+	if (output_length < SHA256_DIGEST_SIZE) {
+		return -1;
+	}
+	if (NULL == SHA256((const unsigned char *)buffer, buffer_length,
+			   output)) {
+		return -1;
+	}
+#else
+	if (output_length < SHA384_DIGEST_SIZE) {
 		return -1;
 	}
+	if (NULL == SHA384((const unsigned char *)buffer, buffer_length,
+			   output)) {
+		return -1;
+	}
+#endif
 
 	return 0;
 }
@@ -316,6 +309,7 @@ int32_t crypto_hal_hmac(uint8_t hmac_type, const uint8_t *buffer,
 			return -1;
 		}
 		break;
+#if defined(FDO_SHA384_ENABLED)
 	case FDO_CRYPTO_HMAC_TYPE_SHA_384:
 		if (output_length < SHA384_DIGEST_SIZE) {
 			return -1;
@@ -325,6 +319,7 @@ int32_t crypto_hal_hmac(uint8_t hmac_type, const uint8_t *buffer,
 			return -1;
 		}
 		break;
+#endif
 	default:
 		return -1;
 	}
@@ -332,3 +327,106 @@ int32_t crypto_hal_hmac(uint8_t hmac_type, const uint8_t *buffer,
 	return 0;
 }
 #endif /* SECURE_ELEMENT */
+
+/**
+ * crypto_hal_hash_init allocates and starts an incremental hash context.
+ * Data is then fed with crypto_hal_hash_update() and the digest produced
+ * with crypto_hal_hash_final(). The context is released with
+ * crypto_hal_hash_free().
+ *
+ * @param hash_type - Hash type (FDO_CRYPTO_HASH_TYPE_SHA_256/
+ *				FDO_CRYPTO_HASH_TYPE_SHA_384)
+ *
+ * @return
+ *        return hash context on success. NULL on failure.
+ */
+void *crypto_hal_hash_init(int hash_type)
+{
+	const EVP_MD *md = NULL;
+	EVP_MD_CTX *ctx = NULL;
+
+	switch (hash_type) {
+	case FDO_CRYPTO_HASH_TYPE_SHA_256:
+		md = EVP_sha256();
+		break;
+#if defined(FDO_SHA384_ENABLED)
+	case FDO_CRYPTO_HASH_TYPE_SHA_384:
+		md = EVP_sha384();
+		break;
+#endif
+	default:
+		return NULL;
+	}
+
+	ctx = EVP_MD_CTX_new();
+	if (!ctx) {
+		return NULL;
+	}
+	if (EVP_DigestInit_ex(ctx, md, NULL) != 1) {
+		EVP_MD_CTX_free(ctx);
+		return NULL;
+	}
+	return ctx;
+}
+
+/**
+ * crypto_hal_hash_update feeds the next chunk of data into the hash.
+ *
+ * @param ctx - hash context returned by crypto_hal_hash_init().
+ * @param buffer - pointer to input data buffer of uint8_t type.
+ * @param buffer_length - input data buffer size
+ *
+ * @return
+ *        return 0 on success. -ve value on failure.
+ */
+int32_t crypto_hal_hash_update(void *ctx, const uint8_t *buffer,
+			       size_t buffer_length)
+{
+	if (!ctx || (!buffer && buffer_length)) {
+		return -1;
+	}
+	if (buffer_length == 0) {
+		return 0;
+	}
+	if (EVP_DigestUpdate((EVP_MD_CTX *)ctx, buffer, buffer_length) != 1) {
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * crypto_hal_hash_final writes the digest of all data fed so far.
+ *
+ * @param ctx - hash context returned by crypto_hal_hash_init().
+ * @param output - pointer to output data buffer of uint8_t type.
+ * @param output_length - output data buffer size
+ *
+ * @return
+ *        return 0 on success. -ve value on failure.
+ */
+int32_t crypto_hal_hash_final(void *ctx, uint8_t *output,
+			      size_t output_length)
+{
+	unsigned int len = 0;
+
+	if (!ctx || !output ||
+	    output_length < (size_t)EVP_MD_CTX_size((EVP_MD_CTX *)ctx)) {
+		return -1;
+	}
+	if (EVP_DigestFinal_ex((EVP_MD_CTX *)ctx, output, &len) != 1) {
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * crypto_hal_hash_free releases a hash context.
+ *
+ * @param ctx - hash context returned by crypto_hal_hash_init().
+ */
+void crypto_hal_hash_free(void *ctx)
+{
+	if (ctx) {
+		EVP_MD_CTX_free((EVP_MD_CTX *)ctx);
+	}
+}
@@ -16,6 +16,9 @@
 #include "openssl/ec.h"
 #include "openssl/objects.h"
 #include "safe_lib.h"
+#ifdef KEX_PRECOMPUTE_ENABLED
+#include <pthread.h>
+#endif
 #define DECLARE_BIGNUM(bn) bignum_t *bn
 
 #ifdef KEX_ECDH384_ENABLED
@@ -36,12 +39,68 @@ typedef struct {
 	DECLARE_BIGNUM(_shared_secret);
 	uint8_t *_pubB;
 	uint8_t _publicB_length;
+	BN_CTX *_bn_ctx; /* Reused for every computation on this context */
+#ifdef KEX_PRECOMPUTE_ENABLED
+	pthread_t _thread; /* Generates Device Random and B in the background */
+	bool _pending;     /* true until _thread is joined */
+	bool _generated;   /* Result of _thread */
+#endif
 } ecdh_context_t;
 
 static bool compute_publicBECDH(ecdh_context_t *key_ex_data);
 
+/**
+ * Generate the Device Random and the ephemeral key, and compute B from them.
+ * @param key_ex_data - pointer to the keyexchange data structure
+ * @return true on success, false on error
+ */
+static bool generate_publicB(ecdh_context_t *key_ex_data)
+{
+	/* Generate Device Random bits(384) */
+	if (bn_rand(key_ex_data->_Device_random, BN_RANDOM_SIZE)) {
+		return false;
+	}
+	return compute_publicBECDH(key_ex_data);
+}
+
+#ifdef KEX_PRECOMPUTE_ENABLED
+static void *generate_publicB_thread(void *arg)
+{
+	ecdh_context_t *key_ex_data = (ecdh_context_t *)arg;
+
+	key_ex_data->_generated = generate_publicB(key_ex_data);
+	return NULL;
+}
+#endif
+
+/**
+ * Wait for the background generation of B started by crypto_hal_kex_init(),
+ * if any. Every other operation on the context must call this first.
+ * @param key_ex_data - pointer to the keyexchange data structure
+ * @return true if B has been generated, false on error
+ */
+static bool wait_publicB(ecdh_context_t *key_ex_data)
+{
+#ifdef KEX_PRECOMPUTE_ENABLED
+	if (key_ex_data->_pending) {
+		key_ex_data->_pending = false;
+		if (pthread_join(key_ex_data->_thread, NULL) != 0) {
+			LOG(LOG_ERROR, "Failed to join key exchange generation\n");
+			key_ex_data->_generated = false;
+		}
+	}
+	return key_ex_data->_generated;
+#else
+	(void)key_ex_data;
+	return true;
+#endif
+}
+
 /**
  * Initialize the key exchange of type ECDH
+ * When built with KEX_PRECOMPUTE_ENABLED, the Device Random and ephemeral key
+ * are generated in a background thread, that overlaps with the TO2 messages
+ * exchanged before they're needed, and is joined on first use of the context.
  * @param context - points to the initialised pointer to the key exchange
  * data structure
  * @return 0 if success else -1
@@ -70,19 +129,19 @@ int32_t crypto_hal_kex_init(void **context)
 	key_ex_data->_publicA = BN_new();
 	key_ex_data->_shared_secret = BN_new();
 	key_ex_data->_Device_random = BN_new();
+	key_ex_data->_bn_ctx = BN_CTX_new();
 
 	if (!key_ex_data->_publicB || !key_ex_data->_publicA ||
 	    !key_ex_data->_shared_secret || !key_ex_data->_Device_random) {
 		LOG(LOG_ERROR, "BN alloc failed\n");
 		goto error;
 	}
-
-	key = EC_KEY_new_by_curve_name(KEY_CURVE);
-	/* Generate Device Random bits(384) */
-	if (bn_rand(key_ex_data->_Device_random, BN_RANDOM_SIZE)) {
+	if (!key_ex_data->_bn_ctx) {
+		LOG(LOG_ERROR, "BN context new fail\n");
 		goto error;
 	}
 
+	key = EC_KEY_new_by_curve_name(KEY_CURVE);
 	if (key == NULL) {
 		LOG(LOG_ERROR, "failed to get the curve parameters\n");
 		goto error;
@@ -90,9 +149,23 @@ int32_t crypto_hal_kex_init(void **context)
 
 	key_ex_data->_key = key;
 
-	if (compute_publicBECDH(key_ex_data) == false) {
+#ifdef KEX_PRECOMPUTE_ENABLED
+	if (pthread_create(&key_ex_data->_thread, NULL, generate_publicB_thread,
+			   key_ex_data) == 0) {
+		key_ex_data->_pending = true;
+	} else {
+		/* generate inline instead */
+		LOG(LOG_DEBUG, "Failed to start key exchange generation thread\n");
+		key_ex_data->_generated = generate_publicB(key_ex_data);
+	}
+	if (!key_ex_data->_pending && !key_ex_data->_generated) {
+		goto error;
+	}
+#else
+	if (generate_publicB(key_ex_data) == false) {
 		goto error;
 	}
+#endif
 
 	*context = (void *)key_ex_data;
 	return 0;
@@ -118,6 +191,8 @@ int32_t crypto_hal_kex_close(void **context)
 	}
 
 	key_ex_data = *(ecdh_context_t **)context;
+	/* the generation thread may still be using the context */
+	(void)wait_publicB(key_ex_data);
 	if (key_ex_data->_publicB) {
 		BN_clear_free(key_ex_data->_publicB);
 	}
@@ -137,6 +212,9 @@ int32_t crypto_hal_kex_close(void **context)
 	if (key_ex_data->_pubB) {
 		fdo_free(key_ex_data->_pubB);
 	}
+	if (key_ex_data->_bn_ctx) {
+		BN_CTX_free(key_ex_data->_bn_ctx);
+	}
 	fdo_free(key_ex_data);
 	return 0;
 }
@@ -167,9 +245,9 @@ static bool compute_publicBECDH(ecdh_context_t *key_ex_data)
 		return ret;
 	}
 
-	ctx = BN_CTX_new();
+	ctx = key_ex_data->_bn_ctx;
 	if (!ctx) {
-		LOG(LOG_ERROR, "BN context new fail\n");
+		LOG(LOG_ERROR, "BN context is missing\n");
 		return ret;
 	}
 	BN_CTX_start(ctx);
@@ -314,10 +392,7 @@ exit:
 	if (y) {
 		BN_clear(y);
 	}
-	/* Consider using the bn cache in ctx. */
-	if (ctx) {
-		BN_CTX_free(ctx);
-	}
+	BN_CTX_end(ctx);
 	return ret;
 }
 
@@ -340,6 +415,10 @@ int32_t crypto_hal_get_device_random(void *context, uint8_t *dev_rand_value,
 		LOG(LOG_ERROR, "Invalid parameters\n");
 		return -1;
 	}
+	if (!wait_publicB(key_ex_data)) {
+		LOG(LOG_ERROR, "Key exchange generation failed\n");
+		return -1;
+	}
 	if (!dev_rand_value) {
 		*dev_rand_length = key_ex_data->_publicB_length;
 		return 0;
@@ -375,6 +454,10 @@ int32_t crypto_hal_set_peer_random(void *context,
 		LOG(LOG_ERROR, "Invalid parameters\n");
 		return -1;
 	}
+	if (!wait_publicB(key_ex_data)) {
+		LOG(LOG_ERROR, "Key exchange generation failed\n");
+		return -1;
+	}
 
 	BN_CTX *ctx = NULL;
 	const uint8_t *temp = NULL;
@@ -462,11 +545,7 @@ int32_t crypto_hal_set_peer_random(void *context,
 	    bn_num_bytes(owner_random_bn), hexbuf4);
 	OPENSSL_free(hexbuf4);
 #endif
-	ctx = BN_CTX_new();
-	if (!ctx) {
-		LOG(LOG_ERROR, "BN context new fail\n");
-		goto error;
-	}
+	ctx = key_ex_data->_bn_ctx;
 
 	key = key_ex_data->_key;
 	group = EC_KEY_get0_group(key);
@@ -570,9 +649,6 @@ error:
 	if (Shy_bn) {
 		BN_clear_free(Shy_bn);
 	}
-	if (ctx) {
-		BN_CTX_free(ctx);
-	}
 	if (shx) {
 		fdo_free(shx);
 	}
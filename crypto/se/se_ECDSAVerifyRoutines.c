@@ -43,6 +43,49 @@ int32_t crypto_hal_sig_verify(uint8_t key_encoding, int key_algorithm,
 			      uint32_t key_param2Length)
 {
 	uint8_t hash[SHA256_DIGEST_SIZE] = {0};
+
+	if (NULL == message || 0 == message_length) {
+		LOG(LOG_ERROR, "Invalid arguments!\n");
+		return -1;
+	}
+
+	if (0 != fdo_crypto_hash((uint8_t *)message, message_length, hash,
+				 BUFF_SIZE_32_BYTES)) {
+		return -1;
+	}
+
+	return crypto_hal_sig_verify_digest(key_encoding, key_algorithm, hash,
+					    sizeof(hash), message_signature,
+					    signature_length, key_param1,
+					    key_param1Length, key_param2,
+					    key_param2Length);
+}
+
+/**
+ * Verify an ECC P-256 signature over a SHA-256 message digest, for callers
+ * that hash the signed data as it is produced.
+ * @param key_encoding - encoding type.
+ * @param key_algorithm - public key algorithm.
+ * @param digest - SHA-256 digest of the message.
+ * @param digest_length - size of digest.
+ * @param message_signature - pointer of type uint8_t, holds a valid
+ *			ecdsa signature in big-endian format
+ * @param signature_length - size of signature, type unsigned int.
+ * @param key_param1 - pointer of type uint8_t, holds the public key.
+ * @param key_param1Length - size of public key, type size_t.
+ * @param key_param2 - not used.
+ * @param key_param2Length - not used
+ * @return 0 if true, else -1.
+ */
+int32_t crypto_hal_sig_verify_digest(uint8_t key_encoding, int key_algorithm,
+				     const uint8_t *digest, size_t digest_length,
+				     const uint8_t *message_signature,
+				     uint32_t signature_length,
+				     const uint8_t *key_param1,
+				     uint32_t key_param1Length,
+				     const uint8_t *key_param2,
+				     uint32_t key_param2Length)
+{
 	bool verified = false;
 	const unsigned char *pub_key = (const unsigned char *)key_param1;
 	uint8_t raw_key[BUFF_SIZE_64_BYTES];
@@ -61,18 +104,12 @@ int32_t crypto_hal_sig_verify(uint8_t key_encoding, int key_algorithm,
 	}
 
 	if (NULL == message_signature || 0 == signature_length ||
-	    NULL == message || 0 == message_length) {
+	    NULL == digest || digest_length != SHA256_DIGEST_SIZE) {
 		LOG(LOG_ERROR, "Invalid arguments!\n");
 		ret = -1;
 		goto err;
 	}
 
-	if (0 != fdo_crypto_hash((uint8_t *)message, message_length, hash,
-				 BUFF_SIZE_32_BYTES)) {
-		ret = -1;
-		goto err;
-	}
-
 	/* SE requires that the public key and signature be present in the raw
 	 * format i.e 64Byte rep of r and s. The following api will use the
 	 * required API calls from openssl/mbedtls for the decoding operation
@@ -87,7 +124,7 @@ int32_t crypto_hal_sig_verify(uint8_t key_encoding, int key_algorithm,
 	}
 
 	if (ATCA_SUCCESS !=
-	    atcab_verify_extern(hash, raw_sig, raw_key, &verified)) {
+	    atcab_verify_extern(digest, raw_sig, raw_key, &verified)) {
 		LOG(LOG_ERROR, "Verify command failed\n");
 		ret = -1;
 		goto err;
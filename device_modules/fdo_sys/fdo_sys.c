@@ -54,6 +54,7 @@ int fdo_sys(fdo_sdk_si_type type,
 	uint16_t *num_module_messages, bool *has_more, bool *is_more, size_t mtu)
 {
 	int strcmp_filedesc = 1;
+	int strcmp_filehash = 1;
 	int strcmp_write = 1;
 	int strcmp_exec = 1;
 	int strcmp_execcb = 1;
@@ -61,6 +62,8 @@ int fdo_sys(fdo_sdk_si_type type,
 	int strcmp_fetch = 1;
 	int result = FDO_SI_INTERNAL_ERROR;
 	uint8_t *bin_data = NULL;
+	const uint8_t *write_data_view = NULL;
+	int hash_type = 0;
 	size_t bin_len = 0;
 	size_t exec_array_index = 0;
 	size_t status_cb_array_length = 0;
@@ -73,7 +76,7 @@ int fdo_sys(fdo_sdk_si_type type,
 		case FDO_SI_START:
 			// Initialize module's CBOR Reader/Writer objects.
 			fdow = ModuleAlloc(sizeof(fdow_t));
-			if (!fdow_init(fdow) || !fdo_block_alloc_with_size(&fdow->b, MOD_MAX_BUFF_SIZE)) {
+			if (!fdow_init(fdow) || !fdo_block_alloc_pooled(&fdow->b, MOD_MAX_BUFF_SIZE)) {
 #ifdef DEBUG_LOGS
 				printf(
 					"Module fdo_sys - FDOW Initialization/Allocation failed!\n");
@@ -82,11 +85,11 @@ int fdo_sys(fdo_sdk_si_type type,
 				goto end;
 			}
 
+			// the FDOR reads the received values in place, so it needs no buffer of its own
 			fdor = ModuleAlloc(sizeof(fdor_t));
-			if (!fdor_init(fdor) ||
-				!fdo_block_alloc_with_size(&fdor->b, MOD_MAX_BUFF_SIZE)) {
+			if (!fdor_init(fdor)) {
 #ifdef DEBUG_LOGS
-				printf("Module fdo_sys - FDOR Initialization/Allocation failed!\n");
+				printf("Module fdo_sys - FDOR Initialization failed!\n");
 #endif
 				goto end;
 			}
@@ -108,7 +111,7 @@ int fdo_sys(fdo_sdk_si_type type,
 				ModuleFree(fdow);
 			}
 			if (fdor) {
-				fdor_flush(fdor);
+				fdor_view_flush(fdor);
 				ModuleFree(fdor);
 			}
 			result = FDO_SI_SUCCESS;
@@ -202,10 +205,9 @@ int fdo_sys(fdo_sdk_si_type type,
 				// if anything goes wrong, EOT will be sent now/next, regardless
 				result = FDO_SI_SUCCESS;
 
-				// if file size is 0 or has changed since first read or the seek/offset
-				// point is more that file size (maybe file is corrupted), finish file transfer
-				if (file_sz == 0 || file_sz != get_file_sz(filename) ||
-					file_seek_pos > file_sz) {
+				// if file size is 0 or the seek/offset point is more that file size
+				// (maybe file is corrupted), finish file transfer
+				if (file_sz == 0 || file_seek_pos >= file_sz) {
 				// file is empty or doesn't exist
 #ifdef DEBUG_LOGS
 					printf("Module fdo_sys - Empty/Invalid content for fdo_sys:data in %s\n",
@@ -236,11 +238,13 @@ int fdo_sys(fdo_sdk_si_type type,
 						goto end;
 					}
 
-					if (!read_buffer_from_file_from_pos(filename, bin_data, bin_len, file_seek_pos)) {
+					// fails if the file has changed since the transfer began
+					if (!fdo_sys_read_chunk(bin_data, bin_len)) {
 #ifdef DEBUG_LOGS
 						printf("Module fdo_sys - Failed to read fdo_sys:data content from %s\n",
 							filename);
 #endif
+						fdo_sys_read_end();
 						if (!write_eot(module_message, fetch_data_status)) {
 #ifdef DEBUG_LOGS
 							printf("Module fdo_sys - Failed to respond with fdo_sys:eot\n");
@@ -317,13 +321,15 @@ int fdo_sys(fdo_sdk_si_type type,
 			// Process the received Owner ServiceInfo contained within 'fdor', here.
 		strcmp_s(module_message, FDO_MODULE_MSG_LEN, "filedesc",
 					&strcmp_filedesc);
+		strcmp_s(module_message, FDO_MODULE_MSG_LEN, "filehash",
+					&strcmp_filehash);
 		strcmp_s(module_message, FDO_MODULE_MSG_LEN, "write", &strcmp_write);
 		strcmp_s(module_message, FDO_MODULE_MSG_LEN, "exec", &strcmp_exec);
 		strcmp_s(module_message, FDO_MODULE_MSG_LEN, "exec_cb", &strcmp_execcb);
 		strcmp_s(module_message, FDO_MODULE_MSG_LEN, "status_cb", &strcmp_statuscb);
 		strcmp_s(module_message, FDO_MODULE_MSG_LEN, "fetch", &strcmp_fetch);
 
-		if (strcmp_filedesc != 0 && strcmp_exec != 0 &&
+		if (strcmp_filedesc != 0 && strcmp_filehash != 0 && strcmp_exec != 0 &&
 					strcmp_write != 0 && strcmp_execcb != 0 &&
 					strcmp_statuscb != 0 && strcmp_fetch != 0) {
 #ifdef DEBUG_LOGS
@@ -332,18 +338,9 @@ int fdo_sys(fdo_sdk_si_type type,
 			return FDO_SI_CONTENT_ERROR;
 		}
 
-		// reset, copy CBOR data and initialize Parser.
-		fdo_block_reset(&fdor->b);
-		if (0 != memcpy_s(fdor->b.block, *module_val_sz,
-			module_val, *module_val_sz)) {
-#ifdef DEBUG_LOGS
-			printf("Module fdo_sys - Failed to copy buffer into temporary FDOR\n");
-#endif
-			goto end;
-		}
-		fdor->b.block_size = *module_val_sz;
-
-		if (!fdor_parser_init(fdor)) {
+		// initialize Parser directly over the received CBOR data, which stays
+		// valid until this callback returns
+		if (!fdor_view_init(fdor, module_val, *module_val_sz)) {
 #ifdef DEBUG_LOGS
 			printf("Module fdo_sys - Failed to init FDOR parser\n");
 #endif
@@ -404,11 +401,40 @@ int fdo_sys(fdo_sdk_si_type type,
 				goto end;
 			}
 
-			if (true ==
-				delete_old_file((const char *)filename)) {
+			// truncate the file and keep it open for the fdo_sys:write chunks
+			if (fdo_sys_write_begin((const char *)filename)) {
 				result = FDO_SI_SUCCESS;
 			}
 
+			goto end;
+		} else if (strcmp_filehash == 0) {
+
+			// Hash = [hashtype, bstr], the SHA-256 of the whole file
+			// announced by fdo_sys:filedesc, checked once it is written
+			if (!fdor_start_array(fdor) ||
+				!fdor_signed_int(fdor, &hash_type) ||
+				!fdor_byte_string_view(fdor, &write_data_view, &bin_len) ||
+				!fdor_end_array(fdor)) {
+#ifdef DEBUG_LOGS
+				printf("Module fdo_sys - Failed to read fdo_sys:filehash\n");
+#endif
+				goto end;
+			}
+
+			if (hash_type != MOD_FILEHASH_TYPE_SHA256) {
+#ifdef DEBUG_LOGS
+				printf("Module fdo_sys - Unsupported hash type in fdo_sys:filehash\n");
+#endif
+				return FDO_SI_CONTENT_ERROR;
+			}
+
+			if (!fdo_sys_write_expect(write_data_view, bin_len)) {
+#ifdef DEBUG_LOGS
+				printf("Module fdo_sys - fdo_sys:filehash without a file being written\n");
+#endif
+				return FDO_SI_CONTENT_ERROR;
+			}
+			result = FDO_SI_SUCCESS;
 			goto end;
 		} else if (strcmp_write == 0) {
 
@@ -434,28 +460,15 @@ int fdo_sys(fdo_sdk_si_type type,
 				return FDO_SI_SUCCESS;
 			}
 
-			bin_data = ModuleAlloc(bin_len * sizeof(uint8_t));
-			if (!bin_data) {
-#ifdef DEBUG_LOGS
-					printf("Module fdo_sys - Failed to alloc for fdo_sys:write\n");
-#endif
-				goto end;
-			}
-			if (memset_s(bin_data, bin_len, 0) != 0) {
-#ifdef DEBUG_LOGS
-				printf("Module fdo_sys - Failed to clear fdo_sys:write buffer\n");
-#endif
-				goto end;
-			}
-
-			if (!fdor_byte_string(fdor, bin_data, bin_len)) {
+			// write the file contents straight out of the received buffer
+			if (!fdor_byte_string_view(fdor, &write_data_view, &bin_len)) {
 #ifdef DEBUG_LOGS
 				printf("Module fdo_sys - Failed to read value for fdo_sys:write\n");
 #endif
 				goto end;
 			}
 
-			if (!process_data(FDO_SYS_MOD_MSG_WRITE, bin_data, bin_len, filename,
+			if (!process_data(FDO_SYS_MOD_MSG_WRITE, write_data_view, bin_len, filename,
 				NULL, NULL, NULL, NULL)) {
 #ifdef DEBUG_LOGS
 				printf("Module fdo_sys - Failed to process value for fdo_sys:write\n");
@@ -695,8 +708,24 @@ int fdo_sys(fdo_sdk_si_type type,
 				goto end;
 			}
 
-			// set the file size here so that we don't read any more than what we initially saw
-			file_sz = get_file_sz(filename);
+			// complete a transfer still being written, it may be the file
+			// to fetch
+			if (!fdo_sys_write_end()) {
+#ifdef DEBUG_LOGS
+				printf("Module fdo_sys - Failed to complete fdo_sys:write before fdo_sys:fetch\n");
+#endif
+				goto end;
+			}
+
+			// open the file and set the file size here so that we don't read any more
+			// than what we initially saw
+			if (!fdo_sys_read_begin(filename, &file_sz)) {
+#ifdef DEBUG_LOGS
+				printf("Module fdo_sys - Failed to open %s for fdo_sys:fetch\n",
+					filename);
+#endif
+				goto end;
+			}
 			hasmore = true;
 			// reset the file offset to read a new file
 			file_seek_pos = 0;
@@ -724,6 +753,7 @@ end:
 	}
 	if (result != FDO_SI_SUCCESS) {
 		// clean-up state variables/objects
+		fdo_sys_read_end();
 		hasmore = false;
 		file_sz = 0;
 		file_seek_pos = 0;
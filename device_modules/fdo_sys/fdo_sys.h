@@ -25,6 +25,15 @@
 // maximum length of the individual text arguments in the received exec array
 #define MOD_MAX_EXEC_ARG_LEN 100
 
+/*
+ * fdo_sys:filehash is a device extension to the standard fdo_sys module
+ * messages (see docs/setup.md): the Hash of the file being written through
+ * fdo_sys:filedesc/fdo_sys:write, checked once the file is complete. Stock
+ * Owners don't send it, and the file is then checked for size only.
+ */
+// hashtype of the fdo_sys:filehash value, SHA-256 (FDO Hash)
+#define MOD_FILEHASH_TYPE_SHA256 -16
+
 /**
  * The registered callback method for 'fdo_sys' ServiceInfo module.
  * The implementation is responsible for handling the received Owner ServiceInfo,
@@ -34,6 +43,8 @@
  * 'FDO_SI_SET_OSI', these represent the moduleMessage, CBOR-encoded (bstr-unwrapped)
  * module value i.e ServiceInfoVal cbor.bytes, as received in TO2.OwnerServiceInfo (Type 69),
  * and its length.
+ * The input module value points into the SDK's receive buffer, and is only valid
+ * until the callback returns. It must not be modified.
  * The implementation must parse and process the input module value
  * depending on the given module message, and return.
  *
@@ -8,6 +8,16 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
+
+// size of the staging buffer used to write out fdo_sys:write chunks
+#define FDO_SYS_XFER_BUFF_SIZE (64 * 1024)
+// disk space reserved ahead of an ongoing fdo_sys:write transfer
+#define FDO_SYS_PREALLOC_SIZE (1024 * 1024)
+// longest wait for fdo_sys:exec, in ms, between checks on the process
+#define FDO_SYS_EXEC_POLL_MS 100
+// longest wait, in ms, for a process to exit after SIGTERM, then SIGKILL
+#define FDO_SYS_EXEC_STOP_MS 2000
 
 #ifdef TARGET_OS_OPTEE
 #include <tee_api.h>
@@ -37,12 +47,15 @@ typedef enum {
 } fdoSysModMsg;
 
 void *ModuleAlloc(int size);
-bool process_data(fdoSysModMsg type, uint8_t *data, uint32_t dataLen,
+bool process_data(fdoSysModMsg type, const uint8_t *data, uint32_t dataLen,
 		  char *file_name, char **command,
 		  bool *status_iscomplete, int *status_resultcode,
 		  uint64_t *status_waitsec);
 
-size_t get_file_sz(char const *filename);
-bool read_buffer_from_file_from_pos(const char *filename, uint8_t *buffer, size_t size, int from);
-bool delete_old_file(const char *file_name);
+bool fdo_sys_write_begin(const char *filename);
+bool fdo_sys_write_expect(const uint8_t *digest, size_t digest_len);
+bool fdo_sys_write_end(void);
+bool fdo_sys_read_begin(const char *filename, size_t *file_sz);
+bool fdo_sys_read_chunk(uint8_t *buffer, size_t size);
+bool fdo_sys_read_end(void);
 #endif /* __SYS_UTILS_H__ */
@@ -3,7 +3,14 @@
  * SPDX-License-Identifier: Apache 2.0
  */
 
+// for fallocate()
+#define _GNU_SOURCE
 #include "safe_lib.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/stat.h>
@@ -11,9 +18,51 @@
 #include <unistd.h>
 #include "fdo_sys_utils.h"
 #include "fdo_sys.h"
+#include "fdoCryptoHal.h"
 
-// Process ID of the process created by fdo_sys:exec_cb
-static pid_t exec_pid = -1;
+/*
+ * Process created by fdo_sys:exec or fdo_sys:exec_cb. Its stdout and stderr
+ * go to a pipe, that is drained without blocking whenever the process is
+ * checked on.
+ */
+typedef struct {
+	pid_t pid;
+	// read end of the output pipe, -1 once closed
+	int out_fd;
+} fdo_sys_exec_t;
+
+static fdo_sys_exec_t exec_proc = {-1, -1};
+
+/*
+ * State of a streaming file transfer (fdo_sys:write or fdo_sys:fetch).
+ * The descriptor stays open from the first to the last chunk. Written
+ * content is hashed as it passes through, and checked against the SHA-256
+ * given by fdo_sys:filehash, if the Owner sent one.
+ */
+typedef struct {
+	int fd;
+	// file offset at which the transfer started
+	size_t base;
+	// bytes transferred so far
+	size_t pos;
+	// end of the preallocated space (write) or file size at open (fetch)
+	size_t limit;
+	// staged data not yet written to fd (write only)
+	uint8_t *buf;
+	size_t buf_len;
+	// hash of the content written so far (write only)
+	void *hash_ctx;
+	// digest of the complete content, given by the Owner (write only)
+	bool has_expected;
+	uint8_t expected[SHA256_DIGEST_SIZE];
+	// file being written, removed if the transfer fails (write only)
+	char path[FILE_NAME_LEN];
+} fdo_sys_transfer_t;
+
+static fdo_sys_transfer_t write_xfer = {-1, 0, 0, 0, NULL, 0, NULL, false,
+					{0}, {0}};
+static fdo_sys_transfer_t read_xfer = {-1, 0, 0, 0, NULL, 0, NULL, false,
+				       {0}, {0}};
 
 /* Allow only alphanumeric file name either shell or python script*/
 static bool is_valid_filename(const char *fname)
@@ -112,13 +161,561 @@ end:
 	return buf;
 }
 
-bool process_data(fdoSysModMsg type, uint8_t *data, uint32_t data_len,
+/**
+ * Release the descriptor, staging buffer and hash context of a transfer.
+ */
+static void transfer_reset(fdo_sys_transfer_t *xfer)
+{
+	if (xfer->fd >= 0) {
+		if (close(xfer->fd) != 0) {
+#ifdef DEBUG_LOGS
+			printf("fdo_sys : Failed to close transfer file\n");
+#endif
+		}
+	}
+	if (xfer->buf) {
+		ModuleFree(xfer->buf);
+	}
+	if (xfer->hash_ctx) {
+		crypto_hal_hash_free(xfer->hash_ctx);
+	}
+	xfer->fd = -1;
+	xfer->base = 0;
+	xfer->pos = 0;
+	xfer->limit = 0;
+	xfer->buf_len = 0;
+	xfer->hash_ctx = NULL;
+	xfer->has_expected = false;
+	if (memset_s(xfer->expected, sizeof(xfer->expected), 0) != 0 ||
+	    memset_s(xfer->path, sizeof(xfer->path), 0) != 0) {
+#ifdef DEBUG_LOGS
+		printf("fdo_sys : Failed to clear transfer state\n");
+#endif
+	}
+}
+
+/**
+ * Drop the current fdo_sys:write transfer, and what it has written so far:
+ * a file it created or truncated is removed, a file it appended to is cut
+ * back to its previous size.
+ */
+static void write_discard(void)
+{
+	if (write_xfer.fd < 0) {
+		return;
+	}
+	if (write_xfer.base == 0) {
+		if (unlink(write_xfer.path) != 0) {
+#ifdef DEBUG_LOGS
+			printf("fdo_sys write : Failed to remove %s\n",
+			       write_xfer.path);
+#endif
+		}
+	} else if (ftruncate(write_xfer.fd, (off_t)write_xfer.base) != 0) {
+#ifdef DEBUG_LOGS
+		printf("fdo_sys write : Failed to restore %s\n", write_xfer.path);
+#endif
+	}
+	transfer_reset(&write_xfer);
+}
+
+/**
+ * Finalize the hash of the current fdo_sys:write transfer, and check it
+ * against the digest given by the Owner, if any.
+ */
+static bool write_digest(void)
+{
+	uint8_t digest[SHA256_DIGEST_SIZE] = {0};
+	int result = 1;
+
+	if (!write_xfer.hash_ctx ||
+	    crypto_hal_hash_final(write_xfer.hash_ctx, digest,
+				  sizeof(digest)) != 0) {
+#ifdef DEBUG_LOGS
+		printf("fdo_sys write : Failed to compute transfer hash\n");
+#endif
+		return false;
+	}
+
+#ifdef DEBUG_LOGS
+	{
+		size_t i = 0;
+
+		printf("fdo_sys write : %zu bytes transferred, SHA-256 ",
+		       write_xfer.pos);
+		for (i = 0; i < sizeof(digest); i++) {
+			printf("%02x", digest[i]);
+		}
+		printf("\n");
+	}
+#endif
+
+	if (!write_xfer.has_expected) {
+		return true;
+	}
+	if (memcmp_s(digest, sizeof(digest), write_xfer.expected,
+		     sizeof(write_xfer.expected), &result) != 0 || result != 0) {
+#ifdef DEBUG_LOGS
+		printf("fdo_sys write : SHA-256 mismatch at end of transfer\n");
+#endif
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Write out the staged data of the current fdo_sys:write transfer.
+ */
+static bool write_flush(void)
+{
+	size_t done = 0;
+	ssize_t n = 0;
+
+	while (done < write_xfer.buf_len) {
+		n = write(write_xfer.fd, write_xfer.buf + done,
+			  write_xfer.buf_len - done);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+#ifdef DEBUG_LOGS
+			printf("fdo_sys write : Failed to write, errno=%d\n", errno);
+#endif
+			return false;
+		}
+		done += (size_t)n;
+	}
+	write_xfer.buf_len = 0;
+	return true;
+}
+
+/**
+ * Open the given file for an fdo_sys:write transfer, either truncating it
+ * (O_TRUNC) or appending to it (O_APPEND).
+ */
+static bool write_open(const char *filename, int mode)
+{
+	struct stat st;
+
+	if (strcpy_s(write_xfer.path, sizeof(write_xfer.path), filename) != 0) {
+		return false;
+	}
+	write_xfer.fd = open(filename, O_WRONLY | O_CREAT | O_CLOEXEC | mode,
+			     0666);
+	if (write_xfer.fd < 0) {
+#ifdef DEBUG_LOGS
+		printf("fdo_sys write : Failed to open file(path): %s\n", filename);
+#endif
+		return false;
+	}
+
+	if (fstat(write_xfer.fd, &st) != 0) {
+		transfer_reset(&write_xfer);
+		return false;
+	}
+	write_xfer.base = (size_t)st.st_size;
+	write_xfer.limit = write_xfer.base;
+
+	write_xfer.buf = ModuleAlloc(FDO_SYS_XFER_BUFF_SIZE);
+	write_xfer.hash_ctx = crypto_hal_hash_init(FDO_CRYPTO_HASH_TYPE_SHA_256);
+	if (!write_xfer.buf || !write_xfer.hash_ctx) {
+		transfer_reset(&write_xfer);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Start a new fdo_sys:write transfer into the given file, truncating any
+ * existing content. A transfer that is still open is completed first.
+ */
+bool fdo_sys_write_begin(const char *filename)
+{
+	if (!filename) {
+		return false;
+	}
+
+	if (!fdo_sys_write_end()) {
+		return false;
+	}
+	return write_open(filename, O_TRUNC);
+}
+
+/**
+ * Set the SHA-256 that the content of the current fdo_sys:write transfer
+ * must have once complete.
+ */
+bool fdo_sys_write_expect(const uint8_t *digest, size_t digest_len)
+{
+	if (!digest || digest_len != SHA256_DIGEST_SIZE || write_xfer.fd < 0) {
+		return false;
+	}
+	if (memcpy_s(write_xfer.expected, sizeof(write_xfer.expected), digest,
+		     digest_len) != 0) {
+		return false;
+	}
+	write_xfer.has_expected = true;
+	return true;
+}
+
+/**
+ * Append a chunk to the current fdo_sys:write transfer.
+ * Chunks are staged and written out in FDO_SYS_XFER_BUFF_SIZE units, while
+ * disk space is reserved ahead in FDO_SYS_PREALLOC_SIZE extents.
+ */
+static bool write_chunk(const uint8_t *data, size_t data_len)
+{
+	size_t copy_len = 0;
+
+	if (crypto_hal_hash_update(write_xfer.hash_ctx, data, data_len) != 0) {
+		return false;
+	}
+
+	if (write_xfer.base + write_xfer.pos + data_len > write_xfer.limit) {
+		// best effort, not all filesystems support it
+		if (fallocate(write_xfer.fd, FALLOC_FL_KEEP_SIZE,
+			      (off_t)write_xfer.limit,
+			      FDO_SYS_PREALLOC_SIZE) == 0) {
+			write_xfer.limit += FDO_SYS_PREALLOC_SIZE;
+		} else {
+			write_xfer.limit = SIZE_MAX;
+		}
+	}
+
+	while (data_len > 0) {
+		copy_len = FDO_SYS_XFER_BUFF_SIZE - write_xfer.buf_len;
+		if (copy_len > data_len) {
+			copy_len = data_len;
+		}
+		if (memcpy_s(write_xfer.buf + write_xfer.buf_len, copy_len, data,
+			     copy_len) != 0) {
+			return false;
+		}
+		write_xfer.buf_len += copy_len;
+		write_xfer.pos += copy_len;
+		data += copy_len;
+		data_len -= copy_len;
+
+		if (write_xfer.buf_len == FDO_SYS_XFER_BUFF_SIZE &&
+		    !write_flush()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Complete the current fdo_sys:write transfer, if any: write out the staged
+ * data, release unused preallocated space and verify that the file holds
+ * exactly the bytes that were received, with the expected SHA-256. A
+ * transfer that fails the checks is discarded.
+ */
+bool fdo_sys_write_end(void)
+{
+	struct stat st;
+	bool ret = false;
+
+	if (write_xfer.fd < 0) {
+		return true;
+	}
+
+	if (!write_flush()) {
+		goto end;
+	}
+
+	if (ftruncate(write_xfer.fd,
+		      (off_t)(write_xfer.base + write_xfer.pos)) != 0 ||
+	    fstat(write_xfer.fd, &st) != 0 ||
+	    (size_t)st.st_size != write_xfer.base + write_xfer.pos) {
+#ifdef DEBUG_LOGS
+		printf("fdo_sys write : File size mismatch at end of transfer\n");
+#endif
+		goto end;
+	}
+
+	ret = write_digest();
+end:
+	if (ret) {
+		transfer_reset(&write_xfer);
+	} else {
+		write_discard();
+	}
+	return ret;
+}
+
+/**
+ * Start a new fdo_sys:fetch transfer from the given file and return its
+ * size. The size is fixed for the duration of the transfer.
+ */
+bool fdo_sys_read_begin(const char *filename, size_t *file_sz)
+{
+	struct stat st;
+
+	if (!filename || !file_sz) {
+		return false;
+	}
+
+	fdo_sys_read_end();
+	*file_sz = 0;
+
+	read_xfer.fd = open(filename, O_RDONLY | O_CLOEXEC);
+	if (read_xfer.fd < 0) {
+		// missing file is reported to the Owner as an empty transfer
+		return true;
+	}
+
+	if (fstat(read_xfer.fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+		transfer_reset(&read_xfer);
+		return true;
+	}
+	(void)posix_fadvise(read_xfer.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	read_xfer.limit = (size_t)st.st_size;
+	*file_sz = read_xfer.limit;
+	return true;
+}
+
+/**
+ * Read the next 'size' bytes of the current fdo_sys:fetch transfer into
+ * the given buffer (pre-allocated memory). Fails if the file has changed
+ * size since the transfer began.
+ */
+bool fdo_sys_read_chunk(uint8_t *buffer, size_t size)
+{
+	struct stat st;
+	size_t done = 0;
+	ssize_t n = 0;
+
+	if (!buffer || read_xfer.fd < 0 ||
+	    read_xfer.pos + size > read_xfer.limit) {
+		return false;
+	}
+
+	if (fstat(read_xfer.fd, &st) != 0 ||
+	    (size_t)st.st_size != read_xfer.limit) {
+#ifdef DEBUG_LOGS
+		printf("fdo_sys fetch : File changed during transfer\n");
+#endif
+		return false;
+	}
+
+	while (done < size) {
+		n = pread(read_xfer.fd, buffer + done, size - done,
+			  (off_t)(read_xfer.pos + done));
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		done += (size_t)n;
+	}
+	read_xfer.pos += size;
+
+	if (read_xfer.pos == read_xfer.limit) {
+		return fdo_sys_read_end();
+	}
+	return true;
+}
+
+/**
+ * Complete the current fdo_sys:fetch transfer, if any.
+ */
+bool fdo_sys_read_end(void)
+{
+	if (read_xfer.fd < 0) {
+		return true;
+	}
+#ifdef DEBUG_LOGS
+	if (read_xfer.pos == read_xfer.limit) {
+		printf("fdo_sys fetch : %zu bytes transferred\n", read_xfer.pos);
+	}
+#endif
+	transfer_reset(&read_xfer);
+	return true;
+}
+
+/**
+ * Spawn the given command, with its output redirected to a pipe.
+ * posix_spawn() is used rather than fork(), so that the SDK process, its
+ * memory and descriptors are never duplicated.
+ */
+static bool exec_start(char **command)
+{
+	posix_spawn_file_actions_t actions;
+	int fds[2] = {-1, -1};
+	int flags = 0;
+	bool ret = false;
+
+	if (pipe2(fds, O_CLOEXEC) != 0) {
+		return false;
+	}
+	if (posix_spawn_file_actions_init(&actions) != 0) {
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+
+	if (posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO) != 0 ||
+	    posix_spawn_file_actions_adddup2(&actions, fds[1], STDERR_FILENO) != 0 ||
+	    posix_spawn(&exec_proc.pid, command[0], &actions, NULL, command,
+			environ) != 0) {
+		exec_proc.pid = -1;
+		close(fds[0]);
+		goto end;
+	}
+
+	flags = fcntl(fds[0], F_GETFL);
+	if (flags == -1 || fcntl(fds[0], F_SETFL, flags | O_NONBLOCK) == -1) {
+		// the output is not captured, rather than risk blocking on it
+		close(fds[0]);
+		fds[0] = -1;
+	}
+	exec_proc.out_fd = fds[0];
+	ret = true;
+end:
+	posix_spawn_file_actions_destroy(&actions);
+	close(fds[1]);
+	return ret;
+}
+
+/**
+ * Copy out whatever the process has written so far, without blocking.
+ * The pipe is closed at end of file.
+ */
+static void exec_drain(void)
+{
+	uint8_t buf[512];
+	ssize_t n = 0;
+
+	while (exec_proc.out_fd >= 0) {
+		n = read(exec_proc.out_fd, buf, sizeof(buf));
+		if (n > 0) {
+			(void)fwrite(buf, 1, (size_t)n, stdout);
+			continue;
+		}
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n < 0 && errno == EAGAIN) {
+			break;
+		}
+		close(exec_proc.out_fd);
+		exec_proc.out_fd = -1;
+	}
+	fflush(stdout);
+}
+
+/**
+ * Forget the process: release the pipe and clear the pid, so that another
+ * exec instruction can run.
+ */
+static void exec_release(void)
+{
+	if (exec_proc.out_fd >= 0) {
+		close(exec_proc.out_fd);
+		exec_proc.out_fd = -1;
+	}
+	exec_proc.pid = -1;
+}
+
+/**
+ * Check whether the process has terminated, without blocking.
+ * @param exit_status - exit status of the process, or 128 + the number of the
+ * signal that terminated it
+ * @return 1 if the process has terminated, 0 if it is still running, -1 on error
+ */
+static int exec_check(int *exit_status)
+{
+	int status = 0;
+	pid_t pid = 0;
+
+	exec_drain();
+	do {
+		pid = waitpid(exec_proc.pid, &status, WNOHANG);
+	} while (pid < 0 && errno == EINTR);
+	if (pid < 0) {
+		// e.g. ECHILD, there is no process left to wait for
+		exec_release();
+		return -1;
+	}
+	if (pid == 0) {
+		return 0;
+	}
+
+	exec_drain();
+	// the output of any process left behind isn't waited for
+	exec_release();
+	*exit_status = WIFEXITED(status) ? WEXITSTATUS(status) :
+		       128 + WTERMSIG(status);
+	return 1;
+}
+
+/**
+ * Wait for the process to terminate, copying out its output as it comes.
+ * @return true if the process has terminated, false on error
+ */
+static bool exec_wait(int *exit_status)
+{
+	struct pollfd pfd;
+	int done = 0;
+
+	while ((done = exec_check(exit_status)) == 0) {
+		pfd.fd = exec_proc.out_fd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		// woken up by output, else check on the process periodically
+		(void)poll(&pfd, exec_proc.out_fd >= 0 ? 1 : 0, FDO_SYS_EXEC_POLL_MS);
+	}
+	return done > 0;
+}
+
+/**
+ * Wait up to timeout_ms for the process to terminate, copying out its output.
+ * @return 1 if the process has terminated, 0 if it is still running, -1 on error
+ */
+static int exec_reap(int timeout_ms)
+{
+	int exit_status = 0;
+	int waited = 0;
+	int done = 0;
+
+	while ((done = exec_check(&exit_status)) == 0 && waited < timeout_ms) {
+		(void)poll(NULL, 0, FDO_SYS_EXEC_POLL_MS);
+		waited += FDO_SYS_EXEC_POLL_MS;
+	}
+	return done;
+}
+
+/**
+ * Terminate the process, if any, and release the pipe. The process is asked
+ * to exit with SIGTERM, and killed with SIGKILL if it is still running after
+ * FDO_SYS_EXEC_STOP_MS, so that it isn't left behind as a zombie.
+ */
+static void exec_stop(void)
+{
+	if (exec_proc.pid > 0) {
+		kill(exec_proc.pid, SIGTERM);
+		if (exec_reap(FDO_SYS_EXEC_STOP_MS) == 0) {
+			kill(exec_proc.pid, SIGKILL);
+			if (exec_reap(FDO_SYS_EXEC_STOP_MS) == 0) {
+#ifdef DEBUG_LOGS
+				printf("fdo_sys : Process %d did not exit after SIGKILL\n",
+				       (int)exec_proc.pid);
+#endif
+			}
+		}
+	}
+	exec_release();
+}
+
+bool process_data(fdoSysModMsg type, const uint8_t *data, uint32_t data_len,
 		  char *file_name, char **command, bool *status_iscomplete, int *status_resultcode,
 		  uint64_t *status_waitsec)
 {
 	bool ret = false;
-	FILE *fp = NULL;
-	int status = -1;
+	int exit_status = 0;
+	int done = 0;
 
 	// For writing to a file
 	if (type == FDO_SYS_MOD_MSG_WRITE) {
@@ -135,19 +732,15 @@ bool process_data(fdoSysModMsg type, uint8_t *data, uint32_t data_len,
 #endif
 			return false;
 		}
-		fp = fopen(file_name, "a");
-		if (!fp) {
-#ifdef DEBUG_LOGS
-			printf("fdo_sys write : Failed to open file(path): %s\n", file_name);
-#endif
+		// without a preceding fdo_sys:filedesc, append to the file
+		if (write_xfer.fd < 0 && !write_open(file_name, O_APPEND)) {
 			return false;
 		}
 
 		printf("fdo_sys write : %"PRIu32 " bytes being written to the file %s\n",
 			data_len, file_name);
 
-		if (fwrite(data, sizeof(char), data_len, fp) !=
-		    (size_t)data_len) {
+		if (!write_chunk(data, data_len)) {
 #ifdef DEBUG_LOGS
 			printf("fdo_sys write : Failed to write\n");
 #endif
@@ -157,6 +750,12 @@ bool process_data(fdoSysModMsg type, uint8_t *data, uint32_t data_len,
 		goto end;
 	}
 
+	// any other instruction completes a file being written, in particular
+	// the script about to be executed must be complete on disk
+	if (!fdo_sys_write_end()) {
+		goto end;
+	}
+
 	// For exec/exec_cb call
 	if (type == FDO_SYS_MOD_MSG_EXEC || type == FDO_SYS_MOD_MSG_EXEC_CB) {
 
@@ -174,67 +773,47 @@ bool process_data(fdoSysModMsg type, uint8_t *data, uint32_t data_len,
 			return false;
 		}
 
-		if (exec_pid != -1) {
+		if (exec_proc.pid != -1) {
 #ifdef DEBUG_LOGS
 			printf("fdo_sys exec/exec_cb : An exec instruction is currently in progress\n");
 #endif
 			return false;
 		}
 
-		printf("fdo_sys exec : Executing command...\n");
-		exec_pid = fork();
-		if (exec_pid < 0) {
-			// error
+		if (type == FDO_SYS_MOD_MSG_EXEC_CB &&
+		    (!status_iscomplete || !status_resultcode || !status_waitsec)) {
 #ifdef DEBUG_LOGS
-			printf("fdo_sys exec : Failed to fork.\n");
+			printf("fdo_sys exec_cb : Invalid params\n");
 #endif
 			return false;
-		} else if (exec_pid == 0) {
-			// child process
-			status = execv(command[0], command);
-			if (status == -1) {
-#ifdef DEBUG_LOGS
-				printf("fdo_sys exec : Failed to execute command.\n");
-#endif
-				goto end;
-			}
-		} else {
-			// parent process
-			// if exec, block until process completes
-			if (type == FDO_SYS_MOD_MSG_EXEC) {
-				waitpid(exec_pid, &status, 0);
-				if (WIFEXITED(status)) {
-					if (WEXITSTATUS(status) != 0) {
+		}
+
+		printf("fdo_sys exec : Executing command...\n");
+		if (!exec_start(command)) {
 #ifdef DEBUG_LOGS
-						printf("fdo_sys exec : Proces execution failed.\n");
+			printf("fdo_sys exec : Failed to spawn the process.\n");
 #endif
-						goto end;
+			return false;
+		}
 
-					} else {
+		// if exec, block until process completes
+		if (type == FDO_SYS_MOD_MSG_EXEC) {
+			if (!exec_wait(&exit_status) || exit_status != 0) {
 #ifdef DEBUG_LOGS
-						printf("fdo_sys exec : Process execution completed.\n");
+				printf("fdo_sys exec : Proces execution failed.\n");
 #endif
-						// reset the process ID since execution is done
-						exec_pid = -1;
-						ret = true;
-						goto end;
-					}
-				}
-			} else {
-				if (!status_iscomplete || !status_resultcode || !status_waitsec) {
+				goto end;
+			}
 #ifdef DEBUG_LOGS
-					printf("fdo_sys exec_cb : Invalid params\n");
+			printf("fdo_sys exec : Process execution completed.\n");
 #endif
-					return ret;
-				}
-				*status_iscomplete = false;
-				*status_resultcode = 0;
-				*status_waitsec = 5;
-				ret = true;
+		} else {
+			*status_iscomplete = false;
+			*status_resultcode = 0;
+			*status_waitsec = 5;
 #ifdef DEBUG_LOGS
-				printf("fdo_sys exec_cb : Process execution started\n");
+			printf("fdo_sys exec_cb : Process execution started\n");
 #endif
-			}
 		}
 
 		ret = true;
@@ -249,44 +828,44 @@ bool process_data(fdoSysModMsg type, uint8_t *data, uint32_t data_len,
 #endif
 			return ret;
 		}
-		if (*status_iscomplete && exec_pid < 0) {
+		if (*status_iscomplete && exec_proc.pid < 0) {
 			// final Acknowledgement message from the Owner. NO-OP
 			ret = true;
 			return ret;
 		}
-		if (*status_iscomplete && exec_pid > 0) {
+		if (exec_proc.pid < 0) {
+#ifdef DEBUG_LOGS
+			printf("fdo_sys status_cb : No process is being executed\n");
+#endif
+			return ret;
+		}
+		if (*status_iscomplete) {
 			// kill the process as requested by the Owner
-			kill(exec_pid, SIGTERM);
+			exec_stop();
 			*status_iscomplete = true;
 			*status_resultcode = 0;
 			*status_waitsec = 0;
 			ret = true;
 			goto end;
-		} else {
-			// check for process status every second, until the given waitsec
-			int wait_timer = *status_waitsec;
-			while (wait_timer > 0) {
-				if (waitpid(exec_pid, &status, WNOHANG) == -1) {
+		}
+
+		// report the process status right away, the Owner asks again
+		// after waitSec if it's still running
+		done = exec_check(&exit_status);
+		if (done < 0) {
 #ifdef DEBUG_LOGS
-					printf("fdo_sys status_cb : Error occurred while checking process status\n");
+			printf("fdo_sys status_cb : Error occurred while checking process status\n");
 #endif
-					return ret;
-				}
-				if (WIFEXITED(status)) {
-					*status_resultcode = WEXITSTATUS(status);
-					*status_iscomplete = true;
-					*status_waitsec = 0;
+			return ret;
+		}
+		if (done > 0) {
+			*status_resultcode = exit_status;
+			*status_iscomplete = true;
+			*status_waitsec = 0;
 #ifdef DEBUG_LOGS
-					printf("fdo_sys status_cb: Process execution completed\n");
+			printf("fdo_sys status_cb: Process execution completed\n");
 #endif
-					// reset the process ID since execution is done
-					exec_pid = -1;
-					ret = true;
-					goto end;
-				}
-				sleep(1);
-				wait_timer--;
-			}
+		} else {
 			*status_iscomplete = false;
 			*status_resultcode = 0;
 		}
@@ -296,103 +875,19 @@ bool process_data(fdoSysModMsg type, uint8_t *data, uint32_t data_len,
 
 	// For performing clean-up operations of module exit
 	if (type == FDO_SYS_MOD_MSG_EXIT) {
-		if (exec_pid > 0) {
-			// kill the process as a part of clea-up operations
-			kill(exec_pid, SIGTERM);
-		}
+		fdo_sys_read_end();
+		// kill the process as a part of clean-up operations
+		exec_stop();
 		ret = true;
 	}
 end:
-
-	if (fp) {
-		if (fclose(fp) == EOF) {
-#ifdef DEBUG_LOGS
-			printf("Fclose failed\n");
-#endif
-		}
+	// upon error, drop a partially written file transfer
+	if (!ret && type == FDO_SYS_MOD_MSG_WRITE) {
+		write_discard();
 	}
-	// upon error, kill the forked process
-	if (!ret && exec_pid > 0) {
-		kill(exec_pid, SIGTERM);
-		exec_pid = -1;
+	// upon error, kill the spawned process
+	if (!ret && exec_proc.pid > 0) {
+		exec_stop();
 	}
 	return ret;
 }
-
-bool delete_old_file(const char *filename)
-{
-	FILE *file = NULL;
-	bool ret = false;
-
-	file = fopen(filename, "w");
-	if (file) {
-		if (!fclose(file)) {
-			ret = true;
-		}
-	} else {
-		ret = true;
-	}
-	return ret;
-}
-
-/**
- * Return the length of the given file.
- */
-size_t get_file_sz(char const *filename)
-{
-	if (!filename || !filename[0]) {
-		return 0;
-	}
-	size_t file_length = 0;
-	FILE *fp = fopen(filename, "rb");
-
-	if (fp) {
-		if (fseek(fp, 0, SEEK_END) != 0) {
-			printf("fseek() failed in the file");
-			if (fclose(fp) == EOF) {
-				printf("Fclose Failed");
-			}
-			return 0;
-		}
-		file_length = ftell(fp);
-		if (fclose(fp) == EOF) {
-			printf("Fclose Failed");
-		}
-	}
-	return file_length;
-}
-
-/**
- * Read the filename's content (size bytes) into the given buffer (pre-allocated memory)
- * starting at the specified offset (from).
- */
-bool read_buffer_from_file_from_pos(const char *filename, uint8_t *buffer, size_t size, int from)
-{
-	FILE *file = NULL;
-	size_t bytes_read = 0;
-
-	file = fopen(filename, "rb");
-	if (!file) {
-		return false;
-	}
-
-	if (fseek(file, from, SEEK_SET) != 0) {
-		printf("fseek() failed in the file");
-		if (fclose(file) == EOF) {
-			printf("Fclose Failed");
-		}
-		return false;
-    }
-	bytes_read = fread(buffer, 1, size, file);
-	if (bytes_read != size) {
-		if (fclose(file) == EOF) {
-			printf("Fclose Failed");
-		}
-		return false;
-	}
-
-	if (fclose(file) == EOF) {
-		printf("Fclose Failed");
-	}
-	return true;
-}
@@ -27,7 +27,8 @@ typedef enum {
 	FDO_RESALE_NOT_READY,
 	FDO_WARNING,
 	FDO_ERROR,
-	FDO_ABORT
+	FDO_ABORT,
+	FDO_IN_PROGRESS
 } fdo_sdk_status;
 
 typedef enum {
@@ -44,11 +45,25 @@ extern bool useSelfSignedCerts;
 
 fdo_sdk_status fdo_sdk_run(void);
 
+// incremental fdo_sdk_run, for use from an application's event loop: call
+// again once fd (if not -1) is readable or wait_ms has elapsed. Responses and
+// retry delays aren't waited for, but DNS lookups, connecting (TLS included)
+// and sending, up to the fdo_sdk_set_timeout budget, and fdo_sys:exec still
+// block; see lib/fdo.c
+fdo_sdk_status fdo_sdk_step(uint32_t budget_ms, uint32_t *wait_ms, int *fd);
+
+// time budget of each network operation, in ms, 0 for the default
+void fdo_sdk_set_timeout(uint32_t timeout_ms);
+
+// stop fdo_sdk_run/fdo_sdk_step, which then return FDO_ABORT
+void fdo_sdk_cancel(void);
+
 fdo_sdk_status fdo_sdk_resale(void);
 
 fdo_sdk_device_state fdo_sdk_get_status(void);
 
-// callback for error handling
+// callback for error handling, also called with FDO_WARNING for each failed
+// DI/TO1/TO2 attempt; returning FDO_ABORT then stops the retries
 typedef int (*fdo_sdk_errorCB)(fdo_sdk_status type, fdo_sdk_error error_code);
 
 fdo_sdk_status fdo_sdk_init(fdo_sdk_errorCB error_handling_callback,
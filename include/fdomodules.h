@@ -47,6 +47,8 @@ typedef struct fdo_sdk_si_key_value {
 } fdo_sdk_si_key_value;
 
 // callback to module
+// In FDO_SI_SET_OSI, module_val points into the SDK's receive buffer: it is read-only
+// and only valid until the callback returns, so modules must copy anything they keep.
 typedef int (*fdo_sdk_service_infoCB)(fdo_sdk_si_type type,
 	char *module_message, uint8_t *module_val, size_t *module_val_sz,
 	uint16_t *num_module_messages, bool *has_more, bool *is_more, size_t mtu);
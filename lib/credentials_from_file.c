@@ -20,37 +20,51 @@
 
 static bool validate_state(fdo_sdk_device_status current_status);
 
+#ifndef NO_PERSISTENT_STORAGE
 /**
- * Write the Device Credentials blob, contains our state
- * @param dev_cred_file - pointer of type const char to which credentails are
- * to be written.
- * @param flags ///TO BE ADDED
- *
- *
- * @param ocred - pointer of type fdo_dev_cred_t, holds the credentials for
- * writing to dev_cred_file.
- * @return true if write and parsed correctly, otherwise false
+ * Allocate a CBOR writer for a credentials blob.
+ * @param size - size of the encode buffer.
+ * @return pointer to the writer, NULL on failure.
  */
-
-bool write_normal_device_credentials(const char *dev_cred_file,
-				     fdo_sdk_blob_flags flags,
-				     fdo_dev_cred_t *ocred)
+static fdow_t *alloc_cred_writer(size_t size)
 {
-	bool ret = true;
-
-	if (!ocred || !dev_cred_file) {
-		return false;
-	}
-#ifndef NO_PERSISTENT_STORAGE
-
 	fdow_t *fdow = fdo_alloc(sizeof(fdow_t));
+
 	if (!fdow || !fdow_init(fdow) ||
-		!fdo_block_alloc_with_size(&fdow->b, BUFF_SIZE_4K_BYTES) ||
+		!fdo_block_alloc_with_size(&fdow->b, size) ||
 		!fdow_encoder_init(fdow)) {
 		LOG(LOG_ERROR, "FDOW Initialization/Allocation failed!\n");
-		ret = false;
-		goto end;
+		if (fdow) {
+			fdow_flush(fdow);
+			fdo_free(fdow);
+		}
+		return NULL;
 	}
+	return fdow;
+}
+
+/**
+ * Free a CBOR writer allocated by alloc_cred_writer().
+ */
+static void free_cred_writer(fdow_t *fdow)
+{
+	if (fdow) {
+		fdow_flush(fdow);
+		fdo_free(fdow);
+	}
+}
+
+/**
+ * Encode the Device Credentials, our state & owner_blk, and set the block
+ * size to the encoded length.
+ * @param fdow - writer from alloc_cred_writer().
+ * @param ocred - pointer of type fdo_dev_cred_t, holds the credentials.
+ * @return true if encoded correctly, otherwise false
+ */
+static bool encode_normal_device_credentials(fdow_t *fdow,
+					     fdo_dev_cred_t *ocred)
+{
+	size_t encoded_cred_length = 0;
 
 	/**
 	 * Blob format: Complete DeviceCredential as per Section 3.4.1 of FDO Specification,
@@ -67,49 +81,96 @@ bool write_normal_device_credentials(const char *dev_cred_file,
 	 */
 	fdow_next_block(fdow, FDO_DI_SET_CREDENTIALS);
 	if (!fdow_start_array(fdow, 7)) {
-		ret = false;
-		goto end;
+		return false;
 	}
 	if (!fdow_signed_int(fdow, ocred->ST)) {
-		ret = false;
-		goto end;
+		return false;
 	}
 	if (!fdow_boolean(fdow, true)) {
-		ret = false;
-		goto end;
+		return false;
 	}
 	if (!fdow_signed_int(fdow, ocred->owner_blk->pv)) {
-		ret = false;
-		goto end;
+		return false;
 	}
 
 	if (!fdow_text_string(fdow, ocred->mfg_blk->d->bytes, ocred->mfg_blk->d->byte_sz)) {
-		ret = false;
-		goto end;
+		return false;
 	}
 	if (!fdow_byte_string(fdow, ocred->owner_blk->guid->bytes, ocred->owner_blk->guid->byte_sz)) {
-		ret = false;
-		goto end;
+		return false;
 	}
 	if (!fdo_rendezvous_list_write(fdow, ocred->owner_blk->rvlst)) {
-		ret = false;
-		goto end;
+		return false;
 	}
 	if (!fdo_hash_write(fdow, ocred->owner_blk->pkh)) {
-		ret = false;
-		goto end;
+		return false;
 	}
 	if (!fdow_end_array(fdow)) {
-		ret = false;
-		goto end;
+		return false;
 	}
-	size_t encoded_cred_length = 0;
 	if (!fdow_encoded_length(fdow, &encoded_cred_length) || encoded_cred_length == 0) {
 		LOG(LOG_ERROR, "Failed to get DeviceCredential encoded length\n");
+		return false;
+	}
+	fdow->b.block_size = encoded_cred_length;
+	return true;
+}
+
+/**
+ * Encode the Device Credentials Secret, and set the block size to the
+ * encoded length.
+ * @param fdow - writer from alloc_cred_writer().
+ * @return true if encoded correctly, otherwise false
+ */
+static bool encode_device_secret(fdow_t *fdow)
+{
+	size_t encoded_secret_length = 0;
+	fdo_byte_array_t **ovkey = getOVKey();
+
+	if (!ovkey || !*ovkey) {
+		return false;
+	}
+	/**
+	 * Blob format: DeviceCredential.DCHmacSecret as bstr.
+	 */
+	fdow_byte_string(fdow, (*ovkey)->bytes, (*ovkey)->byte_sz);
+	if (!fdow_encoded_length(fdow, &encoded_secret_length) || encoded_secret_length == 0) {
+		LOG(LOG_ERROR, "Failed to get encoded DeviceCredential.DCHmacSecret length\n");
+		return false;
+	}
+	fdow->b.block_size = encoded_secret_length;
+	return true;
+}
+#endif
+
+/**
+ * Write the Device Credentials blob, contains our state
+ * @param dev_cred_file - pointer of type const char to which credentails are
+ * to be written.
+ * @param flags ///TO BE ADDED
+ *
+ *
+ * @param ocred - pointer of type fdo_dev_cred_t, holds the credentials for
+ * writing to dev_cred_file.
+ * @return true if write and parsed correctly, otherwise false
+ */
+
+bool write_normal_device_credentials(const char *dev_cred_file,
+				     fdo_sdk_blob_flags flags,
+				     fdo_dev_cred_t *ocred)
+{
+	bool ret = true;
+
+	if (!ocred || !dev_cred_file) {
+		return false;
+	}
+#ifndef NO_PERSISTENT_STORAGE
+
+	fdow_t *fdow = alloc_cred_writer(BUFF_SIZE_4K_BYTES);
+	if (!fdow || !encode_normal_device_credentials(fdow, ocred)) {
 		ret = false;
 		goto end;
 	}
-	fdow->b.block_size = encoded_cred_length;
 
 	if (fdo_blob_write((char *)dev_cred_file, flags, fdow->b.block,
 			   fdow->b.block_size) == -1) {
@@ -119,10 +180,7 @@ bool write_normal_device_credentials(const char *dev_cred_file,
 	}
 
 end:
-	if (fdow) {
-		fdow_flush(fdow);
-		fdo_free(fdow);
-	}
+	free_cred_writer(fdow);
 #endif
 	return ret;
 }
@@ -149,30 +207,11 @@ bool write_secure_device_credentials(const char *dev_cred_file,
 
 #ifndef NO_PERSISTENT_STORAGE
 
-	fdow_t *fdow = fdo_alloc(sizeof(fdow_t));
-	if (!fdow || !fdow_init(fdow) ||
-		!fdo_block_alloc_with_size(&fdow->b, BUFF_SIZE_128_BYTES) ||
-		!fdow_encoder_init(fdow)) {
-		LOG(LOG_ERROR, "FDOW Initialization/Allocation failed!\n");
-		ret = false;
-		goto end;
-	}
-	fdo_byte_array_t **ovkey = getOVKey();
-	if (!ovkey || !*ovkey) {
-		ret = false;
-		goto end;
-	}
-	/**
-	 * Blob format: DeviceCredential.DCHmacSecret as bstr.
-	 */
-	fdow_byte_string(fdow, (*ovkey)->bytes, (*ovkey)->byte_sz);
-	size_t encoded_secret_length = 0;
-	if (!fdow_encoded_length(fdow, &encoded_secret_length) || encoded_secret_length == 0) {
-		LOG(LOG_ERROR, "Failed to get encoded DeviceCredential.DCHmacSecret length\n");
+	fdow_t *fdow = alloc_cred_writer(BUFF_SIZE_128_BYTES);
+	if (!fdow || !encode_device_secret(fdow)) {
 		ret = false;
 		goto end;
 	}
-	fdow->b.block_size = encoded_secret_length;
 
 	if (fdo_blob_write((char *)dev_cred_file, flags, fdow->b.block,
 			   fdow->b.block_size) == -1) {
@@ -181,10 +220,7 @@ bool write_secure_device_credentials(const char *dev_cred_file,
 		goto end;
 	}
 end:
-	if (fdow) {
-		fdow_flush(fdow);
-		fdo_free(fdow);
-	}
+	free_cred_writer(fdow);
 #endif
 	return ret;
 }
@@ -417,25 +453,86 @@ end:
  */
 int store_credential(fdo_dev_cred_t *ocred)
 {
+	return store_credentials(ocred, FDO_CRED_STORE_SECRET);
+}
+
+/**
+ * Commit the device credentials, and the state they hold, in one pass.
+ * Everything is encoded before storage is touched, so that an encoding
+ * failure leaves the stored credentials as they were. Then, the storage
+ * HMAC key is rotated if requested, and each blob is sealed and written
+ * once. The Secure blob is only written when its secret has to be stored.
+ *
+ * @param ocred - Pointer of type fdo_dev_cred_t, credentials to be stored
+ * @param parts - FDO_CRED_STORE_* flags, for what is stored along with the
+ * Normal blob.
+ * @return 0 if success, else -1 on failure.
+ */
+int store_credentials(fdo_dev_cred_t *ocred, uint32_t parts)
+{
+	int ret = -1;
+
+	if (!ocred) {
+		return -1;
+	}
+#if defined(DEVICE_TPM20_ENABLED)
+	/* The secret never leaves the TPM */
+	parts &= ~FDO_CRED_STORE_SECRET;
+#endif
+
+#ifndef NO_PERSISTENT_STORAGE
+	fdow_t *normal = NULL;
+	fdow_t *secret = NULL;
+
+	normal = alloc_cred_writer(BUFF_SIZE_4K_BYTES);
+	if (!normal || !encode_normal_device_credentials(normal, ocred)) {
+		LOG(LOG_ERROR, "Could not encode the Device Credentials\n");
+		goto end;
+	}
+	if (parts & FDO_CRED_STORE_SECRET) {
+		secret = alloc_cred_writer(BUFF_SIZE_128_BYTES);
+		if (!secret || !encode_device_secret(secret)) {
+			LOG(LOG_ERROR, "Could not encode the Device Secret\n");
+			goto end;
+		}
+	}
+
+	if (parts & FDO_CRED_STORE_ROTATE_KEY) {
+		if (0 != fdo_generate_storage_hmac_key()) {
+			LOG(LOG_ERROR, "Failed to rotate data protection key.\n");
+		} else {
+			LOG(LOG_DEBUG, "Data protection key rotated successfully!!\n");
+		}
+	}
+
 	/* Write in the file and save the Normal device credentials */
 	LOG(LOG_DEBUG, "Writing to %s blob\n", "Normal.blob");
-	if (!write_normal_device_credentials((char *)FDO_CRED_NORMAL,
-					     FDO_SDK_NORMAL_DATA, ocred)) {
+	if (fdo_blob_write((char *)FDO_CRED_NORMAL, FDO_SDK_NORMAL_DATA,
+			   normal->b.block, normal->b.block_size) == -1) {
 		LOG(LOG_ERROR, "Could not write to Normal Credentials blob\n");
-		return -1;
+		goto end;
 	}
 
-#if !defined(DEVICE_TPM20_ENABLED)
 	/* Write in the file and save the Secure device credentials */
-	LOG(LOG_DEBUG, "Writing to %s blob\n", "Secure.blob");
-	if (!write_secure_device_credentials((char *)FDO_CRED_SECURE,
-					     FDO_SDK_SECURE_DATA, ocred)) {
-		LOG(LOG_ERROR, "Could not write to Secure Credentials blob\n");
-		return -1;
+	if (secret) {
+		LOG(LOG_DEBUG, "Writing to %s blob\n", "Secure.blob");
+		if (fdo_blob_write((char *)FDO_CRED_SECURE, FDO_SDK_SECURE_DATA,
+				   secret->b.block,
+				   secret->b.block_size) == -1) {
+			LOG(LOG_ERROR, "Could not write to Secure Credentials blob\n");
+			goto end;
+		}
 	}
-#endif
+	ret = 0;
 
-	return 0;
+end:
+	free_cred_writer(normal);
+	free_cred_writer(secret);
+#else
+	(void)parts;
+	ret = 0;
+#endif
+	return ret;
 }
 
 /**
@@ -85,13 +85,16 @@ end:
 }
 
 /**
- * Decrypt a FDOEncrypted_packet object to an fdo_string_t. Also calculate HMAC
- * of decrypted text and compare it with received HMAC.
+ * Decrypt a FDOEncrypted_packet object straight into the given buffer, and
+ * verify its tag. On failure, the buffer may hold unauthenticated text that
+ * the caller must discard.
  *
  * @param cipher_txt
- *        Cipher text to be decrypted and HMAC to be verified.
+ *        Cipher text to be decrypted and tag to be verified.
  * @param clear_txt
  *        Buffer to place the decrypted text.
+ * @param clear_txt_size
+ *        In: size of clear_txt, out: length of the decrypted text.
  * @param aad
  *        Buffer containing the Additonal Authenticated Data (AAD).
  * @param aad_length
@@ -99,63 +102,85 @@ end:
  * @return ret
  *        return 0 on success. -1 on failure.
  */
-int aes_decrypt_packet(fdo_encrypted_packet_t *cipher_txt,
-		       fdo_byte_array_t *clear_txt, const uint8_t *aad,
-		       size_t aad_length)
+int aes_decrypt_packet_to_buf(fdo_encrypted_packet_t *cipher_txt,
+			      uint8_t *clear_txt, size_t *clear_txt_size,
+			      const uint8_t *aad, size_t aad_length)
 {
-	int ret = -1;
 	uint32_t clear_text_length = 0;
-	uint8_t *cleartext = NULL;
-	int result = -1;
 
-	if (!cipher_txt || !cipher_txt->em_body || !aad || 0 == aad_length) {
+	if (!cipher_txt || !cipher_txt->em_body || !clear_txt ||
+	    !clear_txt_size || !aad || 0 == aad_length) {
 		return -1;
 	}
 
-	clear_text_length = cipher_txt->em_body->byte_sz;
-
-	result = fdo_msg_decrypt_get_pt_len(cipher_txt->em_body->byte_sz,
-					    &clear_text_length);
-	if (result != 0) {
+	if (0 != fdo_msg_decrypt_get_pt_len(cipher_txt->em_body->byte_sz,
+					    &clear_text_length)) {
 		LOG(LOG_ERROR, "Can't get required clear text size\n");
-		goto end;
+		return -1;
 	}
-
-	cleartext = fdo_alloc(clear_text_length);
-	if (!cleartext) {
-		LOG(LOG_ERROR, "Failed to allocate cleartext buffer\n");
-		goto end;
+	if (clear_text_length > *clear_txt_size) {
+		LOG(LOG_ERROR, "Clear text buffer is too small\n");
+		return -1;
 	}
 
 	if (0 != fdo_msg_decrypt(
-		     cleartext, &clear_text_length, cipher_txt->em_body->bytes,
+		     clear_txt, &clear_text_length, cipher_txt->em_body->bytes,
 		     cipher_txt->em_body->byte_sz, cipher_txt->iv,
 		     cipher_txt->tag, sizeof(cipher_txt->tag), aad, aad_length)) {
 		LOG(LOG_ERROR, "Failed to Decrypt\n");
-		goto end;
+		return -1;
 	}
+	*clear_txt_size = clear_text_length;
+	return 0;
+}
 
-	/*
-	 * TODO: Since, clear_txt is defined with a string data structure, so,
-	 * resizing using that API, and memcpy to it as cleartext is
-	 * without NULL termination. So, it must be moved to a different
-	 * data structure.
-	 */
-	if (fdo_byte_array_resize(clear_txt, clear_text_length) == false) {
-		LOG(LOG_ERROR, "Failed to resize clear text buffer\n");
-		goto end;
+/**
+ * Decrypt a FDOEncrypted_packet object to an fdo_byte_array_t. Also verify
+ * the tag of the decrypted text.
+ *
+ * @param cipher_txt
+ *        Cipher text to be decrypted and HMAC to be verified.
+ * @param clear_txt
+ *        Buffer to place the decrypted text.
+ * @param aad
+ *        Buffer containing the Additonal Authenticated Data (AAD).
+ * @param aad_length
+ *        Size of the aad
+ * @return ret
+ *        return 0 on success. -1 on failure.
+ */
+int aes_decrypt_packet(fdo_encrypted_packet_t *cipher_txt,
+		       fdo_byte_array_t *clear_txt, const uint8_t *aad,
+		       size_t aad_length)
+{
+	uint32_t clear_text_length = 0;
+	size_t clear_txt_size = 0;
+
+	if (!cipher_txt || !cipher_txt->em_body || !clear_txt || !aad ||
+	    0 == aad_length) {
+		return -1;
 	}
 
-	if (memcpy_s(clear_txt->bytes, clear_text_length, cleartext,
-		     clear_text_length)) {
-		LOG(LOG_ERROR, "Copying cleartext failed\n");
-		goto end;
+	if (0 != fdo_msg_decrypt_get_pt_len(cipher_txt->em_body->byte_sz,
+					    &clear_text_length)) {
+		LOG(LOG_ERROR, "Can't get required clear text size\n");
+		return -1;
 	}
 
-	ret = 0;
-end:
-	if (cleartext) {
-		fdo_free(cleartext);
+	if (fdo_byte_array_resize(clear_txt, clear_text_length) == false) {
+		LOG(LOG_ERROR, "Failed to resize clear text buffer\n");
+		return -1;
 	}
-	return ret;
+
+	clear_txt_size = clear_txt->byte_sz;
+	if (0 != aes_decrypt_packet_to_buf(cipher_txt, clear_txt->bytes,
+					   &clear_txt_size, aad, aad_length)) {
+		if (clear_txt->bytes &&
+		    memset_s(clear_txt->bytes, clear_txt->byte_sz, 0) != 0) {
+			LOG(LOG_ERROR, "Failed to clear clear text buffer\n");
+		}
+		return -1;
+	}
+	clear_txt->byte_sz = clear_txt_size;
+	return 0;
 }
@@ -15,6 +15,8 @@
 #include "fdoprotctx.h"
 #include "fdonet.h"
 #include "fdoprot.h"
+#include "fdoretry.h"
+#include "fdobufpool.h"
 #include "load_credentials.h"
 #include "network_al.h"
 #include "fdoCrypto.h"
@@ -24,6 +26,7 @@
 #include "safe_lib.h"
 #include "fdodeviceinfo.h"
 #include <ctype.h>
+#include <signal.h>
 
 typedef struct app_data_s {
 	bool error_recovery;
@@ -43,6 +46,20 @@ typedef struct app_data_s {
 	fdo_sdk_service_info_module_list_t *module_list;
 	fdo_rendezvous_directive_t *current_rvdirective;
 	fdo_rvto2addr_entry_t *current_rvto2addrentry;
+	/* Until when RVTO2Addr from TO1 may be reused for TO2 retries, in ms */
+	uint64_t to1d_expiry_ms;
+	/* Retry delays and health of the Rendezvous/Owner addresses */
+	fdo_retry_t retry;
+	/* When the next state is due, in fdo_time_ms() milliseconds */
+	uint64_t wake_ms;
+	/* The state machine is driven by fdo_sdk_step() */
+	bool stepping;
+	/* Protocol exchange of the current state, stepped by run_state() */
+	fdo_prot_ctx_t *prot_ctx;
+	bool exchange_pending;
+	int exchange_result;
+	/* Rendezvous/Owner address of the exchange, see fdo_retry_report() */
+	uint32_t exchange_id;
 } app_data_t;
 
 /* Globals */
@@ -64,18 +81,35 @@ static const uint64_t default_delay = 3;
 static const uint64_t default_delay_rvinfo_retries = 120;
 static const uint64_t max_delay = 3600;
 
+/* How long the RVTO2Addr received in TO1.RVRedirect is reused, 0 to disable */
+#ifndef TO1D_CACHE_SEC
+#define TO1D_CACHE_SEC 600
+#endif
+
 static unsigned int error_count;
 static bool rvbypass;
+/* Set by fdo_sdk_cancel(), checked before each state and while waiting */
+static volatile sig_atomic_t cancel_requested;
+
+/* How long fdo_sdk_run() waits for a response before checking for a cancel,
+ * and the longest fdo_sdk_step() asks its caller to wait while one is due */
+#define EXCHANGE_POLL_MS 1000
 
 static bool _STATE_DI(void);
+static bool _STATE_DI_Done(void);
 static bool _STATE_TO1(void);
+static bool _STATE_TO1_Done(void);
 static bool _STATE_TO2(void);
+static bool _STATE_TO2_Done(void);
 static bool _STATE_Error(void);
 static bool _STATE_Shutdown(void);
 static bool _STATE_Shutdown_Error(void);
 
 static fdo_sdk_status app_initialize(void);
 static void app_close(void);
+static void fdo_protDIExit(app_data_t *app_data);
+static void fdo_protTO1Exit(app_data_t *app_data);
+static void fdo_protTO2Exit(app_data_t *app_data);
 bool parse_manufacturer_address(char *buffer, size_t buffer_sz, bool *tls,
 	fdo_ip_address_t **mfg_ip, char *mfg_dns, size_t mfg_dns_sz, int *mfg_port);
 
@@ -85,6 +119,142 @@ bool parse_manufacturer_address(char *buffer, size_t buffer_sz, bool *tls,
 		g_fdo_data->state_fn = &_STATE_Error;                          \
 	}
 
+/**
+ * Delay the next state of the state machine, instead of sleeping in the
+ * current one: fdo_sdk_run() waits, and fdo_sdk_step() returns to its caller.
+ *
+ * @param sec
+ *        Delay, in seconds.
+ */
+static void delay_next_state(uint64_t sec)
+{
+	g_fdo_data->wake_ms = fdo_time_ms() + sec * 1000;
+}
+
+/**
+ * Notify the application of a failed attempt through its error callback.
+ *
+ * @param error
+ *        The protocol that failed.
+ * @return
+ *        true if the application asked to stop retrying, false otherwise.
+ */
+static bool notify_error(fdo_sdk_error error)
+{
+	if (g_fdo_data->error_callback &&
+	    g_fdo_data->error_callback(FDO_WARNING, error) == FDO_ABORT) {
+		LOG(LOG_INFO, "Retry aborted by the application\n");
+		return true;
+	}
+	return false;
+}
+
+/**
+ * Hand the protocol exchange of the current state over to run_state(),
+ * which steps it to completion and then runs done_fn with its result.
+ *
+ * @param prot_ctx
+ *        The protocol context to run, freed with end_exchange().
+ * @param done_fn
+ *        The state that handles the result of the exchange.
+ */
+static void start_exchange(fdo_prot_ctx_t *prot_ctx, bool (*done_fn)(void))
+{
+	g_fdo_data->prot_ctx = prot_ctx;
+	g_fdo_data->exchange_pending = true;
+	g_fdo_data->exchange_result = -1;
+	g_fdo_data->state_fn = done_fn;
+}
+
+/**
+ * Free the protocol exchange, closing its connection if it is still open.
+ */
+static void end_exchange(void)
+{
+	if (g_fdo_data->prot_ctx) {
+		fdo_prot_ctx_free(g_fdo_data->prot_ctx);
+		fdo_free(g_fdo_data->prot_ctx);
+	}
+	g_fdo_data->exchange_pending = false;
+}
+
+/**
+ * Abandon the protocol exchange in progress, if any, along with the
+ * protocol data it built so far.
+ */
+static void abort_exchange(void)
+{
+	if (!g_fdo_data->prot_ctx) {
+		return;
+	}
+	end_exchange();
+	if (g_fdo_data->state_fn == &_STATE_DI_Done) {
+		fdo_protDIExit(g_fdo_data);
+	} else if (g_fdo_data->state_fn == &_STATE_TO1_Done) {
+		fdo_protTO1Exit(g_fdo_data);
+	} else if (g_fdo_data->state_fn == &_STATE_TO2_Done) {
+		fdo_protTO2Exit(g_fdo_data);
+	}
+}
+
+/**
+ * Run the current state of the state machine, counting the failed ones.
+ * A protocol exchange started by the previous state is stepped first, and
+ * the state handling its result only runs once it completed.
+ *
+ * @param ret
+ *        Status of the last state run, updated. FDO_IN_PROGRESS if the
+ *        exchange is still waiting for a response at deadline_ms.
+ * @param deadline_ms
+ *        fdo_time_ms() after which the exchange is left in progress.
+ * @return
+ *        true if there are more states to run, false otherwise.
+ */
+static bool run_state(fdo_sdk_status *ret, uint64_t deadline_ms)
+{
+	/* Nothing left to perform in state machine */
+	if (!g_fdo_data->state_fn) {
+		return false;
+	}
+
+	if (cancel_requested && g_fdo_data->state_fn != &_STATE_Shutdown) {
+		cancel_requested = false;
+		LOG(LOG_INFO, "FIDO Device Onboard cancelled\n");
+		abort_exchange();
+		(void)_STATE_Shutdown_Error();
+		*ret = FDO_ABORT;
+		return false;
+	}
+
+	if (g_fdo_data->exchange_pending) {
+		g_fdo_data->exchange_result =
+		    fdo_prot_ctx_step(g_fdo_data->prot_ctx, deadline_ms);
+		if (g_fdo_data->exchange_result > 0) {
+			*ret = FDO_IN_PROGRESS;
+			return true;
+		}
+		g_fdo_data->exchange_pending = false;
+	}
+
+	/* Start the state machine */
+	if (true == g_fdo_data->state_fn()) {
+		*ret = FDO_SUCCESS;
+	} else {
+		*ret = FDO_ERROR;
+		++error_count;
+		if (error_count == ERROR_RETRY_COUNT) {
+			LOG(LOG_INFO, "*********Retry(s) done*********\n");
+			g_fdo_data->state_fn = &_STATE_Shutdown_Error;
+		} else if (error_count > ERROR_RETRY_COUNT) {
+			// reach here when all retries have been completed
+			return false;
+		} else {
+			LOG(LOG_INFO, "*********Retry count : %u*********\n", error_count);
+		}
+	}
+	return g_fdo_data->state_fn != NULL;
+}
+
 /**
  * fdo_sdk_run is user API call to start device ownership
  * transfer
@@ -115,27 +285,107 @@ fdo_sdk_status fdo_sdk_run(void)
 	}
 
 	/* Loop until last state has been reached */
-	while (1) {
-		/* Nothing left to perform in state machine */
-		if (!g_fdo_data->state_fn) {
-			break;
+	do {
+		/* Wait for the delay set by the previous state */
+		while (!cancel_requested &&
+		       fdo_time_ms() < g_fdo_data->wake_ms) {
+			fdo_sleep(1);
 		}
+		/* a response is waited for in slices, to notice a cancel */
+	} while (run_state(&ret, fdo_time_ms() + EXCHANGE_POLL_MS));
 
-		/* Start the state machine */
-		if (true == g_fdo_data->state_fn()) {
-			ret = FDO_SUCCESS;
-		} else {
-			ret = FDO_ERROR;
-			++error_count;
-			if (error_count == ERROR_RETRY_COUNT) {
-				LOG(LOG_INFO, "*********Retry(s) done*********\n");
-				g_fdo_data->state_fn = &_STATE_Shutdown_Error;
-			} else if (error_count > ERROR_RETRY_COUNT) {
-				// reach here when all retries have been completed
-				goto end;
-			} else {
-				LOG(LOG_INFO, "*********Retry count : %u*********\n", error_count);
+end:
+	app_close();
+	/* This should be moved to fdo_sdk_exit when its available */
+	fdo_free(g_fdo_data);
+	return ret;
+}
+
+/**
+ * fdo_sdk_step is the incremental alternative to fdo_sdk_run, for
+ * applications that onboard from their own event loop.
+ * fdo_sdk_init should be called before calling this function.
+ * Each call advances the state machine until budget_ms has elapsed, and
+ * returns FDO_IN_PROGRESS as long as onboarding isn't complete. Delays
+ * between retries aren't slept, and a response from the server isn't
+ * waited for past budget_ms: the call returns, handing out the socket to
+ * wait on. Building and parsing a message isn't interrupted, so a call may
+ * overrun budget_ms by the time it takes.
+ *
+ * The call isn't fully non-blocking. It can still block, whatever
+ * budget_ms is, while:
+ * - resolving the DNS name of a server with getaddrinfo(), for up to the
+ *   resolver's own timeout;
+ * - connecting to a server, TCP and TLS handshake included, and sending a
+ *   message, for up to the fdo_sdk_set_timeout() budget each (60 s by
+ *   default);
+ * - running an fdo_sys:exec instruction of the Owner ServiceInfo, until the
+ *   command exits (fdo_sys:exec_cb doesn't wait).
+ *
+ * @param budget_ms
+ *        Time after which the call returns, in milliseconds.
+ * @param wait_ms
+ *        Longest time to wait before calling again, in milliseconds, when
+ *        FDO_IN_PROGRESS is returned. Can be NULL.
+ * @param fd
+ *        File descriptor to wait on for readability before calling again,
+ *        or -1 if there is none, when FDO_IN_PROGRESS is returned. Can be
+ *        NULL.
+ * @return
+ *        FDO_IN_PROGRESS until onboarding is complete, then the status
+ *        fdo_sdk_run would have returned, or FDO_ABORT if it was cancelled
+ *        with fdo_sdk_cancel.
+ */
+fdo_sdk_status fdo_sdk_step(uint32_t budget_ms, uint32_t *wait_ms, int *fd)
+{
+	fdo_sdk_status ret = FDO_ERROR;
+	uint64_t deadline_ms = fdo_time_ms() + budget_ms;
+	uint64_t now_ms = 0;
+	bool ran = false;
+
+	if (fd) {
+		*fd = -1;
+	}
+
+	if (!g_fdo_data) {
+		LOG(LOG_ERROR,
+		    "fdo_sdk not initialized. Call fdo_sdk_init first\n");
+		return FDO_ERROR;
+	}
+
+	if (!g_fdo_data->stepping) {
+		if (FDO_SUCCESS != app_initialize()) {
+			goto end;
+		}
+		g_fdo_data->stepping = true;
+	}
+
+	while (g_fdo_data->state_fn) {
+		now_ms = fdo_time_ms();
+		if (!cancel_requested &&
+		    (now_ms < g_fdo_data->wake_ms || (ran && now_ms >= deadline_ms))) {
+			if (wait_ms) {
+				*wait_ms = (uint32_t)(now_ms < g_fdo_data->wake_ms ?
+					   g_fdo_data->wake_ms - now_ms : 0);
+			}
+			return FDO_IN_PROGRESS;
+		}
+		ran = true;
+		if (!run_state(&ret, deadline_ms)) {
+			break;
+		}
+		if (ret == FDO_IN_PROGRESS) {
+			// waiting for the server, on its socket if it is pollable,
+			// or out of budget with the next message to send
+			if (wait_ms) {
+				*wait_ms = g_fdo_data->prot_ctx->phase ==
+						   FDO_PROT_CTX_RECV ?
+					   EXCHANGE_POLL_MS : 0;
+			}
+			if (fd) {
+				*fd = fdo_prot_ctx_get_fd(g_fdo_data->prot_ctx);
 			}
+			return FDO_IN_PROGRESS;
 		}
 	}
 
@@ -146,6 +396,30 @@ end:
 	return ret;
 }
 
+/**
+ * Set the time budget of each network operation: connecting, sending a
+ * message, and waiting for and receiving its response. A response that
+ * doesn't come in time fails the protocol, which is then retried.
+ *
+ * @param timeout_ms
+ *        Time budget, in milliseconds, 0 for the default.
+ */
+void fdo_sdk_set_timeout(uint32_t timeout_ms)
+{
+	fdo_con_set_timeout((long)timeout_ms);
+}
+
+/**
+ * Request fdo_sdk_run or fdo_sdk_step to stop onboarding. A message being
+ * built or parsed completes, a response being waited for is given up within
+ * a second, then the device shuts down as after a failure, and FDO_ABORT is
+ * returned. Safe to call from a signal handler.
+ */
+void fdo_sdk_cancel(void)
+{
+	cancel_requested = true;
+}
+
 /**
  * Deallocate allocated  memories in DI protocol and exit from DI.
  *
@@ -269,10 +543,11 @@ static void fdo_protTO2Exit(app_data_t *app_data)
 		ps->dsi_info = NULL;
 	}
 
-	if (ps->service_info) {
+	if (ps->service_info && ps->service_info != ps->devmod_info) {
 		fdo_service_info_free(ps->service_info);
-		ps->service_info = NULL;
 	}
+	ps->service_info = NULL;
+	ps->devmod_info = NULL;
 
 	if (ps->ext_service_info) {
 		fdo_byte_array_free(ps->ext_service_info);
@@ -350,6 +625,7 @@ static fdo_sdk_status app_initialize(void)
 	}
 
 	g_fdo_data->delaysec = 0;
+	fdo_retry_init(&g_fdo_data->retry, max_delay);
 	/* Initialize service_info to NULL in case of early error. */
 	g_fdo_data->service_info = NULL;
 
@@ -438,13 +714,13 @@ static fdo_sdk_status app_initialize(void)
 	* protocol execution. Reuse the allocated memory by emptying the contents.
 	*/
 	if (!fdow_init(&g_fdo_data->prot.fdow) ||
-		!fdo_block_alloc_with_size(&g_fdo_data->prot.fdow.b,
+		!fdo_block_alloc_pooled(&g_fdo_data->prot.fdow.b,
 			g_fdo_data->prot.prot_buff_sz)) {
 		LOG(LOG_ERROR, "fdow_init() failed!\n");
 		return FDO_ERROR;
 	}
 	if (!fdor_init(&g_fdo_data->prot.fdor) ||
-		!fdo_block_alloc_with_size(&g_fdo_data->prot.fdor.b,
+		!fdo_block_alloc_pooled(&g_fdo_data->prot.fdor.b,
 			g_fdo_data->prot.prot_buff_sz)) {
 		LOG(LOG_ERROR, "fdor_init() failed!\n");
 		return FDO_ERROR;
@@ -557,6 +833,15 @@ void fdo_sdk_service_info_register_module(fdo_sdk_service_info_module *module)
 		return;
 	}
 
+	// index the module by name, the registry lives on the list head
+	if (!fdo_serviceinfo_module_index_add(
+		g_fdo_data->module_list ? g_fdo_data->module_list : new, new)) {
+		LOG(LOG_ERROR, "Failed to register module\n");
+		fdo_serviceinfo_module_index_free(new);
+		fdo_free(new);
+		return;
+	}
+
 	if (g_fdo_data->module_list == NULL) {
 		// 1st module to register
 		g_fdo_data->module_list = new;
@@ -574,6 +859,8 @@ void fdo_sdk_service_info_register_module(fdo_sdk_service_info_module *module)
 
 /**
  * Create 'devmod' module and initialize it with the key-value pairs.
+ * It is created once, and kept along with its CBOR encoding for every
+ * TO2 attempt that follows.
  */
 static bool add_module_devmod(void) {
 	// Build up default 'devmod' ServiceInfo list
@@ -669,10 +956,6 @@ static bool add_module_devmod(void) {
 		LOG(LOG_ERROR, "Failed to add devmod:modules\n");
 		return false;
 	}
-
-	g_fdo_data->service_info->sv_index_begin = 0;
-	g_fdo_data->service_info->sv_index_end = 0;
-	g_fdo_data->service_info->sv_val_index = 0;
 	return true;
 }
 
@@ -703,6 +986,7 @@ void fdo_sdk_service_info_deregister_module(void)
 {
 	fdo_sdk_service_info_module_list_t *list = g_fdo_data->module_list;
 	if (list) {
+		fdo_serviceinfo_module_index_free(list);
 		g_fdo_data->module_list = clear_modules_list(list);
 	}
 }
@@ -1046,12 +1330,8 @@ fdo_sdk_status fdo_sdk_resale(void)
 	if (g_fdo_data->devcred->ST == FDO_DEVICE_STATE_IDLE) {
 		g_fdo_data->devcred->ST = FDO_DEVICE_STATE_READYN;
 
-		if (load_device_secret()) {
-			LOG(LOG_ERROR, "Reading {Mfg|Secret} blob failied!\n");
-			return FDO_ERROR;
-		}
-
-		ret = store_credential(g_fdo_data->devcred);
+		// the secret is unchanged, only the state is stored
+		ret = store_credentials(g_fdo_data->devcred, 0);
 		if (!ret) {
 			LOG(LOG_INFO, "Set Resale complete\n");
 			r = FDO_SUCCESS;
@@ -1087,26 +1367,30 @@ static void app_close(void)
 		return;
 	}
 
-	if (g_fdo_data->prot.service_info && g_fdo_data->service_info) {
+	abort_exchange();
+
+	if (g_fdo_data->service_info) {
 		fdo_service_info_free(g_fdo_data->service_info);
 		g_fdo_data->service_info = NULL;
 	}
+	fdo_prot_ov_checkpoint_free(&g_fdo_data->prot);
 
 	fdo_sdk_service_info_deregister_module();
 
 	fdob = &g_fdo_data->prot.fdor.b;
 	if (fdob->block) {
-		fdo_free(fdob->block);
+		fdo_buf_pool_put(fdob->block);
 		fdob->block = NULL;
 	}
 	fdor_flush(&g_fdo_data->prot.fdor);
 
 	fdob = &g_fdo_data->prot.fdow.b;
 	if (fdob->block) {
-		fdo_free(fdob->block);
+		fdo_buf_pool_put(fdob->block);
 		fdob->block = NULL;
 	}
 	fdow_flush(&g_fdo_data->prot.fdow);
+	fdo_buf_pool_drain();
 
 	if (g_fdo_data->devcred) {
 		fdo_dev_cred_free(g_fdo_data->devcred);
@@ -1117,10 +1401,11 @@ static void app_close(void)
 
 /**
  * Handles DI state of device. Initializes protocol context engine,
- * initializse state variables and runs the DI protocol.
+ * initializse state variables and starts the DI protocol, which
+ * _STATE_DI_Done handles the result of.
  *
  * @return ret
- *         true if DI completes successfully. false in case of error.
+ *         true if DI is started. false in case of error.
  */
 static bool _STATE_DI(void)
 {
@@ -1183,55 +1468,79 @@ static bool _STATE_DI(void)
 		goto end;
 	}
 
-	if (fdo_prot_ctx_run(prot_ctx) != 0) {
+	// DI runs from run_state(), then _STATE_DI_Done() with its result
+	start_exchange(prot_ctx, &_STATE_DI_Done);
+	ret = true;
+end:
+	if (!ret) {
+		fdo_protDIExit(g_fdo_data);
+	}
+	if (buffer) {
+		fdo_free(buffer);
+	}
+	if (mfg_ip) {
+		fdo_free(mfg_ip);
+	}
+	return ret;
+}
+
+/**
+ * Handles the result of the DI protocol started by _STATE_DI.
+ *
+ * @return ret
+ *         true if DI completes successfully. false in case of error.
+ */
+static bool _STATE_DI_Done(void)
+{
+	bool ret = false;
+
+	end_exchange();
+	if (g_fdo_data->exchange_result != 0) {
 		LOG(LOG_ERROR, "DI failed.\n");
-		if (g_fdo_data->error_recovery) {
+		if (!notify_error(FDO_DI_ERROR) && g_fdo_data->error_recovery) {
 			g_fdo_data->state_fn = &_STATE_DI;
+			g_fdo_data->retry.failures++;
+			g_fdo_data->delaysec =
+			    fdo_retry_delay(&g_fdo_data->retry,
+					    g_fdo_data->retry.failures,
+					    default_delay, 0);
 			LOG(LOG_INFO, "\nDelaying for %"PRIu64" seconds\n\n", g_fdo_data->delaysec);
-			fdo_sleep(g_fdo_data->delaysec);
+			delay_next_state(g_fdo_data->delaysec);
 			LOG(LOG_INFO, "Retrying.....\n");
 			goto end;
 		} else {
 			ERROR()
-			fdo_sleep(g_fdo_data->delaysec);
+			delay_next_state(g_fdo_data->delaysec);
 			goto end;
 		}
 	}
 	LOG(LOG_DEBUG, "\n------------------------------------ DI Successful "
 		       "--------------------------------------\n");
+	fdo_retry_report(&g_fdo_data->retry, 0, true);
 	LOG(LOG_INFO, "@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@\n");
 	LOG(LOG_INFO, "@FIDO Device Initialization Complete@\n");
 	LOG(LOG_INFO, "@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@\n");
 
 #ifdef NO_PERSISTENT_STORAGE
 	g_fdo_data->state_fn = &_STATE_TO1;
-	fdo_sleep(5);
+	delay_next_state(5);
 #else
 	g_fdo_data->state_fn = &_STATE_Shutdown;
 #endif
 	ret = true;
 end:
 	fdo_protDIExit(g_fdo_data);
-	if (prot_ctx) {
-		fdo_prot_ctx_free(prot_ctx);
-		fdo_free(prot_ctx);
-	}
-	if (buffer) {
-		fdo_free(buffer);
-	}
-	if (mfg_ip) {
-		fdo_free(mfg_ip);
-	}
 	return ret;
 }
 
 /**
  * Handles TO1 state of device. Initializes protocol context engine,
- * initializse state variables and runs the TO1 protocol.
+ * initializse state variables and starts the TO1 protocol, which
+ * _STATE_TO1_Done handles the result of.
  *
  * @return ret
- *         true if TO1 completes successfully, or if RVBypass was encountered in RendezvousInfo
- *         false if all RendezvousDirectives have been tried and TO1 resulted in failure.
+ *         true if TO1 is started, or if RVBypass was encountered in RendezvousInfo
+ *         false if no RendezvousDirective could be tried.
  */
 static bool _STATE_TO1(void)
 {
@@ -1240,6 +1549,14 @@ static bool _STATE_TO1(void)
 	bool skip_rv = false;
 	fdo_prot_ctx_t *prot_ctx = NULL;
 
+	// delay if we came back from RVBypass or re-try RVInfo with some value,
+	// otherwise, delaysec will be 0
+	if (g_fdo_data->delaysec) {
+		delay_next_state(g_fdo_data->delaysec);
+		g_fdo_data->delaysec = 0;
+		return true;
+	}
+
 	LOG(LOG_DEBUG, "\n-------------------------------------------"
 		       "-------------------------------------------"
 		       "-------------------------------------------"
@@ -1280,10 +1597,6 @@ static bool _STATE_TO1(void)
 		g_fdo_data->current_rvdirective = g_fdo_data->devcred->owner_blk->rvlst->rv_directives;
 	}
 
-	// delay if we came back from RVBypass or re-try RVInfo with some value,
-	// otherwise, delaysec will be 0
-	fdo_sleep(g_fdo_data->delaysec);
-
 	while (!ret && g_fdo_data->current_rvdirective) {
 		fdo_rendezvous_t *rv = g_fdo_data->current_rvdirective->rv_entries;
 		// reset for next use.
@@ -1354,72 +1667,106 @@ static bool _STATE_TO1(void)
 			ERROR();
 			goto end;
 		}
+		g_fdo_data->exchange_id = fdo_retry_endpoint_id(
+		    ip ? ip->addr : NULL, ip ? ip->length : 0, dns, port);
 
-		if (fdo_prot_ctx_run(prot_ctx) != 0) {
-			LOG(LOG_ERROR, "TO1 failed.\n");
+		// TO1 runs from run_state(), then _STATE_TO1_Done() with its result
+		start_exchange(prot_ctx, &_STATE_TO1_Done);
+		return true;
+	}
 
-			// clear contents for a fresh start.
-			fdo_protTO1Exit(g_fdo_data);
-			fdo_prot_ctx_free(prot_ctx);
-			fdo_free(prot_ctx);
+end:
+	fdo_protTO1Exit(g_fdo_data);
+	return ret;
+}
 
-			// check if there is another RV location to try. if yes, try it
-			// the delay interval is conditional
-			if (g_fdo_data->current_rvdirective) {
-				if (g_fdo_data->delaysec == 0 || g_fdo_data->delaysec > max_delay) {
-					g_fdo_data->delaysec = default_delay;
-				}
-				LOG(LOG_INFO, "\nDelaying for %"PRIu64" seconds\n\n", g_fdo_data->delaysec);
-				fdo_sleep(g_fdo_data->delaysec);
-				continue;
-			}
+/**
+ * Handles the result of the TO1 protocol started by _STATE_TO1.
+ *
+ * @return ret
+ *         true if TO1 completes successfully, or if there are more
+ *         RendezvousDirectives to try,
+ *         false if all RendezvousDirectives have been tried and TO1 resulted in failure.
+ */
+static bool _STATE_TO1_Done(void)
+{
+	bool ret = false;
+	uint32_t rv_id = g_fdo_data->exchange_id;
 
-			// there are no more RV locations left, so check if retry is enabled.
-			// if yes, proceed with retrying all the RV locations
-			// if not, return immediately since there is nothing else left to do.
-			if (g_fdo_data->error_recovery) {
-				if (g_fdo_data->delaysec == 0 || g_fdo_data->delaysec > max_delay) {
-					g_fdo_data->delaysec = default_delay_rvinfo_retries;
-				}
-				LOG(LOG_INFO, "\nDelaying for %"PRIu64" seconds\n\n", g_fdo_data->delaysec);
-				g_fdo_data->state_fn = &_STATE_TO1;
-				LOG(LOG_INFO, "Retrying.....\n");
-				return ret;
-			} else {
-				LOG(LOG_INFO, "Retry is disabled. Aborting.....\n");
-				return ret;
-			}
+	end_exchange();
+	if (g_fdo_data->exchange_result != 0) {
+		LOG(LOG_ERROR, "TO1 failed.\n");
+
+		// clear contents for a fresh start.
+		fdo_protTO1Exit(g_fdo_data);
+		g_fdo_data->state_fn = &_STATE_TO1;
+
+		fdo_retry_report(&g_fdo_data->retry, rv_id, false);
+		if (notify_error(FDO_TO1_ERROR)) {
+			ERROR();
+			return ret;
+		}
+
+		// check if there is another RV location to try. if yes, try it
+		// the delay interval is conditional: RVDelaysec if given,
+		// backing off with the failures of this RV location otherwise
+		if (g_fdo_data->current_rvdirective) {
+			g_fdo_data->delaysec = fdo_retry_delay(
+			    &g_fdo_data->retry,
+			    fdo_retry_failures(&g_fdo_data->retry, rv_id),
+			    default_delay, g_fdo_data->delaysec);
+			LOG(LOG_INFO, "\nDelaying for %"PRIu64" seconds\n\n", g_fdo_data->delaysec);
+			// the next RendezvousDirective is tried once the delay is over
+			delay_next_state(g_fdo_data->delaysec);
+			g_fdo_data->delaysec = 0;
+			return true;
+		}
+
+		// there are no more RV locations left, so check if retry is enabled.
+		// if yes, proceed with retrying all the RV locations
+		// if not, return immediately since there is nothing else left to do.
+		if (g_fdo_data->error_recovery) {
+			// backing off with the rounds over all RV locations
+			g_fdo_data->retry.failures++;
+			g_fdo_data->delaysec = fdo_retry_delay(
+			    &g_fdo_data->retry, g_fdo_data->retry.failures,
+			    default_delay_rvinfo_retries, g_fdo_data->delaysec);
+			LOG(LOG_INFO, "\nDelaying for %"PRIu64" seconds\n\n", g_fdo_data->delaysec);
+			g_fdo_data->state_fn = &_STATE_TO1;
+			LOG(LOG_INFO, "Retrying.....\n");
+			return ret;
 		} else {
-			LOG(LOG_DEBUG, "\n------------------------------------ TO1 Successful "
-		       "--------------------------------------\n");
-			ret = true;
-			g_fdo_data->state_fn = &_STATE_TO2;
-			goto end;
+			LOG(LOG_INFO, "Retry is disabled. Aborting.....\n");
+			return ret;
 		}
 	}
 
-end:
+	LOG(LOG_DEBUG, "\n------------------------------------ TO1 Successful "
+		       "--------------------------------------\n");
+	fdo_retry_report(&g_fdo_data->retry, rv_id, true);
+	g_fdo_data->to1d_expiry_ms =
+	    fdo_time_ms() + (uint64_t)TO1D_CACHE_SEC * 1000;
+	ret = true;
+	g_fdo_data->state_fn = &_STATE_TO2;
 	fdo_protTO1Exit(g_fdo_data);
-	if (prot_ctx) {
-		fdo_prot_ctx_free(prot_ctx);
-		fdo_free(prot_ctx);
-	}
 	return ret;
 }
 
 /**
  * Handles TO2 state of device. Initializes protocol context engine,
- * initializse state variables and runs the TO2 protocol.
+ * initializse state variables and starts the TO2 protocol, which
+ * _STATE_TO2_Done handles the result of.
  *
  * @return ret
- *         true if TO2 completes successfully, or if there are more RendezvousDirectives that
+ *         true if TO2 is started, or if there are more RendezvousDirectives that
  *         need to be processed,
- *         false if all RendezvousDirectives have been tried and TO2 resulted in failure.
+ *         false in case of error.
  */
 static bool _STATE_TO2(void)
 {
 	fdo_prot_ctx_t *prot_ctx = NULL;
 	bool ret = false;
+	uint32_t owner_id = 0;
 
 	LOG(LOG_DEBUG, "\n-------------------------------------------"
 		       "-------------------------------------------"
@@ -1438,10 +1785,17 @@ static bool _STATE_TO2(void)
 		return FDO_ERROR;
 	}
 
-	if (!add_module_devmod()) {
+	if (!g_fdo_data->service_info && !add_module_devmod()) {
 		LOG(LOG_ERROR, "Failed to create devmod module\n");
+		fdo_service_info_free(g_fdo_data->service_info);
+		g_fdo_data->service_info = NULL;
 		return FDO_ERROR;
 	}
+	// send 'devmod' from its 1st ServiceInfoKV, even on a retry
+	g_fdo_data->service_info->sv_index_begin = 0;
+	g_fdo_data->service_info->sv_index_end = 0;
+	g_fdo_data->service_info->sv_val_index = 0;
+	g_fdo_data->service_info->sv_val_offset = 0;
 
 	if (!fdo_prot_to2_init(&g_fdo_data->prot, g_fdo_data->service_info,
 			       g_fdo_data->devcred, g_fdo_data->module_list)) {
@@ -1456,6 +1810,8 @@ static bool _STATE_TO2(void)
 			LOG(LOG_ERROR, "RVTO2Addr list is empty!\n");
 			return FDO_ERROR;
 		}
+		// try the Owner addresses that failed the least first
+		fdo_retry_sort_rvto2addr(&g_fdo_data->retry, rvto2addr);
 		g_fdo_data->current_rvto2addrentry = rvto2addr->rv_to2addr_entry;
 	}
 
@@ -1508,6 +1864,9 @@ static bool _STATE_TO2(void)
 				rv = rv->next;
 			}
 
+			owner_id = fdo_retry_endpoint_id(ip ? ip->addr : NULL,
+							 ip ? ip->length : 0, dns, port);
+
 			// Found the  needed entries of the current directive.
 			// Prepare to move to next in case of failure
 			g_fdo_data->current_rvdirective = g_fdo_data->current_rvdirective->next;
@@ -1518,7 +1877,9 @@ static bool _STATE_TO2(void)
 			// Else, COSE Signature verification is done.
 			if (g_fdo_data->prot.to1d_cose != NULL) {
 				fdo_cose_free(g_fdo_data->prot.to1d_cose);
+				g_fdo_data->prot.to1d_cose = NULL;
 			}
+			g_fdo_data->to1d_expiry_ms = 0;
 
 		} else {
 
@@ -1538,6 +1899,12 @@ static bool _STATE_TO2(void)
 					"Skipping the RVTO2AddrEntry...\n");
 				skip_rv = true;
 			}
+			owner_id = fdo_retry_endpoint_id(
+			    g_fdo_data->current_rvto2addrentry->rvip ?
+				g_fdo_data->current_rvto2addrentry->rvip->bytes : NULL,
+			    g_fdo_data->current_rvto2addrentry->rvip ?
+				g_fdo_data->current_rvto2addrentry->rvip->byte_sz : 0,
+			    dns, port);
 			// prepare for next iteration beforehand
 			g_fdo_data->current_rvto2addrentry = g_fdo_data->current_rvto2addrentry->next;
 
@@ -1573,99 +1940,150 @@ static bool _STATE_TO2(void)
 
 		prot_ctx = fdo_prot_ctx_alloc(
 			fdo_process_states, &g_fdo_data->prot, ip, dns ? dns->bytes : NULL, port, tls);
+		if (!rvbypass && ip) {
+			// free only when rvbypass is false, since the allocation was done then.
+			// the protocol context holds a copy
+			fdo_free(ip);
+		}
 		if (prot_ctx == NULL) {
 			ERROR();
 			return FDO_ABORT;
 		}
+		g_fdo_data->exchange_id = owner_id;
 
-		if (fdo_prot_ctx_run(prot_ctx) != 0 || g_fdo_data->prot.success == false) {
-			LOG(LOG_ERROR, "TO2 failed.\n");
-			/* Execute Sv_info type=FAILURE */
-			if (!fdo_mod_exec_sv_infotype(
-				g_fdo_data->prot.sv_info_mod_list_head,
-				FDO_SI_FAILURE)) {
-				LOG(LOG_ERROR, "Sv_info: One or more module's FAILURE "
-						"CB failed\n");
-			}
-			fdo_protTO2Exit(g_fdo_data);
-			fdo_prot_ctx_free(prot_ctx);
-			fdo_free(prot_ctx);
+		// TO2 runs from run_state(), then _STATE_TO2_Done() with its result
+		start_exchange(prot_ctx, &_STATE_TO2_Done);
+		ret = true;
+	} else {
+		LOG(LOG_ERROR, "Invalid State\n");
+	}
+	return ret;
+}
 
-			// Repeat some of the same operations as the failure case above
-			// when processing RendezvousInfo/RVTO2Addr and they need to be skipped
-			if (!rvbypass) {
-				if (ip) {
-					fdo_free(ip);
-				}
-				ip = NULL;
-				LOG(LOG_INFO, "\nDelaying for %"PRIu64" seconds\n\n", default_delay);
-				fdo_sleep(default_delay);
-				// if there is another Owner location present, try it
-				// the execution reaches here only if rvbypass was never set
-				if (g_fdo_data->current_rvto2addrentry) {
-					LOG(LOG_ERROR, "Retrying TO2 using the next RVTO2AddrEntry\n");
-					g_fdo_data->state_fn = &_STATE_TO2;
-					// return true so that TO2 is processed with the remaining directives
-					ret = true;
-					return ret;
-				}
-				// there's no more owner locations left to try,
-				// so start retrying with TO1, if retry is enabled.
-				if (g_fdo_data->error_recovery) {
-					g_fdo_data->state_fn = &_STATE_TO1;
-					LOG(LOG_ERROR, "All RVTO2AddreEntry(s) exhausted. "
-						"Retrying TO1 using the next RendezvousDirective\n");
-				}
+/**
+ * Handles the result of the TO2 protocol started by _STATE_TO2.
+ *
+ * @return ret
+ *         true if TO2 completes successfully, or if there are more RendezvousDirectives that
+ *         need to be processed,
+ *         false if all RendezvousDirectives have been tried and TO2 resulted in failure.
+ */
+static bool _STATE_TO2_Done(void)
+{
+	bool ret = false;
+	uint32_t owner_id = g_fdo_data->exchange_id;
+	bool reuse_to1d = false;
+	uint64_t delay = 0;
+
+	end_exchange();
+	if (g_fdo_data->exchange_result != 0 || g_fdo_data->prot.success == false) {
+		LOG(LOG_ERROR, "TO2 failed.\n");
+		g_fdo_data->state_fn = &_STATE_TO2;
+		/* Execute Sv_info type=FAILURE */
+		if (!fdo_mod_exec_sv_infotype(
+			g_fdo_data->prot.sv_info_mod_list_head,
+			FDO_SI_FAILURE)) {
+			LOG(LOG_ERROR, "Sv_info: One or more module's FAILURE "
+					"CB failed\n");
+		}
+		fdo_protTO2Exit(g_fdo_data);
+
+		fdo_retry_report(&g_fdo_data->retry, owner_id, false);
+		if (notify_error(FDO_TO2_ERROR)) {
+			rvbypass = false;
+			ERROR();
+			return false;
+		}
+
+		// Repeat some of the same operations as the failure case above
+		// when processing RendezvousInfo/RVTO2Addr and they need to be skipped
+		if (!rvbypass) {
+			// If the RVTO2Addr from TO1 is recent and its to1d was verified
+			// by an Owner, all its entries are retried without TO1, as a
+			// new round. Otherwise, back off with the failures of this
+			// Owner location.
+			reuse_to1d = !g_fdo_data->current_rvto2addrentry &&
+				     g_fdo_data->error_recovery && TO1D_CACHE_SEC > 0 &&
+				     g_fdo_data->prot.to1d_owner_key &&
+				     fdo_time_ms() < g_fdo_data->to1d_expiry_ms;
+			if (reuse_to1d) {
+				g_fdo_data->retry.failures++;
+				delay = fdo_retry_delay(&g_fdo_data->retry,
+							g_fdo_data->retry.failures,
+							default_delay, 0);
 			} else {
-				rvbypass = false;
+				delay = fdo_retry_delay(
+				    &g_fdo_data->retry,
+				    fdo_retry_failures(&g_fdo_data->retry, owner_id),
+				    default_delay, 0);
+			}
+			LOG(LOG_INFO, "\nDelaying for %"PRIu64" seconds\n\n", delay);
+			delay_next_state(delay);
+			// if there is another Owner location present, try it
+			// the execution reaches here only if rvbypass was never set
+			if (g_fdo_data->current_rvto2addrentry) {
+				LOG(LOG_ERROR, "Retrying TO2 using the next RVTO2AddrEntry\n");
+				g_fdo_data->state_fn = &_STATE_TO2;
+				// return true so that TO2 is processed with the remaining directives
+				ret = true;
+				return ret;
+			}
+			// there's no more owner locations left to try, so start over
+			// from the 1st RVTO2AddrEntry, or retry with TO1.
+			if (reuse_to1d) {
+				g_fdo_data->state_fn = &_STATE_TO2;
+				LOG(LOG_ERROR, "All RVTO2AddreEntry(s) exhausted. "
+					"Retrying TO2 using the RVTO2Addr from the last TO1\n");
+			} else if (g_fdo_data->error_recovery) {
+				// otherwise, start retrying with TO1, if retry is enabled.
 				g_fdo_data->state_fn = &_STATE_TO1;
-				if (g_fdo_data->delaysec == 0 || g_fdo_data->delaysec > max_delay) {
-					if (!g_fdo_data->current_rvdirective) {
-						g_fdo_data->delaysec = default_delay_rvinfo_retries;
-					} else {
-						g_fdo_data->delaysec = default_delay;
-					}
-				}
-				LOG(LOG_INFO, "\nDelaying for %"PRIu64" seconds\n\n", g_fdo_data->delaysec);
+				LOG(LOG_ERROR, "All RVTO2AddreEntry(s) exhausted. "
+					"Retrying TO1 using the next RendezvousDirective\n");
 			}
-			// if this is last directive (NULL), return false to mark end of 1 retry
-			// else if there are more directives left, return true for trying those
+		} else {
+			rvbypass = false;
+			g_fdo_data->state_fn = &_STATE_TO1;
+			// RVDelaysec if given, backing off with the rounds over all
+			// RendezvousDirectives, or the failures of this Owner otherwise
 			if (!g_fdo_data->current_rvdirective) {
-				ret = false;
+				g_fdo_data->retry.failures++;
+				g_fdo_data->delaysec = fdo_retry_delay(
+				    &g_fdo_data->retry, g_fdo_data->retry.failures,
+				    default_delay_rvinfo_retries, g_fdo_data->delaysec);
 			} else {
-				ret = true;
+				g_fdo_data->delaysec = fdo_retry_delay(
+				    &g_fdo_data->retry,
+				    fdo_retry_failures(&g_fdo_data->retry, owner_id),
+				    default_delay, g_fdo_data->delaysec);
 			}
-			return ret;
+			LOG(LOG_INFO, "\nDelaying for %"PRIu64" seconds\n\n", g_fdo_data->delaysec);
 		}
-
-		// if we reach here no failures occurred and TO2 has completed.
-		// So proceed for shutdown and break.
-		g_fdo_data->state_fn = &_STATE_Shutdown;
-		fdo_protTO2Exit(g_fdo_data);
-		fdo_prot_ctx_free(prot_ctx);
-		fdo_free(prot_ctx);
-
-		if (!rvbypass) {
-			// free only when rvbypass is false, since the allocation was done then.
-			if (ip) {
-				fdo_free(ip);
-			}
-			ip = NULL;
+		// if this is last directive (NULL), return false to mark end of 1 retry
+		// else if there are more directives left, return true for trying those
+		if (!g_fdo_data->current_rvdirective) {
+			ret = false;
 		} else {
-			// set the global rvbypass flag to false so that we don't continue the loop
-			// because of rvbypass
-			rvbypass = false;
+			ret = true;
 		}
-
-		LOG(LOG_DEBUG, "\n------------------------------------ TO2 Successful "
-				"--------------------------------------\n\n");
-		LOG(LOG_INFO, "@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@\n");
-		LOG(LOG_INFO, "@FIDO Device Onboard Complete@\n");
-		LOG(LOG_INFO, "@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@\n");
-		ret = true;
-	} else {
-		LOG(LOG_ERROR, "Invalid State\n");
+		return ret;
 	}
+
+	// if we reach here no failures occurred and TO2 has completed.
+	// So proceed for shutdown and break.
+	fdo_retry_report(&g_fdo_data->retry, owner_id, true);
+	g_fdo_data->state_fn = &_STATE_Shutdown;
+	fdo_protTO2Exit(g_fdo_data);
+
+	// set the global rvbypass flag to false so that we don't continue the loop
+	// because of rvbypass
+	rvbypass = false;
+
+	LOG(LOG_DEBUG, "\n------------------------------------ TO2 Successful "
+			"--------------------------------------\n\n");
+	LOG(LOG_INFO, "@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@\n");
+	LOG(LOG_INFO, "@FIDO Device Onboard Complete@\n");
+	LOG(LOG_INFO, "@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@\n");
+	ret = true;
 	return ret;
 }
 
@@ -1692,10 +2110,11 @@ static bool _STATE_Error(void)
  */
 static bool _STATE_Shutdown(void)
 {
-	if (g_fdo_data->prot.service_info && g_fdo_data->service_info) {
+	if (g_fdo_data->service_info) {
 		fdo_service_info_free(g_fdo_data->service_info);
 		g_fdo_data->service_info = NULL;
 	}
+	fdo_prot_ov_checkpoint_free(&g_fdo_data->prot);
 	if (g_fdo_data->devcred) {
 		fdo_dev_cred_free(g_fdo_data->devcred);
 		fdo_free(g_fdo_data->devcred);
@@ -1712,6 +2131,11 @@ static bool _STATE_Shutdown(void)
 		fdo_cose_free(g_fdo_data->prot.to1d_cose);
 		g_fdo_data->prot.to1d_cose = NULL;
 	}
+	if (g_fdo_data->prot.to1d_owner_key) {
+		fdo_public_key_free(g_fdo_data->prot.to1d_owner_key);
+		g_fdo_data->prot.to1d_owner_key = NULL;
+	}
+	g_fdo_data->to1d_expiry_ms = 0;
 
 	/* Closing all crypto related functions.*/
 	(void)fdo_crypto_close();
@@ -10,6 +10,7 @@
  */
 
 #include "fdoblockio.h"
+#include "fdobufpool.h"
 #include "util.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -63,7 +64,8 @@ bool fdo_block_alloc_with_size(fdo_block_t *fdob, size_t block_sz)
 	}
 	// if block exists, free it first, then alloc
 	if (fdob->block != NULL) {
-		fdo_free(fdob->block);
+		fdo_buf_pool_put(fdob->block);
+		fdob->block = NULL;
 	}
 	//Ensure that unsigned integer operations do not wrap
 	if (block_sz > SIZE_MAX / sizeof(uint8_t)) {
@@ -84,6 +86,33 @@ bool fdo_block_alloc_with_size(fdo_block_t *fdob, size_t block_sz)
 	return true;
 }
 
+/**
+ * Take the underlying block, of the given size, from the buffer pool.
+ *
+ * @param fdo_block_t - struct containg the buffer and its size
+ * @return true if the operation was a success, false otherwise
+ *
+ * NOTE: fdow_flush()/fdor_flush() give the block back to the pool.
+ */
+bool fdo_block_alloc_pooled(fdo_block_t *fdob, size_t block_sz)
+{
+	if (!fdob) {
+		return false;
+	}
+	if (fdob->block != NULL) {
+		fdo_buf_pool_put(fdob->block);
+		fdob->block = NULL;
+	}
+	fdob->block = fdo_buf_pool_get(block_sz);
+	if (fdob->block == NULL) {
+		LOG(LOG_ERROR, "FDOBlock alloc() failed!\n");
+		fdob->block_size = 0;
+		return false;
+	}
+	fdob->block_size = block_sz;
+	return true;
+}
+
 //==============================================================================
 // Write values in CBOR
 //
@@ -431,6 +460,27 @@ bool fdow_end_map(fdow_t *fdow)
 	return true;
 }
 
+/**
+ * Return the length of the CBOR head (initial byte plus argument) that encodes the given
+ * argument, i.e. the length, count or unsigned value of a data item.
+ * Used to compute encoded lengths without encoding.
+ *
+ * @param value - the argument to be encoded
+ * @return the length of the head, in bytes
+ */
+size_t fdow_head_length(uint64_t value) {
+	if (value < 24) {
+		return 1;
+	} else if (value <= UINT8_MAX) {
+		return 2;
+	} else if (value <= UINT16_MAX) {
+		return 3;
+	} else if (value <= UINT32_MAX) {
+		return 5;
+	}
+	return 9;
+}
+
 /**
  * Store the length of the CBOR data that has been written so far to the supplied buffer
  * (fdow_t.fdo_block_t.block) in the output size_t variable.
@@ -459,7 +509,8 @@ void fdow_flush(fdow_t *fdow)
 		fdo_block_t *fdob = &fdow->b;
 		if (fdob) {
 			fdo_block_reset(fdob);
-			fdo_free(fdob->block);
+			fdo_buf_pool_put(fdob->block);
+			fdob->block = NULL;
 		}
 		if (fdow->current) {
 			while (fdow->current->previous) {
@@ -536,6 +587,43 @@ bool fdor_parser_init(fdor_t *fdor) {
 	return true;
 }
 
+/**
+ * Initialize the given fdor_t struct to decode CBOR data directly from a buffer owned
+ * by the caller, without copying it. The buffer must stay valid and unmodified while
+ * decoding, and the struct must be cleared using fdor_view_flush() instead of fdor_flush().
+ * Calling this again on the same struct re-initializes it over the new buffer.
+ *
+ * @param fdor_t - struct fdor_t
+ * @param buffer - buffer containing the CBOR-encoded data
+ * @param buffer_length - size of the buffer
+ * @return true if the operation was a success, false otherwise
+ */
+bool fdor_view_init(fdor_t *fdor, const uint8_t *buffer, size_t buffer_length) {
+	if (!fdor || !buffer || !buffer_length) {
+		LOG(LOG_ERROR, "CBOR decoder: Invalid params\n");
+		return false;
+	}
+	// the block is borrowed and never written to, nor freed, by the decoder
+	fdor->b.block = (uint8_t *)buffer;
+	fdor->b.block_size = buffer_length;
+	return fdor_parser_init(fdor);
+}
+
+/**
+ * Deallocate the current node of an fdor_t struct initialized with fdor_view_init(),
+ * leaving the borrowed buffer untouched.
+ *
+ * @param fdor_t - struct fdor_t
+ */
+void fdor_view_flush(fdor_t *fdor)
+{
+	if (fdor) {
+		fdor->b.block = NULL;
+		fdor->b.block_size = 0;
+		fdor_flush(fdor);
+	}
+}
+
 /**
  * Mark the beginning of reading elements from a CBOR array (Major Type 4).
  *
@@ -718,6 +806,129 @@ bool fdor_text_string(fdor_t *fdor, char *buffer, size_t buffer_length) {
 	return true;
 }
 
+/**
+ * Locate the contents of the current definite-length bstr/tstr inside the input buffer
+ * and advance past it, without copying.
+ *
+ * @param fdor_t - struct fdor_t
+ * @param text - true for tstr (Major Type 3), false for bstr (Major Type 2)
+ * @param buffer - out pointer to the string contents inside the input buffer
+ * @param buffer_length - out length of the string
+ * @return true if the operation was a success, false otherwise
+ */
+static bool fdor_string_view(fdor_t *fdor, bool text, const uint8_t **buffer,
+	size_t *buffer_length) {
+	const uint8_t *header = NULL;
+	size_t header_length = 1;
+	size_t length = 0;
+
+	if (!fdor || !fdor->current || !buffer || !buffer_length) {
+		LOG(LOG_ERROR, "CBOR decoder: Invalid params\n");
+		return false;
+	}
+	if ((text ? !cbor_value_is_text_string(&fdor->current->cbor_value) :
+		!cbor_value_is_byte_string(&fdor->current->cbor_value)) ||
+		!cbor_value_is_length_known(&fdor->current->cbor_value) ||
+		cbor_value_get_string_length(&fdor->current->cbor_value, &length)
+			!= CborNoError) {
+		LOG(LOG_ERROR, "CBOR decoder: Failed to read Major Type 2/3 (bstr/tstr)\n");
+		return false;
+	}
+
+	// the contents follow the initial byte and its 0/1/2/4/8-byte length argument
+	header = cbor_value_get_next_byte(&fdor->current->cbor_value);
+	switch (header[0] & 0x1f) {
+	case 24:
+		header_length = 2;
+		break;
+	case 25:
+		header_length = 3;
+		break;
+	case 26:
+		header_length = 5;
+		break;
+	case 27:
+		header_length = 9;
+		break;
+	default:
+		header_length = 1;
+		break;
+	}
+
+	// advancing validates that the contents lie within the input buffer
+	if (!fdor_next(fdor)) {
+		return false;
+	}
+	*buffer = header + header_length;
+	*buffer_length = length;
+	return true;
+}
+
+/**
+ * Read a CBOR bstr (Major Type 2) value without copying it. The returned pointer
+ * refers to the fdor_t input buffer and is valid as long as that buffer is.
+ *
+ * @param fdor_t - struct fdor_t
+ * @param buffer - out pointer to the bstr contents
+ * @param buffer_length - out length of the bstr
+ * @return true if the operation was a success, false otherwise
+ */
+bool fdor_byte_string_view(fdor_t *fdor, const uint8_t **buffer, size_t *buffer_length) {
+	return fdor_string_view(fdor, false, buffer, buffer_length);
+}
+
+/**
+ * Read a CBOR tstr (Major Type 3) value without copying it. The returned pointer
+ * refers to the fdor_t input buffer, is valid as long as that buffer is, and is
+ * NOT NULL-terminated.
+ *
+ * @param fdor_t - struct fdor_t
+ * @param buffer - out pointer to the tstr contents
+ * @param buffer_length - out length of the tstr
+ * @return true if the operation was a success, false otherwise
+ */
+bool fdor_text_string_view(fdor_t *fdor, const char **buffer, size_t *buffer_length) {
+	return fdor_string_view(fdor, true, (const uint8_t **)buffer, buffer_length);
+}
+
+/**
+ * Get the complete CBOR encoding of the current item, including any tags and, for
+ * arrays and maps, all their contents, as it appears in the input buffer. The item
+ * is not consumed, so it can still be decoded after its raw bytes are hashed.
+ * The returned pointer is valid as long as the fdor_t input buffer is.
+ *
+ * @param fdor_t - struct fdor_t
+ * @param buffer - out pointer to the first byte of the encoded item
+ * @param buffer_length - out length of the encoded item
+ * @return true if the operation was a success, false otherwise
+ */
+bool fdor_item_view(fdor_t *fdor, const uint8_t **buffer, size_t *buffer_length) {
+	CborValue item;
+	const uint8_t *start = NULL;
+
+	if (!fdor || !fdor->current || !buffer || !buffer_length) {
+		LOG(LOG_ERROR, "CBOR decoder: Invalid params\n");
+		return false;
+	}
+
+	// advance a copy, leaving the decoder where it is
+	item = fdor->current->cbor_value;
+	start = cbor_value_get_next_byte(&item);
+	while (cbor_value_is_tag(&item)) {
+		if (cbor_value_advance_fixed(&item) != CborNoError) {
+			LOG(LOG_ERROR, "CBOR decoder: Failed to skip tag\n");
+			return false;
+		}
+	}
+	if (cbor_value_at_end(&item) || cbor_value_advance(&item) != CborNoError) {
+		LOG(LOG_ERROR, "CBOR decoder: Failed to advance over item\n");
+		return false;
+	}
+	*buffer = start;
+	*buffer_length = (size_t)(cbor_value_get_next_byte(&item) - start);
+	return true;
+}
+
 /**
  * Check if the current value is CBOR NULL (Major Type 7, Additional Info 22) value.
  *
@@ -964,7 +1175,8 @@ void fdor_flush(fdor_t *fdor)
 		fdo_block_t *fdob = &fdor->b;
 		if (fdob) {
 			fdo_block_reset(fdob);
-			fdo_free(fdob->block);
+			fdo_buf_pool_put(fdob->block);
+			fdob->block = NULL;
 		}
 		if (fdor->current) {
 			while (fdor->current->previous) {
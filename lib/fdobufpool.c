@@ -0,0 +1,198 @@
+/*
+ * Copyright 2020 Intel Corporation
+ * SPDX-License-Identifier: Apache 2.0
+ */
+
+/*!
+ * \file
+ * \brief Pool of the message buffers: the send/receive blocks, the receive
+ * buffer of the network layer, the AAD writers and the ServiceInfo module
+ * writers all draw from it. A buffer given back is cleared and reused by
+ * the next request that fits in it, and the bytes held by the pool never
+ * go over BUFFER_POOL_SZ. Without that ceiling, a request that finds all
+ * the slots in use is served by fdo_alloc() instead.
+ */
+
+#include "fdobufpool.h"
+#include "util.h"
+#include "safe_lib.h"
+
+typedef struct fdo_buf_slot_s {
+	uint8_t *buf; // NULL if the slot is free
+	size_t size;
+	bool in_use;
+} fdo_buf_slot_t;
+
+static fdo_buf_slot_t pool[FDO_BUF_POOL_SLOTS];
+static size_t pool_bytes; // held by the pool, in use or not
+static size_t pool_peak;
+static size_t pool_cap = BUFFER_POOL_SZ; // 0 for no ceiling
+
+/**
+ * Free the buffer of the given slot, which must not be in use.
+ */
+static void buf_pool_release(fdo_buf_slot_t *slot)
+{
+	pool_bytes -= slot->size;
+	fdo_free(slot->buf);
+	slot->size = 0;
+}
+
+/**
+ * Find the unused buffer to give up first: the largest one, since it's
+ * the one that makes the most room.
+ */
+static fdo_buf_slot_t *buf_pool_spare(void)
+{
+	fdo_buf_slot_t *spare = NULL;
+	int i;
+
+	for (i = 0; i < FDO_BUF_POOL_SLOTS; i++) {
+		if (pool[i].buf && !pool[i].in_use &&
+		    (!spare || pool[i].size > spare->size)) {
+			spare = &pool[i];
+		}
+	}
+	return spare;
+}
+
+/**
+ * Get a zeroed buffer of at least the given size. The smallest unused
+ * buffer that fits is reused, otherwise a new one is allocated, after
+ * freeing unused buffers as needed to stay under the pool ceiling.
+ *
+ * @param size
+ *        Number of bytes needed.
+ * @return
+ *        the buffer, NULL if the pool can't provide it.
+ */
+uint8_t *fdo_buf_pool_get(size_t size)
+{
+	fdo_buf_slot_t *slot = NULL;
+	fdo_buf_slot_t *spare = NULL;
+	int i;
+
+	if (size == 0) {
+		return NULL;
+	}
+
+	for (i = 0; i < FDO_BUF_POOL_SLOTS; i++) {
+		if (pool[i].buf && !pool[i].in_use && pool[i].size >= size &&
+		    (!slot || pool[i].size < slot->size)) {
+			slot = &pool[i];
+		}
+	}
+	if (slot) {
+		slot->in_use = true;
+		return slot->buf;
+	}
+
+	if (pool_cap > 0 && size > pool_cap) {
+		LOG(LOG_ERROR, "Buffer of %zu bytes is over the pool size\n",
+		    size);
+		return NULL;
+	}
+	while (pool_cap > 0 && pool_bytes + size > pool_cap) {
+		spare = buf_pool_spare();
+		if (!spare) {
+			LOG(LOG_ERROR, "Buffer pool exhausted, %zu bytes in use\n",
+			    pool_bytes);
+			return NULL;
+		}
+		buf_pool_release(spare);
+	}
+
+	for (i = 0; i < FDO_BUF_POOL_SLOTS && !slot; i++) {
+		if (!pool[i].buf) {
+			slot = &pool[i];
+		}
+	}
+	if (!slot) {
+		slot = buf_pool_spare();
+		if (!slot && pool_cap == 0) {
+			// nothing to keep under, fdo_buf_pool_put() frees it
+			return fdo_alloc(size);
+		}
+		if (!slot) {
+			LOG(LOG_ERROR, "All the %d pool buffers are in use\n",
+			    FDO_BUF_POOL_SLOTS);
+			return NULL;
+		}
+		buf_pool_release(slot);
+	}
+
+	slot->buf = fdo_alloc(size);
+	if (!slot->buf) {
+		LOG(LOG_ERROR, "Failed to alloc pool buffer\n");
+		return NULL;
+	}
+	slot->size = size;
+	slot->in_use = true;
+	pool_bytes += size;
+	if (pool_bytes > pool_peak) {
+		pool_peak = pool_bytes;
+	}
+	return slot->buf;
+}
+
+/**
+ * Give a buffer back to the pool. It is cleared, since it may hold
+ * cleartext, and kept for reuse. A buffer that doesn't come from the pool
+ * is freed.
+ *
+ * @param buf
+ *        Buffer from fdo_buf_pool_get(), or from fdo_alloc().
+ */
+void fdo_buf_pool_put(uint8_t *buf)
+{
+	int i;
+
+	if (!buf) {
+		return;
+	}
+	for (i = 0; i < FDO_BUF_POOL_SLOTS; i++) {
+		if (pool[i].buf == buf) {
+			if (memset_s(buf, pool[i].size, 0) != 0) {
+				LOG(LOG_ERROR, "Failed to clear pool buffer\n");
+			}
+			pool[i].in_use = false;
+			return;
+		}
+	}
+	fdo_free(buf);
+}
+
+/**
+ * Free the buffers that aren't in use.
+ */
+void fdo_buf_pool_drain(void)
+{
+	int i;
+
+	for (i = 0; i < FDO_BUF_POOL_SLOTS; i++) {
+		if (pool[i].buf && !pool[i].in_use) {
+			buf_pool_release(&pool[i]);
+		}
+	}
+	LOG(LOG_DEBUG, "Buffer pool peak: %zu bytes\n", pool_peak);
+}
+
+/**
+ * Set the most bytes the pool holds at once, in place of BUFFER_POOL_SZ.
+ * The buffers already held are kept until they are given back.
+ *
+ * @param cap
+ *        Number of bytes, 0 for no ceiling.
+ */
+void fdo_buf_pool_set_cap(size_t cap)
+{
+	pool_cap = cap;
+}
+
+/**
+ * Return the most bytes the pool held at once.
+ */
+size_t fdo_buf_pool_peak(void)
+{
+	return pool_peak;
+}
@@ -271,13 +271,16 @@ void fdo_ov_free(fdo_ownership_voucher_t *ov)
 }
 
 /**
- * Read the OwnershipVoucher header passed in TO2.ProveOVHeader
- * @param ovheader - the received CBOR-encoded OVHeader
+ * Read the OwnershipVoucher header received in DI.SetCredentials or TO2.ProveOVHdr.
+ * The header is parsed in place, and the HMAC is computed over the received bytes.
+ * @param ovheader - view of the received CBOR-encoded OVHeader
  * @param hmac a place top store the resulting HMAC
- * @param cal_hp_hc - calculate hp, hc if true.
+ * @param read_rvinfo - decode OVRVInfo into rvlst2 if true, skip it otherwise.
+ * TO2 skips it, since the device already has it and the HMAC covers it.
  * @return A newly allocated OwnershipVoucher with the header completed
  */
-fdo_ownership_voucher_t *fdo_ov_hdr_read(fdo_byte_array_t *ovheader, fdo_hash_t **hmac)
+fdo_ownership_voucher_t *fdo_ov_hdr_read(const fdo_byte_view_t *ovheader,
+					 fdo_hash_t **hmac, bool read_rvinfo)
 {
 
 	if (!ovheader || !hmac) {
@@ -294,30 +297,13 @@ fdo_ownership_voucher_t *fdo_ov_hdr_read(fdo_byte_array_t *ovheader, fdo_hash_t
 		return NULL;
 	}
 
-	if (memset_s(&fdor, sizeof(fdor_t), 0) != 0) {
-		LOG(LOG_ERROR, "OVheader: Failed to intialize temporary FDOR\n");
-		return NULL;
-	}
 	if (!fdor_init(&fdor) ||
-		!fdo_block_alloc_with_size(&fdor.b, ovheader->byte_sz)) {
+		!fdor_view_init(&fdor, ovheader->bytes, ovheader->byte_sz)) {
 		LOG(LOG_ERROR,
 			"OVHeader: Failed to setup temporary FDOR\n");
 		goto exit;
 	}
 
-	if (0 != memcpy_s(fdor.b.block, fdor.b.block_size,
-		ovheader->bytes, ovheader->byte_sz)) {
-		LOG(LOG_ERROR,
-			"OVHeader: Failed to copy temporary data\n");
-		goto exit;
-	}
-
-	if (!fdor_parser_init(&fdor)) {
-		LOG(LOG_ERROR,
-			"OVHeader: Failed to init temporary FDOR parser\n");
-		goto exit;
-	}
-
 	// OVHeader is of size 6 always.
 	if (!fdor_array_length(&fdor, &num_ov_items) || num_ov_items != 6) {
 		LOG(LOG_ERROR, "%s Invalid OVHeader: Invalid OVHeader array length\n", __func__);
@@ -351,18 +337,25 @@ fdo_ownership_voucher_t *fdo_ov_hdr_read(fdo_byte_array_t *ovheader, fdo_hash_t
 	}
 
 	// Rendezvous
-	ov->rvlst2 = fdo_rendezvous_list_alloc();
+	if (!read_rvinfo) {
+		if (!fdor_next(&fdor)) {
+			LOG(LOG_ERROR, "%s Invalid OVHeader: Unable to skip OVRvInfo\n", __func__);
+			goto exit;
+		}
+	} else {
+		ov->rvlst2 = fdo_rendezvous_list_alloc();
 
-	if (!ov->rvlst2 || !fdo_rendezvous_list_read(&fdor, ov->rvlst2)) {
-		LOG(LOG_ERROR, "%s Invalid OVHeader: Unable to decode OVRvInfo\n", __func__);
-		goto exit;
-	}
+		if (!ov->rvlst2 || !fdo_rendezvous_list_read(&fdor, ov->rvlst2)) {
+			LOG(LOG_ERROR, "%s Invalid OVHeader: Unable to decode OVRvInfo\n", __func__);
+			goto exit;
+		}
 
-	/* There must be at-least 1 valid rv entry, if not its a error-case */
-	if (ov->rvlst2->num_rv_directives == 0) {
-		LOG(LOG_ERROR,
-		    "Invalid OVHeader: All rendezvous entries are invalid for the device!\n");
-		goto exit;
+		/* There must be at-least 1 valid rv entry, if not its a error-case */
+		if (ov->rvlst2->num_rv_directives == 0) {
+			LOG(LOG_ERROR,
+			    "Invalid OVHeader: All rendezvous entries are invalid for the device!\n");
+			goto exit;
+		}
 	}
 
 	// Device_info String
@@ -408,14 +401,12 @@ fdo_ownership_voucher_t *fdo_ov_hdr_read(fdo_byte_array_t *ovheader, fdo_hash_t
 	fdo_ov_hdr_hmac(ovheader, hmac);
 	ret = 0;
 exit:
+	fdor_view_flush(&fdor);
 	if (ret) {
 		LOG(LOG_ERROR, "Ov_hdr Error\n");
 		fdo_ov_free(ov);
 		return NULL;
 	}
-	if (fdor.b.block || fdor.current) {
-		fdor_flush(&fdor);
-	}
 	return ov;
 }
 
@@ -426,7 +417,7 @@ exit:
  * @param num_ov_items - number of items in ownership voucher header
  * @return true if hmac was successfully generated, false otherwise.
  */
-bool fdo_ov_hdr_hmac(fdo_byte_array_t *ovheader, fdo_hash_t **hmac) {
+bool fdo_ov_hdr_hmac(const fdo_byte_view_t *ovheader, fdo_hash_t **hmac) {
 
 	bool ret = false;
 	// Create the HMAC
@@ -437,7 +428,7 @@ bool fdo_ov_hdr_hmac(fdo_byte_array_t *ovheader, fdo_hash_t **hmac) {
 		goto exit;
 	}
 
-	if (0 != fdo_device_ov_hmac(ovheader->bytes, ovheader->byte_sz,
+	if (0 != fdo_device_ov_hmac((uint8_t *)ovheader->bytes, ovheader->byte_sz,
 				    (*hmac)->hash->bytes,
 				    (*hmac)->hash->byte_sz, false)) {
 		fdo_hash_free(*hmac);
@@ -514,21 +505,21 @@ bool fdo_ovheader_write(fdow_t *fdow, int protver, fdo_byte_array_t *guid, fdo_r
 bool fdo_ove_hash_hdr_info_save(fdo_ownership_voucher_t *ov) {
 
 	bool ret = false;
-	// calculate and save OVEHashHdrInfo (hash[GUID||DeviceInfo])
-	// Header Hash Info is of length OVGuid length + OVDeviceInfo length
-	uint8_t *hash_hdr_info = fdo_alloc(ov->g2->byte_sz + ov->dev_info->byte_sz);
-	if (!hash_hdr_info) {
-		LOG(LOG_ERROR, "OVEHashHdrInfo: Failed to alloc for OVEHashHdrInfo\n");
+	// calculate and save OVEHashHdrInfo (hash[GUID||DeviceInfo]),
+	// hashing both in turn rather than copying them together
+	void *hash_ctx = fdo_crypto_hash_init();
+	if (!hash_ctx) {
+		LOG(LOG_ERROR, "OVEHashHdrInfo: Failed to start hash\n");
 		goto exit;
 	}
-	if (0 != memcpy_s(hash_hdr_info, ov->g2->byte_sz,
-		ov->g2->bytes, ov->g2->byte_sz)) {
-		LOG(LOG_ERROR, "OVEHashHdrInfo: Failed to copy GUID\n");
+	if (0 != fdo_crypto_hash_update(hash_ctx, ov->g2->bytes, ov->g2->byte_sz)) {
+		LOG(LOG_ERROR, "OVEHashHdrInfo: Failed to hash GUID\n");
 		goto exit;
 	}
-	if (0 != memcpy_s(hash_hdr_info + ov->g2->byte_sz, ov->dev_info->byte_sz,
-		ov->dev_info->bytes, ov->dev_info->byte_sz)) {
-		LOG(LOG_ERROR, "OVEHashHdrInfo: Failed to copy DeviceInfo\n");
+	if (ov->dev_info->byte_sz > 0 &&
+		0 != fdo_crypto_hash_update(hash_ctx, (uint8_t *)ov->dev_info->bytes,
+		ov->dev_info->byte_sz)) {
+		LOG(LOG_ERROR, "OVEHashHdrInfo: Failed to hash DeviceInfo\n");
 		goto exit;
 	}
 
@@ -538,16 +529,18 @@ bool fdo_ove_hash_hdr_info_save(fdo_ownership_voucher_t *ov) {
 		LOG(LOG_ERROR, "OVEHashHdrInfo: Failed to alloc OVEHashHdrInfo in storage\n");
 		goto exit;
 	}
-	if (0 != fdo_crypto_hash(hash_hdr_info, ov->g2->byte_sz + ov->dev_info->byte_sz,
+	if (0 != fdo_crypto_hash_final(hash_ctx,
 		ov->ov_entries->hc_hash->hash->bytes,
 		ov->ov_entries->hc_hash->hash->byte_sz)) {
+		hash_ctx = NULL;
 		LOG(LOG_ERROR, "OVEHashHdrInfo: Failed to generate hash\n");
 		goto exit;
 	}
+	hash_ctx = NULL;
 	ret = true;
 exit:
-	if (hash_hdr_info) {
-		fdo_free(hash_hdr_info);
+	if (hash_ctx) {
+		fdo_crypto_hash_final(hash_ctx, NULL, 0);
 	}
 	if (!ret && ov->ov_entries->hc_hash) {
 		fdo_hash_free(ov->ov_entries->hc_hash);
@@ -557,78 +550,29 @@ exit:
 
 /**
  * Given an OwnershipVoucher and hmac, calculate and save the OVEHashPrevEntry.
- * @param fdow - fdow_t object to use for encoding data into CBOR
+ * The hash is taken over the OVHeader and HMac as received, so that neither is
+ * re-encoded nor copied.
+ * @param ovheader - view of the received CBOR-encoded OVHeader
+ * @param hmac - view of the received CBOR-encoded HMac
  * @param ov - pointer to the fdo_ownership_voucher_t object
- * @param hmac - OVHeaderHMac.OVHeaderHMac object
  * @return true if operation is a success, false otherwise
  */
-bool fdo_ove_hash_prev_entry_save(fdow_t *fdow, fdo_ownership_voucher_t *ov,
-	fdo_hash_t *hmac) {
+bool fdo_ove_hash_prev_entry_save(const fdo_byte_view_t *ovheader,
+	const fdo_byte_view_t *hmac, fdo_ownership_voucher_t *ov) {
 
 	bool ret = false;
-	fdo_byte_array_t *enc_ovheader = NULL;
-	fdo_byte_array_t *enc_hmac = NULL;
-	uint8_t *hash_prev_entry = NULL;
-	// save the default buffer size, set it back at the end
-	size_t fdow_buff_default_sz = fdow->b.block_size;
-
-	// reset the block to write OVHeader
-	fdo_block_reset(&fdow->b);
-	fdow->b.block_size = fdow_buff_default_sz;
-	if (!fdow_encoder_init(fdow)) {
-		LOG(LOG_ERROR, "OVEHashPrevEntry: Failed to initialize FDOW encoder\n");
-		goto exit;
-	}
-
-	// write OVHeader
-	if (!fdo_ovheader_write(fdow, ov->prot_version, ov->g2, ov->rvlst2,
-		ov->dev_info, ov->mfg_pub_key, ov->hdc)) {
-		LOG(LOG_ERROR, "OVEHashPrevEntry: Failed to write OVHeader\n");
-		goto exit;
-	}
-	enc_ovheader = fdo_byte_array_alloc_with_byte_array(fdow->b.block, fdow->b.block_size);
-	if (!enc_ovheader) {
-		LOG(LOG_ERROR, "OVEHashPrevEntry: Failed to copy encoded OVHeader\n");
-		goto exit;
-	}
-
-	// reset the FDOW block to write HMac
-	fdo_block_reset(&fdow->b);
-	fdow->b.block_size = fdow_buff_default_sz;
-	if (!fdow_encoder_init(fdow)) {
-		LOG(LOG_ERROR, "OVEHashPrevEntry: Failed to initialize FDOW encoder\n");
-		goto exit;
-	}
-
-	// write HMac
-	if (!fdo_hash_write(fdow, hmac)) {
-		LOG(LOG_ERROR, "OVEHashPrevEntry: Failed to write HMac\n");
-		goto exit;
-	}
-	if (!fdow_encoded_length(fdow, &fdow->b.block_size)) {
-		LOG(LOG_ERROR, "OVEHashPrevEntry: Failed to get HMac length\n");
-		goto exit;
-	}
-	enc_hmac = fdo_byte_array_alloc_with_byte_array(fdow->b.block, fdow->b.block_size);
-	if (!enc_hmac) {
-		LOG(LOG_ERROR, "OVEHashPrevEntry: Failed to copy encoded HMac\n");
-		goto exit;
-	}
 	// calculate and save OVEHashPrevEntry (hash[OVHeader||HMac])
-	// Prev Entry Hash is of length OVHeader length + HMac length
-	hash_prev_entry = fdo_alloc(enc_ovheader->byte_sz + enc_hmac->byte_sz);
-	if (!hash_prev_entry) {
-		LOG(LOG_ERROR, "OVEHashPrevEntry: Failed to alloc for OVEHashPrevEntry\n");
+	void *hash_ctx = fdo_crypto_hash_init();
+	if (!hash_ctx) {
+		LOG(LOG_ERROR, "OVEHashPrevEntry: Failed to start hash\n");
 		goto exit;
 	}
-	if (0 != memcpy_s(hash_prev_entry, enc_ovheader->byte_sz,
-		enc_ovheader->bytes, enc_ovheader->byte_sz)) {
-		LOG(LOG_ERROR, "OVEHashPrevEntry: Failed to copy OVHeader\n");
+	if (0 != fdo_crypto_hash_update(hash_ctx, ovheader->bytes, ovheader->byte_sz)) {
+		LOG(LOG_ERROR, "OVEHashPrevEntry: Failed to hash OVHeader\n");
 		goto exit;
 	}
-	if (0 != memcpy_s(hash_prev_entry + enc_ovheader->byte_sz, enc_hmac->byte_sz,
-		enc_hmac->bytes, enc_hmac->byte_sz)) {
-		LOG(LOG_ERROR, "OVEHashPrevEntry: Failed to copy HMac\n");
+	if (0 != fdo_crypto_hash_update(hash_ctx, hmac->bytes, hmac->byte_sz)) {
+		LOG(LOG_ERROR, "OVEHashPrevEntry: Failed to hash HMac\n");
 		goto exit;
 	}
 
@@ -638,30 +582,18 @@ bool fdo_ove_hash_prev_entry_save(fdow_t *fdow, fdo_ownership_voucher_t *ov,
 		LOG(LOG_ERROR, "OVEHashPrevEntry: Failed to alloc for OVEHashPrevEntry in storage\n");
 		goto exit;
 	}
-	if (0 != fdo_crypto_hash(hash_prev_entry, enc_ovheader->byte_sz + enc_hmac->byte_sz,
+	if (0 != fdo_crypto_hash_final(hash_ctx,
 		ov->ov_entries->hp_hash->hash->bytes,
 		ov->ov_entries->hp_hash->hash->byte_sz)) {
+		hash_ctx = NULL;
 		LOG(LOG_ERROR, "OVEHashPrevEntry: Failed to generate hash\n");
 		goto exit;
 	}
+	hash_ctx = NULL;
 	ret = true;
-
-	// reset the given FDOW for the next encoding
-	fdo_block_reset(&fdow->b);
-	fdow->b.block_size = fdow_buff_default_sz;
-	if (!fdow_encoder_init(fdow)) {
-		LOG(LOG_ERROR, "OVEHashPrevEntry: Failed to initialize FDOW encoder\n");
-		goto exit;
-	}
 exit:
-	if (enc_ovheader) {
-		fdo_byte_array_free(enc_ovheader);
-	}
-	if (enc_hmac) {
-		fdo_byte_array_free(enc_hmac);
-	}
-	if (hash_prev_entry) {
-		fdo_free(hash_prev_entry);
+	if (hash_ctx) {
+		fdo_crypto_hash_final(hash_ctx, NULL, 0);
 	}
 	if (!ret && ov->ov_entries->hp_hash) {
 		fdo_hash_free(ov->ov_entries->hp_hash);
@@ -280,6 +280,7 @@ bool fdo_prot_to2_init(fdo_prot_t *ps, fdo_service_info_t *si,
 
 	ps->success = false;
 	ps->service_info = si;
+	ps->devmod_info = si;
 	ps->dev_cred = dev_cred;
 	ps->g2 = dev_cred->owner_blk->guid;
 	ps->round_trip_count = 0;
@@ -356,6 +357,137 @@ bool fdo_check_to2_round_trips(fdo_prot_t *ps)
 	return true;
 }
 
+/**
+ * Check whether the given hash is the checkpoint hash at the given index.
+ */
+static bool ov_checkpoint_match(fdo_ov_checkpoint_t *cp, int index,
+				fdo_hash_t *hash)
+{
+	int result_memcmp = 1;
+
+	if (index < 0 || index >= cp->num_hashes || !hash || !hash->hash ||
+	    hash->hash->byte_sz != FDO_SHA_DIGEST_SIZE_USED) {
+		return false;
+	}
+	return memcmp_s(cp->hashes + (size_t)index * FDO_SHA_DIGEST_SIZE_USED,
+			FDO_SHA_DIGEST_SIZE_USED, hash->hash->bytes,
+			FDO_SHA_DIGEST_SIZE_USED, &result_memcmp) == 0 &&
+	       result_memcmp == 0;
+}
+
+/**
+ * Start checking the received Ownership Voucher against the OVEntries verified
+ * by previous TO2 attempts. The checkpoint is kept if it is for the same
+ * OVHeader, and restarted otherwise.
+ *
+ * @param ps
+ *        Pointer to the database containtain all protocol state variables.
+ * @param hdr_hash
+ *        Initial OVEHashPrevEntry, the hash of OVHeader and HMac.
+ * @param num_ov_entries
+ *        Number of OVEntries to follow.
+ */
+void fdo_prot_ov_checkpoint_start(fdo_prot_t *ps, fdo_hash_t *hdr_hash,
+				  int num_ov_entries)
+{
+	fdo_ov_checkpoint_t *cp = &ps->ov_checkpoint;
+
+	if (ov_checkpoint_match(cp, 0, hdr_hash)) {
+		LOG(LOG_DEBUG, "TO2: %d OVEntry(s) verified by a previous attempt\n",
+		    cp->num_hashes - 1);
+		return;
+	}
+
+	// a different voucher, the checkpoint is only an optimization, so
+	// failures leave it empty
+	fdo_prot_ov_checkpoint_free(ps);
+	if (!hdr_hash || !hdr_hash->hash ||
+	    hdr_hash->hash->byte_sz != FDO_SHA_DIGEST_SIZE_USED ||
+	    num_ov_entries < 0 || num_ov_entries > MAX_NO_OVENTRIES) {
+		return;
+	}
+	cp->hashes = fdo_alloc((size_t)(num_ov_entries + 1) * FDO_SHA_DIGEST_SIZE_USED);
+	if (!cp->hashes) {
+		return;
+	}
+	if (memcpy_s(cp->hashes, FDO_SHA_DIGEST_SIZE_USED, hdr_hash->hash->bytes,
+		     FDO_SHA_DIGEST_SIZE_USED) != 0) {
+		fdo_prot_ov_checkpoint_free(ps);
+		return;
+	}
+	cp->max_hashes = num_ov_entries + 1;
+	cp->num_hashes = 1;
+}
+
+/**
+ * Check whether the given OVEntry was verified by a previous TO2 attempt.
+ *
+ * @param ps
+ *        Pointer to the database containtain all protocol state variables.
+ * @param entry_num
+ *        OVEntryNum of the OVEntry.
+ * @param prev_hash
+ *        OVEHashPrevEntry expected by the OVEntry.
+ * @param entry_hash
+ *        Hash of the OVEntry, as received.
+ * @return
+ *        true if the OVEntry was already verified, false otherwise.
+ */
+bool fdo_prot_ov_checkpoint_verified(fdo_prot_t *ps, int entry_num,
+				     fdo_hash_t *prev_hash,
+				     fdo_hash_t *entry_hash)
+{
+	return ov_checkpoint_match(&ps->ov_checkpoint, entry_num, prev_hash) &&
+	       ov_checkpoint_match(&ps->ov_checkpoint, entry_num + 1, entry_hash);
+}
+
+/**
+ * Record an OVEntry whose signature has just been verified, if it extends the
+ * checkpoint.
+ *
+ * @param ps
+ *        Pointer to the database containtain all protocol state variables.
+ * @param entry_num
+ *        OVEntryNum of the OVEntry.
+ * @param prev_hash
+ *        OVEHashPrevEntry of the OVEntry.
+ * @param entry_hash
+ *        Hash of the OVEntry.
+ */
+void fdo_prot_ov_checkpoint_add(fdo_prot_t *ps, int entry_num,
+				fdo_hash_t *prev_hash, fdo_hash_t *entry_hash)
+{
+	fdo_ov_checkpoint_t *cp = &ps->ov_checkpoint;
+
+	if (entry_num + 1 != cp->num_hashes || cp->num_hashes >= cp->max_hashes ||
+	    !ov_checkpoint_match(cp, entry_num, prev_hash) || !entry_hash ||
+	    !entry_hash->hash ||
+	    entry_hash->hash->byte_sz != FDO_SHA_DIGEST_SIZE_USED) {
+		return;
+	}
+	if (memcpy_s(cp->hashes + (size_t)cp->num_hashes * FDO_SHA_DIGEST_SIZE_USED,
+		     FDO_SHA_DIGEST_SIZE_USED, entry_hash->hash->bytes,
+		     FDO_SHA_DIGEST_SIZE_USED) != 0) {
+		return;
+	}
+	cp->num_hashes++;
+}
+
+/**
+ * Drop the OVEntries verified by previous TO2 attempts.
+ *
+ * @param ps
+ *        Pointer to the database containtain all protocol state variables.
+ */
+void fdo_prot_ov_checkpoint_free(fdo_prot_t *ps)
+{
+	if (ps->ov_checkpoint.hashes) {
+		fdo_free(ps->ov_checkpoint.hashes);
+	}
+	ps->ov_checkpoint.num_hashes = 0;
+	ps->ov_checkpoint.max_hashes = 0;
+}
+
 /**
  * Check if we have received a REST message.
  *
@@ -23,9 +23,12 @@
 #include "safe_lib.h"
 #include "snprintf_s.h"
 #include "rest_interface.h"
+#include "fdobufpool.h"
 
 #define CONNECTION_RETRY 2
 
+static void prot_ctx_finish(fdo_prot_ctx_t *prot_ctx);
+
 /**
  * fdo_prot_ctx_alloc responsible for allocation of required protocol context.
  * @param protrun - pointer to function for intended protocol (DI/TO1/TO2).
@@ -71,10 +74,19 @@ fdo_prot_ctx_t *fdo_prot_ctx_alloc(bool (*protrun)(fdo_prot_t *ps),
 		}
 	}
 
-	// use the DNS directly, since the DNS is resolved and cached,
-	// and the resolved IP is used directly
+	// copy the DNS too, the exchange may outlive the caller's buffer when
+	// it is stepped through fdo_prot_ctx_step()
 	if (host_dns) {
-		prot_ctx->host_dns = host_dns;
+		size_t dns_len = strnlen_s(host_dns, FDO_MAX_STR_SIZE);
+
+		prot_ctx->host_dns_copy = fdo_alloc(dns_len + 1);
+		if (!prot_ctx->host_dns_copy ||
+		    strncpy_s(prot_ctx->host_dns_copy, dns_len + 1, host_dns,
+			      dns_len) != 0) {
+			LOG(LOG_ERROR, "Failed to copy host DNS\n");
+			goto err;
+		}
+		prot_ctx->host_dns = prot_ctx->host_dns_copy;
 	}
 
 	prot_ctx->protdata = protdata;
@@ -87,6 +99,10 @@ err:
 	if (prot_ctx->host_ip) {
 		fdo_free(prot_ctx->host_ip);
 	}
+	if (prot_ctx->host_dns_copy) {
+		fdo_free(prot_ctx->host_dns_copy);
+	}
+	fdo_free(prot_ctx);
 	return NULL;
 }
 
@@ -96,6 +112,12 @@ err:
 void fdo_prot_ctx_free(fdo_prot_ctx_t *prot_ctx)
 {
 	if (prot_ctx) {
+		// an exchange left part way through
+		prot_ctx_finish(prot_ctx);
+		if (prot_ctx->host_dns_copy) {
+			fdo_free(prot_ctx->host_dns_copy);
+			prot_ctx->host_dns = NULL;
+		}
 		if (prot_ctx->resolved_ip) {
 			fdo_free(prot_ctx->resolved_ip);
 		}
@@ -227,238 +249,358 @@ static bool fdo_prot_ctx_connect(fdo_prot_ctx_t *prot_ctx)
 }
 
 /**
- * fdo_prot_ctx_run responsible for running/maintaining DI, T01, T02 protocol
- * contexts and respond according to the state specified.
- * Managing the JSON packet to/from device to server is taken care.
- * Managing the ip/dns-to-ip resolution is taken care.
- * @param prot_ctx - Pointer of type fdo_prot_ctx_t, holds the all the
- * information,
+ * Start the protocol exchange: take the response header buffer and set up
+ * the network connection.
+ * @param prot_ctx - Pointer of type fdo_prot_ctx_t.
  * @return 0 on success, -1 on error.
  */
-
-int fdo_prot_ctx_run(fdo_prot_ctx_t *prot_ctx)
+static int prot_ctx_start(fdo_prot_ctx_t *prot_ctx)
 {
-	int ret = 0;
-	int n, size;
-	int retries = 0;
-	fdor_t *fdor = NULL;
-	fdow_t *fdow = NULL;
-
-	if (!prot_ctx || !prot_ctx->protdata) {
+	// the same header buffer serves every message of the protocol, the
+	// body is received straight into the FDOR block
+	prot_ctx->curl_buf = (char *)fdo_buf_pool_get(REST_MAX_MSGHDR_SIZE);
+	if (!prot_ctx->curl_buf) {
+		LOG(LOG_ERROR, "Failed to get the receive buffer!\n");
 		return -1;
 	}
-	fdor = &prot_ctx->protdata->fdor;
-	fdow = &prot_ctx->protdata->fdow;
 
 	// init connection set-up for send/receive packets
 	if (fdo_con_setup(NULL, NULL, 0)) {
 		LOG(LOG_ERROR, "Connection setup failed!\n");
+		fdo_buf_pool_put((uint8_t *)prot_ctx->curl_buf);
+		prot_ctx->curl_buf = NULL;
 		return -1;
 	}
+	prot_ctx->phase = FDO_PROT_CTX_SEND;
+	return 0;
+}
 
-	for (;;) {
-
-		// initialize the encoder before every write operation
-		if (!fdow_encoder_init(fdow)) {
-			LOG(LOG_ERROR, "Failed to initilize FDOW encoder\n");
-			return -1;
+/**
+ * End the protocol exchange, closing the connection if a response was still
+ * awaited, and give back what prot_ctx_start() took.
+ * @param prot_ctx - Pointer of type fdo_prot_ctx_t.
+ */
+static void prot_ctx_finish(fdo_prot_ctx_t *prot_ctx)
+{
+	if (prot_ctx->phase == FDO_PROT_CTX_IDLE) {
+		return;
+	}
+	if (prot_ctx->phase == FDO_PROT_CTX_RECV &&
+	    prot_ctx->sock_hdl != FDO_CON_INVALID_HANDLE) {
+		if (fdo_con_disconnect(prot_ctx->sock_hdl, prot_ctx->tls)) {
+			LOG(LOG_ERROR, "Error during socket close()\n");
 		}
+		prot_ctx->sock_hdl = FDO_CON_INVALID_HANDLE;
+	}
+	fdo_con_teardown();
+	fdo_buf_pool_put((uint8_t *)prot_ctx->curl_buf);
+	prot_ctx->curl_buf = NULL;
+	prot_ctx->phase = FDO_PROT_CTX_IDLE;
+}
 
-		if (prot_ctx->protrun) {
-			(*prot_ctx->protrun)(prot_ctx->protdata);
-		} else {
-			ret = -1;
-			break;
-		}
+/**
+ * Build the next message of the protocol and send it.
+ * @param prot_ctx - Pointer of type fdo_prot_ctx_t.
+ * @return 1 once sent, 0 if the protocol is complete, -1 on error.
+ */
+static int prot_ctx_send(fdo_prot_ctx_t *prot_ctx)
+{
+	int n, size, closed;
+	int retries = 0;
+	fdow_t *fdow = &prot_ctx->protdata->fdow;
 
-		/* ========================================================== */
-		/*  Transmit outbound packet */
+	// initialize the encoder before every write operation
+	if (!fdow_encoder_init(fdow)) {
+		LOG(LOG_ERROR, "Failed to initilize FDOW encoder\n");
+		return -1;
+	}
 
+	if (prot_ctx->protrun) {
+		(*prot_ctx->protrun)(prot_ctx->protdata);
+	} else {
+		return -1;
+	}
 
-		/*  Protocol sets State as FDO_STATE_DONE at the end of the*/
-		/*  protocol(DI/T01/TO2) */
-		/*  Hence, when state = FDO_STATE_DONE, we have nothing more*/
-		/*  left to */
-		/*  send. Exit!! */
-		if (prot_ctx->protdata->state == FDO_STATE_DONE) {
-			ret = 0;
-			break;
-		}
+	/* ========================================================== */
+	/*  Transmit outbound packet */
 
-		if ((fdow->msg_type < FDO_DI_APP_START) ||
-		    (fdow->msg_type > FDO_TYPE_ERROR)) {
-			ret = -1;
-			break;
-		}
 
-		// update the final encoded length in the FDOW block after every successfull write.
-		if (!fdow_encoded_length(fdow, &fdow->b.block_size)) {
-			LOG(LOG_ERROR, "Failed to get encoded length in FDOW\n");
-			ret = -1;
-			break;
-		}
-		LOG(LOG_DEBUG, "%s Tx Request Body length: %zu\n", __func__, fdow->b.block_size);
-		LOG(LOG_DEBUG, "%s Tx Request Body:\n", __func__);
-		fdo_log_block(&fdow->b);
-
-		if (!fdo_prot_ctx_connect(prot_ctx)) {
-			/* Giving up, we tried enough to
-			 * re-establish
-			 */
-			ret = -1;
-			break;
+	/*  Protocol sets State as FDO_STATE_DONE at the end of the*/
+	/*  protocol(DI/T01/TO2) */
+	/*  Hence, when state = FDO_STATE_DONE, we have nothing more*/
+	/*  left to */
+	/*  send. Exit!! */
+	if (prot_ctx->protdata->state == FDO_STATE_DONE) {
+		return 0;
+	}
+
+	if ((fdow->msg_type < FDO_DI_APP_START) ||
+	    (fdow->msg_type > FDO_TYPE_ERROR)) {
+		return -1;
+	}
+
+	// update the final encoded length in the FDOW block after every successfull write.
+	if (!fdow_encoded_length(fdow, &fdow->b.block_size)) {
+		LOG(LOG_ERROR, "Failed to get encoded length in FDOW\n");
+		return -1;
+	}
+	LOG(LOG_DEBUG, "%s Tx Request Body length: %zu\n", __func__, fdow->b.block_size);
+	LOG(LOG_DEBUG, "%s Tx Request Body:\n", __func__);
+	fdo_log_block(&fdow->b);
+
+	if (!fdo_prot_ctx_connect(prot_ctx)) {
+		/* Giving up, we tried enough to
+		 * re-establish
+		 */
+		return -1;
+	}
+
+	size = fdow->b.block_size;
+
+	fdow->b.block[size] = 0;
+	retries = CONNECTION_RETRY;
+	do {
+		n = fdo_con_send_message(
+		    prot_ctx->sock_hdl, FDO_PROT_SPEC_VERSION,
+		    fdow->msg_type, &fdow->b.block[0], size,
+		    prot_ctx->tls);
+
+		if (n <= 0) {
+			closed = fdo_con_disconnect(prot_ctx->sock_hdl,
+						    prot_ctx->tls);
+			prot_ctx->sock_hdl = FDO_CON_INVALID_HANDLE;
+			if (closed) {
+				LOG(LOG_ERROR,
+				    "Error during socket close()\n");
+				return -1;
+			}
+
+			if (fdo_connection_restablish(prot_ctx)) {
+				/* Giving up, we tried enough to
+				 * re-establish
+				 */
+				return -1;
+			}
 		}
+	} while (n < 0 && retries--);
+
+	if (n < 0) {
+		return -1;
+	}
+
+	// clear the block contents in preparation for the next FDOW write operation
+	fdo_block_reset(&fdow->b);
+	fdow->b.block_size = prot_ctx->protdata->prot_buff_sz;
+	prot_ctx->phase = FDO_PROT_CTX_RECV;
+	return 1;
+}
+
+/**
+ * Receive the response to the last message sent, and close the connection.
+ * @param prot_ctx - Pointer of type fdo_prot_ctx_t.
+ * @return 0 on success, -1 on error.
+ */
+static int prot_ctx_recv(fdo_prot_ctx_t *prot_ctx)
+{
+	int n;
+	int retries = 0;
+	fdor_t *fdor = &prot_ctx->protdata->fdor;
+	fdow_t *fdow = &prot_ctx->protdata->fdow;
+	uint32_t msglen = 0;
+	uint32_t protver = 0;
+	size_t curl_buf_offset = 0;
+
+	if (memset_s(prot_ctx->curl_buf, REST_MAX_MSGHDR_SIZE, 0) != 0) {
+		LOG(LOG_ERROR, "Memset() failed!\n");
+		return -1;
+	}
+
+	if (fdo_con_recv_msg_header(prot_ctx->sock_hdl, &protver,
+				    (uint32_t *)&fdor->msg_type,
+				    &msglen, prot_ctx->tls, prot_ctx->curl_buf,
+				    &curl_buf_offset) == -1) {
+		LOG(LOG_ERROR, "fdo_con_recv_msg_header() Failed!\n");
+		return -1;
+	}
 
-		size = fdow->b.block_size;
+	// clear the block contents in preparation for the next FDOR read operation
+	fdo_block_reset(&fdor->b);
+	// set the received msg length in the block
+	fdor->b.block_size = msglen;
 
-		fdow->b.block[size] = 0;
+	if (msglen > 0 && msglen <= prot_ctx->protdata->prot_buff_sz) {
 		retries = CONNECTION_RETRY;
+		n = 0;
 		do {
-			n = fdo_con_send_message(
-			    prot_ctx->sock_hdl, FDO_PROT_SPEC_VERSION,
-			    fdow->msg_type, &fdow->b.block[0], size,
-			    prot_ctx->tls);
-
-			if (n <= 0) {
-				if (fdo_con_disconnect(prot_ctx->sock_hdl,
-						       prot_ctx->tls)) {
-					LOG(LOG_ERROR,
-					    "Error during socket close()\n");
-					ret = -1;
-					break;
+			n = fdo_con_recv_msg_body(
+			    prot_ctx->sock_hdl, &fdor->b.block[0], msglen,
+			    prot_ctx->tls, prot_ctx->curl_buf, curl_buf_offset);
+			if (n < 0) {
+				if (fdo_con_disconnect(
+					prot_ctx->sock_hdl,
+					prot_ctx->tls)) {
+					LOG(LOG_ERROR, "Error during "
+						       "socket "
+						       "close()\n");
+					prot_ctx->sock_hdl = FDO_CON_INVALID_HANDLE;
+					return -1;
 				}
 
-				if (fdo_connection_restablish(prot_ctx)) {
+				if (fdo_connection_restablish(
+					prot_ctx)) {
 					/* Giving up, we tried enough to
 					 * re-establish
 					 */
-					ret = -1;
-					break;
+					return -1;
 				}
 			}
 		} while (n < 0 && retries--);
 
-		if (n < 0) {
-			ret = -1;
-			break;
+		if (n <= 0) {
+			LOG(LOG_ERROR, "Socket read not successful "
+				       "after retries!\n");
+			fdo_block_reset(&fdor->b);
+			return -1;
 		}
+	}
 
-		// clear the block contents in preparation for the next FDOW write operation
-		fdo_block_reset(&fdow->b);
-		fdow->b.block_size = prot_ctx->protdata->prot_buff_sz;
-
-		/* ========================================================== */
-		/*  Receive response */
+	n = fdo_con_disconnect(prot_ctx->sock_hdl, prot_ctx->tls);
+	prot_ctx->sock_hdl = FDO_CON_INVALID_HANDLE;
+	prot_ctx->phase = FDO_PROT_CTX_SEND;
+	if (n) {
+		LOG(LOG_ERROR, "Error during socket close()\n");
+		return -1;
+	}
 
-		uint32_t msglen = 0;
-		uint32_t protver = 0;
-		char curl_buf[REST_MAX_MSGBODY_SIZE];
-		size_t curl_buf_offset = 0;
+	if (msglen > prot_ctx->protdata->prot_buff_sz) {
+		LOG(LOG_ERROR, "Response body size is more than allocated memory\n");
+		return -1;
+	}
 
-		if (memset_s(curl_buf, REST_MAX_MSGBODY_SIZE, 0) != 0) {
-				LOG(LOG_ERROR, "Memset() failed!\n");
-				return false;
-			}
+	LOG(LOG_DEBUG, "%s Rx Response Body: \n", __func__);
+	fdo_log_block(&fdor->b);
 
-		ret = fdo_con_recv_msg_header(prot_ctx->sock_hdl, &protver,
-					      (uint32_t *)&fdor->msg_type,
-					      &msglen, prot_ctx->tls, curl_buf, &curl_buf_offset);
-		if (ret == -1) {
-			LOG(LOG_ERROR, "fdo_con_recv_msg_header() Failed!\n");
-			ret = -1;
-			break;
-		}
+	/*
+	 * When a REST error message(type 255) is sent over network,
+	 * the received response may have an empty body.
+	 */
+	if (msglen == 0 && fdow->msg_type == FDO_TYPE_ERROR) {
+		return -1;
+	}
+	 /* ERROR case ? */
+	if (fdor->msg_type == FDO_TYPE_ERROR) {
+		return -1;
+	}
 
-		// clear the block contents in preparation for the next FDOR read operation
+	/*
+	 * Now that we have the received buffer, initialize the parser for next FDOR read
+	 * operation and set the have_block flag.
+	 */
+	if (!fdor_parser_init(fdor)) {
+		LOG(LOG_ERROR, "Failed to initilize FDOR parser\n");
+		return -1;
+	}
+	if (!fdor_is_valid_cbor(fdor)) {
+		LOG(LOG_ERROR, "Received an invalid CBOR stream\n");
 		fdo_block_reset(&fdor->b);
-		// set the received msg length in the block
-		fdor->b.block_size = msglen;
-
-		if (msglen > 0 && msglen <= prot_ctx->protdata->prot_buff_sz) {
-			retries = CONNECTION_RETRY;
-			n = 0;
-			do {
-				n = fdo_con_recv_msg_body(
-				    prot_ctx->sock_hdl, &fdor->b.block[0], msglen,
-				    prot_ctx->tls, curl_buf, curl_buf_offset);
-				if (n < 0) {
-					if (fdo_con_disconnect(
-						prot_ctx->sock_hdl,
-						prot_ctx->tls)) {
-						LOG(LOG_ERROR, "Error during "
-							       "socket "
-							       "close()\n");
-						ret = -1;
-						break;
-					}
-
-					if (fdo_connection_restablish(
-						prot_ctx)) {
-						/* Giving up, we tried enough to
-						 * re-establish
-						 */
-						ret = -1;
-						break;
-					}
-				}
-			} while (n < 0 && retries--);
+		return -1;
+	}
+	fdor->have_block = true;
+	return 0;
+}
 
-			if (n <= 0) {
-				LOG(LOG_ERROR, "Socket read not successful "
-					       "after retries!\n");
-				fdo_block_reset(&fdor->b);
-				ret = -1;
+/**
+ * fdo_prot_ctx_step advances the DI, T01 or T02 protocol exchange of a
+ * context, message by message, so that an event loop can run it without
+ * blocking on the network: it returns once the deadline has passed, or
+ * while the response to a message is still awaited at the deadline.
+ * The messages themselves are built, sent and parsed in one go.
+ * @param prot_ctx - Pointer of type fdo_prot_ctx_t, holds the all the
+ * information,
+ * @param deadline_ms - fdo_time_ms() after which to return, 0 to run the
+ * whole exchange.
+ * @return 0 once the exchange completed, 1 if it is still in progress,
+ * -1 on error.
+ */
+int fdo_prot_ctx_step(fdo_prot_ctx_t *prot_ctx, uint64_t deadline_ms)
+{
+	int ret = -1;
+	uint64_t now_ms = 0;
+	int32_t ready = 0;
+
+	if (!prot_ctx || !prot_ctx->protdata) {
+		return -1;
+	}
+
+	if (prot_ctx->phase == FDO_PROT_CTX_IDLE &&
+	    prot_ctx_start(prot_ctx) != 0) {
+		return -1;
+	}
+
+	for (;;) {
+		if (prot_ctx->phase == FDO_PROT_CTX_SEND) {
+			ret = prot_ctx_send(prot_ctx);
+			if (ret <= 0) {
 				break;
 			}
 		}
 
-		if (fdo_con_disconnect(prot_ctx->sock_hdl, prot_ctx->tls)) {
-			LOG(LOG_ERROR, "Error during socket close()\n");
-			ret = -1;
-			break;
-		}
+		/* ========================================================== */
+		/*  Receive response */
 
-		if (msglen > prot_ctx->protdata->prot_buff_sz) {
-			LOG(LOG_ERROR, "Response body size is more than allocated memory\n");
-			ret = -1;
-			break;
+		if (deadline_ms) {
+			now_ms = fdo_time_ms();
+			ready = fdo_con_wait_recv(prot_ctx->sock_hdl,
+				now_ms < deadline_ms ?
+				(uint32_t)(deadline_ms - now_ms) : 0);
+			if (ready < 0) {
+				ret = -1;
+				break;
+			}
+			if (ready == 0) {
+				return 1;
+			}
 		}
 
-		LOG(LOG_DEBUG, "%s Rx Response Body: \n", __func__);
-		fdo_log_block(&fdor->b);
-
-		/*
-		 * When a REST error message(type 255) is sent over network,
-		 * the received response may have an empty body.
-		 */
-		if (msglen == 0 && fdow->msg_type == FDO_TYPE_ERROR) {
-			ret = -1;
-			break;
-		}
-		 /* ERROR case ? */
-		if (fdor->msg_type == FDO_TYPE_ERROR) {
-			ret = -1;
+		ret = prot_ctx_recv(prot_ctx);
+		if (ret != 0) {
 			break;
 		}
 
-		/*
-		 * Now that we have the received buffer, initialize the parser for next FDOR read
-		 * operation and set the have_block flag.
-		 */
-		if (!fdor_parser_init(fdor)) {
-			LOG(LOG_ERROR, "Failed to initilize FDOR parser\n");
-			ret = -1;
-			break;
+		if (deadline_ms && fdo_time_ms() >= deadline_ms) {
+			return 1;
 		}
-		if (!fdor_is_valid_cbor(fdor)) {
-			LOG(LOG_ERROR, "Received an invalid CBOR stream\n");
-			fdo_block_reset(&fdor->b);
-			ret = -1;
-			break;
-		}
-		fdor->have_block = true;
 	}
 
-	fdo_con_teardown();
+	prot_ctx_finish(prot_ctx);
 	return ret;
 }
+
+/**
+ * fdo_prot_ctx_run responsible for running/maintaining DI, T01, T02 protocol
+ * contexts and respond according to the state specified.
+ * Managing the JSON packet to/from device to server is taken care.
+ * Managing the ip/dns-to-ip resolution is taken care.
+ * @param prot_ctx - Pointer of type fdo_prot_ctx_t, holds the all the
+ * information,
+ * @return 0 on success, -1 on error.
+ */
+int fdo_prot_ctx_run(fdo_prot_ctx_t *prot_ctx)
+{
+	return fdo_prot_ctx_step(prot_ctx, 0);
+}
+
+/**
+ * Get the file descriptor to poll for the response awaited by a protocol
+ * exchange that fdo_prot_ctx_step() left in progress.
+ * @param prot_ctx - Pointer of type fdo_prot_ctx_t.
+ * @return the file descriptor, -1 if no response is awaited or it can't be
+ * polled.
+ */
+int fdo_prot_ctx_get_fd(fdo_prot_ctx_t *prot_ctx)
+{
+	if (!prot_ctx || prot_ctx->phase != FDO_PROT_CTX_RECV) {
+		return -1;
+	}
+	return fdo_con_get_fd(prot_ctx->sock_hdl);
+}
@@ -0,0 +1,274 @@
+/*
+ * Copyright 2020 Intel Corporation
+ * SPDX-License-Identifier: Apache 2.0
+ */
+
+/*!
+ * \file
+ * \brief Retry scheduling for the Rendezvous and Owner addresses: backoff
+ * delays with jitter, and the health of each address.
+ */
+
+#include "fdoretry.h"
+#include "fdoCrypto.h"
+#include "util.h"
+#include "safe_lib.h"
+
+/**
+ * Initialize the retry scheduler, with no failures and no address tracked.
+ *
+ * @param retry
+ *        Pointer to the retry scheduler.
+ * @param cap_sec
+ *        Longest delay, in seconds.
+ */
+void fdo_retry_init(fdo_retry_t *retry, uint64_t cap_sec)
+{
+	if (!retry) {
+		return;
+	}
+	if (memset_s(retry, sizeof(*retry), 0) != 0) {
+		LOG(LOG_ERROR, "Failed to clear retry scheduler\n");
+	}
+	retry->cap_sec = cap_sec;
+}
+
+/**
+ * FNV-1a step over the given bytes.
+ */
+static uint32_t retry_hash(uint32_t hash, const uint8_t *bytes, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		hash ^= bytes[i];
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+/**
+ * Identify a Rendezvous/Owner address. 0 is never returned, so that it can
+ * mark a free slot.
+ *
+ * @param ip
+ *        IP address bytes, NULL if there is none.
+ * @param ip_len
+ *        Number of IP address bytes.
+ * @param dns
+ *        DNS name, NULL if there is none.
+ * @param port
+ *        Port number.
+ * @return
+ *        the address id.
+ */
+uint32_t fdo_retry_endpoint_id(const uint8_t *ip, size_t ip_len,
+			       const fdo_string_t *dns, int port)
+{
+	uint32_t hash = 2166136261U;
+	uint8_t port_bytes[2];
+
+	if (ip) {
+		hash = retry_hash(hash, ip, ip_len);
+	}
+	if (dns && dns->bytes && dns->byte_sz > 0) {
+		hash = retry_hash(hash, (const uint8_t *)dns->bytes,
+				  (size_t)dns->byte_sz);
+	}
+	port_bytes[0] = (uint8_t)((port >> 8) & 0xff);
+	port_bytes[1] = (uint8_t)(port & 0xff);
+	hash = retry_hash(hash, port_bytes, sizeof(port_bytes));
+	return hash ? hash : 1;
+}
+
+/**
+ * Find the slot holding the health of the given address, -1 if none does.
+ */
+static int retry_find(const fdo_retry_t *retry, uint32_t id)
+{
+	int i;
+
+	for (i = 0; i < FDO_RETRY_MAX_ENDPOINTS; i++) {
+		if (retry->endpoints[i].id == id) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/**
+ * Record the outcome of an attempt with the given address. A success also
+ * ends the failed rounds.
+ *
+ * @param retry
+ *        Pointer to the retry scheduler.
+ * @param id
+ *        Address id, from fdo_retry_endpoint_id(), 0 for an address that
+ *        isn't tracked.
+ * @param success
+ *        true if the protocol completed with the address.
+ */
+void fdo_retry_report(fdo_retry_t *retry, uint32_t id, bool success)
+{
+	int slot = -1;
+
+	if (!retry) {
+		return;
+	}
+	if (success) {
+		retry->failures = 0;
+	}
+	if (id == 0) {
+		return;
+	}
+
+	slot = retry_find(retry, id);
+	if (slot < 0) {
+		if (success) {
+			// healthy addresses aren't tracked
+			return;
+		}
+		// take a free slot, or the oldest one
+		slot = retry_find(retry, 0);
+		if (slot < 0) {
+			slot = (int)retry->next_slot;
+			retry->next_slot =
+			    (retry->next_slot + 1) % FDO_RETRY_MAX_ENDPOINTS;
+		}
+		retry->endpoints[slot].id = id;
+		retry->endpoints[slot].failures = 0;
+	}
+	retry->endpoints[slot].failures =
+	    success ? 0 : retry->endpoints[slot].failures + 1;
+}
+
+/**
+ * Return the number of consecutive failed attempts with the given address.
+ *
+ * @param retry
+ *        Pointer to the retry scheduler.
+ * @param id
+ *        Address id, from fdo_retry_endpoint_id().
+ * @return
+ *        the number of failures, 0 for an address never tried.
+ */
+uint32_t fdo_retry_failures(const fdo_retry_t *retry, uint32_t id)
+{
+	int slot = -1;
+
+	if (!retry || id == 0) {
+		return 0;
+	}
+	slot = retry_find(retry, id);
+	return slot < 0 ? 0 : retry->endpoints[slot].failures;
+}
+
+/**
+ * Compute the delay before the next attempt.
+ *
+ * A delaysec given in the RendezvousInfo is honored, randomized by up to 25%
+ * either way. Otherwise, the bound doubles from base_sec with each failure,
+ * up to the cap, and the delay is drawn uniformly between
+ * FDO_RETRY_MIN_DELAY_SEC and that bound (full jitter), so that devices
+ * failing together spread their retries over the whole interval.
+ *
+ * @param retry
+ *        Pointer to the retry scheduler.
+ * @param failures
+ *        Number of consecutive failures so far, at least 1.
+ * @param base_sec
+ *        Delay after the first failure, in seconds.
+ * @param delaysec
+ *        RVDelaysec, 0 if there is none.
+ * @return
+ *        the delay, in seconds.
+ */
+uint64_t fdo_retry_delay(const fdo_retry_t *retry, uint32_t failures,
+			 uint64_t base_sec, uint64_t delaysec)
+{
+	uint64_t low = 0;
+	uint64_t high = 0;
+	uint32_t random = 0;
+
+	if (!retry) {
+		return base_sec;
+	}
+
+	if (delaysec > 0 && delaysec <= retry->cap_sec) {
+		low = delaysec - delaysec / 4;
+		high = delaysec + delaysec / 4;
+	} else {
+		high = base_sec;
+		while (failures > 1 && high < retry->cap_sec) {
+			high *= 2;
+			failures--;
+		}
+		if (high > retry->cap_sec) {
+			high = retry->cap_sec;
+		}
+		low = FDO_RETRY_MIN_DELAY_SEC;
+		if (low > high) {
+			low = high;
+		}
+	}
+
+	if (high == low) {
+		return high;
+	}
+	if (fdo_crypto_random_bytes((uint8_t *)&random, sizeof(random)) != 0) {
+		// no jitter, but still within bounds
+		return high;
+	}
+	return low + (uint64_t)random % (high - low + 1);
+}
+
+/**
+ * Return the number of consecutive failed attempts with the given
+ * RVTO2AddrEntry.
+ */
+static uint32_t retry_entry_failures(const fdo_retry_t *retry,
+				     const fdo_rvto2addr_entry_t *entry)
+{
+	return fdo_retry_failures(
+	    retry, fdo_retry_endpoint_id(entry->rvip ? entry->rvip->bytes : NULL,
+					 entry->rvip ? entry->rvip->byte_sz : 0,
+					 entry->rvdns, entry->rvport));
+}
+
+/**
+ * Order the RVTO2AddrEntry(s) from the healthiest to the least healthy.
+ * The order is stable, so addresses that are equally healthy keep the
+ * Owner's order.
+ *
+ * @param retry
+ *        Pointer to the retry scheduler.
+ * @param rvto2addr
+ *        RVTO2Addr, sorted in place.
+ */
+void fdo_retry_sort_rvto2addr(const fdo_retry_t *retry,
+			      fdo_rvto2addr_t *rvto2addr)
+{
+	fdo_rvto2addr_entry_t *sorted = NULL;
+	fdo_rvto2addr_entry_t *entry = NULL;
+	fdo_rvto2addr_entry_t **pos = NULL;
+	uint32_t failures = 0;
+
+	if (!retry || !rvto2addr) {
+		return;
+	}
+
+	// insertion sort, after the entries that are at least as healthy
+	while (rvto2addr->rv_to2addr_entry) {
+		entry = rvto2addr->rv_to2addr_entry;
+		rvto2addr->rv_to2addr_entry = entry->next;
+		failures = retry_entry_failures(retry, entry);
+
+		pos = &sorted;
+		while (*pos && retry_entry_failures(retry, *pos) <= failures) {
+			pos = &(*pos)->next;
+		}
+		entry->next = *pos;
+		*pos = entry;
+	}
+	rvto2addr->rv_to2addr_entry = sorted;
+}
@@ -11,6 +11,7 @@
 #include "crypto_utils.h"
 #include "fdoprot.h"
 #include "fdotypes.h"
+#include "fdobufpool.h"
 #include "network_al.h"
 #include "fdoCrypto.h"
 #include "util.h"
@@ -24,6 +25,29 @@
 
 int keyfromstring(const char *key);
 
+/**
+ * Check whether the bytes of the bits are stored inline, in the same
+ * allocation right after the struct, rather than in a buffer of their own.
+ * @param b - pointer to the struct bits
+ * @return true if the bytes are inline
+ */
+static bool fdo_bits_is_inline(const fdo_bits_t *b)
+{
+	return b->bytes == (const uint8_t *)(b + 1);
+}
+
+/**
+ * Release the bytes of the bits, if they have a buffer of their own.
+ * @param b - pointer to the struct bits
+ */
+static void fdo_bits_release(fdo_bits_t *b)
+{
+	if (b->bytes && !fdo_bits_is_inline(b)) {
+		fdo_free(b->bytes);
+	}
+	b->bytes = NULL;
+}
+
 /**
  * Allocate and Initialize the bits
  * @param b - pointer to initialized bits struct
@@ -45,10 +69,7 @@ fdo_bits_t *fdo_bits_init(fdo_bits_t *b, size_t byte_sz)
 		return b;
 	}
 
-	if (b->bytes) {
-		fdo_free(b->bytes);
-		b->bytes = NULL;
-	}
+	fdo_bits_release(b);
 	b->byte_sz = 0;
 
 	return b;
@@ -61,17 +82,31 @@ fdo_bits_t *fdo_bits_init(fdo_bits_t *b, size_t byte_sz)
  */
 fdo_bits_t *fdo_bits_alloc(size_t byte_sz)
 {
-	fdo_bits_t *b = fdo_alloc(sizeof(fdo_bits_t));
+	fdo_bits_t *b = NULL;
+
+	// small payloads share the allocation of the struct
+	if (byte_sz > 0 && byte_sz <= FDO_INLINE_BYTES_MAX) {
+		b = fdo_alloc(sizeof(fdo_bits_t) + byte_sz);
+		if (b == NULL) {
+			return NULL;
+		}
+		b->bytes = (uint8_t *)(b + 1);
+		b->byte_sz = byte_sz;
+		return b;
+	}
 
+	b = fdo_alloc(sizeof(fdo_bits_t));
 	if (b == NULL) {
 		return NULL;
 	}
 
 	if (byte_sz > 0) {
-		return fdo_bits_init(b, byte_sz);
-	} else {
-		return b;
+		if (!fdo_bits_init(b, byte_sz)) {
+			fdo_free(b);
+			return NULL;
+		}
 	}
+	return b;
 }
 
 /**
@@ -82,13 +117,13 @@ fdo_bits_t *fdo_bits_alloc(size_t byte_sz)
  */
 fdo_bits_t *fdo_bits_alloc_with(size_t byte_sz, uint8_t *data)
 {
-	fdo_bits_t *b = fdo_bits_alloc(byte_sz);
+	fdo_bits_t *b = NULL;
 
-	if (b == NULL) {
+	if (byte_sz == 0) {
 		return NULL;
 	}
-	if (!fdo_bits_fill(&b)) {
-		fdo_bits_free(b);
+	b = fdo_bits_alloc(byte_sz);
+	if (b == NULL) {
 		return NULL;
 	}
 	if (memcpy_s(b->bytes, b->byte_sz, data, b->byte_sz) != 0) {
@@ -124,8 +159,7 @@ void fdo_bits_empty(fdo_bits_t *b)
 		if (b->byte_sz && memset_s(b->bytes, b->byte_sz, 0)) {
 			LOG(LOG_ERROR, "Failed to clear memory\n");
 		}
-		fdo_free(b->bytes);
-		b->bytes = NULL;
+		fdo_bits_release(b);
 	}
 	b->byte_sz = 0;
 }
@@ -171,10 +205,7 @@ bool fdo_bits_fill(fdo_bits_t **bits)
 	}
 
 	b = *bits;
-	if (b->bytes != NULL) {
-		fdo_free(b->bytes);
-		b->bytes = NULL;
-	}
+	fdo_bits_release(b);
 	b->bytes = fdo_alloc(b->byte_sz);
 	if (b->bytes == NULL) {
 		return false;
@@ -245,6 +276,38 @@ fdo_byte_array_t *fdo_byte_array_clone(fdo_byte_array_t *bn)
 	return fdo_bits_clone(bn);
 }
 
+/**
+ * Read a CBOR bstr as a view into the fdor_t input buffer, without allocating.
+ * @param fdor - fdor_t object to read from
+ * @param view - filled with the location and length of the bstr contents
+ * @return true if a bstr was read, false otherwise
+ */
+bool fdo_byte_view_read(fdor_t *fdor, fdo_byte_view_t *view)
+{
+	if (!fdor || !view) {
+		return false;
+	}
+	if (!fdor_byte_string_view(fdor, &view->bytes, &view->byte_sz)) {
+		LOG(LOG_ERROR, "Failed to read bstr view\n");
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Copy the contents of a view into a newly allocated byte array, for when
+ * they are needed after the buffer the view refers to is gone.
+ * @param view - pointer to the view to materialise
+ * @return pointer to the allocated byte array, or NULL on failure
+ */
+fdo_byte_array_t *fdo_byte_view_dup(const fdo_byte_view_t *view)
+{
+	if (!view || !view->bytes || !view->byte_sz) {
+		return NULL;
+	}
+	return fdo_bits_alloc_with(view->byte_sz, (uint8_t *)view->bytes);
+}
+
 /**
  * Append one byte array onto another and return the resulting byte array
  * @param baA - pointer to the first byte array object
@@ -297,6 +360,37 @@ fdo_string_t *fdo_string_alloc(void)
 	return (fdo_string_t *)fdo_alloc(sizeof(fdo_string_t));
 }
 
+/**
+ * Allocate a fdo_string_t object along with a zeroed buffer of total_size
+ * bytes, inline after the object when it is small enough.
+ * @param total_size - size of the buffer, including the '\0'
+ * @return an allocated fdo_string_t object, with byte_sz left 0
+ */
+static fdo_string_t *fdo_string_alloc_buffer(size_t total_size)
+{
+	fdo_string_t *s = NULL;
+
+	if (total_size <= FDO_INLINE_BYTES_MAX) {
+		s = fdo_alloc(sizeof(fdo_string_t) + total_size);
+		if (!s) {
+			return NULL;
+		}
+		s->bytes = (char *)(s + 1);
+		return s;
+	}
+
+	s = fdo_string_alloc();
+	if (!s) {
+		return NULL;
+	}
+	s->bytes = fdo_alloc(total_size * sizeof(char));
+	if (!s->bytes) {
+		fdo_free(s);
+		return NULL;
+	}
+	return s;
+}
+
 /**
  * Create fdo_string_t object by allocating memory for the inner buffer
  * with the given size.
@@ -310,17 +404,11 @@ fdo_string_t *fdo_string_alloc_size(size_t byte_sz) {
 	}
 
 	// Buffer would store NULL terminated string, adding +1 for '\0'
-	int total_size = byte_sz + 1;
-	fdo_string_t *s = (fdo_string_t *)fdo_alloc(sizeof(fdo_string_t));
+	fdo_string_t *s = fdo_string_alloc_buffer(byte_sz + 1);
 	if (!s) {
 		return NULL;
 	}
 
-	s->bytes = fdo_alloc(total_size * sizeof(char));
-	if (!s->bytes) {
-		fdo_free(s);
-		return NULL;
-	}
 	// byte_sz contains the number of characters
 	s->byte_sz = byte_sz;
 	return s;
@@ -338,20 +426,15 @@ fdo_string_t *fdo_string_alloc_with(const char *data, int byte_sz)
 	// Buffer would store NULL terminated string, adding +1 for '\0'
 	int total_size = byte_sz + 1;
 
-	if (!data) {
+	if (!data || byte_sz < 0) {
 		goto err1;
 	}
 
-	temp_str = fdo_string_alloc();
+	temp_str = fdo_string_alloc_buffer(total_size);
 	if (!temp_str) {
 		goto err1;
 	}
 
-	temp_str->bytes = fdo_alloc(total_size * sizeof(char));
-	if (temp_str->bytes == NULL) {
-		goto err2;
-	}
-
 	// byte_sz contains the number of characters
 	temp_str->byte_sz = byte_sz;
 	if (byte_sz) {
@@ -411,10 +494,10 @@ void fdo_string_free(fdo_string_t *b)
  */
 void fdo_string_init(fdo_string_t *b)
 {
-	if (b->bytes) {
+	if (b->bytes && b->bytes != (char *)(b + 1)) {
 		fdo_free(b->bytes);
-		b->bytes = NULL;
 	}
+	b->bytes = NULL;
 	b->byte_sz = 0;
 }
 
@@ -465,7 +548,7 @@ bool fdo_string_resize_with(fdo_string_t *b, int new_byte_sz, const char *data)
 			if (memcpy_s(b->bytes, new_byte_sz, data,
 				     new_byte_sz) != 0) {
 				LOG(LOG_ERROR, "Memcpy Failed\n");
-				fdo_free(b->bytes);
+				fdo_string_init(b);
 				return false;
 			}
 		}
@@ -683,8 +766,23 @@ fdo_hash_t *fdo_hash_alloc_empty(void)
  */
 fdo_hash_t *fdo_hash_alloc(int hash_type, int size)
 {
-	fdo_hash_t *hp = fdo_alloc(sizeof(fdo_hash_t));
+	fdo_hash_t *hp = NULL;
+
+	// digests share a single allocation: fdo_hash_t, fdo_byte_array_t, bytes
+	if (size > 0 && size <= FDO_INLINE_BYTES_MAX) {
+		hp = fdo_alloc(sizeof(fdo_hash_t) + sizeof(fdo_byte_array_t) +
+			       size);
+		if (hp == NULL) {
+			return NULL;
+		}
+		hp->hash_type = hash_type;
+		hp->hash = (fdo_byte_array_t *)(hp + 1);
+		hp->hash->bytes = (uint8_t *)(hp->hash + 1);
+		hp->hash->byte_sz = size;
+		return hp;
+	}
 
+	hp = fdo_alloc(sizeof(fdo_hash_t));
 	if (hp == NULL) {
 		return NULL;
 	}
@@ -706,10 +804,13 @@ void fdo_hash_free(fdo_hash_t *hp)
 	if (NULL == hp) {
 		return;
 	}
-	if (hp->hash != NULL) {
+	if (hp->hash == (fdo_byte_array_t *)(hp + 1)) {
+		// inline, only clear the digest
+		fdo_bits_empty(hp->hash);
+	} else if (hp->hash != NULL) {
 		fdo_byte_array_free(hp->hash);
-		hp->hash = NULL;
 	}
+	hp->hash = NULL;
 	fdo_free(hp);
 }
 
@@ -2423,7 +2524,8 @@ void fdo_encrypted_packet_free(fdo_encrypted_packet_t *pkt)
 	if (pkt == NULL) {
 		return;
 	}
-	if (pkt->em_body) {
+	// a view into the FDOR buffer isn't owned by the packet
+	if (pkt->em_body && pkt->em_body != &pkt->em_view) {
 		fdo_byte_array_free(pkt->em_body);
 	}
 	if (pkt->hmac) {
@@ -2444,6 +2546,9 @@ void fdo_encrypted_packet_free(fdo_encrypted_packet_t *pkt)
  *   unprotected: { 5:IV}				// contains IV
  *   payload:     ETMInnerBlock			// cipher||tag
  * ]
+ * The cipher is not copied: em_body refers to the FDOR buffer, and is valid
+ * until the buffer is written to, which fdo_encrypted_packet_unwind() takes
+ * care of.
  * @param fdor - pointer to the character buffer to parse
  * @return a newly allocated FDOEcnrypted_packet object if successful, otherwise
  * NULL
@@ -2476,24 +2581,19 @@ fdo_encrypted_packet_t *fdo_encrypted_packet_read(fdor_t *fdor)
 	}
 
 	// Encrypted payload that contains cipher||tag
-	// Allocate for cipher, discarding the tag length
-	pkt->em_body = fdo_byte_array_alloc(cose_encrypt0->payload->byte_sz - sizeof(pkt->tag));
-	if (!pkt->em_body) {
-		LOG(LOG_ERROR, "Encrypted Message Read: Failed to copy COSE_Encrypt0.Payload\n");
+	if (cose_encrypt0->payload_view.byte_sz <= sizeof(pkt->tag)) {
+		LOG(LOG_ERROR, "Encrypted Message Read: Invalid COSE_Encrypt0.Payload length\n");
 		goto err;
 	}
 
-	// copy the cipher
-	if (memcpy_s(pkt->em_body->bytes, pkt->em_body->byte_sz,
-		    cose_encrypt0->payload->bytes,
-			cose_encrypt0->payload->byte_sz - sizeof(pkt->tag)) != 0) {
-		LOG(LOG_ERROR, "Encrypted Message Read: Failed to copy cipher data\n");
-		goto err;
-	}
+	// the cipher is left in the FDOR buffer, discarding the tag length
+	pkt->em_view.bytes = (uint8_t *)cose_encrypt0->payload_view.bytes;
+	pkt->em_view.byte_sz = cose_encrypt0->payload_view.byte_sz - sizeof(pkt->tag);
+	pkt->em_body = &pkt->em_view;
 
 	// copy the tag
 	if (0 != memcpy_s(&pkt->tag, sizeof(pkt->tag),
-		cose_encrypt0->payload->bytes + pkt->em_body->byte_sz, sizeof(pkt->tag))) {
+		pkt->em_body->bytes + pkt->em_body->byte_sz, sizeof(pkt->tag))) {
 		LOG(LOG_ERROR, "Encrypted Message Read: Failed to copy tag\n");
 		goto err;
 	}
@@ -2694,14 +2794,20 @@ err:
  * Take in encrypted data object and end up with it represented
  * cleartext in the fdor buffer.  This will allow the data to be parsed
  * for its content.
+ * The cipher that pkt refers to in the fdor buffer is decrypted into a buffer
+ * from the pool, which then replaces the fdor buffer.
  * @param fdor - pointer to the fdor object to fill
  * @param pkt - Pointer to the Encrypted packet pkt that has to be processed.
+ * @param fdor_buff_sz - size of the fdor buffer, that the replacement must keep
  * @return true if all goes well, otherwise false
  */
-bool fdo_encrypted_packet_unwind(fdor_t *fdor, fdo_encrypted_packet_t *pkt)
+bool fdo_encrypted_packet_unwind(fdor_t *fdor, fdo_encrypted_packet_t *pkt,
+	size_t fdor_buff_sz)
 {
 	bool ret = false;
-	fdo_byte_array_t *cleartext = NULL;
+	size_t cleartext_sz = 0;
+	uint8_t *cleartext = NULL;
+	uint8_t *ciphertext_block = NULL;
 	fdow_t temp_fdow = {0};
 
 	// Decrypt the Encrypted Body
@@ -2710,14 +2816,8 @@ bool fdo_encrypted_packet_unwind(fdor_t *fdor, fdo_encrypted_packet_t *pkt)
 		return false;
 	}
 
-	cleartext = fdo_byte_array_alloc(0);
-	if (cleartext == NULL) {
-		LOG(LOG_ERROR, "Encrypted Message (decrypt): Failed to alloc clear data\n");
-		goto err;
-	}
-
 	// create temporary FDOW, use it to create AAD and then clear it.
-	if (!fdow_init(&temp_fdow) || !fdo_block_alloc_with_size(&temp_fdow.b, BUFF_SIZE_256_BYTES) ||
+	if (!fdow_init(&temp_fdow) || !fdo_block_alloc_pooled(&temp_fdow.b, BUFF_SIZE_256_BYTES) ||
 		!fdow_encoder_init(&temp_fdow)) {
 		LOG(LOG_ERROR,
 			"Encrypted Message write: FDOW Initialization/Allocation failed!\n");
@@ -2735,21 +2835,31 @@ bool fdo_encrypted_packet_unwind(fdor_t *fdor, fdo_encrypted_packet_t *pkt)
 		goto err;
 	}
 
-	/* New iv is used for each new decryption which comes from pkt*/
-	if (0 != aes_decrypt_packet(pkt, cleartext, temp_fdow.b.block, temp_fdow.b.block_size)) {
-		LOG(LOG_ERROR, "Encrypted Message (decrypt): Failed to decrypt\n");
+	// the cipher is still in the FDOR buffer, and not every crypto backend
+	// decrypts in place, so decrypt into a pooled buffer of the same size.
+	// New iv is used for each new decryption which comes from pkt
+	cleartext = fdo_buf_pool_get(fdor_buff_sz);
+	if (!cleartext) {
+		LOG(LOG_ERROR, "Encrypted Message (decrypt): Failed to alloc cleartext buffer\n");
 		goto err;
 	}
-
-	// clear the FDOR buffer and push decrypted payload into it
-	fdo_block_reset(&fdor->b);
-	fdor->b.block_size = cleartext->byte_sz;
-	if (0 != memcpy_s(fdor->b.block, cleartext->byte_sz,
-		cleartext->bytes, cleartext->byte_sz)) {
-		LOG(LOG_ERROR, "Encrypted Message (decrypt): Failed to copy\n");
+	cleartext_sz = fdor_buff_sz;
+	if (0 != aes_decrypt_packet_to_buf(pkt, cleartext, &cleartext_sz,
+					   temp_fdow.b.block,
+					   temp_fdow.b.block_size)) {
+		LOG(LOG_ERROR, "Encrypted Message (decrypt): Failed to decrypt\n");
+		// the pool clears it, leaving no unauthenticated plaintext behind
+		fdo_buf_pool_put(cleartext);
 		goto err;
 	}
 
+	// swap the buffers, the cipher buffer is cleared and kept for the next one
+	ciphertext_block = fdor->b.block;
+	fdor->b.block = cleartext;
+	fdor->b.block_size = cleartext_sz;
+	pkt->em_body = NULL;
+	fdo_buf_pool_put(ciphertext_block);
+
 	// initialize the parser once the buffer contains COSE payload to be decoded.
 	if (!fdor_parser_init(fdor)) {
 		LOG(LOG_ERROR, "Encrypted Message (decrypt): Failed to initialize FDOR parser\n");
@@ -2764,9 +2874,6 @@ err:
 	if (pkt) {
 		fdo_encrypted_packet_free(pkt);
 	}
-	if (cleartext) {
-		fdo_byte_array_free(cleartext);
-	}
 	return ret;
 }
 
@@ -2792,7 +2899,7 @@ bool fdo_prep_simple_encrypted_message(fdo_encrypted_packet_t *pkt,
 		return false;
 	}
 
-	if (!fdow_init(&temp_fdow) || !fdo_block_alloc_with_size(&temp_fdow.b, BUFF_SIZE_256_BYTES) ||
+	if (!fdow_init(&temp_fdow) || !fdo_block_alloc_pooled(&temp_fdow.b, BUFF_SIZE_256_BYTES) ||
 		!fdow_encoder_init(&temp_fdow)) {
 		LOG(LOG_ERROR,
 			"Encrypted Message write: FDOW Initialization/Allocation failed!\n");
@@ -3283,6 +3390,102 @@ bool fdo_eat_write_payloadbasemap(fdow_t *fdow, fdo_eat_payload_base_map_t *eat_
 	return true;
 }
 
+/* Largest head of a CBOR data item: initial byte and 8-byte argument */
+#define FDO_CBOR_HEAD_MAX 9
+/* Sig_structure array, context, protected header and external_aad heads */
+#define FDO_SIG_STRUCTURE_HEAD_MAX 48
+
+/**
+ * Write the head of a CBOR data item, i.e. its major type and argument: the
+ * value of an unsigned/negative integer, or the length of a string/container.
+ * @param major_type - CBOR major type (0-7)
+ * @param argument - value of the argument
+ * @param buf - buffer of at least 9 bytes to write the head into
+ * @return number of bytes written
+ */
+static size_t fdo_cbor_write_head(uint8_t major_type, uint64_t argument,
+	uint8_t *buf)
+{
+	size_t arg_len = 0;
+	size_t i;
+
+	buf[0] = (uint8_t)(major_type << 5);
+	if (argument < 24) {
+		buf[0] |= (uint8_t)argument;
+		return 1;
+	} else if (argument <= UINT8_MAX) {
+		buf[0] |= 24;
+		arg_len = 1;
+	} else if (argument <= UINT16_MAX) {
+		buf[0] |= 25;
+		arg_len = 2;
+	} else if (argument <= UINT32_MAX) {
+		buf[0] |= 26;
+		arg_len = 4;
+	} else {
+		buf[0] |= 27;
+		arg_len = 8;
+	}
+	// the argument follows in network byte order
+	for (i = 0; i < arg_len; i++) {
+		buf[1 + i] = (uint8_t)(argument >> (8 * (arg_len - 1 - i)));
+	}
+	return 1 + arg_len;
+}
+
+/**
+ * Write everything in a COSE_Sign1 Sig_structure that precedes the external_aad
+ * contents:
+ * Sig_structure = [
+ * context : "Signature1",
+ * body_protected : empty_or_serialized_map,	// {CoseAlg: sig_alg} as bstr
+ * external_aad : bstr,		// only its head
+ * ...
+ * ]
+ * It is the same for every message signed with the same algorithm, so the
+ * Sig_structure can be hashed or assembled around the payload without encoding
+ * it again.
+ *
+ * @param sig_alg - COSE signature algorithm of the protected header
+ * @param aad_length - length of external_aad, 0 for an empty bstr
+ * @param buf - buffer of FDO_SIG_STRUCTURE_HEAD_MAX bytes
+ * @return number of bytes written, 0 on failure
+ */
+static size_t fdo_sigstructure_write_head(int sig_alg, size_t aad_length,
+	uint8_t *buf)
+{
+	static const char context[] = "Signature1";
+	uint8_t ph[FDO_CBOR_HEAD_MAX + 2];
+	size_t ph_length = 0;
+	size_t length = 0;
+
+	// Protected header map {CoseAlg: sig_alg}
+	ph_length += fdo_cbor_write_head(5, 1, ph);
+	ph_length += fdo_cbor_write_head(0, FDO_COSE_ALG_KEY, ph + ph_length);
+	if (sig_alg < 0) {
+		ph_length += fdo_cbor_write_head(1,
+			(uint64_t)(-1 - (int64_t)sig_alg), ph + ph_length);
+	} else {
+		ph_length += fdo_cbor_write_head(0, (uint64_t)sig_alg, ph + ph_length);
+	}
+
+	length += fdo_cbor_write_head(4, 4, buf);
+	length += fdo_cbor_write_head(3, sizeof(context) - 1, buf + length);
+	if (0 != memcpy_s(buf + length, FDO_SIG_STRUCTURE_HEAD_MAX - length,
+		context, sizeof(context) - 1)) {
+		return 0;
+	}
+	length += sizeof(context) - 1;
+	length += fdo_cbor_write_head(2, ph_length, buf + length);
+	if (0 != memcpy_s(buf + length, FDO_SIG_STRUCTURE_HEAD_MAX - length,
+		ph, ph_length)) {
+		return 0;
+	}
+	length += ph_length;
+	length += fdo_cbor_write_head(2, aad_length, buf + length);
+	return length;
+}
+
 /**
  * Create Sig_structure of the form:
  * Sig_structure = [
@@ -3291,7 +3494,8 @@ bool fdo_eat_write_payloadbasemap(fdow_t *fdow, fdo_eat_payload_base_map_t *eat_
  * external_aad : bstr,
  * payload : bstr
  * ]
- * Only to be used Sig_sturcture for EAT.
+ * Only to be used Sig_sturcture for EAT. It is assembled in a single buffer
+ * of its exact size, copying the payload once.
  *
  * @param eat_ph - EAT protected header
  * @param eat_payload - EAT Payload
@@ -3306,99 +3510,59 @@ bool fdo_eat_write_sigstructure(fdo_eat_protected_header_t *eat_ph,
 	fdo_byte_array_t *eat_payload, fdo_byte_array_t *external_aad,
 	fdo_byte_array_t **sig_structure) {
 
-	bool ret = false;
-	char context[] = "Signature1";
-	fdo_byte_array_t *empty_byte_array = NULL;
-	fdow_t temp_fdow = {0};
-	size_t enc_length = 0;
-	size_t sig_struct_sz = 0;
+	uint8_t head[FDO_SIG_STRUCTURE_HEAD_MAX];
+	uint8_t payload_head[FDO_CBOR_HEAD_MAX];
+	size_t head_length = 0;
+	size_t payload_head_length = 0;
+	size_t aad_length = 0;
+	size_t offset = 0;
+	fdo_byte_array_t *sig_struct = NULL;
 
 	if (!eat_ph || !eat_payload || !sig_structure) {
 		return false;
 	}
 
-	// size of the Sigstruct CBOR encoded buffer
-	// provide buffer of 128 bytes for protected header + context + additional CBOR encoding
-	if (external_aad) {
-		sig_struct_sz = eat_payload->byte_sz + external_aad->byte_sz + BUFF_SIZE_128_BYTES;
-	} else {
-		sig_struct_sz = eat_payload->byte_sz + BUFF_SIZE_128_BYTES;
-	}
-
-	if (!fdow_init(&temp_fdow) || !fdo_block_alloc_with_size(&temp_fdow.b, sig_struct_sz) ||
-		!fdow_encoder_init(&temp_fdow)) {
-		LOG(LOG_ERROR, "EAT Sig_structure: FDOW Initialization/Allocation failed!\n");
-		goto end;
-	}
-
-	if (!fdow_start_array(&temp_fdow, 4)) {
-		LOG(LOG_ERROR, "EAT Sig_structure: Failed to write start array\n");
-		return false;
-	}
-
-	if (!fdow_text_string(&temp_fdow, context, sizeof(context) - 1)) {
-		LOG(LOG_ERROR, "EAT Sig_structure: Failed to write Context\n");
+	aad_length = external_aad ? external_aad->byte_sz : 0;
+	head_length = fdo_sigstructure_write_head(eat_ph->ph_sig_alg, aad_length, head);
+	if (!head_length) {
+		LOG(LOG_ERROR, "EAT Sig_structure: Failed to write head\n");
 		return false;
 	}
+	payload_head_length = fdo_cbor_write_head(2, eat_payload->byte_sz, payload_head);
 
-	if (!fdo_eat_write_protected_header(&temp_fdow, eat_ph)) {
-		LOG(LOG_ERROR, "EAT Sig_structure: Failed to write protected header\n");
+	sig_struct = fdo_byte_array_alloc(head_length + aad_length +
+		payload_head_length + eat_payload->byte_sz);
+	if (!sig_struct) {
+		LOG(LOG_ERROR,
+			"EAT Sig_structure: Failed to alloc output Sig_structure\n");
 		return false;
 	}
 
-	if (external_aad) {
-		if (!fdow_byte_string(&temp_fdow, external_aad->bytes, external_aad->byte_sz)) {
-			LOG(LOG_ERROR, "EAT Sig_structure: Failed to write external_aad\n");
-			goto end;
-		}
-	} else {
-		empty_byte_array = fdo_byte_array_alloc(0);
-		if (!empty_byte_array) {
-			LOG(LOG_ERROR, "EAT Sig_structure: Byte Array Alloc failed\n");
-			return false;
-		}
-
-		if (!fdow_byte_string(&temp_fdow, empty_byte_array->bytes, empty_byte_array->byte_sz)) {
-			LOG(LOG_ERROR, "EAT Sig_structure: Failed to write external_aad\n");
-			goto end;
-		}
-	}
-
-	if (!fdow_byte_string(&temp_fdow, eat_payload->bytes, eat_payload->byte_sz)) {
-		LOG(LOG_ERROR, "EAT Sig_structure: Failed to write payload\n");
-		goto end;
+	if (0 != memcpy_s(sig_struct->bytes, sig_struct->byte_sz, head, head_length)) {
+		goto err;
 	}
-
-	if (!fdow_end_array(&temp_fdow)) {
-		LOG(LOG_ERROR, "EAT Sig_structure: Failed to write end array\n");
-		goto end;
+	offset = head_length;
+	if (aad_length && 0 != memcpy_s(sig_struct->bytes + offset,
+		sig_struct->byte_sz - offset, external_aad->bytes, aad_length)) {
+		goto err;
 	}
-
-	enc_length = 0;
-	if (!fdow_encoded_length(&temp_fdow, &enc_length) || enc_length == 0) {
-		LOG(LOG_ERROR, "EAT Sig_structure: Failed to find encoded length of "
-			"Sig_structure array as bstr\n");
-		goto end;
+	offset += aad_length;
+	if (0 != memcpy_s(sig_struct->bytes + offset, sig_struct->byte_sz - offset,
+		payload_head, payload_head_length)) {
+		goto err;
 	}
-
-	// Alocate and copy the encoded Sig_sturcture bstr
-	*sig_structure =
-		fdo_byte_array_alloc_with_byte_array(temp_fdow.b.block, enc_length);
-	if (!(*sig_structure)) {
-		LOG(LOG_ERROR,
-			"EAT Sig_structure: Failed to alloc output Sig_structure\n");
-		goto end;
+	offset += payload_head_length;
+	if (eat_payload->byte_sz && 0 != memcpy_s(sig_struct->bytes + offset,
+		sig_struct->byte_sz - offset, eat_payload->bytes, eat_payload->byte_sz)) {
+		goto err;
 	}
 
-	ret = true;
-end:
-	if (empty_byte_array) {
-		fdo_byte_array_free(empty_byte_array);
-	}
-	if (temp_fdow.b.block || temp_fdow.current) {
-		fdow_flush(&temp_fdow);
-	}
-	return ret;
+	*sig_structure = sig_struct;
+	return true;
+err:
+	LOG(LOG_ERROR, "EAT Sig_structure: Failed to copy Sig_structure\n");
+	fdo_byte_array_free(sig_struct);
+	return false;
 }
 
 /**
@@ -3871,121 +4035,73 @@ bool fdo_cose_write(fdow_t *fdow, fdo_cose_t *cose) {
 }
 
 /**
- * Create Sig_structure of the form:
+ * Verify the signature of a COSE_Sign1 object. The Sig_structure it is computed
+ * over is never built:
  * Sig_structure = [
  * context : "Signature1",
  * body_protected : empty_or_serialized_map,	// COSE Protected header as bstr
  * external_aad : bstr,
  * payload : bstr
  * ]
- * Only to be used Sig_sturcture for COSE.
+ * Instead, its encoded head, the external_aad and the payload are fed to the
+ * signature hash in turn, so large payloads are neither copied nor re-encoded.
  *
  * @param cose_ph - COSE protected header
  * @param cose_payload - COSE Payload
- * @param external_aad - External AAD. If NULL, empty bstr will be written, else
- * the AAD bytes will be written
- * @param sig_structure - Out buffer to store the constructred CBOR encoded Sig_structure.
- * Memory allocation will be done inside this method, if the operation is successful.
- * It will be NULL otherwise.
- * @return true, if read was a success. False otherwise.
+ * @param external_aad - External AAD. If NULL, empty bstr is used.
+ * @param cose_signature - COSE signature to verify
+ * @param pk - public key to verify the signature with
+ * @return true, if the signature verifies. False otherwise.
  */
-bool fdo_cose_write_sigstructure(fdo_cose_protected_header_t *cose_ph,
+bool fdo_cose_verify_signature(fdo_cose_protected_header_t *cose_ph,
 	fdo_byte_array_t *cose_payload, fdo_byte_array_t *external_aad,
-	fdo_byte_array_t **sig_structure) {
+	fdo_byte_array_t *cose_signature, fdo_public_key_t *pk) {
 
-	bool ret = false;
-	char context[] = "Signature1";
-	fdo_byte_array_t *empty_byte_array = NULL;
-	fdow_t temp_fdow = {0};
-	size_t enc_length = 0;
-	size_t sig_struct_sz = 0;
+	uint8_t head[FDO_SIG_STRUCTURE_HEAD_MAX];
+	uint8_t payload_head[FDO_CBOR_HEAD_MAX];
+	size_t head_length = 0;
+	size_t payload_head_length = 0;
+	size_t aad_length = 0;
+	bool signature_verify = false;
+	void *hash_ctx = NULL;
 
-	if (!cose_ph || !cose_payload || !sig_structure) {
+	if (!cose_ph || !cose_payload || !cose_signature || !pk) {
 		return false;
 	}
 
-	// size of the Sigstruct CBOR encoded buffer
-	// provide buffer of 128 bytes for protected header + context + additional CBOR encoding
-	if (external_aad) {
-		sig_struct_sz = cose_payload->byte_sz + external_aad->byte_sz + BUFF_SIZE_128_BYTES;
-	} else {
-		sig_struct_sz = cose_payload->byte_sz + BUFF_SIZE_128_BYTES;
-	}
-
-	if (!fdow_init(&temp_fdow) || !fdo_block_alloc_with_size(&temp_fdow.b, sig_struct_sz) ||
-		!fdow_encoder_init(&temp_fdow)) {
-		LOG(LOG_ERROR, "COSE Sig_structure: FDOW Initialization/Allocation failed!\n");
-		goto end;
-	}
-
-	if (!fdow_start_array(&temp_fdow, 4)) {
-		LOG(LOG_ERROR, "COSE Sig_structure: Failed to write start array\n");
+	aad_length = external_aad ? external_aad->byte_sz : 0;
+	head_length = fdo_sigstructure_write_head(cose_ph->ph_sig_alg, aad_length, head);
+	if (!head_length) {
+		LOG(LOG_ERROR, "COSE Sig_structure: Failed to write head\n");
 		return false;
 	}
+	payload_head_length = fdo_cbor_write_head(2, cose_payload->byte_sz, payload_head);
 
-	if (!fdow_text_string(&temp_fdow, context, sizeof(context) - 1)) {
-		LOG(LOG_ERROR, "COSE Sig_structure: Failed to write Context\n");
+	hash_ctx = fdo_ov_verify_init(pk);
+	if (!hash_ctx) {
+		LOG(LOG_ERROR, "COSE Sig_structure: Failed to start hash\n");
 		return false;
 	}
-
-	if (!fdo_cose_write_protected_header(&temp_fdow, cose_ph)) {
-		LOG(LOG_ERROR, "COSE Sig_structure: Failed to write protected header\n");
+	if (0 != fdo_crypto_hash_update(hash_ctx, head, head_length) ||
+		(aad_length && 0 != fdo_crypto_hash_update(hash_ctx,
+			external_aad->bytes, aad_length)) ||
+		0 != fdo_crypto_hash_update(hash_ctx, payload_head, payload_head_length) ||
+		(cose_payload->byte_sz && 0 != fdo_crypto_hash_update(hash_ctx,
+			cose_payload->bytes, cose_payload->byte_sz))) {
+		LOG(LOG_ERROR, "COSE Sig_structure: Failed to hash\n");
+		fdo_crypto_hash_final(hash_ctx, NULL, 0);
 		return false;
 	}
 
-	if (external_aad) {
-		if (!fdow_byte_string(&temp_fdow, external_aad->bytes, external_aad->byte_sz)) {
-			LOG(LOG_ERROR, "COSE Sig_structure: Failed to write external_aad\n");
-			goto end;
-		}
-	} else {
-		empty_byte_array = fdo_byte_array_alloc(0);
-		if (!empty_byte_array) {
-			LOG(LOG_ERROR, "COSE Sig_structure: Byte Array Alloc failed\n");
-			return false;
-		}
-
-		if (!fdow_byte_string(&temp_fdow, empty_byte_array->bytes, empty_byte_array->byte_sz)) {
-			LOG(LOG_ERROR, "COSE Sig_structure: Failed to write external_aad\n");
-			goto end;
-		}
-	}
-
-	if (!fdow_byte_string(&temp_fdow, cose_payload->bytes, cose_payload->byte_sz)) {
-		LOG(LOG_ERROR, "COSE Sig_structure: Failed to write payload\n");
-		goto end;
-	}
-
-	if (!fdow_end_array(&temp_fdow)) {
-		LOG(LOG_ERROR, "COSE Sig_structure: Failed to write end array\n");
-		goto end;
-	}
-
-	enc_length = 0;
-	if (!fdow_encoded_length(&temp_fdow, &enc_length) || enc_length == 0) {
-		LOG(LOG_ERROR, "COSE Sig_structure: Failed to find encoded length of "
-			"Sig_structure array as bstr\n");
-		goto end;
-	}
-
-	// Alocate and copy the encoded Sig_sturcture bstr
-	*sig_structure =
-		fdo_byte_array_alloc_with_byte_array(temp_fdow.b.block, enc_length);
-	if (!(*sig_structure)) {
-		LOG(LOG_ERROR,
-			"COSE Sig_structure: Failed to alloc output Sig_structure\n");
-		goto end;
-	}
-
-	ret = true;
-end:
-	if (empty_byte_array) {
-		fdo_byte_array_free(empty_byte_array);
-	}
-	if (temp_fdow.b.block || temp_fdow.current) {
-		fdow_flush(&temp_fdow);
+	// releases hash_ctx
+	if (0 != fdo_ov_verify_final(hash_ctx, cose_signature->bytes,
+		cose_signature->byte_sz, pk, &signature_verify) || !signature_verify) {
+		LOG(LOG_ERROR, "Signature internal failure, or signature does "
+		    "not verify.\n");
+		return false;
 	}
-	return ret;
+	LOG(LOG_DEBUG, "Signature verifies OK.\n");
+	return true;
 }
 
 /**
@@ -4059,45 +4175,21 @@ bool fdo_cose_encrypt0_read_protected_header(fdor_t *fdor,
 
 	bool ret = false;
 	fdor_t temp_fdor;
+	fdo_byte_view_t ph_as_bstr = {0};
+
 	if (memset_s(&temp_fdor, sizeof(fdor_t), 0) != 0) {
 		LOG(LOG_ERROR, "COSE_Encrypt0 Protected header: Failed to intialize temporary FDOR\n");
 		return false;
 	}
 
-	size_t var_length = 0;
-	if (!fdor_string_length(fdor, &var_length) ||
-		var_length == 0) {
-		LOG(LOG_ERROR, "COSE_Encrypt0 Protected header: Failed to read length\n");
-		return false;
-	}
-	fdo_byte_array_t *ph_as_bstr = fdo_byte_array_alloc(var_length);
-	if (!ph_as_bstr) {
-		LOG(LOG_ERROR,
-			"COSE_Encrypt0 Protected header: Failed to alloc for bstr\n");
-		return false;
-	}
-	if (!fdor_byte_string(fdor, ph_as_bstr->bytes, ph_as_bstr->byte_sz)) {
+	if (!fdo_byte_view_read(fdor, &ph_as_bstr) || ph_as_bstr.byte_sz == 0) {
 		LOG(LOG_ERROR,
 			"COSE_Encrypt0 Protected header: Failed to read as bstr\n");
-		goto end;
-	}
-
-	// create a temporary FDOR to read (unwrap) the header contents as map
-	if (!fdor_init(&temp_fdor) ||
-		!fdo_block_alloc_with_size(&temp_fdor.b, ph_as_bstr->byte_sz)) {
-		LOG(LOG_ERROR,
-			"COSE_Encrypt0 Protected header: Failed to setup temporary FDOR\n");
-		goto end;
-	}
-
-	if (0 != memcpy_s(temp_fdor.b.block, temp_fdor.b.block_size,
-		ph_as_bstr->bytes, ph_as_bstr->byte_sz)) {
-		LOG(LOG_ERROR,
-			"COSE_Encrypt0 Protected header: Failed to copy temporary unwrapped Header content\n");
-		goto end;
+		return false;
 	}
 
-	if (!fdor_parser_init(&temp_fdor)) {
+	// read (unwrap) the header contents as map, straight from the bstr
+	if (!fdor_view_init(&temp_fdor, ph_as_bstr.bytes, ph_as_bstr.byte_sz)) {
 		LOG(LOG_ERROR,
 			"COSE_Encrypt0 Protected header: Failed to init temporary FDOR parser\n");
 		goto end;
@@ -4130,11 +4222,7 @@ bool fdo_cose_encrypt0_read_protected_header(fdor_t *fdor,
 	}
 	ret = true;
 end:
-	fdor_flush(&temp_fdor);
-	fdo_free(temp_fdor.b.block);
-	if (ph_as_bstr) {
-		fdo_byte_array_free(ph_as_bstr);
-	}
+	fdor_view_flush(&temp_fdor);
 	return ret;
 }
 
@@ -4188,7 +4276,8 @@ bool fdo_cose_encrypt0_read_unprotected_header(fdor_t *fdor,
  * Read the given COSE_Encrypt0 into the fdo_cose_encrypt0_t parameter.
  * The fdo_cose_encrypt0_t parameter should have memory pre-allocated.
  * However, the internal elements must be un-allocated.
- * The memory allocation for the same would be done in the method.
+ * The memory allocation for the headers would be done in the method, while
+ * the payload is read into payload_view, which refers to the FDOR buffer.
  * [
  * protected header,
  * unprotected header,
@@ -4243,19 +4332,9 @@ bool fdo_cose_encrypt0_read(fdor_t *fdor, fdo_cose_encrypt0_t *cose_encrypt0) {
 		goto end;
 	}
 
-	size_t payload_length = 0;
-	if (!fdor_string_length(fdor, &payload_length) ||
-		payload_length == 0) {
-		LOG(LOG_ERROR, "COSE_Encrypt0: Failed to read EATpayload length\n");
-		goto end;
-	}
-	cose_encrypt0->payload = fdo_byte_array_alloc(payload_length);
-	if (!cose_encrypt0->payload) {
-		LOG(LOG_ERROR, "COSE_Encrypt0: Failed to alloc EATPayload\n");
-		goto end;
-	}
-	if (!fdor_byte_string(fdor, cose_encrypt0->payload->bytes, cose_encrypt0->payload->byte_sz)) {
-		LOG(LOG_ERROR, "COSE_Encrypt0: Failed to read EATpayload\n");
+	if (!fdo_byte_view_read(fdor, &cose_encrypt0->payload_view) ||
+		cose_encrypt0->payload_view.byte_sz == 0) {
+		LOG(LOG_ERROR, "COSE_Encrypt0: Failed to read EATpayload\n");
 		goto end;
 	}
 
@@ -4672,121 +4751,190 @@ bool fdo_signature_verification(fdo_byte_array_t *plain_text,
 //
 
 /**
- * Allocate the key value
- */
-fdo_key_value_t *fdo_kv_alloc(void)
+ * Compute the 32-bit FNV-1a hash of a name, used to index ServiceInfo keys and
+ * module names. 0 is never returned, so that it can mark an uncomputed hash.
+ * @param name - pointer to the name
+ * @param name_len - maximum number of characters to hash
+ * @param fold_case - true to hash ASCII letters case-insensitively
+ * @return hash of the name
+ */
+static uint32_t fdo_name_hash(const char *name, size_t name_len, bool fold_case)
 {
-	return fdo_alloc(sizeof(fdo_key_value_t));
+	uint32_t hash = 2166136261U;
+	size_t i;
+
+	for (i = 0; i < name_len && name[i] != '\0'; i++) {
+		uint8_t c = (uint8_t)name[i];
+
+		if (fold_case && c >= 'A' && c <= 'Z') {
+			c = (uint8_t)(c - 'A' + 'a');
+		}
+		hash ^= c;
+		hash *= 16777619U;
+	}
+	return hash ? hash : 1;
 }
 
+//----------------------------------------------------------------------
+// Service_info handling
+//
+
 /**
- * Allocate the key vlaue and initialize with the value provided
- * @param key - pointer to the key
- * @param val - pointer to the input value
- * @return pointer to the allocated key value if success else NULL.
+ * Add a module to the module registry of the given module list, allocating
+ * the registry on the list head if needed. Module names must be unique.
+ * At most one module can be active at a time, so a module registered as active
+ * while another one already is, is registered as inactive.
+ *
+ * @param module_list - Owner ServiceInfo module list head
+ * @param module - module list node to add to the registry
+ * @return true if the module was added, false otherwise
  */
-fdo_key_value_t *fdo_kv_alloc_with_str(const char *key, const char *val)
+bool fdo_serviceinfo_module_index_add(fdo_sdk_service_info_module_list_t *module_list,
+	fdo_sdk_service_info_module_list_t *module)
 {
-	if (!key || !val) {
-		return NULL;
-	}
+	fdo_sdk_service_info_module_list_t *entry = NULL;
+	fdo_sv_info_module_index_t *index = NULL;
+	size_t module_name_len = 0;
+	int strcmp_result = 1;
 
-	fdo_key_value_t *kv = fdo_kv_alloc();
+	if (!module_list || !module) {
+		return false;
+	}
 
-	if (kv != NULL) {
-		int key_len = strnlen_s(key, FDO_MAX_STR_SIZE);
+	module_name_len = strnlen_s(module->module.module_name, FDO_MODULE_NAME_LEN);
+	if (!module_name_len || module_name_len == FDO_MODULE_NAME_LEN) {
+		LOG(LOG_ERROR, "ServiceInfo: Module name is either empty or "
+			"isn't NULL-terminated\n");
+		return false;
+	}
 
-		if (!key_len || key_len == FDO_MAX_STR_SIZE) {
-			LOG(LOG_ERROR, "%s(): key is either "
-			    "'NULL' or 'isn't "
-			    "NULL terminated'\n", __func__);
-			fdo_kv_free(kv);
-			return NULL;
+	if (!module_list->index) {
+		module_list->index = fdo_alloc(sizeof(fdo_sv_info_module_index_t));
+		if (!module_list->index) {
+			LOG(LOG_ERROR, "ServiceInfo: Failed to alloc module registry\n");
+			return false;
 		}
+	}
+	index = module_list->index;
 
-		kv->key = fdo_string_alloc_with(key, key_len);
+	module->name_hash = fdo_name_hash(module->module.module_name,
+		module_name_len, false);
+	entry = index->buckets[module->name_hash & (FDO_SI_MODULE_BUCKETS - 1)];
+	while (entry) {
+		if (entry->name_hash == module->name_hash &&
+			strcmp_s(entry->module.module_name, FDO_MODULE_NAME_LEN,
+			module->module.module_name, &strcmp_result) == 0 &&
+			strcmp_result == 0) {
+			LOG(LOG_ERROR, "ServiceInfo: Module %s is already registered\n",
+				module->module.module_name);
+			return false;
+		}
+		entry = entry->bucket_next;
+	}
 
-		int val_len = strnlen_s(val, FDO_MAX_STR_SIZE);
+	module->bucket_next = index->buckets[module->name_hash & (FDO_SI_MODULE_BUCKETS - 1)];
+	index->buckets[module->name_hash & (FDO_SI_MODULE_BUCKETS - 1)] = module;
 
-		if (val_len == FDO_MAX_STR_SIZE) {
-			LOG(LOG_ERROR,
-			    "%s(): value is either "
-			    "'NULL' or 'isn't NULL terminated'\n", __func__);
-			printf("vallen:%d\t, buf:%s\n", val_len, val);
-			fdo_kv_free(kv);
-			return NULL;
+	if (module->module.active) {
+		if (index->active) {
+			LOG(LOG_ERROR, "ServiceInfo: Module %s is already active, "
+				"registering %s as inactive\n",
+				index->active->module.module_name, module->module.module_name);
+			module->module.active = false;
+		} else {
+			index->active = module;
 		}
+	}
+	return true;
+}
 
-		kv->str_val = fdo_string_alloc_with(val, val_len);
-		if (kv->key == NULL || kv->str_val == NULL) {
-			fdo_kv_free(kv);
-			kv = NULL;
-		}
+/**
+ * Free the module registry of the given module list. The modules themselves are not freed.
+ *
+ * @param module_list - Owner ServiceInfo module list head
+ */
+void fdo_serviceinfo_module_index_free(fdo_sdk_service_info_module_list_t *module_list)
+{
+	if (module_list && module_list->index) {
+		fdo_free(module_list->index);
 	}
-	return kv;
 }
 
 /**
- * Allocate and initialize the key
- * @param key - pointer to the key
- * @return pointer to the allocated key if success else NULL.
+ * Find the module with the given name. The module registry is used when the list
+ * has one, else the list is traversed.
+ *
+ * @param module_list - Owner ServiceInfo module list head
+ * @param module_name - NULL-terminated module name
+ * @return the module list node if found, NULL otherwise
  */
-fdo_key_value_t *fdo_kv_alloc_key_only(const char *key)
+fdo_sdk_service_info_module_list_t *fdo_serviceinfo_module_lookup(
+	fdo_sdk_service_info_module_list_t *module_list, const char *module_name)
 {
-	if (!key) {
+	fdo_sdk_service_info_module_list_t *entry = NULL;
+	size_t module_name_len = 0;
+	uint32_t name_hash = 0;
+	int strcmp_result = 1;
+
+	if (!module_list || !module_name) {
 		return NULL;
 	}
 
-	fdo_key_value_t *kv = fdo_kv_alloc();
-
-	if (kv != NULL) {
-		int key_len = strnlen_s(key, FDO_MAX_STR_SIZE);
+	module_name_len = strnlen_s(module_name, FDO_MODULE_NAME_LEN);
+	if (!module_name_len || module_name_len == FDO_MODULE_NAME_LEN) {
+		return NULL;
+	}
 
-		if (!key_len || key_len == FDO_MAX_STR_SIZE) {
-			LOG(LOG_ERROR, "%s(): key is either "
-			    "'NULL' or 'isn't "
-			    "NULL terminated'\n", __func__);
-			fdo_kv_free(kv);
-			return NULL;
+	if (!module_list->index) {
+		entry = module_list;
+		while (entry) {
+			if (strcmp_s(entry->module.module_name, FDO_MODULE_NAME_LEN,
+				module_name, &strcmp_result) == 0 && strcmp_result == 0) {
+				return entry;
+			}
+			entry = entry->next;
 		}
+		return NULL;
+	}
 
-		kv->key = fdo_string_alloc_with(key, key_len);
-		if (kv->key == NULL) {
-			fdo_kv_free(kv);
-			kv = NULL;
+	name_hash = fdo_name_hash(module_name, module_name_len, false);
+	entry = module_list->index->buckets[name_hash & (FDO_SI_MODULE_BUCKETS - 1)];
+	while (entry) {
+		if (entry->name_hash == name_hash &&
+			strcmp_s(entry->module.module_name, FDO_MODULE_NAME_LEN,
+			module_name, &strcmp_result) == 0 && strcmp_result == 0) {
+			return entry;
 		}
+		entry = entry->bucket_next;
 	}
-	return kv;
+	return NULL;
 }
 
 /**
- * Free the allcated strutc of type key value
- * @param kv - pointer to the struct of type key value that is to be fdo_free
+ * Return the currently active module. The module registry is used when the list
+ * has one, else the list is traversed for the first active module.
+ *
+ * @param module_list - Owner ServiceInfo module list head
+ * @return the active module list node, NULL if no module is active
  */
-void fdo_kv_free(fdo_key_value_t *kv)
+fdo_sdk_service_info_module_list_t *fdo_serviceinfo_active_module(
+	fdo_sdk_service_info_module_list_t *module_list)
 {
-	if (kv->key != NULL) {
-		fdo_string_free(kv->key);
-	}
-	if (kv->str_val != NULL) {
-		fdo_string_free(kv->str_val);
-	}
-	if (kv->bin_val != NULL) {
-		fdo_byte_array_free(kv->bin_val);
+	if (!module_list) {
+		return NULL;
 	}
-	if (kv->bool_val != NULL) {
-		fdo_free(kv->bool_val);
+	if (module_list->index) {
+		return module_list->index->active;
 	}
-	if (kv->int_val != NULL) {
-		fdo_free(kv->int_val);
+	while (module_list) {
+		if (module_list->module.active) {
+			return module_list;
+		}
+		module_list = module_list->next;
 	}
-	fdo_free(kv);
+	return NULL;
 }
 
-//----------------------------------------------------------------------
-// Service_info handling
-//
-
 /**
  * Read the CBOR encoded ServiceInfo struct.
  * ServiceInfo = [
@@ -4808,8 +4956,8 @@ bool fdo_serviceinfo_read(fdor_t *fdor, fdo_sdk_service_info_module_list_t *modu
 		int *cb_return_val, fdo_sv_invalid_modnames_t **serviceinfo_invalid_modnames) {
 
 	bool ret = false;
-	char *serviceinfokey = NULL;
-	fdo_byte_array_t *serviceinfoval = NULL;
+	const char *serviceinfokey = NULL;
+	const uint8_t *serviceinfoval = NULL;
 	char module_name[FDO_MODULE_NAME_LEN] = {0};
 	char module_message[FDO_MODULE_MSG_LEN] = {0};
 	size_t num_serviceinfokv = 0;
@@ -4841,10 +4989,12 @@ bool fdo_serviceinfo_read(fdor_t *fdor, fdo_sdk_service_info_module_list_t *modu
 			goto exit;
 		}
 
+		// ServiceInfoKey and ServiceInfoVal are referenced in place within the
+		// decrypted message buffer, and are not copied out of it
 		size_t serviceinfokey_length = 0;
 		size_t serviceinfoval_length = 0;
-		if (!fdor_string_length(fdor, &serviceinfokey_length)) {
-			LOG(LOG_ERROR, "ServiceInfoKV read: Failed to read ServiceInfoKey length\n");
+		if (!fdor_text_string_view(fdor, &serviceinfokey, &serviceinfokey_length)) {
+			LOG(LOG_ERROR, "ServiceInfoKV read: Failed to read ServiceInfoKV\n");
 			goto exit;
 		}
 		if (serviceinfokey_length == 0 ||
@@ -4854,16 +5004,6 @@ bool fdo_serviceinfo_read(fdor_t *fdor, fdo_sdk_service_info_module_list_t *modu
 			goto exit;
 		}
 
-		serviceinfokey = fdo_alloc(sizeof(char) * serviceinfokey_length);
-		if (!serviceinfokey) {
-			LOG(LOG_ERROR, "ServiceInfoKV read: Failed to alloc ServiceInfoKey\n");
-			goto exit;
-			}
-		if (!fdor_text_string(fdor, serviceinfokey, serviceinfokey_length)) {
-			LOG(LOG_ERROR, "ServiceInfoKV read: Failed to read ServiceInfoKV\n");
-			goto exit;
-		}
-
 		if (0 != memset_s(&module_name, sizeof(module_name), 0)) {
 			LOG(LOG_ERROR, "ServiceInfoKV read: Failed to clear modulename\n");
 			goto exit;
@@ -4881,7 +5021,7 @@ bool fdo_serviceinfo_read(fdor_t *fdor, fdo_sdk_service_info_module_list_t *modu
 			*cb_return_val = MESSAGE_BODY_ERROR;
 			goto exit;
 		}
-		while (':' != serviceinfokey[index]) {
+		while (index < serviceinfokey_length && ':' != serviceinfokey[index]) {
 			if (index >= sizeof(module_name) - 1) {
 				LOG(LOG_ERROR, "ServiceInfoKV read: Invalid ServiceInfoKey\n");
 				*cb_return_val = MESSAGE_BODY_ERROR;
@@ -4891,6 +5031,11 @@ bool fdo_serviceinfo_read(fdor_t *fdor, fdo_sdk_service_info_module_list_t *modu
 			module_name[index] = serviceinfokey[index];
 			++index;
 		}
+		if (index >= serviceinfokey_length) {
+			LOG(LOG_ERROR, "ServiceInfoKV read: Invalid ServiceInfoKey\n");
+			*cb_return_val = MESSAGE_BODY_ERROR;
+			goto exit;
+		}
 		++index;
 		size_t module_msg_index = 0;
 		if (serviceinfokey_length - index >= sizeof(module_message) - 1) {
@@ -4905,19 +5050,7 @@ bool fdo_serviceinfo_read(fdor_t *fdor, fdo_sdk_service_info_module_list_t *modu
 		}
 
 		// start parsing ServiceInfoVal now
-		if (!fdor_string_length(fdor, &serviceinfoval_length)) {
-			LOG(LOG_ERROR, "ServiceInfoKV read: Failed to read ServiceInfoKey length\n");
-			goto exit;
-		}
-
-		serviceinfoval = fdo_byte_array_alloc(serviceinfoval_length);
-		if (!serviceinfoval) {
-			LOG(LOG_ERROR,
-				"ServiceInfoKV read: Failed to alloc ServiceInfoVal\n");
-			goto exit;
-		}
-
-		if (!fdor_byte_string(fdor, serviceinfoval->bytes, serviceinfoval->byte_sz)) {
+		if (!fdor_byte_string_view(fdor, &serviceinfoval, &serviceinfoval_length)) {
 			LOG(LOG_ERROR, "ServiceInfoKV read: Failed to read ServiceInfoVal\n");
 			goto exit;
 		}
@@ -4928,15 +5061,11 @@ bool fdo_serviceinfo_read(fdor_t *fdor, fdo_sdk_service_info_module_list_t *modu
 		}
 
 		if (!fdo_supply_serviceinfoval(&module_name[0], &module_message[0],
-				serviceinfoval, module_list, cb_return_val)) {
+				serviceinfoval, serviceinfoval_length, module_list, cb_return_val)) {
 			LOG(LOG_ERROR, "ServiceInfoKV read: Failed to read ServiceInfoVal\n");
 			goto exit;
 		}
 
-		// free the entries for reuse
-		fdo_free(serviceinfokey);
-		fdo_byte_array_free(serviceinfoval);
-		serviceinfoval = NULL;
 		if (*cb_return_val == FDO_SI_INVALID_MOD_ERROR) {
 			if (!fdo_serviceinfo_invalid_modname_add(module_name,
 				serviceinfo_invalid_modnames)) {
@@ -4952,13 +5081,6 @@ bool fdo_serviceinfo_read(fdor_t *fdor, fdo_sdk_service_info_module_list_t *modu
 
 	ret = true;
 exit:
-	if (serviceinfokey) {
-		fdo_free(serviceinfokey);
-	}
-	if (serviceinfoval) {
-		fdo_byte_array_free(serviceinfoval);
-		serviceinfoval = NULL;
-	}
 	return ret;
 }
 
@@ -4976,12 +5098,14 @@ bool fdo_serviceinfo_invalid_modname_add(char *module_name,
 
 	int strcmp_diff = 0;
 	size_t modname_sz_rcv = 0;
+	uint32_t name_hash = 0;
 	fdo_sv_invalid_modnames_t *temp_next = NULL;
 	fdo_sv_invalid_modnames_t *temp_current = NULL;
 
 	if (!module_name || !serviceinfo_invalid_modnames) {
 		return false;
 	}
+	name_hash = fdo_name_hash(module_name, FDO_MODULE_NAME_LEN, false);
 
 	// 1st module name being allocated
 	if (!(*serviceinfo_invalid_modnames)) {
@@ -4999,6 +5123,13 @@ bool fdo_serviceinfo_invalid_modname_add(char *module_name,
 		temp_next = *serviceinfo_invalid_modnames;
 		while (temp_next) {
 
+			// only compare the names when their hashes match
+			if (temp_next->name_hash != name_hash) {
+				temp_current = temp_next;
+				temp_next = temp_next->next;
+				continue;
+			}
+
 			modname_sz_rcv = strnlen_s(temp_next->bytes,
 				FDO_MODULE_NAME_LEN);
 			if (modname_sz_rcv == 0 || modname_sz_rcv == FDO_MODULE_NAME_LEN) {
@@ -5020,11 +5151,12 @@ bool fdo_serviceinfo_invalid_modname_add(char *module_name,
 			temp_next = temp_next->next;
 		}
 		temp_current->next = fdo_alloc(sizeof(fdo_sv_invalid_modnames_t));
-		if (!temp_current) {
+		if (!temp_current->next) {
 			LOG(LOG_ERROR,
 				"Failed to alloc for unsupported modules\n");
 			return false;
 		}
+		temp_current = temp_current->next;
 	}
 
 	if (0 != strncpy_s(temp_current->bytes,
@@ -5033,6 +5165,7 @@ bool fdo_serviceinfo_invalid_modname_add(char *module_name,
 			"Failed to copy unsupported module name\n");
 		return false;
 	}
+	temp_current->name_hash = name_hash;
 	return true;
 }
 
@@ -5062,7 +5195,7 @@ void fdo_serviceinfo_invalid_modname_free(
 }
 
 /**
- * Traverse the Module list to check if the module name is supported and active.
+ * Look up the module name in the Module registry to check if it is supported and active.
  * If yes, call the registered callback method that processes the ServiceInfoVal
  * and return true/false depending on callback's execution.
  * If the module name is not supported, set cb_return_val to 'FDO_SI_INVALID_MOD_ERROR'
@@ -5071,126 +5204,120 @@ void fdo_serviceinfo_invalid_modname_free(
  *
  * @param module_name - moduleName as received in Owner ServiceInfo
  * @param module_message - messageName as received in Owner ServiceInfo
+ * The ServiceInfoVal is handed to the module in place: it points into the
+ * decrypted message buffer and is only valid for the duration of the callback.
+ *
  * @param module_val - moduleVal (bstr-unwrapped) as received in Owner ServiceInfo
+ * @param module_val_sz - size of moduleVal
  * @param module_list - Owner ServiceInfo module list
  * @param cb_return_val - out value to hold the return value from the registered modules.
  * @return true if the operation was a success, false otherwise
  */
 bool fdo_supply_serviceinfoval(char *module_name, char *module_message,
-	fdo_byte_array_t *module_val,
+	const uint8_t *module_val, size_t module_val_sz,
 	fdo_sdk_service_info_module_list_t *module_list, int *cb_return_val)
 {
 	int strcmp_result = 1;
 	bool retval = false;
-	bool module_name_found = false;
 	bool active = false;
-	fdo_sdk_service_info_module_list_t *traverse_list = module_list;
+	size_t val_sz = module_val_sz;
+	fdo_sdk_service_info_module_list_t *module = NULL;
+	fdo_sdk_service_info_module_list_t *active_module = NULL;
 	fdor_t temp_fdor = {0};
 
 	if (!cb_return_val) {
 		return retval;
 	}
 
-	if (!module_name || !module_message || !module_val) {
+	if (!module_name || !module_message || !module_val || !module_val_sz) {
 		*cb_return_val = FDO_SI_INTERNAL_ERROR;
 		return retval;
 	}
 
-	// create a temporary FDOR to read the received unwrapped (cbor.any) ServiceInfoVal
-	if (!fdor_init(&temp_fdor) ||
-		!fdo_block_alloc_with_size(&temp_fdor.b, module_val->byte_sz)) {
-		LOG(LOG_ERROR, "ServiceInfo - Failed to setup temporary FDOR\n");
-		goto end;
-	}
-
-	if (0 != memcpy_s(temp_fdor.b.block, temp_fdor.b.block_size,
-		module_val->bytes, module_val->byte_sz)) {
-		LOG(LOG_ERROR, "ServiceInfo - Failed to copy buffer into temporary FDOR\n");
-		goto end;
-	}
-
-	if (!fdor_parser_init(&temp_fdor)) {
-		printf("ServiceInfo - Failed to perform init FDOR parser\n");
-		goto end;
+	module = fdo_serviceinfo_module_lookup(module_list, module_name);
+	if (!module) {
+		// module is not present. skip this ServiceInfoVal and
+		// set cb_return_val to 'FDO_SI_INVALID_MOD_ERROR'
+		LOG(LOG_ERROR,
+			"ServiceInfo: Received ServiceInfo for an unsupported module %s\n",
+		    module_name);
+		*cb_return_val = FDO_SI_INVALID_MOD_ERROR;
+		return true;
 	}
 
-	while (module_list) {
-		strcmp_s(module_list->module.module_name, FDO_MODULE_NAME_LEN,
-			 module_name, &strcmp_result);
-		if (strcmp_result == 0) {
-			// found the module, now check if the message is 'active'
-			// if yes, read the value and activate/deactivate the module and return.
-			module_name_found = true;
-			strcmp_s(module_message, FDO_MODULE_MSG_LEN,
-				FDO_MODULE_MESSAGE_ACTIVE, &strcmp_result);
-			if (strcmp_result == 0) {
-				if (!fdor_boolean(&temp_fdor, &active)) {
-					LOG(LOG_ERROR, "ServiceInfoKey: Failed to read module message active %s\n",
-				    	module_list->module.module_name);
-					goto end;
-				}
-
-				if (active) {
-					// traverse the list to deactivate every module
-					while (traverse_list) {
-						traverse_list->module.active = false;
-						traverse_list = traverse_list->next;
-					}
-					// now activate the current module
-					module_list->module.active = active;
-					LOG(LOG_INFO, "ServiceInfo: Activated module %s\n",
-						module_list->module.module_name);
-				} else {
-					// now de-activate the current module
-					module_list->module.active = active;
-					LOG(LOG_INFO, "ServiceInfo: De-activated module %s\n",
-						module_list->module.module_name);
-				}
+	// found the module, now check if the message is 'active'
+	// if yes, read the value and activate/deactivate the module and return.
+	strcmp_s(module_message, FDO_MODULE_MSG_LEN,
+		FDO_MODULE_MESSAGE_ACTIVE, &strcmp_result);
+	if (strcmp_result == 0) {
+		// read the unwrapped (cbor.any) ServiceInfoVal directly from the
+		// received buffer
+		if (!fdor_init(&temp_fdor) ||
+			!fdor_view_init(&temp_fdor, module_val, module_val_sz)) {
+			LOG(LOG_ERROR, "ServiceInfo - Failed to setup temporary FDOR\n");
+			goto end;
+		}
+		if (!fdor_boolean(&temp_fdor, &active)) {
+			LOG(LOG_ERROR, "ServiceInfoKey: Failed to read module message active %s\n",
+			    module->module.module_name);
+			goto end;
+		}
 
-				retval = true;
-				break;
-			}
-			// if the module is activated by the Owner, only then proceed with processing
-			// ServiceInfoVal via callback method
-			if (module_list->module.active) {
-				// check if module callback is successful
-				*cb_return_val = module_list->module.service_info_callback(
-					FDO_SI_SET_OSI, module_message, module_val->bytes,
-					&module_val->byte_sz, NULL, NULL, NULL, 0);
-
-				if (*cb_return_val != FDO_SI_SUCCESS) {
-					LOG(LOG_ERROR,
-						"ServiceInfo: %s's CB Failed for type:%d\n",
-						module_list->module.module_name,
-						FDO_SI_SET_OSI);
-					break;
+		if (active) {
+			// deactivate every module
+			if (module_list->index) {
+				active_module = module_list->index->active;
+				if (active_module) {
+					active_module->module.active = false;
 				}
-				retval = true;
+				module_list->index->active = module;
 			} else {
-				LOG(LOG_ERROR, "ServiceInfo: Received ServiceInfo for an inactive module %s\n",
-				    module_list->module.module_name);
-				// module is present, but is not the active module. skip this ServiceInfoVal
-				fdor_next(&temp_fdor);
-				retval = true;
+				fdo_serviceinfo_deactivate_modules(module_list);
 			}
-			break;
+			// now activate the current module
+			module->module.active = active;
+			LOG(LOG_INFO, "ServiceInfo: Activated module %s\n",
+				module->module.module_name);
+		} else {
+			// now de-activate the current module
+			module->module.active = active;
+			if (module_list->index && module_list->index->active == module) {
+				module_list->index->active = NULL;
+			}
+			LOG(LOG_INFO, "ServiceInfo: De-activated module %s\n",
+				module->module.module_name);
 		}
-		module_list = module_list->next;
+
+		retval = true;
+		goto end;
 	}
-	if (!module_name_found) {
-			// module is not present. skip this ServiceInfoVal and
-			// set cb_return_val to 'FDO_SI_INVALID_MOD_ERROR'
+
+	// if the module is activated by the Owner, only then proceed with processing
+	// ServiceInfoVal via callback method
+	if (module->module.active) {
+		// check if module callback is successful
+		*cb_return_val = module->module.service_info_callback(
+			FDO_SI_SET_OSI, module_message, (uint8_t *)module_val,
+			&val_sz, NULL, NULL, NULL, 0);
+
+		if (*cb_return_val != FDO_SI_SUCCESS) {
 			LOG(LOG_ERROR,
-				"ServiceInfo: Received ServiceInfo for an unsupported module %s\n",
-			    module_name);
-			fdor_next(&temp_fdor);
-			*cb_return_val = FDO_SI_INVALID_MOD_ERROR;
-			retval = true;
+				"ServiceInfo: %s's CB Failed for type:%d\n",
+				module->module.module_name,
+				FDO_SI_SET_OSI);
+			goto end;
+		}
+		retval = true;
+	} else {
+		LOG(LOG_ERROR, "ServiceInfo: Received ServiceInfo for an inactive module %s\n",
+		    module->module.module_name);
+		// module is present, but is not the active module. skip this ServiceInfoVal
+		retval = true;
 	}
 
 end:
-	if (temp_fdor.b.block || temp_fdor.current) {
-		fdor_flush(&temp_fdor);
+	if (temp_fdor.current) {
+		fdor_view_flush(&temp_fdor);
 	}
 	return retval;
 }
@@ -5210,11 +5337,19 @@ bool fdo_serviceinfo_deactivate_modules(fdo_sdk_service_info_module_list_t *modu
 		traverse_list->module.active = false;
 		traverse_list = traverse_list->next;
 	}
+	if (module_list->index) {
+		module_list->index->active = NULL;
+	}
 	return true;
 }
 
+/* Initial number of entries, and size of the arena, of a ServiceInfo table */
+#define FDO_SI_KV_MIN 16
+#define FDO_SI_ARENA_MIN 512
+
 /**
  * Allocate an empty fdo_service_info_t object.
+ * The table and the arena are allocated when the first key is added.
  * @return an allocated fdo_service_info_t object.
  */
 fdo_service_info_t *fdo_service_info_alloc(void)
@@ -5229,77 +5364,257 @@ fdo_service_info_t *fdo_service_info_alloc(void)
  */
 void fdo_service_info_free(fdo_service_info_t *si)
 {
-	fdo_key_value_t *kv = NULL;
-
 	if (!si) {
 		return;
 	}
-	while ((kv = si->kv) != NULL) {
-		si->kv = kv->next;
-		fdo_kv_free(kv);
-		kv = NULL;
+	if (si->kv) {
+		fdo_free(si->kv);
+	}
+	if (si->arena) {
+		fdo_free(si->arena);
 	}
 	fdo_free(si);
-	si = NULL;
 }
 
 /**
- * Compares the kv member of si with key parameter and
- * if there is match, return the matched pointer,
- * else last entry in the list.
- * @param si  - Pointer to the fdo_service_info_t object si,
- * @param key - Pointer to the char buffer key,
- * @return pointer to fdo_key_value_t.
+ * Make room for len more bytes in the arena of the given ServiceInfo,
+ * doubling its size as needed. Entries refer to the arena by offset, so
+ * they stay valid when it moves.
+ * @param si  - Pointer to the fdo_service_info_t,
+ * @param len - number of bytes needed,
+ * @return true if the bytes are available, false otherwise.
  */
-fdo_key_value_t **fdo_service_info_fetch(fdo_service_info_t *si,
-					 const char *key)
+static bool fdo_service_info_reserve(fdo_service_info_t *si, size_t len)
 {
-	fdo_key_value_t **kvp = NULL, *kv = NULL;
-	int res = 1;
+	size_t size = si->arena_size ? si->arena_size : FDO_SI_ARENA_MIN;
+	uint8_t *arena = NULL;
+
+	if (si->arena_used + len <= si->arena_size) {
+		return true;
+	}
+	while (size < si->arena_used + len) {
+		size *= 2;
+	}
+	arena = fdo_alloc(size);
+	if (!arena) {
+		LOG(LOG_ERROR, "Failed to alloc ServiceInfo arena\n");
+		return false;
+	}
+	if (si->arena_used &&
+	    memcpy_s(arena, size, si->arena, si->arena_used) != 0) {
+		LOG(LOG_ERROR, "Memcpy Failed\n");
+		fdo_free(arena);
+		return false;
+	}
+	if (si->arena) {
+		fdo_free(si->arena);
+	}
+	si->arena = arena;
+	si->arena_size = size;
+	return true;
+}
+
+/**
+ * Make room for one more entry in the table of the given ServiceInfo,
+ * doubling its capacity as needed.
+ * @param si  - Pointer to the fdo_service_info_t,
+ * @return true if an entry is available, false otherwise.
+ */
+static bool fdo_service_info_grow(fdo_service_info_t *si)
+{
+	size_t capacity = si->kv_capacity ? 2 * si->kv_capacity : FDO_SI_KV_MIN;
+	fdo_key_value_t *kv = NULL;
+
+	if (si->numKV < si->kv_capacity) {
+		return true;
+	}
+	kv = fdo_alloc(capacity * sizeof(fdo_key_value_t));
+	if (!kv) {
+		LOG(LOG_ERROR, "Failed to alloc ServiceInfo table\n");
+		return false;
+	}
+	if (si->numKV &&
+	    memcpy_s(kv, capacity * sizeof(fdo_key_value_t), si->kv,
+		     si->numKV * sizeof(fdo_key_value_t)) != 0) {
+		LOG(LOG_ERROR, "Memcpy Failed\n");
+		fdo_free(kv);
+		return false;
+	}
+	if (si->kv) {
+		fdo_free(si->kv);
+	}
+	si->kv = kv;
+	si->kv_capacity = capacity;
+	return true;
+}
 
-	for (kvp = &si->kv; (kv = *kvp) != NULL; kvp = &kv->next) {
-		int keylen = strnlen_s(key, FDO_MAX_STR_SIZE);
+/**
+ * Look up a key in the hash index of the given ServiceInfo.
+ * Keys are compared case-insensitively.
+ * @param si  - Pointer to the fdo_service_info_t,
+ * @param key - Pointer to the key,
+ * @param key_len - length of the key,
+ * @param key_hash - case-insensitive hash of the key,
+ * @return pointer to the matching entry, NULL if there is none.
+ */
+static fdo_key_value_t *fdo_service_info_lookup(fdo_service_info_t *si,
+						const char *key, size_t key_len,
+						uint32_t key_hash)
+{
+	fdo_key_value_t *kv = NULL;
+	uint32_t entry = si->buckets[key_hash & (FDO_SI_KV_BUCKETS - 1)];
+	int res = 1;
 
-		if (!keylen || keylen == FDO_MAX_STR_SIZE) {
-			LOG(LOG_DEBUG, "strlen() failed!\n");
+	for (; entry != 0; entry = kv->bucket_next) {
+		kv = &si->kv[entry - 1];
+		if (kv->key_hash != key_hash || kv->key_len != key_len) {
 			continue;
 		}
-
-		if ((strcasecmp_s(key, keylen, (char *)(kv->key->bytes),
+		if ((strcasecmp_s(key, key_len,
+				  (char *)si->arena + kv->key_offset,
 				  &res) == 0) &&
 		    res == 0) {
-			break;
+			return kv;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Set the value of the given key, adding the key at the end of the table
+ * if it isn't present. A text/binary value is written over the previous one
+ * when it fits there, and appended to the arena otherwise.
+ * @param si  - Pointer to the fdo_service_info_t,
+ * @param key - Pointer to the NULL-terminated key,
+ * @param type - type of the value,
+ * @param val - Pointer to the text/binary value, NULL for other types,
+ * @param val_len - length of the text/binary value,
+ * @return pointer to the updated entry, NULL on failure.
+ */
+static fdo_key_value_t *fdo_service_info_put(fdo_service_info_t *si,
+					     const char *key,
+					     fdo_kv_val_type_t type,
+					     const void *val, size_t val_len)
+{
+	fdo_key_value_t *kv = NULL;
+	size_t key_len = strnlen_s(key, FDO_MAX_STR_SIZE);
+	size_t needed = 0;
+	uint32_t key_hash = 0;
+	uint32_t bucket = 0;
+	bool is_buf = (type == FDO_KV_VAL_STR || type == FDO_KV_VAL_BIN);
+	bool in_place = false;
+
+	if (!key_len || key_len == FDO_MAX_STR_SIZE) {
+		LOG(LOG_ERROR, "%s(): key is either "
+		    "'NULL' or 'isn't "
+		    "NULL terminated'\n", __func__);
+		return NULL;
+	}
+	key_hash = fdo_name_hash(key, key_len, true);
+	kv = fdo_service_info_lookup(si, key, key_len, key_hash);
+
+	// reserve the arena space first, so that nothing is left half-added
+	if (kv == NULL) {
+		needed += key_len + 1;
+	}
+	if (is_buf) {
+		in_place = kv && (kv->type == FDO_KV_VAL_STR ||
+				  kv->type == FDO_KV_VAL_BIN) &&
+			   val_len <= kv->val.buf.capacity;
+		if (!in_place) {
+			needed += val_len;
+		}
+	}
+	if (!fdo_service_info_reserve(si, needed)) {
+		return NULL;
+	}
+
+	if (kv == NULL) {
+		 /* Not found, add a new entry at the end of the table */
+		if (!fdo_service_info_grow(si)) {
+			return NULL;
+		}
+		kv = &si->kv[si->numKV];
+		if (memcpy_s(si->arena + si->arena_used,
+			     si->arena_size - si->arena_used, key,
+			     key_len) != 0) {
+			LOG(LOG_ERROR, "Memcpy Failed\n");
+			return NULL;
 		}
+		si->arena[si->arena_used + key_len] = '\0';
+		kv->key_offset = si->arena_used;
+		kv->key_len = key_len;
+		kv->key_hash = key_hash;
+		kv->type = FDO_KV_VAL_NONE;
+		si->arena_used += key_len + 1;
+
+		bucket = key_hash & (FDO_SI_KV_BUCKETS - 1);
+		kv->bucket_next = si->buckets[bucket];
+		si->numKV++;
+		si->buckets[bucket] = (uint32_t)si->numKV;
 	}
-	return kvp;
+
+	if (is_buf) {
+		if (!in_place) {
+			kv->val.buf.offset = si->arena_used;
+			kv->val.buf.capacity = val_len;
+			si->arena_used += val_len;
+		}
+		if (val_len &&
+		    memcpy_s(si->arena + kv->val.buf.offset,
+			     kv->val.buf.capacity, val, val_len) != 0) {
+			LOG(LOG_ERROR, "Memcpy Failed\n");
+			return NULL;
+		}
+		kv->val.buf.len = val_len;
+	}
+	kv->type = type;
+	// the value changed, its CBOR encoding has to be redone
+	kv->enc_len = 0;
+	return kv;
 }
+
 /**
- * Compares the corresponding index associated with kv member of si
- * & key_num parameter, if there is match, return the matched pointer,
- * else last entry in the list.
+ * Look up the given key in si, case-insensitively.
  * @param si  - Pointer to the fdo_service_info_t object si,
- * @param key_num - Integer variable determines service request Info number,
- * @return pointer to fdo_key_value_t.
+ * @param key - Pointer to the char buffer key,
+ * @return pointer to the matching fdo_key_value_t, NULL if there is none.
  */
-fdo_key_value_t **fdo_service_info_get(fdo_service_info_t *si, int key_num)
+fdo_key_value_t *fdo_service_info_fetch(fdo_service_info_t *si,
+					const char *key)
 {
-	fdo_key_value_t **kvp = NULL, *kv = NULL;
-	int index;
+	size_t keylen = 0;
 
-	for (kvp = &si->kv, index = 0; (kv = *kvp) != NULL;
-	     kvp = &kv->next, index++) {
-		if (index == key_num) {
-			break;
-		}
+	if (!si || !key) {
+		return NULL;
+	}
+	keylen = strnlen_s(key, FDO_MAX_STR_SIZE);
+	if (!keylen || keylen == FDO_MAX_STR_SIZE) {
+		LOG(LOG_DEBUG, "strlen() failed!\n");
+		return NULL;
 	}
-	return kvp;
+	return fdo_service_info_lookup(si, key, keylen,
+				       fdo_name_hash(key, keylen, true));
+}
+
+/**
+ * Return the entry at index key_num of si, in the order the keys were added.
+ * @param si  - Pointer to the fdo_service_info_t object si,
+ * @param key_num - Index of the ServiceInfoKV,
+ * @return pointer to fdo_key_value_t, NULL if key_num is out of range.
+ */
+fdo_key_value_t *fdo_service_info_get(fdo_service_info_t *si, size_t key_num)
+{
+	if (!si || key_num >= si->numKV) {
+		return NULL;
+	}
+	return &si->kv[key_num];
 }
 
 /**
  * si & key are input to the function, it looks for the matching
  * (key, value):
- * if found, update the corresponding si member with string val, if memory
- * is not allocated, allocate it.
+ * if found, update the corresponding si member with string val.
  * if no matching entry is found, it will add a new entry at the end.
  * @param si  - Pointer to the fdo_service_info_t,
  * @param key - Pointer to the char buffer key,
@@ -5309,63 +5624,26 @@ fdo_key_value_t **fdo_service_info_get(fdo_service_info_t *si, int key_num)
 bool fdo_service_info_add_kv_str(fdo_service_info_t *si, const char *key,
 				 const char *val)
 {
-	fdo_key_value_t **kvp = NULL, *kv = NULL;
+	size_t val_len = 0;
 
 	if (!si || !key || !val) {
 		return false;
 	}
 
-	kvp = fdo_service_info_fetch(si, key);
-	kv = *kvp;
-	if (kv == NULL) {
-		 /* Not found, at end of linked list, add a new entry */
-		kv = fdo_kv_alloc_with_str(key, val);
-		if (kv == NULL) {
-			return false;
-		}
-		*kvp = kv;  /* Use this pointer to update the next value */
-		si->numKV++;
-		return true;
-	}
-
-	 /* Found, update value */
-	if (kv->str_val == NULL) {
-		 /* No allocated string present for value, make a new one */
-		kv->str_val = fdo_string_alloc_with_str(val);
-	} else {
-		int val_len = strnlen_s(val, FDO_MAX_STR_SIZE);
-
-		if (!val_len || val_len == FDO_MAX_STR_SIZE) {
-			LOG(LOG_ERROR,
-			    "%s(): val "
-			    "is either 'NULL' or"
-			    "'isn't 'NULL-terminating'\n", __func__);
-			fdo_string_free(kv->str_val);
-			return false;
-		}
-
-		 /* Update the string */
-		fdo_string_resize_with(kv->str_val, val_len, val);
-	}
-	// free other values of other type
-	if (kv->bin_val) {
-		fdo_byte_array_free(kv->bin_val);
-	}
-	if (kv->int_val) {
-		fdo_free(kv->int_val);
-	}
-	if (kv->bool_val) {
-		fdo_free(kv->bool_val);
+	val_len = strnlen_s(val, FDO_MAX_STR_SIZE);
+	if (val_len == FDO_MAX_STR_SIZE) {
+		LOG(LOG_ERROR,
+		    "%s(): value is either "
+		    "'NULL' or 'isn't NULL terminated'\n", __func__);
+		return false;
 	}
-
-	return true;
+	return fdo_service_info_put(si, key, FDO_KV_VAL_STR, val, val_len) != NULL;
 }
 
 /**
  * si & key are input to the function, it looks for the matching
  * (key, value):
- * if found, update the corresponding si member with byte array val, if memory
- * is not allocated, allocate it.
+ * if found, update the corresponding si member with byte array val.
  * if no matching entry is found, it will add a new entry at the end.
  * @param si  - Pointer to the fdo_service_info_t,
  * @param key - Pointer to the char buffer key,
@@ -5375,196 +5653,65 @@ bool fdo_service_info_add_kv_str(fdo_service_info_t *si, const char *key,
 bool fdo_service_info_add_kv_bin(fdo_service_info_t *si, const char *key,
 				 const fdo_byte_array_t *val)
 {
-	fdo_key_value_t **kvp = NULL, *kv = NULL;
-
 	if (!si || !key || !val) {
 		return false;
 	}
 
-	kvp = fdo_service_info_fetch(si, key);
-	kv = *kvp;
-	if (kv == NULL) {
-		 /* Not found, at end of linked list, add a new entry */
-		kv = fdo_kv_alloc_key_only(key);
-		if (kv == NULL) {
-			return false;
-		}
-		kv->bin_val = fdo_byte_array_alloc_with_byte_array(val->bytes, val->byte_sz);
-
-		*kvp = kv;  /* Use this pointer to update the next value */
-		si->numKV++;
-		return true;
-	}
-
-	 /* Found, free the current and update value */
-	if (kv->bin_val) {
-		fdo_byte_array_free(kv->bin_val);
-	}
-	kv->bin_val = fdo_byte_array_alloc_with_byte_array(val->bytes, val->byte_sz);
-
-	// free other values of other type
-	if (kv->str_val) {
-		fdo_string_free(kv->str_val);
-	}
-	if (kv->int_val) {
-		fdo_free(kv->int_val);
-	}
-	if (kv->bool_val) {
-		fdo_free(kv->bool_val);
-	}
-
-	return true;
+	return fdo_service_info_put(si, key, FDO_KV_VAL_BIN, val->bytes,
+				    val->byte_sz) != NULL;
 }
 
 /**
  * si & key are input to the function, it looks for the matching
  * (key, value):
- * if found, update the corresponding si member with boolean val, if memory
- * is not allocated, allocate it.
+ * if found, update the corresponding si member with boolean val.
  * if no matching entry is found, it will add a new entry at the end.
  * @param si  - Pointer to the fdo_service_info_t,
  * @param key - Pointer to the char buffer key,
- * @param val - Pointer to the boolean val, to be updated,
+ * @param val - boolean val, to be updated,
  * @return true if updated correctly else false.
  */
 bool fdo_service_info_add_kv_bool(fdo_service_info_t *si, const char *key,
 				 bool val)
 {
-	fdo_key_value_t **kvp = NULL, *kv = NULL;
+	fdo_key_value_t *kv = NULL;
 
 	if (!si || !key) {
 		return false;
 	}
 
-	kvp = fdo_service_info_fetch(si, key);
-	kv = *kvp;
-	if (kv == NULL) {
-		 /* Not found, at end of linked list, add a new entry */
-		kv = fdo_kv_alloc_key_only(key);
-		if (kv == NULL) {
-			return false;
-		}
-		kv->bool_val = fdo_alloc(sizeof(bool));
-		if (!kv->bool_val) {
-			LOG(LOG_ERROR, "Failed to alloc bool Device ServiceInfoVal");
-			return false;
-		}
-		*kv->bool_val = val;
-		*kvp = kv;  /* Use this pointer to update the next value */
-		si->numKV++;
-		return true;
-	}
-
-	kv->bool_val = fdo_alloc(sizeof(bool));
-	if (!kv->bool_val) {
-		LOG(LOG_ERROR, "Failed to alloc bool Device ServiceInfoVal");
+	kv = fdo_service_info_put(si, key, FDO_KV_VAL_BOOL, NULL, 0);
+	if (!kv) {
 		return false;
 	}
-	*kv->bool_val = val;
-
-	// free any other type of value, if present
-	if (kv->str_val) {
-		fdo_string_free(kv->str_val);
-	}
-	if (kv->bin_val) {
-		fdo_byte_array_free(kv->bin_val);
-	}
-	if (kv->int_val) {
-		fdo_free(kv->int_val);
-	}
-
+	kv->val.bool_val = val;
 	return true;
 }
 
 /**
  * si & key are input to the function, it looks for the matching
  * (key, value):
- * if found, update the corresponding si member with integer val, if memory
- * is not allocated, allocate it.
+ * if found, update the corresponding si member with integer val.
  * if no matching entry is found, it will add a new entry at the end.
  * @param si  - Pointer to the fdo_service_info_t,
  * @param key - Pointer to the char buffer key,
- * @param val - Pointer to the integer val, to be updated,
+ * @param val - integer val, to be updated,
  * @return true if updated correctly else false.
  */
 bool fdo_service_info_add_kv_int(fdo_service_info_t *si, const char *key,
 				 int val)
 {
-	fdo_key_value_t **kvp = NULL, *kv = NULL;
+	fdo_key_value_t *kv = NULL;
 
 	if (!si || !key) {
 		return false;
 	}
 
-	kvp = fdo_service_info_fetch(si, key);
-	kv = *kvp;
-	if (kv == NULL) {
-		 /* Not found, at end of linked list, add a new entry */
-		kv = fdo_kv_alloc_key_only(key);
-		if (kv == NULL) {
-			return false;
-		}
-		kv->int_val = fdo_alloc(sizeof(int));
-		if (!kv->int_val) {
-			LOG(LOG_ERROR, "Failed to alloc int Device ServiceInfoVal");
-			return false;
-		}
-		*kv->int_val = val;
-		*kvp = kv;  /* Use this pointer to update the next value */
-		si->numKV++;
-		return true;
-	}
-
-	kv->int_val = fdo_alloc(sizeof(int));
-	if (!kv->int_val) {
-		LOG(LOG_ERROR, "Failed to alloc int Device ServiceInfoVal");
-		return false;
-	}
-	*kv->int_val = val;
-
-	// free any other type of value, if present
-	if (kv->str_val) {
-		fdo_string_free(kv->str_val);
-	}
-	if (kv->bin_val) {
-		fdo_byte_array_free(kv->bin_val);
-	}
-	if (kv->bool_val) {
-		fdo_free(kv->bool_val);
-	}
-
-	return true;
-}
-
-/**
- * Add kvs object of type fdo_key_value_t to the end of the list(si) if
- * not empty else add it to the head.
- * @param si  - Pointer to the fdo_service_info_t list,
- * @param kvs - Pointer to the fdo_key_value_t kvs, to be added,
- * @return true if updated correctly else false.
- */
-bool fdo_service_info_add_kv(fdo_service_info_t *si, fdo_key_value_t *kvs)
-{
-	fdo_key_value_t *kv = NULL;
-
-	if (!si || !kvs) {
+	kv = fdo_service_info_put(si, key, FDO_KV_VAL_INT, NULL, 0);
+	if (!kv) {
 		return false;
 	}
-
-	// Is the list empty?  If it is, add this to the head of the list
-	if (si->kv == NULL) {
-		si->kv = kvs;
-		si->numKV = 1;
-		kvs->next = NULL;
-	} else {
-		// Find the last entry
-		for (kv = si->kv; kv->next != NULL; kv = kv->next) {
-			// Iterate till the last entry
-		}
-		kv->next = kvs;
-		si->numKV++;
-		kvs->next = NULL;
-	}
+	kv->val.int_val = val;
 	return true;
 }
 
@@ -5638,10 +5785,15 @@ end:
  */
 bool fdo_serviceinfo_kv_write(fdow_t *fdow, fdo_service_info_t *si, size_t num, size_t mtu)
 {
-	fdo_key_value_t **kvp = NULL;
 	fdo_key_value_t *kv = NULL;
+	uint8_t *val = NULL;
+	uint8_t *encoded_val = NULL;
+	size_t encoded_val_len = 0;
 	int strcmp_diff = 0;
 	fdow_t temp_fdow = {0};
+	size_t val_offset = 0;
+	size_t val_len = 0;
+	bool whole_val = true;
 
 	bool ret = false;
 
@@ -5649,82 +5801,120 @@ bool fdo_serviceinfo_kv_write(fdow_t *fdow, fdo_service_info_t *si, size_t num,
 		goto end;
 	}
 
-	kvp = fdo_service_info_get(si, num);
-
-	kv = *kvp;
-	if (!kv || !kv->key) {
+	kv = fdo_service_info_get(si, num);
+	if (!kv) {
 		LOG(LOG_ERROR, "Platform Device ServiceInfo: Key/Value not found\n");
 		goto end;
 	}
 
-	// create temporary FDOW, use it to encode ServiceInfoVal array and then clear it.
-	if (!fdow_init(&temp_fdow) || !fdo_block_alloc_with_size(&temp_fdow.b, mtu) ||
-		!fdow_encoder_init(&temp_fdow)) {
-		LOG(LOG_ERROR,
-			"Platform Device ServiceInfo: FDOW Initialization/Allocation failed!\n");
-		goto end;
-	}
-
-	// start writing ServiceInfoKV
-	if (!fdow_start_array(fdow, 2)) {
-		LOG(LOG_ERROR, "Platform Device ServiceInfoKV: Failed to write start array\n");
-		goto end;
-	}
-
-	if (!fdow_text_string(fdow, kv->key->bytes, kv->key->byte_sz)) {
-		LOG(LOG_ERROR, "Platform Device ServiceInfoKV: Failed to write ServiceInfoKey\n");
-		goto end;
+	// a text/binary ServiceInfoVal may be sent partially, see fdo_serviceinfo_fit_mtu()
+	if (kv->type == FDO_KV_VAL_STR || kv->type == FDO_KV_VAL_BIN) {
+		val_len = kv->val.buf.len;
+		if (num == si->sv_index_begin) {
+			val_offset = si->sv_val_offset;
+		}
+		if (val_offset > val_len) {
+			LOG(LOG_ERROR, "Platform Device ServiceInfo: Invalid ServiceInfoVal offset\n");
+			goto end;
+		}
+		val = si->arena + kv->val.buf.offset + val_offset;
+		val_len -= val_offset;
+		if (num + 1 == si->sv_index_end && si->sv_val_index != 0 &&
+			si->sv_val_index < val_len) {
+			val_len = si->sv_val_index;
+		}
+		whole_val = (val_len == kv->val.buf.len);
 	}
 
-	if (0 != strcmp_s(kv->key->bytes, kv->key->byte_sz, "devmod:modules", &strcmp_diff)) {
-		LOG(LOG_ERROR, "Platform Device ServiceInfoKV: Failed to compare\n");
-		goto end;
-	}
-	if (strcmp_diff == 0) {
-		// write value "[1,1,"fdo_sys"]" for "devmod:modules" ServiceInfoKey
-		// TO-DO: Update this when multi-module support is added.
-		if (!fdo_serviceinfo_modules_list_write(&temp_fdow)) {
-			LOG(LOG_ERROR, "Platform Device ServiceInfoKeyVal: Failed to write modules\n");
+	// a whole ServiceInfoVal is CBOR-encoded once, and the encoding is kept in
+	// the arena, so that it is reused by every later TO2 attempt
+	if (!whole_val || kv->enc_len == 0) {
+		// create temporary FDOW, use it to encode ServiceInfoVal and then clear it.
+		if (!fdow_init(&temp_fdow) || !fdo_block_alloc_with_size(&temp_fdow.b, mtu) ||
+			!fdow_encoder_init(&temp_fdow)) {
+			LOG(LOG_ERROR,
+				"Platform Device ServiceInfo: FDOW Initialization/Allocation failed!\n");
 			goto end;
 		}
-	} else {
 
-		// CBOR-encode the appropriate ServiceInfoVal using temporary FDOW
-		if (kv->str_val) {
-			if (!fdow_text_string(&temp_fdow, kv->str_val->bytes,
-				si->sv_val_index == 0 ? (size_t) kv->str_val->byte_sz : si->sv_val_index)) {
-				LOG(LOG_ERROR, "Platform Device ServiceInfoKV: Failed to write Text ServiceInfoVal\n");
-				goto end;
-			}
-		} else if (kv->bin_val) {
-			if (!fdow_byte_string(&temp_fdow, kv->bin_val->bytes,
-				si->sv_val_index == 0 ? kv->bin_val->byte_sz : si->sv_val_index)) {
-				LOG(LOG_ERROR, "Platform Device ServiceInfoKV: Failed to write Binary ServiceInfoVal\n");
+		if (0 != strcmp_s((char *)si->arena + kv->key_offset, kv->key_len,
+			"devmod:modules", &strcmp_diff)) {
+			LOG(LOG_ERROR, "Platform Device ServiceInfoKV: Failed to compare\n");
+			goto end;
+		}
+		if (strcmp_diff == 0) {
+			// write value "[1,1,"fdo_sys"]" for "devmod:modules" ServiceInfoKey
+			// TO-DO: Update this when multi-module support is added.
+			if (!fdo_serviceinfo_modules_list_write(&temp_fdow)) {
+				LOG(LOG_ERROR, "Platform Device ServiceInfoKeyVal: Failed to write modules\n");
 				goto end;
 			}
-		} else if (kv->bool_val) {
-			if (!fdow_boolean(&temp_fdow, *kv->bool_val)) {
-				LOG(LOG_ERROR, "Platform Device ServiceInfoKV: Failed to write Bool ServiceInfoVal\n");
+		} else {
+
+			// CBOR-encode the appropriate ServiceInfoVal using temporary FDOW
+			if (kv->type == FDO_KV_VAL_STR) {
+				if (!fdow_text_string(&temp_fdow, (char *)val, val_len)) {
+					LOG(LOG_ERROR, "Platform Device ServiceInfoKV: Failed to write Text ServiceInfoVal\n");
+					goto end;
+				}
+			} else if (kv->type == FDO_KV_VAL_BIN) {
+				if (!fdow_byte_string(&temp_fdow, val, val_len)) {
+					LOG(LOG_ERROR, "Platform Device ServiceInfoKV: Failed to write Binary ServiceInfoVal\n");
+					goto end;
+				}
+			} else if (kv->type == FDO_KV_VAL_BOOL) {
+				if (!fdow_boolean(&temp_fdow, kv->val.bool_val)) {
+					LOG(LOG_ERROR, "Platform Device ServiceInfoKV: Failed to write Bool ServiceInfoVal\n");
+					goto end;
+				}
+			} else if (kv->type == FDO_KV_VAL_INT) {
+				if (!fdow_signed_int(&temp_fdow, kv->val.int_val)) {
+					LOG(LOG_ERROR, "Platform Device ServiceInfoKV: Failed to write Int ServiceInfoVal\n");
+					goto end;
+				}
+			} else {
+				LOG(LOG_ERROR, "Platform Device ServiceInfoKV: No ServiceInfoVal found\n");
 				goto end;
 			}
-		} else if (kv->int_val) {
-			if (!fdow_signed_int(&temp_fdow, *kv->int_val)) {
-				LOG(LOG_ERROR, "Platform Device ServiceInfoKV: Failed to write Int ServiceInfoVal\n");
+		}
+
+		if (!fdow_encoded_length(&temp_fdow, &temp_fdow.b.block_size)) {
+			LOG(LOG_ERROR, "Platform Device ServiceInfoKV: Failed to get encoded length\n");
+			goto end;
+		}
+		encoded_val = temp_fdow.b.block;
+		encoded_val_len = temp_fdow.b.block_size;
+
+		if (whole_val) {
+			if (!fdo_service_info_reserve(si, encoded_val_len) ||
+				memcpy_s(si->arena + si->arena_used, si->arena_size - si->arena_used,
+				encoded_val, encoded_val_len) != 0) {
+				LOG(LOG_ERROR, "Platform Device ServiceInfoKV: Failed to keep ServiceInfoVal\n");
 				goto end;
 			}
-		} else {
-			LOG(LOG_ERROR, "Platform Device ServiceInfoKV: No ServiceInfoVal found\n");
-			goto end;
+			kv->enc_offset = si->arena_used;
+			kv->enc_len = encoded_val_len;
+			si->arena_used += encoded_val_len;
 		}
 	}
+	if (whole_val) {
+		encoded_val = si->arena + kv->enc_offset;
+		encoded_val_len = kv->enc_len;
+	}
 
-	if (!fdow_encoded_length(&temp_fdow, &temp_fdow.b.block_size)) {
-		LOG(LOG_ERROR, "Platform Device ServiceInfoKV: Failed to get encoded length\n");
+	// start writing ServiceInfoKV
+	if (!fdow_start_array(fdow, 2)) {
+		LOG(LOG_ERROR, "Platform Device ServiceInfoKV: Failed to write start array\n");
+		goto end;
+	}
+
+	if (!fdow_text_string(fdow, (char *)si->arena + kv->key_offset, kv->key_len)) {
+		LOG(LOG_ERROR, "Platform Device ServiceInfoKV: Failed to write ServiceInfoKey\n");
 		goto end;
 	}
 
-	// Now, wrap the CBOR-encoded ServiceInfoVal at temporary FDOW, into a bstr
-	if (!fdow_byte_string(fdow, temp_fdow.b.block, temp_fdow.b.block_size)) {
+	// Now, wrap the CBOR-encoded ServiceInfoVal into a bstr
+	if (!fdow_byte_string(fdow, encoded_val, encoded_val_len)) {
 		LOG(LOG_ERROR,
 			"Platform Device ServiceInfoKV: Failed to write ServiceInfoVal as bstr\n");
 		goto end;
@@ -5802,29 +5992,28 @@ bool fdo_serviceinfo_external_mod_is_more(fdow_t *fdow,
 	if (!fdow || !module_list || !is_more) {
 		return false;
 	}
-	fdo_sdk_service_info_module_list_t *traverse_list = module_list;
+	// only the active module can have ServiceInfo to send
+	fdo_sdk_service_info_module_list_t *active_module =
+		fdo_serviceinfo_active_module(module_list);
 	bool more = false;
 
-	while (traverse_list) {
-		if (traverse_list->module.active &&
-			traverse_list->module.service_info_callback(
-			FDO_SI_IS_MORE_DSI, NULL, NULL, NULL, NULL, NULL, &more, mtu) != FDO_SI_SUCCESS) {
-			LOG(LOG_DEBUG, "Sv_info: %s's CB Failed for type:%d\n",
-			    traverse_list->module.module_name, FDO_SI_HAS_MORE_DSI);
-			return false;
-		}
-		if (more) {
-			*is_more = more;
-			return more;
-		}
-		traverse_list = traverse_list->next;
+	if (active_module &&
+		active_module->module.service_info_callback(
+		FDO_SI_IS_MORE_DSI, NULL, NULL, NULL, NULL, NULL, &more, mtu) != FDO_SI_SUCCESS) {
+		LOG(LOG_DEBUG, "Sv_info: %s's CB Failed for type:%d\n",
+		    active_module->module.module_name, FDO_SI_HAS_MORE_DSI);
+		return false;
+	}
+	if (more) {
+		*is_more = more;
+		return more;
 	}
 	return true;
 }
 
 /**
  * Return a module reference that has some ServiceInfo to be sent NOW/immediately,
- * by making callbacks to each active module, to determine whether the module
+ * by making a callback to the active module, to determine whether the module
  * has something to send immediately.
  *
  * @param fdow - Pointer to the writer.
@@ -5841,21 +6030,22 @@ fdo_sdk_service_info_module* fdo_serviceinfo_get_external_mod_to_write(fdow_t *f
 	if (!fdow || !module_list) {
 		return NULL;
 	}
-	fdo_sdk_service_info_module_list_t *traverse_list = module_list;
+	// only the active module can have ServiceInfo to send
+	fdo_sdk_service_info_module_list_t *active_module =
+		fdo_serviceinfo_active_module(module_list);
 	bool has_more = false;
 
-	while (traverse_list) {
-		if (traverse_list->module.active &&
-			traverse_list->module.service_info_callback(
-			FDO_SI_HAS_MORE_DSI, NULL, NULL, NULL, NULL, &has_more, NULL, mtu) != FDO_SI_SUCCESS) {
-			LOG(LOG_DEBUG, "Sv_info: %s's CB Failed for type:%d\n",
-			    traverse_list->module.module_name, FDO_SI_HAS_MORE_DSI);
-			return NULL;
-		}
-		if (has_more) {
-			return &(traverse_list->module);
-		}
-		traverse_list = traverse_list->next;
+	if (!active_module) {
+		return NULL;
+	}
+	if (active_module->module.service_info_callback(
+		FDO_SI_HAS_MORE_DSI, NULL, NULL, NULL, NULL, &has_more, NULL, mtu) != FDO_SI_SUCCESS) {
+		LOG(LOG_DEBUG, "Sv_info: %s's CB Failed for type:%d\n",
+		    active_module->module.module_name, FDO_SI_HAS_MORE_DSI);
+		return NULL;
+	}
+	if (has_more) {
+		return &(active_module->module);
 	}
 	return NULL;
 }
@@ -5960,93 +6150,148 @@ bool fdo_serviceinfo_external_mod_write(fdow_t *fdow,
 }
 
 /**
- * Fit as many ServiceInfo as possible in the given MTU.
- * The key-values are CBOR encoded once to decide how many
- * key-value pairs (partial/complete), can be fitted within the
- * current message as per MTU.
+ * Return the CBOR-encoded length of the given ServiceInfoKV, without encoding it,
+ * if 'val_len' bytes of its ServiceInfoVal are sent. 'val_len' is only used for
+ * text/binary ServiceInfoVal, that may be split.
+ * ServiceInfoKV = [
+ *   ServiceInfoKey: tstr,
+ *   ServiceInfoVal: bstr (wraps any cborSimpleType)
+ * ]
+ *
+ * @param si - Pointer to the ServiceInfo holding the ServiceInfoKV
+ * @param kv - Pointer to the ServiceInfoKV
+ * @param val_len - number of ServiceInfoVal bytes
+ * @return the encoded length, or 0 if the ServiceInfoKV has no ServiceInfoVal.
+ */
+static size_t fdo_serviceinfo_kv_encoded_length(fdo_service_info_t *si,
+	fdo_key_value_t *kv, size_t val_len)
+{
+	size_t key_len = kv->key_len;
+	size_t val_encoded_length = 0;
+	int strcmp_diff = 1;
+
+	if (0 == strcmp_s((char *)si->arena + kv->key_offset, key_len, "devmod:modules",
+		&strcmp_diff) && strcmp_diff == 0) {
+		// [1, 1, "fdo_sys"] as written by fdo_serviceinfo_modules_list_write()
+		val_encoded_length = fdow_head_length(3) + fdow_head_length(1) +
+			fdow_head_length(1) + fdow_head_length(7) + 7;
+	} else if (kv->type == FDO_KV_VAL_STR || kv->type == FDO_KV_VAL_BIN) {
+		val_encoded_length = fdow_head_length(val_len) + val_len;
+	} else if (kv->type == FDO_KV_VAL_BOOL) {
+		val_encoded_length = 1;
+	} else if (kv->type == FDO_KV_VAL_INT) {
+		// negative integers encode -1 - value
+		val_encoded_length = kv->val.int_val >= 0 ?
+			fdow_head_length((uint64_t) kv->val.int_val) :
+			fdow_head_length((uint64_t) (-1 - (int64_t) kv->val.int_val));
+	} else {
+		return 0;
+	}
+	return fdow_head_length(2) + fdow_head_length(key_len) + key_len +
+		fdow_head_length(val_encoded_length) + val_encoded_length;
+}
+
+/**
+ * Fit as many ServiceInfo as possible in the given MTU, in a single pass.
+ * The CBOR-encoded length of every ServiceInfoKV is computed from the lengths of
+ * its contents, and nothing is encoded here. A text/binary ServiceInfoVal that
+ * does not fit is split, and the next call resumes from where this message ends.
+ * On return, [sv_index_begin, sv_index_end), sv_val_offset and sv_val_index
+ * describe the ServiceInfoKVs to be written by fdo_serviceinfo_write().
  * NOTE: Might need to be updated when multiple Device ServiceInfo module
  * aupport is added, since this operation might be module-specific (TO-DO).
  *
- * @param fdow - FDOW writer to be used for encoding
  * @param si - Pointer to the fdo_service_info_t list containing all platform
  * Device ServiceInfos.
  * @param mtu - MTU to be used for fitting the values
 * @return Return true if operation was successful, else return false.
  */
-bool fdo_serviceinfo_fit_mtu(fdow_t *fdow, fdo_service_info_t *si, size_t mtu) {
+bool fdo_serviceinfo_fit_mtu(fdo_service_info_t *si, size_t mtu) {
 
-	bool ret = false;
 	fdo_key_value_t *kv = NULL;
-	fdo_key_value_t **kvp = NULL;
-
 	size_t num = 0;
-	size_t encoded_length = 0;
 	size_t fit_so_far = 0;
+	size_t kv_length = 0;
+	size_t val_offset = 0;
+	size_t val_len = 0;
+	size_t val_fit = 0;
 
-	if (!fdow || !si) {
+	if (!si || si->sv_index_end > si->numKV) {
 		return false;
 	}
 
-	num = si->sv_index_end;
+	// resume a ServiceInfoVal that was sent partially in the previous message
+	if (si->sv_val_index != 0) {
+		val_offset = si->sv_val_index;
+		if (si->sv_index_end - 1 == si->sv_index_begin) {
+			val_offset += si->sv_val_offset;
+		}
+		si->sv_index_end--;
+	}
 	si->sv_index_begin = si->sv_index_end;
+	si->sv_val_offset = val_offset;
+	si->sv_val_index = 0;
 
-	// just start writing the ServiceInfo till numKV, but don't end it
-	// since it does not matter in finding out encoded length,
-	// and is not going to be used for any other purposes
-	if (!fdow_start_array(fdow, si->numKV)) {
-		LOG(LOG_ERROR, "Failed to write start array\n");
-		goto end;
-	}
+	// ServiceInfo array header, for at most the remaining number of ServiceInfoKVs
+	fit_so_far = fdow_head_length(si->numKV - si->sv_index_begin);
 
-	// fetch all Device ServiceInfo's one-by-one
-	while (num != si->numKV) {
+	for (num = si->sv_index_begin; num < si->numKV; num++) {
+		kv = fdo_service_info_get(si, num);
+		if (!kv) {
+			LOG(LOG_ERROR, "Device ServiceInfo: Key/Value not found\n");
+			return false;
+		}
 
-		encoded_length = 0;
-		if (!fdo_serviceinfo_kv_write(fdow, si, num, mtu)) {
-			LOG(LOG_ERROR, "Failed to write ServiceInfoKV\n");
-			goto end;
+		val_len = 0;
+		if (kv->type == FDO_KV_VAL_STR || kv->type == FDO_KV_VAL_BIN) {
+			val_len = kv->val.buf.len;
+			if (num == si->sv_index_begin) {
+				val_len -= si->sv_val_offset;
+			}
 		}
-		if (!fdow_encoded_length(fdow, &encoded_length) || encoded_length == 0) {
-			LOG(LOG_ERROR, "Failed to read ServiceInfoKV length\n");
-			goto end;
+
+		kv_length = fdo_serviceinfo_kv_encoded_length(si, kv, val_len);
+		if (kv_length == 0) {
+			LOG(LOG_ERROR, "Device ServiceInfo: No ServiceInfoVal found\n");
+			return false;
 		}
-		if (encoded_length >= mtu) {
-			// this key-value does not fit within the MTU
-			// now, check if atleast the key fits with some room for value
-			kvp = fdo_service_info_get(si, num);
-			kv = *kvp;
-			if ((fit_so_far + kv->key->byte_sz + 10) < mtu) {
-				// the key fits and atleast 10 bytes of value fits
-				// the difference gives the exact length exceeding the MTU
-				// for the given key and partial value
-				si->sv_val_index = encoded_length - mtu;
-				si->sv_index_end++;
-				ret = true;
-				goto end;
-			} else {
-				// key and partial value cannot be fit within the MTU,
-				// ignore this key and value, return
-				si->sv_val_index = 0;
-				ret = true;
-				goto end;
-			}
-		} else {
+
+		if (fit_so_far + kv_length < mtu) {
 			// both key and value fit within the MTU
+			fit_so_far += kv_length;
 			si->sv_index_end++;
-			si->sv_val_index = 0;
-			fit_so_far = encoded_length;
+			continue;
 		}
-		num++;
+
+		// this key-value does not fit within the MTU
+		// find how much of a text/binary value fits, along with its key
+		if ((kv->type == FDO_KV_VAL_STR || kv->type == FDO_KV_VAL_BIN) &&
+		    val_len > 0) {
+			val_fit = val_len;
+			while (val_fit > 0) {
+				kv_length = fdo_serviceinfo_kv_encoded_length(si, kv, val_fit);
+				if (fit_so_far + kv_length < mtu) {
+					break;
+				}
+				// dropping the excess bytes is enough, unless headers shrink too
+				val_fit -= (fit_so_far + kv_length + 1 - mtu) < val_fit ?
+					(fit_so_far + kv_length + 1 - mtu) : val_fit;
+			}
+			// only split when atleast 10 bytes of value fit
+			if (val_fit >= 10) {
+				si->sv_val_index = val_fit;
+				si->sv_index_end++;
+			}
+		}
+		break;
 	}
-	ret = true;
-end:
-	while (fdow->current->previous) {
-		// recursively move to previous and free current
-		// this is done because we cannot close the arrays created initially
-		fdow->current = fdow->current->previous;
-		fdo_free(fdow->current->next);
+
+	if (si->sv_index_end == si->sv_index_begin && si->sv_index_end < si->numKV) {
+		// not even a part of the next key-value fits, it never will
+		LOG(LOG_ERROR, "Device ServiceInfo: ServiceInfoKV cannot be fit within MTU\n");
+		return false;
 	}
-	return ret;
+	return true;
 }
 
 /**
@@ -16,4 +16,8 @@ int aes_encrypt_packet(fdo_encrypted_packet_t *cipher_txt, uint8_t *clear_txt,
 int aes_decrypt_packet(fdo_encrypted_packet_t *cipher_txt,
 		       fdo_byte_array_t *clear_txt, const uint8_t *aad, size_t aad_length);
 
+int aes_decrypt_packet_to_buf(fdo_encrypted_packet_t *cipher_txt,
+			      uint8_t *clear_txt, size_t *clear_txt_size,
+			      const uint8_t *aad, size_t aad_length);
+
 #endif /* __CRYPTO_UTILS_H__ */
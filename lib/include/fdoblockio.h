@@ -68,6 +68,7 @@ typedef struct _FDOW_s {
 void fdo_block_reset(fdo_block_t *fdob);
 bool fdo_block_alloc(fdo_block_t *fdob);
 bool fdo_block_alloc_with_size(fdo_block_t *fdob, size_t block_sz);
+bool fdo_block_alloc_pooled(fdo_block_t *fdob, size_t block_sz);
 
 // CBOR encoder methods
 
@@ -86,12 +87,14 @@ bool fdow_null(fdow_t *fdow);
 bool fdow_end_array(fdow_t *fdow_cbor);
 bool fdow_end_map(fdow_t *fdow_cbor);
 bool fdow_encoded_length(fdow_t *fdow_cbor, size_t *length);
+size_t fdow_head_length(uint64_t value);
 void fdow_flush(fdow_t *fdow);
 
 // CBOR decoder methods
 
 bool fdor_init(fdor_t *fdor);
 bool fdor_parser_init(fdor_t *fdor_cbor);
+bool fdor_view_init(fdor_t *fdor, const uint8_t *buffer, size_t buffer_length);
 bool fdor_start_array(fdor_t *fdor);
 bool fdor_start_map(fdor_t *fdor);
 bool fdor_array_length(fdor_t *fdor, size_t *length);
@@ -99,6 +102,9 @@ bool fdor_map_length(fdor_t *fdor, size_t *length);
 bool fdor_string_length(fdor_t *fdor, size_t *length);
 bool fdor_byte_string(fdor_t *fdor, uint8_t *buffer, size_t buffer_length);
 bool fdor_text_string(fdor_t *fdor, char *buffer, size_t buffer_length);
+bool fdor_byte_string_view(fdor_t *fdor, const uint8_t **buffer, size_t *buffer_length);
+bool fdor_text_string_view(fdor_t *fdor, const char **buffer, size_t *buffer_length);
+bool fdor_item_view(fdor_t *fdor, const uint8_t **buffer, size_t *buffer_length);
 bool fdor_is_value_null(fdor_t *fdor);
 bool fdor_is_value_signed_int(fdor_t *fdor);
 bool fdor_signed_int(fdor_t *fdor, int *result);
@@ -111,5 +117,6 @@ bool fdor_map_has_more(fdor_t *fdor);
 bool fdor_next(fdor_t *fdor);
 bool fdor_is_valid_cbor(fdor_t *fdor);
 void fdor_flush(fdor_t *fdor);
+void fdor_view_flush(fdor_t *fdor);
 
 #endif /*__FDOBLOCKIO_H__ */
@@ -0,0 +1,30 @@
+/*
+ * Copyright 2020 Intel Corporation
+ * SPDX-License-Identifier: Apache 2.0
+ */
+
+#ifndef __FDOBUFPOOL_H__
+#define __FDOBUFPOOL_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Number of buffers the pool keeps track of */
+#define FDO_BUF_POOL_SLOTS 8
+
+/*
+ * Most bytes held by the pool at once, in use or kept for reuse.
+ * 0 for no ceiling. Can be changed at runtime with fdo_buf_pool_set_cap().
+ */
+#ifndef BUFFER_POOL_SZ
+#define BUFFER_POOL_SZ 0
+#endif
+
+uint8_t *fdo_buf_pool_get(size_t size);
+void fdo_buf_pool_put(uint8_t *buf);
+void fdo_buf_pool_drain(void);
+size_t fdo_buf_pool_peak(void);
+void fdo_buf_pool_set_cap(size_t cap);
+
+#endif /* __FDOBUFPOOL_H__ */
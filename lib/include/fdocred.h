@@ -62,7 +62,6 @@ typedef struct _fdo_oventry_t {
 	uint16_t enn;
 	fdo_hash_t *hp_hash;	// Hash of previous entry (OVEHashPrevEntry)
 	fdo_hash_t *hc_hash;	// Hash of header info (OVEHashHdrInfo)
-	fdo_byte_array_t *ove_extra; // (OVEExtra)
 	fdo_public_key_t *pk;	// public key (OVEPubKey)
 } fdo_ov_entry_t;
 
@@ -96,12 +95,13 @@ typedef struct _fdo_ownershipvoucher_t {
 fdo_ownership_voucher_t *fdo_ov_alloc(void);
 void fdo_ov_free(fdo_ownership_voucher_t *ov);
 void fdo_ov_print(fdo_ownership_voucher_t *ov);
-fdo_ownership_voucher_t *fdo_ov_hdr_read(fdo_byte_array_t *ovheader, fdo_hash_t **hmac);
-bool fdo_ov_hdr_hmac(fdo_byte_array_t *ovheader, fdo_hash_t **hmac);
+fdo_ownership_voucher_t *fdo_ov_hdr_read(const fdo_byte_view_t *ovheader,
+					 fdo_hash_t **hmac, bool read_rvinfo);
+bool fdo_ov_hdr_hmac(const fdo_byte_view_t *ovheader, fdo_hash_t **hmac);
 fdo_hash_t *fdo_new_ov_hdr_sign(fdo_dev_cred_t *dev_cred,
 			fdo_owner_supplied_credentials_t *osc, fdo_hash_t *hdc);
-bool fdo_ove_hash_prev_entry_save(fdow_t *fdow, fdo_ownership_voucher_t *ov,
-	fdo_hash_t *hmac);
+bool fdo_ove_hash_prev_entry_save(const fdo_byte_view_t *ovheader,
+	const fdo_byte_view_t *hmac, fdo_ownership_voucher_t *ov);
 bool fdo_ove_hash_hdr_info_save(fdo_ownership_voucher_t *ov);
 bool fdo_ovheader_write(fdow_t *fdow, int protver, fdo_byte_array_t *guid,
 	fdo_rendezvous_list_t *rvlst, fdo_string_t *dev_info,
@@ -117,6 +117,20 @@
 // limit on number of Ownership Voucher entries to 255
 #define MAX_NO_OVENTRIES 255
 
+/*
+ * OVEntries verified by previous TO2 attempts, kept in memory across retries.
+ * hashes[0] is the initial OVEHashPrevEntry (hash of OVHeader and HMac), and
+ * hashes[i + 1] is the hash of OVEntry i, once its signature is verified.
+ * Each hash commits to the whole chain before it, so an OVEntry received again
+ * after hashes[i], and hashing to hashes[i + 1], was verified with the same
+ * key and its signature isn't verified again.
+ */
+typedef struct fdo_ov_checkpoint_s {
+	int num_hashes;
+	int max_hashes;
+	uint8_t *hashes; // max_hashes digests of FDO_SHA_DIGEST_SIZE_USED bytes
+} fdo_ov_checkpoint_t;
+
 // The maximum negotiated message size
 #define MAX_NEGO_MSG_SIZE 65535
 
@@ -148,6 +162,7 @@ typedef struct fdo_prot_s {
 	fdo_public_key_t *
 	    owner_public_key; // Owner's public key
 	fdo_service_info_t *service_info; // store System ServiceInfo (devmod+unsupported module list)
+	fdo_service_info_t *devmod_info; // 'devmod' ServiceInfo, owned by the caller of TO2 init
 	fdo_byte_array_t *ext_service_info; // store External module ServiceInfoVal (fdo_sys, for ex.)
 	fdo_public_key_t *tls_key; // unused for now
 	int ov_entry_num;
@@ -155,6 +170,7 @@ typedef struct fdo_prot_s {
 	fdo_hash_t *new_ov_hdr_hmac;
 	fdo_hash_t *hello_device_hash;
 	fdo_cose_t *to1d_cose;
+	fdo_public_key_t *to1d_owner_key; // Owner key that verified to1d_cose
 	fdo_sv_invalid_modnames_t *serviceinfo_invalid_modnames;
 	uint64_t max_device_message_size; // used to store maxDeviceMessageSize
 	uint64_t max_owner_message_size; // used to store maxOwnerMessageSize and not used thereafter
@@ -178,6 +194,7 @@ typedef struct fdo_prot_s {
 	fdo_sv_info_dsi_info_t *dsi_info;
 	int total_dsi_rounds; // device service infos + module DSI counts
 	bool reuse_enabled;   // REUSE protocol flag
+	fdo_ov_checkpoint_t ov_checkpoint; // not cleared between TO2 attempts
 } fdo_prot_t;
 
 /* DI function declarations */
@@ -218,6 +235,15 @@ bool fdo_process_states(fdo_prot_t *ps);
 
 bool fdo_check_to2_round_trips(fdo_prot_t *ps);
 
+void fdo_prot_ov_checkpoint_start(fdo_prot_t *ps, fdo_hash_t *hdr_hash,
+				  int num_ov_entries);
+bool fdo_prot_ov_checkpoint_verified(fdo_prot_t *ps, int entry_num,
+				     fdo_hash_t *prev_hash,
+				     fdo_hash_t *entry_hash);
+void fdo_prot_ov_checkpoint_add(fdo_prot_t *ps, int entry_num,
+				fdo_hash_t *prev_hash, fdo_hash_t *entry_hash);
+void fdo_prot_ov_checkpoint_free(fdo_prot_t *ps);
+
 void fdo_send_error_message(fdow_t *fdow, int ecode, int msgnum,
 					char *emsg, size_t errmsg_sz);
 void fdo_receive_error_message(fdor_t *fdor, int *ecode, int *msgnum,
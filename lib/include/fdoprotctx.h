@@ -19,6 +19,13 @@ typedef struct {
 	fdourl_t url[1]; // fdourl_t[numURL]
 } fdo_type_to_url_t;
 
+// Where fdo_prot_ctx_step() stands in the protocol exchange
+typedef enum {
+	FDO_PROT_CTX_IDLE = 0,
+	FDO_PROT_CTX_SEND, // next message to be built and sent
+	FDO_PROT_CTX_RECV  // response to the last message awaited
+} fdo_prot_ctx_phase_t;
+
 // FDO protocol context
 typedef struct fdo_prot_ctx_s {
 	fdo_con_handle sock_hdl;
@@ -29,7 +36,10 @@ typedef struct fdo_prot_ctx_s {
 	fdo_ip_address_t *host_ip;
 	uint16_t host_port;
 	const char *host_dns;
+	char *host_dns_copy; // host_dns, owned by the context
 	fdo_ip_address_t *resolved_ip;
+	fdo_prot_ctx_phase_t phase;
+	char *curl_buf; // response header buffer, held during the exchange
 } fdo_prot_ctx_t;
 
 fdo_prot_ctx_t *fdo_prot_ctx_alloc(bool (*protrun)(fdo_prot_t *ps),
@@ -39,6 +49,8 @@ fdo_prot_ctx_t *fdo_prot_ctx_alloc(bool (*protrun)(fdo_prot_t *ps),
 				   bool tls);
 
 int fdo_prot_ctx_run(fdo_prot_ctx_t *prot_ctx);
+int fdo_prot_ctx_step(fdo_prot_ctx_t *prot_ctx, uint64_t deadline_ms);
+int fdo_prot_ctx_get_fd(fdo_prot_ctx_t *prot_ctx);
 void fdo_prot_ctx_free(fdo_prot_ctx_t *prot_ctx);
 
 #endif /* __FDOPROTCTX_H__ */
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2020 Intel Corporation
+ * SPDX-License-Identifier: Apache 2.0
+ */
+
+#ifndef __FDORETRY_H__
+#define __FDORETRY_H__
+
+#include "fdotypes.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Number of Rendezvous/Owner addresses whose health is tracked */
+#define FDO_RETRY_MAX_ENDPOINTS 16
+
+/* Shortest backoff delay, in seconds, so that a retry never follows at once */
+#define FDO_RETRY_MIN_DELAY_SEC 1
+
+/*
+ * Health of one Rendezvous/Owner address. The number of consecutive failed
+ * attempts is its score: the lower, the healthier.
+ */
+typedef struct fdo_retry_endpoint_s {
+	uint32_t id; // fdo_retry_endpoint_id(), 0 if the slot is free
+	uint32_t failures;
+} fdo_retry_endpoint_t;
+
+/*
+ * Retry scheduler: capped exponential backoff with jitter, so that devices
+ * failing together don't retry together, and the health of the addresses
+ * tried so far.
+ */
+typedef struct fdo_retry_s {
+	uint64_t cap_sec;  // longest delay
+	uint32_t failures; // consecutive failed rounds over all addresses
+	uint32_t next_slot; // slot reused once all of them are taken
+	fdo_retry_endpoint_t endpoints[FDO_RETRY_MAX_ENDPOINTS];
+} fdo_retry_t;
+
+void fdo_retry_init(fdo_retry_t *retry, uint64_t cap_sec);
+uint32_t fdo_retry_endpoint_id(const uint8_t *ip, size_t ip_len,
+			       const fdo_string_t *dns, int port);
+void fdo_retry_report(fdo_retry_t *retry, uint32_t id, bool success);
+uint32_t fdo_retry_failures(const fdo_retry_t *retry, uint32_t id);
+uint64_t fdo_retry_delay(const fdo_retry_t *retry, uint32_t failures,
+			 uint64_t base_sec, uint64_t delaysec);
+void fdo_retry_sort_rvto2addr(const fdo_retry_t *retry,
+			      fdo_rvto2addr_t *rvto2addr);
+
+#endif /* __FDORETRY_H__ */
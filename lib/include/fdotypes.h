@@ -23,6 +23,15 @@ typedef struct {
 	uint8_t *bytes;
 } fdo_bits_t;
 
+/*
+ * Payloads of up to FDO_INLINE_BYTES_MAX bytes (nonces, GUIDs, hashes, short
+ * strings) are allocated along with their fdo_bits_t, fdo_string_t or
+ * fdo_hash_t, right after it, in a single allocation. bytes then points into
+ * the same block, so it must only be released through the type's free/resize
+ * functions, never with fdo_free() directly.
+ */
+#define FDO_INLINE_BYTES_MAX 64
+
 fdo_bits_t *fdo_bits_init(fdo_bits_t *b, size_t byte_sz);
 fdo_bits_t *fdo_bits_alloc(size_t byte_sz);
 fdo_bits_t *fdo_bits_alloc_with(size_t byte_sz, uint8_t *data);
@@ -48,6 +57,20 @@ fdo_byte_array_t *fdo_byte_array_append(fdo_byte_array_t *baA,
 					fdo_byte_array_t *baB);
 fdo_byte_array_t *fdo_byte_array_clone(fdo_byte_array_t *ba);
 
+/*
+ * Byte view: a bstr left in place in the buffer it was decoded from. Reading
+ * it allocates and copies nothing, so a view is only valid while that buffer
+ * is. Fields that are only hashed, compared or skipped are read as views, and
+ * fdo_byte_view_dup() materialises one when it has to outlive the buffer.
+ */
+typedef struct {
+	size_t byte_sz;
+	const uint8_t *bytes;
+} fdo_byte_view_t;
+
+bool fdo_byte_view_read(fdor_t *fdor, fdo_byte_view_t *view);
+fdo_byte_array_t *fdo_byte_view_dup(const fdo_byte_view_t *view);
+
 // Generic string holder
 typedef struct {
 	int byte_sz;
@@ -225,6 +248,7 @@ typedef struct {
 	uint8_t nulls_added;
 	fdo_byte_array_t *ct_string;
 	fdo_byte_array_t *em_body; // Ciphertext of Encrypted Message Body
+	fdo_byte_array_t em_view;  // em_body when it refers to the FDOR buffer
 	uint8_t tag[AES_TAG_LEN];
 	fdo_hash_t *hmac;	  // HMAC of ct body
 	uint8_t iv[AES_IV_LEN];	// iv of gcm/ccm.
@@ -239,7 +263,8 @@ bool fdo_aad_write(fdow_t *fdow, int alg_type);
 bool fdo_emblock_write(fdow_t *fdow, fdo_encrypted_packet_t *pkt);
 bool fdo_etminnerblock_write(fdow_t *fdow, fdo_encrypted_packet_t *pkt);
 bool fdo_etmouterblock_write(fdow_t *fdow, fdo_encrypted_packet_t *pkt);
-bool fdo_encrypted_packet_unwind(fdor_t *fdor, fdo_encrypted_packet_t *pkt);
+bool fdo_encrypted_packet_unwind(fdor_t *fdor, fdo_encrypted_packet_t *pkt,
+	size_t fdor_buff_sz);
 bool fdo_encrypted_packet_windup(fdow_t *fdow, int type);
 bool fdo_prep_simple_encrypted_message(fdo_encrypted_packet_t *pkt,
 	fdow_t *fdow, size_t fdow_buff_default_sz);
@@ -258,6 +283,7 @@ typedef struct {
 	fdo_cose_encrypt0_protected_header_t *protected_header;
 	fdo_cose_encrypt0_unprotected_header_t *unprotected_header;
 	fdo_byte_array_t *payload;
+	fdo_byte_view_t payload_view; // set by fdo_cose_encrypt0_read()
 } fdo_cose_encrypt0_t;
 
 void fdo_cose_encrypt0_free(fdo_cose_encrypt0_t *cose_encrypt0);
@@ -331,9 +357,9 @@ bool fdo_cose_read(fdor_t *fdor, fdo_cose_t *cose, bool empty_uph);
 bool fdo_cose_write_protected_header(fdow_t *fdow, fdo_cose_protected_header_t *cose_ph);
 bool fdo_cose_write_unprotected_header(fdow_t *fdow);
 bool fdo_cose_write(fdow_t *fdow, fdo_cose_t *cose);
-bool fdo_cose_write_sigstructure(fdo_cose_protected_header_t *cose_ph,
+bool fdo_cose_verify_signature(fdo_cose_protected_header_t *cose_ph,
 	fdo_byte_array_t *cose_payload, fdo_byte_array_t *external_aad,
-	fdo_byte_array_t **sig_structure);
+	fdo_byte_array_t *cose_signature, fdo_public_key_t *pk);
 
 /*
  * This is a lookup on all possible TransportProtocol values (Section 3.3.12)
@@ -363,22 +389,43 @@ void fdo_rvto2addr_free(fdo_rvto2addr_t *rvto2addr);
 bool fdo_rvto2addr_entry_read(fdor_t *fdor, fdo_rvto2addr_entry_t *rvto2addr_entry);
 bool fdo_rvto2addr_read(fdor_t *fdor, fdo_rvto2addr_t *rvto2addr);
 
+/* Type of the ServiceInfoVal held by a fdo_key_value_t */
+typedef enum {
+	FDO_KV_VAL_NONE = 0,
+	FDO_KV_VAL_STR,
+	FDO_KV_VAL_BIN,
+	FDO_KV_VAL_BOOL,
+	FDO_KV_VAL_INT
+} fdo_kv_val_type_t;
+
+/*
+ * ServiceInfoKV, an entry of the fdo_service_info_t table.
+ * The key (NULL-terminated) and text/binary values are stored in the arena of
+ * the table, at the given offsets. Entries move when the table grows, so a
+ * pointer to one is only valid until the next key is added.
+ */
 typedef struct fdo_key_value_s {
-	struct fdo_key_value_s *next;
-	fdo_string_t *key;
-	fdo_string_t *str_val;
-	fdo_byte_array_t *bin_val;
-	int *int_val;
-	bool *bool_val;
+	size_t key_offset;
+	size_t key_len;
+	// case-insensitive hash of key
+	uint32_t key_hash;
+	// index + 1 of the next entry in the same hash bucket, 0 if none
+	uint32_t bucket_next;
+	fdo_kv_val_type_t type;
+	union {
+		struct {
+			size_t offset;
+			size_t len;
+			size_t capacity;
+		} buf; // FDO_KV_VAL_STR and FDO_KV_VAL_BIN
+		bool bool_val;
+		int int_val;
+	} val;
+	// CBOR-encoded ServiceInfoVal in the arena, enc_len is 0 until it's encoded
+	size_t enc_offset;
+	size_t enc_len;
 } fdo_key_value_t;
 
-fdo_key_value_t *fdo_kv_alloc(void);
-fdo_key_value_t *fdo_kv_alloc_with_array(const char *key,
-					 fdo_byte_array_t *val);
-fdo_key_value_t *fdo_kv_alloc_with_str(const char *key, const char *val);
-fdo_key_value_t *fdo_kv_alloc_key_only(const char *key);
-void fdo_kv_free(fdo_key_value_t *kv);
-
 /*
  * This is a lookup on all possible RVVariable
  */
@@ -459,25 +506,47 @@ fdo_rendezvous_t *fdo_rendezvous_list_get(fdo_rendezvous_directive_t *list, int
 int fdo_rendezvous_list_read(fdor_t *fdor, fdo_rendezvous_list_t *list);
 bool fdo_rendezvous_list_write(fdow_t *fdow, fdo_rendezvous_list_t *list);
 
+/* Number of hash buckets of a ServiceInfo table, must be a power of 2 */
+#define FDO_SI_KV_BUCKETS 16
+
 // List containing string of fixed length (FDO_MODULE_NAME_LEN)
 typedef struct fdo_sv_invalid_modnames_s {
 	char bytes[FDO_MODULE_NAME_LEN];
+	uint32_t name_hash;
 	struct fdo_sv_invalid_modnames_s *next;
 } fdo_sv_invalid_modnames_t;
 
+/*
+ * ServiceInfoKVs [sv_index_begin, sv_index_end) are sent in the current message.
+ * A text/binary ServiceInfoVal that doesn't fit is split across messages:
+ * sv_val_offset is where the 1st ServiceInfoVal of the message resumes from, and
+ * sv_val_index is the number of bytes of the last ServiceInfoVal that are sent,
+ * if it is incomplete (0 otherwise).
+ *
+ * ServiceInfoKVs are kept in a flat table, indexed by a hash of their keys, and
+ * their keys and values in a single arena, so that building ServiceInfo only
+ * allocates when the table or the arena has to grow.
+ */
 typedef struct fdo_service_info_s {
 	size_t numKV;
-	fdo_key_value_t *kv;
+	fdo_key_value_t *kv; // table of numKV entries, in insertion order
+	size_t kv_capacity;
+	uint8_t *arena; // keys, text/binary values and encoded ServiceInfoVals
+	size_t arena_used;
+	size_t arena_size;
+	// index + 1 of the first entry of every hash bucket, 0 if empty
+	uint32_t buckets[FDO_SI_KV_BUCKETS];
 	size_t sv_index_end;
 	size_t sv_index_begin;
 	size_t sv_val_index;
+	size_t sv_val_offset;
 } fdo_service_info_t;
 
 fdo_service_info_t *fdo_service_info_alloc(void);
 void fdo_service_info_free(fdo_service_info_t *si);
-fdo_key_value_t **fdo_service_info_fetch(fdo_service_info_t *si,
-					 const char *key);
-fdo_key_value_t **fdo_service_info_get(fdo_service_info_t *si, int key_num);
+fdo_key_value_t *fdo_service_info_fetch(fdo_service_info_t *si,
+					const char *key);
+fdo_key_value_t *fdo_service_info_get(fdo_service_info_t *si, size_t key_num);
 bool fdo_service_info_add_kv_str(fdo_service_info_t *si, const char *key,
 				 const char *val);
 bool fdo_service_info_add_kv_bin(fdo_service_info_t *si, const char *key,
@@ -486,7 +555,6 @@ bool fdo_service_info_add_kv_bool(fdo_service_info_t *si, const char *key,
 				 bool val);
 bool fdo_service_info_add_kv_int(fdo_service_info_t *si, const char *key,
 				 int val);
-bool fdo_service_info_add_kv(fdo_service_info_t *si, fdo_key_value_t *kv);
 bool fdo_signature_verification(fdo_byte_array_t *plain_text,
 				fdo_byte_array_t *sg, fdo_public_key_t *pk);
 
@@ -495,6 +563,11 @@ bool fdo_compare_public_keys(fdo_public_key_t *pk1, fdo_public_key_t *pk2);
 /*==================================================================*/
 /* Service Info functionality */
 
+/* Number of hash buckets in the module registry, must be a power of 2 */
+#define FDO_SI_MODULE_BUCKETS 64
+
+struct fdo_sv_info_module_index_s;
+
 /* Module list */
 typedef struct fdo_sdk_service_info_module_list_s {
 	fdo_sdk_service_info_module module;
@@ -503,8 +576,22 @@ typedef struct fdo_sdk_service_info_module_list_s {
 	int module_osi_index;
 	struct fdo_sdk_service_info_module_list_s
 	    *next; // ptr to next module node
+	uint32_t name_hash; // hash of module.module_name
+	struct fdo_sdk_service_info_module_list_s
+	    *bucket_next; // ptr to next module node in the same hash bucket
+	struct fdo_sv_info_module_index_s
+	    *index; // module registry, set on the list head only
 } fdo_sdk_service_info_module_list_t;
 
+/*
+ * Module registry, built as modules are registered. It maps module names to
+ * their list nodes, and tracks the single module activated by the Owner.
+ */
+typedef struct fdo_sv_info_module_index_s {
+	fdo_sdk_service_info_module_list_t *buckets[FDO_SI_MODULE_BUCKETS];
+	fdo_sdk_service_info_module_list_t *active;
+} fdo_sv_info_module_index_t;
+
 typedef struct fdo_sv_info_dsi_info_s {
 	fdo_sdk_service_info_module_list_t *list_dsi;
 	int module_dsi_index;
@@ -515,6 +602,14 @@ void fdo_sdk_service_info_register_module(fdo_sdk_service_info_module *module);
 void fdo_sdk_service_info_deregister_module(void);
 void print_service_info_module_list(void);
 
+bool fdo_serviceinfo_module_index_add(fdo_sdk_service_info_module_list_t *module_list,
+	fdo_sdk_service_info_module_list_t *module);
+void fdo_serviceinfo_module_index_free(fdo_sdk_service_info_module_list_t *module_list);
+fdo_sdk_service_info_module_list_t *fdo_serviceinfo_module_lookup(
+	fdo_sdk_service_info_module_list_t *module_list, const char *module_name);
+fdo_sdk_service_info_module_list_t *fdo_serviceinfo_active_module(
+	fdo_sdk_service_info_module_list_t *module_list);
+
 bool fdo_serviceinfo_write(fdow_t *fdow, fdo_service_info_t *si, size_t mtu);
 bool fdo_serviceinfo_kv_write(fdow_t *fdow, fdo_service_info_t *si, size_t num, size_t mtu);
 bool fdo_serviceinfo_modules_list_write(fdow_t *fdow);
@@ -526,7 +621,7 @@ fdo_sdk_service_info_module* fdo_serviceinfo_get_external_mod_to_write(fdow_t *f
 bool fdo_serviceinfo_external_mod_write(fdow_t *fdow, fdo_byte_array_t *ext_serviceinfo,
 	fdo_sdk_service_info_module *module,
 	size_t mtu);
-bool fdo_serviceinfo_fit_mtu(fdow_t *fdow, fdo_service_info_t *si, size_t mtu);
+bool fdo_serviceinfo_fit_mtu(fdo_service_info_t *si, size_t mtu);
 
 bool fdo_mod_exec_sv_infotype(fdo_sdk_service_info_module_list_t *module_list,
 			      fdo_sdk_si_type type);
@@ -537,7 +632,7 @@ void fdo_sv_info_clear_module_psi_osi_index(
 bool fdo_serviceinfo_read(fdor_t *fdor, fdo_sdk_service_info_module_list_t *module_list,
 	int *cb_return_val, fdo_sv_invalid_modnames_t **serviceinfo_invalid_modnames);
 bool fdo_supply_serviceinfoval(char *module_name, char *module_message,
-	fdo_byte_array_t *module_val,
+	const uint8_t *module_val, size_t module_val_sz,
 	fdo_sdk_service_info_module_list_t *module_list, int *cb_return_val);
 bool fdo_serviceinfo_invalid_modname_add(char *module_name,
 	fdo_sv_invalid_modnames_t **serviceinfo_invalid_modnames);
@@ -28,6 +28,11 @@ int load_credential(fdo_dev_cred_t *ocred);
 int load_device_secret(void);
 int store_credential(fdo_dev_cred_t *ocred);
 
+/* What store_credentials() commits along with the Normal blob */
+#define FDO_CRED_STORE_SECRET 0x1     // DCHmacSecret, into the Secure blob
+#define FDO_CRED_STORE_ROTATE_KEY 0x2 // new storage HMAC key, before sealing
+int store_credentials(fdo_dev_cred_t *ocred, uint32_t parts);
+
 bool load_device_status(fdo_sdk_device_status *state);
 bool store_device_status(fdo_sdk_device_status *state);
 
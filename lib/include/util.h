@@ -150,6 +150,14 @@ int read_buffer_from_file(const char *filename, uint8_t *buffer, size_t size);
  */
 void *fdo_alloc(size_t size);
 
+#ifdef FDO_ALLOC_STATS
+/*
+ * Number of successful fdo_alloc() calls and the bytes they requested, since
+ * the start of the process. Built with BENCH=true.
+ */
+void fdo_alloc_stats(uint64_t *allocs, uint64_t *bytes);
+#endif
+
 /* Print timestamp */
 int print_timestamp(void);
 
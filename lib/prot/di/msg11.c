@@ -32,8 +32,7 @@ int32_t msg11(fdo_prot_t *ps)
 	char prot[] = "FDOProtDI";
 	fdo_ownership_voucher_t *ov = NULL;
 	fdo_dev_cred_t *dev_cred = app_get_credentials();
-	fdo_byte_array_t *ovheader = NULL;
-	size_t ovheader_sz = 0;
+	fdo_byte_view_t ovheader = {0};
 
 	if (!ps) {
 		LOG(LOG_ERROR, "Invalid protocol state\n");
@@ -85,18 +84,8 @@ int32_t msg11(fdo_prot_t *ps)
 		goto err;
 	}
 
-	if (!fdor_string_length(&ps->fdor, &ovheader_sz) || ovheader_sz == 0) {
-		LOG(LOG_ERROR,
-		    "DISetCredentials: Failed to read OVeader as bstr length\n");
-		goto err;
-	}
-
-	ovheader = fdo_byte_array_alloc(ovheader_sz);
-	if (!ovheader) {
-		LOG(LOG_ERROR, "DISetCredentials: Failed to alloc for OVHeader as bstr\n");
-		goto err;
-	}
-	if (!fdor_byte_string(&ps->fdor, ovheader->bytes, ovheader->byte_sz)) {
+	// OVHeader stays in the receive buffer, it is parsed from there
+	if (!fdo_byte_view_read(&ps->fdor, &ovheader) || ovheader.byte_sz == 0) {
 		LOG(LOG_ERROR, "DISetCredentials: Failed to read OVHeader as bstr\n");
 		goto err;
 	}
@@ -107,7 +96,7 @@ int32_t msg11(fdo_prot_t *ps)
 	}
 
 	/* Parse the complete Ownership header and calcuate HMAC over it */
-	ov = fdo_ov_hdr_read(ovheader, &ps->new_ov_hdr_hmac);
+	ov = fdo_ov_hdr_read(&ovheader, &ps->new_ov_hdr_hmac, true);
 	if (!ov) {
 		LOG(LOG_ERROR, "DISetCredentials: Failed to read OVHeader\n");
 		goto err;
@@ -140,9 +129,5 @@ int32_t msg11(fdo_prot_t *ps)
 	ret = 0;
 
 err:
-	if (ovheader) {
-		fdo_byte_array_free(ovheader);
-		ovheader = NULL;
-	}
 	return ret;
 }
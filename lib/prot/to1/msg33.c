@@ -54,6 +54,10 @@ int32_t msg33(fdo_prot_t *ps)
 	if (ps->to1d_cose) {
 		fdo_cose_free(ps->to1d_cose);
 	}
+	if (ps->to1d_owner_key) {
+		fdo_public_key_free(ps->to1d_owner_key);
+		ps->to1d_owner_key = NULL;
+	}
 	ps->to1d_cose = fdo_alloc(sizeof(fdo_cose_t));
 	if (!ps->to1d_cose) {
 		LOG(LOG_ERROR, "TO1.RVRedirect: Failed to alloc COSE\n");
@@ -46,11 +46,10 @@ int32_t msg61(fdo_prot_t *ps)
 	int result_memcmp = 0;
 	fdo_byte_array_t *xA = NULL;
 	fdo_cose_t *cose = NULL;
-	fdo_byte_array_t *cose_sig_structure = NULL;
 	fdo_hash_t *ovheader_pubkey_hash = NULL;
 	fdo_hash_t *hello_device_hash_rcv = NULL;
-	fdo_byte_array_t *ovheader = NULL;
-	size_t ovheader_sz = 0;
+	fdo_byte_view_t ovheader = {0};
+	fdo_byte_view_t hmac = {0};
 
 	if (!ps) {
 		LOG(LOG_ERROR, "Invalid protocol state\n");
@@ -101,38 +100,34 @@ int32_t msg61(fdo_prot_t *ps)
 		goto err;
 	}
 
-	if (!fdo_cose_write_sigstructure(cose->cose_ph, cose->cose_payload, NULL,
-		&cose_sig_structure) || !cose_sig_structure) {
-		LOG(LOG_ERROR, "TO2.ProveOVHdr: Failed to write COSE Sig_structure\n");
-		goto err;
-	}
-
 	/* The signature verification over TO2.ProveOVHdr.TO2ProveOVHdrPayload must verify */
-	if (!fdo_signature_verification(cose_sig_structure,
+	if (!fdo_cose_verify_signature(cose->cose_ph, cose->cose_payload, NULL,
 					cose->cose_signature,
 					ps->owner_public_key)) {
 		LOG(LOG_ERROR, "TO2.ProveOVHdr: COSE signature verification failed\n");
 		goto err;
 	}
 	LOG(LOG_DEBUG, "TO2.ProveOVHdr: COSE signature verification successful\n");
-	fdo_byte_array_free(cose_sig_structure);
-	cose_sig_structure = NULL;
 
 	// verify the to1d that was received during TO1.RVRedirect, Type 33
 	// Happens only when TO2 was started without RVBypass flow.
-	if (ps->to1d_cose) {
-		if (!fdo_cose_write_sigstructure(ps->to1d_cose->cose_ph, ps->to1d_cose->cose_payload,
-			NULL, &cose_sig_structure) || !cose_sig_structure) {
-			LOG(LOG_ERROR, "TO2.ProveOVHdr: Failed to write COSE Sig_structure\n");
-			goto err;
-		}
-		if (!fdo_signature_verification(cose_sig_structure,
+	// A to1d reused from a previous TO2 attempt is verified once per Owner key.
+	if (ps->to1d_cose && ps->to1d_owner_key &&
+	    fdo_compare_public_keys(ps->to1d_owner_key, ps->owner_public_key)) {
+		LOG(LOG_DEBUG, "TO2.ProveOVHdr: to1d signature verified by a previous attempt\n");
+	} else if (ps->to1d_cose) {
+		if (!fdo_cose_verify_signature(ps->to1d_cose->cose_ph,
+					ps->to1d_cose->cose_payload, NULL,
 					ps->to1d_cose->cose_signature,
 					ps->owner_public_key)) {
 			LOG(LOG_ERROR, "TO2.ProveOVHdr: COSE signature verification failed\n");
 			goto err;
 		}
 		LOG(LOG_DEBUG, "TO2.ProveOVHdr: to1d signature verification successful\n");
+		if (ps->to1d_owner_key) {
+			fdo_public_key_free(ps->to1d_owner_key);
+		}
+		ps->to1d_owner_key = fdo_public_key_clone(ps->owner_public_key);
 	}
 
 	// clear the FDOR buffer and push COSE payload into it, essentially reusing the FDOR object.
@@ -165,25 +160,14 @@ int32_t msg61(fdo_prot_t *ps)
 		goto err;
 	}
 
-	// Read the bin character length
-	if (!fdor_string_length(&ps->fdor, &ovheader_sz) || ovheader_sz == 0) {
-		LOG(LOG_ERROR, "TO2.ProveOVHdr: Unable to decode length of ProveOVHdr!\n");
-		goto err;
-	}
-
-	// bstr-unwrap OVHeader
-	ovheader = fdo_byte_array_alloc(ovheader_sz);
-	if (!ovheader) {
-		LOG(LOG_ERROR, "TO2.ProveOVHdr: Failed to alloc for OVHeader as bstr\n");
-		goto err;
-	}
-	if (!fdor_byte_string(&ps->fdor, ovheader->bytes, ovheader->byte_sz)) {
+	// bstr-unwrap OVHeader, leaving it in the FDOR buffer until the end of this message
+	if (!fdo_byte_view_read(&ps->fdor, &ovheader) || ovheader.byte_sz == 0) {
 		LOG(LOG_ERROR, "TO2.ProveOVHdr: Failed to read OVHeader as bstr\n");
 		goto err;
 	}
 
-	// Read the OVHeader
-	ps->ovoucher = fdo_ov_hdr_read(ovheader, &ps->new_ov_hdr_hmac);
+	// Read the OVHeader. OVRVInfo is not needed in TO2, and is covered by the HMac.
+	ps->ovoucher = fdo_ov_hdr_read(&ovheader, &ps->new_ov_hdr_hmac, false);
 	if (!ps->ovoucher) {
 		LOG(LOG_ERROR, "TO2.ProveOVHdr: Failed to read OVHeader\n");
 		goto err;
@@ -221,6 +205,11 @@ int32_t msg61(fdo_prot_t *ps)
 		goto err;
 	}
 
+	// keep the encoded HMac in place for OVEHashPrevEntry
+	if (!fdor_item_view(&ps->fdor, &hmac.bytes, &hmac.byte_sz)) {
+		LOG(LOG_ERROR, "TO2.ProveOVHdr: Failed to read HMac\n");
+		goto err;
+	}
 	ps->ovoucher->ovoucher_hdr_hash = fdo_hash_alloc_empty();
 	if (!ps->ovoucher->ovoucher_hdr_hash) {
 		LOG(LOG_ERROR, "TO2.ProveOVHdr: Failed to alloc HMac\n");
@@ -349,19 +338,15 @@ int32_t msg61(fdo_prot_t *ps)
 		LOG(LOG_ERROR, "TO2.ProveOVHdr: Failed to save OVEHashHdrInfo\n");
 		goto err;
 	}
-	// reset the FDOW block to prepare for OVEHashPrevEntry
-	fdo_block_reset(&ps->fdow.b);
-	ps->fdow.b.block_size = ps->prot_buff_sz;
-	if (!fdow_encoder_init(&ps->fdow)) {
-		LOG(LOG_ERROR, "TO2.ProveOVHdr: Failed to initilize FDOW encoder\n");
-		goto err;
-	}
-	if (!fdo_ove_hash_prev_entry_save(&ps->fdow, ps->ovoucher, ps->ovoucher->ovoucher_hdr_hash)) {
+	if (!fdo_ove_hash_prev_entry_save(&ovheader, &hmac, ps->ovoucher)) {
 		LOG(LOG_ERROR, "TO2.ProveOVHdr: Failed to save OVEHashPrevEntry\n");
 		goto err;
 	}
 	// To verify the next entry in the ownership voucher
 	ps->ovoucher->ov_entries->pk = fdo_public_key_clone(ps->ovoucher->mfg_pub_key);
+	// OVEntries of the same voucher verified by a previous attempt are not verified again
+	fdo_prot_ov_checkpoint_start(ps, ps->ovoucher->ov_entries->hp_hash,
+				     ps->ovoucher->num_ov_entries);
 
 	/*
 	 * If the TO2.ProveOVHdr.TO2ProveOVHdrPayload.NumOVEntries > 0,
@@ -389,10 +374,6 @@ err:
 		fdo_cose_free(cose);
 		cose = NULL;
 	}
-	if (cose_sig_structure) {
-		fdo_byte_array_free(cose_sig_structure);
-		cose_sig_structure = NULL;
-	}
 	if (ps->nonce_to2proveov_rcv != NULL) {
 		fdo_byte_array_free(ps->nonce_to2proveov_rcv);
 		ps->nonce_to2proveov_rcv = NULL;
@@ -405,9 +386,5 @@ err:
 		fdo_hash_free(hello_device_hash_rcv);
 		hello_device_hash_rcv = NULL;
 	}
-	if (ovheader) {
-		fdo_byte_array_free(ovheader);
-		ovheader = NULL;
-	}
 	return ret;
 }
@@ -45,13 +45,11 @@ int32_t msg63(fdo_prot_t *ps)
 	fdo_hash_t *current_hp_hash = NULL;
 	fdo_hash_t *temp_hash_hp;
 	fdo_hash_t *temp_hash_hc;
-	fdo_byte_array_t *temp_ove_extra = NULL;
-	size_t ove_extra_len = 0;
+	fdo_byte_view_t ove_extra = {0};
 	fdo_public_key_t *temp_pk;
 	int entry_num;
 	fdo_cose_t *cose = NULL;
-	fdo_byte_array_t *cose_encoded = NULL;
-	fdo_byte_array_t *cose_sig_structure = NULL;
+	fdo_byte_view_t cose_encoded = {0};
 
 	if (!ps) {
 		LOG(LOG_ERROR, "Invalid protocol state\n");
@@ -96,6 +94,12 @@ int32_t msg63(fdo_prot_t *ps)
 		goto err;
 	}
 
+	// keep the encoded COSE in place, OVEHashPrevEntry is calculated over it
+	if (!fdor_item_view(&ps->fdor, &cose_encoded.bytes, &cose_encoded.byte_sz)) {
+		LOG(LOG_ERROR, "TO2.OVNextEntry: Failed to read COSE\n");
+		goto err;
+	}
+
 	if (!fdo_cose_read(&ps->fdor, cose, true)) {
 		LOG(LOG_ERROR, "TO2.OVNextEntry: Failed to read COSE\n");
 		goto err;
@@ -106,42 +110,35 @@ int32_t msg63(fdo_prot_t *ps)
 		goto err;
 	}
 
-	if (!fdo_cose_write_sigstructure(cose->cose_ph, cose->cose_payload, NULL,
-		&cose_sig_structure) || !cose_sig_structure) {
-		LOG(LOG_ERROR, "TO2.OVNextEntry: Failed to write COSE Sig_structure\n");
+	// Hash the received COSE now, before the FDOR buffer is reused below.
+	// It identifies the OVEntry in the checkpoint, and becomes the
+	// OVEHashPrevEntry for the next OVEntry once this one is verified.
+	current_hp_hash =
+	    fdo_hash_alloc(FDO_CRYPTO_HASH_TYPE_USED, FDO_SHA_DIGEST_SIZE_USED);
+	if (!current_hp_hash) {
+		LOG(LOG_ERROR, "TO2.OVNextEntry: Failed to alloc current OVEntry hash!\n");
 		goto err;
 	}
-	// verify the received COSE signature
-	if (!fdo_signature_verification(cose_sig_structure,
-					cose->cose_signature,
-					ps->ovoucher->ov_entries->pk)) {
-		LOG(LOG_ERROR, "TO2.OVNextEntry: Failed to verify OVEntry signature\n");
+	if (0 != fdo_crypto_hash(cose_encoded.bytes, cose_encoded.byte_sz,
+				 current_hp_hash->hash->bytes,
+				 current_hp_hash->hash->byte_sz)) {
+		LOG(LOG_ERROR, "TO2.OVNextEntry: Failed to generate current OVEntry hash!\n");
 		goto err;
 	}
-	LOG(LOG_DEBUG, "TO2.OVNextEntry: OVEntry Signature verification successful\n");
 
-	// Generate COSE as CBOR bytes again that is used to calculate OVEHashPrevEntry.
-	if (!fdo_cose_write(&ps->fdow, cose)) {
-		LOG(LOG_ERROR, "TO2.OVNextEntry: Failed to write COSE for OVEHashPrevEntry\n");
-		goto err;
-	}
-	// Get encoded COSE and copy
-	if (!fdow_encoded_length(&ps->fdow, &ps->fdow.b.block_size)) {
-		LOG(LOG_ERROR,
-			"TO2.OVNextEntry: Failed to get encoded COSE length for OVEHashPrevEntry\n");
-		goto err;
-	}
-	cose_encoded = fdo_byte_array_alloc(ps->fdow.b.block_size);
-	if (!cose_encoded) {
-		LOG(LOG_ERROR,
-			"TO2.OVNextEntry: Failed to alloc encoded COSE for OVEHashPrevEntry\n");
-		goto err;
-	}
-	if (0 != memcpy_s(cose_encoded->bytes, cose_encoded->byte_sz,
-		ps->fdow.b.block, ps->fdow.b.block_size)) {
-		LOG(LOG_ERROR,
-			"TO2.OVNextEntry: Failed to copy encoded COSE for OVEHashPrevEntry\n");
+	// verify the received COSE signature, unless a previous TO2 attempt
+	// verified this very OVEntry at this position in the same chain
+	if (fdo_prot_ov_checkpoint_verified(ps, entry_num,
+					    ps->ovoucher->ov_entries->hp_hash,
+					    current_hp_hash)) {
+		LOG(LOG_DEBUG, "TO2.OVNextEntry: OVEntry Signature verified by a previous attempt\n");
+	} else if (!fdo_cose_verify_signature(cose->cose_ph, cose->cose_payload,
+					       NULL, cose->cose_signature,
+					       ps->ovoucher->ov_entries->pk)) {
+		LOG(LOG_ERROR, "TO2.OVNextEntry: Failed to verify OVEntry signature\n");
 		goto err;
+	} else {
+		LOG(LOG_DEBUG, "TO2.OVNextEntry: OVEntry Signature verification successful\n");
 	}
 
 	// clear the FDOR buffer and copy COSE payload into it,
@@ -214,17 +211,8 @@ int32_t msg63(fdo_prot_t *ps)
 			goto err;
 		}
 	} else {
-		// Read the bin character length
-		if (!fdor_string_length(&ps->fdor, &ove_extra_len) || ove_extra_len == 0) {
-			LOG(LOG_DEBUG, "TO2.OVNextEntry: Unable to decode length of OVEExtra!\n");
-			goto err;
-		}
-		temp_ove_extra = fdo_byte_array_alloc(ove_extra_len);
-		if (!temp_ove_extra) {
-			LOG(LOG_ERROR, "TO2.OVNextEntry: Failed to alloc for OVEExtra as bstr\n");
-			goto err;
-		}
-		if (!fdor_byte_string(&ps->fdor, temp_ove_extra->bytes, temp_ove_extra->byte_sz)) {
+		// OVEExtra is not used by the device, so it is only validated and skipped
+		if (!fdo_byte_view_read(&ps->fdor, &ove_extra) || ove_extra.byte_sz == 0) {
 			LOG(LOG_ERROR, "TO2.OVNextEntry: Failed to read OVEExtra as bstr\n");
 			goto err;
 		}
@@ -251,7 +239,6 @@ int32_t msg63(fdo_prot_t *ps)
 	temp_entry->enn = entry_num;
 	temp_entry->hp_hash = temp_hash_hp;
 	temp_entry->hc_hash = temp_hash_hc;
-	temp_entry->ove_extra = temp_ove_extra;
 	temp_entry->pk = temp_pk;
 
 	// Compare OVEHashPrevEntry (msg61 data) with the OVEHashPrevEntry from this message
@@ -278,24 +265,15 @@ int32_t msg63(fdo_prot_t *ps)
 		goto err;
 	}
 
-	// OVEHashPrevEntry needs to be updated with current OVEntry's hash
-	current_hp_hash =
-	    fdo_hash_alloc(FDO_CRYPTO_HASH_TYPE_USED, FDO_SHA_DIGEST_SIZE_USED);
-	if (!current_hp_hash) {
-		LOG(LOG_ERROR, "TO2.OVNextEntry: Failed to alloc current OVEntry hash!\n");
-		goto err;
-	}
+	fdo_prot_ov_checkpoint_add(ps, entry_num,
+				   ps->ovoucher->ov_entries->hp_hash,
+				   current_hp_hash);
 
-	if (0 != fdo_crypto_hash(cose_encoded->bytes, cose_encoded->byte_sz,
-				 current_hp_hash->hash->bytes,
-				 current_hp_hash->hash->byte_sz)) {
-		fdo_hash_free(current_hp_hash);
-		LOG(LOG_ERROR, "TO2.OVNextEntry: Failed to generate current OVEntry hash!\n");
-		goto err;
-	}
+	// OVEHashPrevEntry needs to be updated with current OVEntry's hash.
 	// free the previous hash and push the new one.
 	fdo_hash_free(ps->ovoucher->ov_entries->hp_hash);
 	ps->ovoucher->ov_entries->hp_hash = current_hp_hash;
+	current_hp_hash = NULL;
 
 	// replace the previous OVEPubKey with the OVEPubKey from this msg data
 	fdo_public_key_free(ps->ovoucher->ov_entries->pk);
@@ -312,13 +290,6 @@ int32_t msg63(fdo_prot_t *ps)
 	ps->ov_entry_num++;
 	if (ps->ov_entry_num < ps->ovoucher->num_ov_entries) {
 		ps->state = FDO_STATE_TO2_SND_GET_OP_NEXT_ENTRY;
-		// reset FDOW because it was used in this method, out of place
-		fdo_block_reset(&ps->fdow.b);
-		ps->fdor.b.block_size = ps->prot_buff_sz;
-		if (!fdow_encoder_init(&ps->fdow)) {
-			LOG(LOG_ERROR, "TO2.OVNextEntry: Failed to initialize FDOW encoder\n");
-			goto err;
-		}
 	} else {
 		LOG(LOG_DEBUG,
 		    "TO2.OVNextEntry: All %d OVEntry(s) have been "
@@ -344,17 +315,10 @@ err:
 		if (temp_entry->hc_hash) {
 			fdo_hash_free(temp_entry->hc_hash);
 		}
-		if (temp_ove_extra) {
-			fdo_byte_array_free(temp_ove_extra);
-		}
 		fdo_free(temp_entry);
 	}
-	if (cose_encoded) {
-		fdo_byte_array_free(cose_encoded);
-	}
-	if (cose_sig_structure) {
-		fdo_byte_array_free(cose_sig_structure);
-		cose_sig_structure = NULL;
+	if (current_hp_hash) {
+		fdo_hash_free(current_hp_hash);
 	}
 	return ret;
 }
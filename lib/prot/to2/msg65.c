@@ -36,7 +36,6 @@ int32_t msg65(fdo_prot_t *ps)
 	char prot[] = "FDOProtTO2";
 	fdo_encrypted_packet_t *pkt = NULL;
 	fdo_cose_t *cose = NULL;
-	fdo_byte_array_t *cose_sig_structure = NULL;
 
 	if (!ps) {
 		LOG(LOG_ERROR, "Invalid protocol state\n");
@@ -61,7 +60,7 @@ int32_t msg65(fdo_prot_t *ps)
 		goto err;
 	}
 
-	if (!fdo_encrypted_packet_unwind(&ps->fdor, pkt)) {
+	if (!fdo_encrypted_packet_unwind(&ps->fdor, pkt, ps->prot_buff_sz)) {
 		LOG(LOG_ERROR, "TO2.SetupDevice: Failed to decrypt packet!\n");
 		goto err;
 	}
@@ -170,14 +169,8 @@ int32_t msg65(fdo_prot_t *ps)
 		goto err;
 	}
 
-	if (!fdo_cose_write_sigstructure(cose->cose_ph, cose->cose_payload, NULL,
-		&cose_sig_structure) || !cose_sig_structure) {
-		LOG(LOG_ERROR, "TO2.SetupDevice: Failed to write COSE Sig_structure\n");
-		goto err;
-	}
-
 	// verify the received COSE signature
-	if (!fdo_signature_verification(cose_sig_structure,
+	if (!fdo_cose_verify_signature(cose->cose_ph, cose->cose_payload, NULL,
 					cose->cose_signature,
 					ps->osc->pubkey)) {
 		LOG(LOG_ERROR, "TO2.SetupDevice: Failed to verify OVEntry signature\n");
@@ -197,9 +190,5 @@ err:
 		fdo_cose_free(cose);
 		cose = NULL;
 	}
-	if (cose_sig_structure) {
-		fdo_byte_array_free(cose_sig_structure);
-		cose_sig_structure = NULL;
-	}
 	return ret;
 }
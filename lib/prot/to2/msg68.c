@@ -39,7 +39,6 @@ int32_t msg68(fdo_prot_t *ps)
 	fdo_service_info_t *serviceinfo_itr = NULL;
 	fdo_sv_invalid_modnames_t *serviceinfo_invalid_modnames_it = NULL;
 	char sv_modname_key[FDO_MODULE_NAME_LEN + FDO_MODULE_MSG_LEN + 1] = "";
-	size_t serviceinfo_invalid_modnames_count = 0;
 	// Pointer to hold the external module reference. No memory is allocated, thus never freed.
 	fdo_sdk_service_info_module *ext_module = NULL;
 	bool module_write_done = false;
@@ -106,9 +105,7 @@ int32_t msg68(fdo_prot_t *ps)
 					goto err;
 				}
 				serviceinfo_invalid_modnames_it = serviceinfo_invalid_modnames_it->next;
-				serviceinfo_invalid_modnames_count++;
 			}
-			ps->service_info->numKV = serviceinfo_invalid_modnames_count;
 
 			// clear it here immediately, so we don't use it back
 			fdo_serviceinfo_invalid_modname_free(ps->serviceinfo_invalid_modnames);
@@ -139,12 +136,11 @@ int32_t msg68(fdo_prot_t *ps)
 
 			// Try to fit in MTU for either (1) or (2), at any given time.
 			// The splitting is done by considering an additional margin for CBOR encoding.
-			// The data is CBOR encoded twice. First time to find the what can be fit, and
-			// and second time to actually transmit the ServiceInfo.
-			// This is done in this way, since the underlying
-			// TinyCBOR library doesn't allow us to change the total number of entries
-			// in an array (ServiceInfoKeyVal, in this case), once it's set.
-			if (!fdo_serviceinfo_fit_mtu(&ps->fdow, ps->service_info,
+			// What fits is computed from the encoded lengths before anything is encoded,
+			// since the underlying TinyCBOR library doesn't allow us to change the total
+			// number of entries in an array (ServiceInfoKeyVal, in this case), once it's set.
+			// A value that does not fit is continued in the next message.
+			if (!fdo_serviceinfo_fit_mtu(ps->service_info,
 				ps->maxDeviceServiceInfoSz - SERVICEINFO_MTU_FIT_MARGIN)) {
 				LOG(LOG_ERROR, "TO2.DeviceServiceInfo: Failed to fit within MTU\n");
 				goto err;
@@ -153,7 +149,7 @@ int32_t msg68(fdo_prot_t *ps)
 			if (ps->service_info->sv_index_end == ps->service_info->numKV &&
 				ps->service_info->sv_val_index == 0) {
 				ps->device_serviceinfo_ismore = false;
-			} else if (ps->service_info->sv_index_end < ps->service_info->numKV) {
+			} else if (ps->service_info->sv_index_end <= ps->service_info->numKV) {
 				ps->device_serviceinfo_ismore = true;
 			} else {
 				LOG(LOG_ERROR, "TO2.DeviceServiceInfo: Invalid state reached while processing "
@@ -161,7 +157,7 @@ int32_t msg68(fdo_prot_t *ps)
 				goto err;
 			}
 
-			// reset FDOW because it was used in this method, out of place
+			// reset FDOW before writing the message
 			fdo_block_reset(&ps->fdow.b);
 			ps->fdor.b.block_size = ps->prot_buff_sz;
 			if (!fdow_encoder_init(&ps->fdow)) {
@@ -196,8 +192,11 @@ int32_t msg68(fdo_prot_t *ps)
 			serviceinfo_itr = NULL;
 			// there is nothing to send, so clear it immediately
 			// so that we don't use it in the next iteration
+			// 'devmod' is kept by the caller, and sent again on a TO2 retry
 			if (!ps->device_serviceinfo_ismore) {
-				fdo_service_info_free(ps->service_info);
+				if (ps->service_info != ps->devmod_info) {
+					fdo_service_info_free(ps->service_info);
+				}
 				ps->service_info = NULL;
 			}
 			// if we reach here, ServiceInfo write has been done
@@ -63,7 +63,7 @@ int32_t msg69(fdo_prot_t *ps)
 		LOG(LOG_ERROR, "TO2.OwnerServiceInfo: Failed to parse encrypted packet\n");
 		goto err;
 	}
-	if (!fdo_encrypted_packet_unwind(&ps->fdor, pkt)) {
+	if (!fdo_encrypted_packet_unwind(&ps->fdor, pkt, ps->prot_buff_sz)) {
 		LOG(LOG_ERROR, "TO2.OwnerServiceInfo: Failed to decrypt packet!\n");
 		goto err;
 	}
@@ -79,12 +79,6 @@ int32_t msg70(fdo_prot_t *ps)
 	LOG(LOG_DEBUG, "(New) GUID after TO2: %s\n",
 		fdo_guid_to_string(ps->dev_cred->owner_blk->guid, guid_buf, sizeof(guid_buf)));
 
-	/* Rotate Data Protection Key */
-	if (0 != fdo_generate_storage_hmac_key()) {
-		LOG(LOG_ERROR, "TO2.Done: Failed to rotate data protection key.\n");
-	}
-	LOG(LOG_DEBUG, "TO2.Done: Data protection key rotated successfully!!\n");
-
 	if (!ps->reuse_enabled) {
 		/* Commit the replacement hmac key only if reuse was not triggered*/
 		if (fdo_commit_ov_replacement_hmac_key() != 0) {
@@ -96,13 +90,13 @@ int32_t msg70(fdo_prot_t *ps)
 		LOG(LOG_DEBUG, "TO2.Done: Device hmac key is unchanged as reuse was triggered.\n");
 	}
 
-	/* Write new device credentials and state*/
-	if (!store_device_status(&ps->dev_cred->ST)) {
-		LOG(LOG_ERROR, "TO2.Done: Failed to store updated device status\n");
-		goto err;
-	}
-
-	if (store_credential(ps->dev_cred) != 0) {
+	/*
+	 * Write new device credentials and state, the secret only if it was
+	 * replaced, sealed with a rotated Data Protection Key
+	 */
+	if (store_credentials(ps->dev_cred,
+			      FDO_CRED_STORE_ROTATE_KEY |
+				  (ps->reuse_enabled ? 0 : FDO_CRED_STORE_SECRET)) != 0) {
 		LOG(LOG_ERROR, "TO2.Done: Failed to store new device creds\n");
 		goto err;
 	}
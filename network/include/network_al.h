@@ -70,6 +70,35 @@ fdo_con_handle fdo_con_connect(fdo_ip_address_t *addr, uint16_t port,
  */
 int32_t fdo_con_disconnect(fdo_con_handle handle, bool tls);
 
+/*
+ * Set the time budget of each network operation. Sockets are non-blocking
+ * and every connect, send or receive fails once its deadline expires.
+ *
+ * @param[in] timeout_ms: time budget in milliseconds, MAX_TIME_OUT if <= 0.
+ */
+void fdo_con_set_timeout(long timeout_ms);
+
+/*
+ * Get the pollable file descriptor backing a connection, for integration
+ * with an external event loop.
+ *
+ * @param[in] handle: connection handler (for ex: socket-id)
+ * @retval -1 on failure, file descriptor on success.
+ */
+int fdo_con_get_fd(fdo_con_handle handle);
+
+/*
+ * Wait up to timeout_ms for the response to a message sent with
+ * fdo_con_send_message() to start arriving, so that a caller can interleave
+ * other work instead of blocking in fdo_con_recv_msg_header().
+ *
+ * @param[in] handle: connection handler (for ex: socket-id)
+ * @param[in] timeout_ms: longest wait in milliseconds, 0 to only check.
+ * @retval 1 if the response can be read, 0 if not yet, -1 on failure or
+ * once the time budget of the receive (see fdo_con_set_timeout()) expired.
+ */
+int32_t fdo_con_wait_recv(fdo_con_handle handle, uint32_t timeout_ms);
+
 /*
  * Receive(read) length of incoming fdo packet.
  *
@@ -78,8 +107,9 @@ int32_t fdo_con_disconnect(fdo_con_handle handle, bool tls);
  * @param[out] message_type: message type of incoming FDO message.
  * @param[out] msglen: length of incoming message.
  * @param[in] tls: flag describing whether HTTP (false) or HTTPS (true) is
- * @param[out] curl_buf: data buffer to read into msg received by curl.
- * @param[out] curl_buf_offset: pointer to track curl_buf.
+ * @param[out] curl_buf: buffer of REST_MAX_MSGHDR_SIZE bytes to read the
+ * header into, along with the start of the body if it comes with it.
+ * @param[out] curl_buf_offset: offset of the body in curl_buf.
  * @retval -1 on failure, 0 on success.
  */
 int32_t fdo_con_recv_msg_header(fdo_con_handle handle,
@@ -94,9 +124,10 @@ int32_t fdo_con_recv_msg_header(fdo_con_handle handle,
  * @param[out] buf: data buffer to read into.
  * @param[in] length: Number of received bytes to be read.
  * @param[in] tls: flag describing whether HTTP (false) or HTTPS (true) is
- * @param[in] curl_buf: data buffer to read into msg received by curl.
- * @param[in] curl_buf_offset: pointer to track curl_buf.
- * @retval -1 on failure, 0 on success.
+ * @param[in] curl_buf: buffer filled by fdo_con_recv_msg_header(), the
+ * body bytes in it are copied first, the rest is read straight into buf.
+ * @param[in] curl_buf_offset: offset of the body in curl_buf.
+ * @retval -1 on failure, number of bytes read on success.
  */
 int32_t fdo_con_recv_msg_body(fdo_con_handle handle, uint8_t *buf,
 			      size_t length, bool tls, char *curl_buf,
@@ -128,6 +159,9 @@ int32_t fdo_con_teardown(void);
 // FIXME: we might have to find a suitable place for this API
 void fdo_sleep(int sec);
 
+/* monotonic time in milliseconds, for measuring intervals */
+uint64_t fdo_time_ms(void);
+
 /* Convert from Network to Host byte order */
 uint32_t fdo_net_to_host_long(uint32_t value);
 
@@ -35,6 +35,7 @@ void mos_socket_close(fdo_con_handle *socket);
 int mos_socket_send(fdo_con_handle *socket, void *buf, size_t len, int flags);
 int mos_socket_recv(fdo_con_handle *socket, void *buf, size_t len, int flags);
 fdo_con_handle get_ssl_socket(void);
+void mos_set_timeout(int timeout_ms);
 
 #define MBED_SOCKET_TIMEOUT 10000
 #ifdef __cplusplus
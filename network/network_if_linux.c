@@ -16,6 +16,9 @@
 #include <stdlib.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/epoll.h>
+#include <errno.h>
+#include <time.h>
 #include <netdb.h> //hostent
 #include <arpa/inet.h>
 
@@ -28,60 +31,286 @@
 #include "snprintf_s.h"
 #include "rest_interface.h"
 
+struct fdo_sock_handle {
+	int sockfd;
+	int epfd;
+	size_t rx_len; // bytes of the receive buffer read along with the header
+	uint64_t rx_deadline; // end of the wait for the response, 0 if none
+};
+
+/* Per-operation time budget, see fdo_con_set_timeout() */
+static long con_timeout_ms = MAX_TIME_OUT;
+
+/**
+ * Return the current monotonic time in milliseconds.
+ */
+static uint64_t con_now_ms(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+		return 0;
+	}
+	return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/**
+ * Compute the absolute deadline for a network operation starting now.
+ */
+static uint64_t con_deadline(void)
+{
+	return con_now_ms() + (uint64_t)con_timeout_ms;
+}
+
 /**
- * Auxiliary function that waits on the socket while receiving data from connected socket.
+ * Auxiliary function that waits on the socket until it becomes readable
+ * (or writable) or the operation deadline expires.
  *
- * @param sockfd - socket struct for read.
- * @param for_recv -  bit for receive (1 or 0)
- * @param timeout_ms - timeout in milliseconds.
- * @retval returns the number of signalled sockets or -1.
+ * The epoll instance is created on first use and kept for the lifetime of
+ * the connection, so a connection that never has to wait never pays for it.
+ *
+ * @param sock_hdl - connection handle to wait on.
+ * @param for_recv - true to wait for readability, false for writability.
+ * @param deadline - absolute deadline in milliseconds (see con_deadline()).
+ * @retval 1 if the socket is ready, 0 on timeout, -1 on error.
  */
-static int wait_on_socket(curl_socket_t sockfd, int for_recv, long timeout_ms)
+static int wait_on_socket(struct fdo_sock_handle *sock_hdl, bool for_recv,
+			  uint64_t deadline)
 {
-	struct timeval tv;
-	fd_set infd, outfd, errfd;
+	struct epoll_event ev;
+	uint64_t now;
 	int res;
 
-	tv.tv_sec = timeout_ms / 1000;
-	tv.tv_usec = (timeout_ms % 1000) * 1000;
+	if (memset_s(&ev, sizeof(ev), 0) != 0) {
+		LOG(LOG_ERROR, "Memset failed\n");
+		return -1;
+	}
+	ev.events = for_recv ? EPOLLIN : EPOLLOUT;
+	ev.data.fd = sock_hdl->sockfd;
+
+	if (sock_hdl->epfd < 0) {
+		sock_hdl->epfd = epoll_create1(EPOLL_CLOEXEC);
+		if (sock_hdl->epfd < 0) {
+			LOG(LOG_ERROR, "epoll_create1() failed, errno=%d\n",
+			    errno);
+			return -1;
+		}
+		res = epoll_ctl(sock_hdl->epfd, EPOLL_CTL_ADD,
+				sock_hdl->sockfd, &ev);
+	} else {
+		res = epoll_ctl(sock_hdl->epfd, EPOLL_CTL_MOD,
+				sock_hdl->sockfd, &ev);
+	}
+	if (res != 0) {
+		LOG(LOG_ERROR, "epoll_ctl() failed, errno=%d\n", errno);
+		return -1;
+	}
 
-	FD_ZERO(&infd);
-	FD_ZERO(&outfd);
-	FD_ZERO(&errfd);
+	for (;;) {
+		now = con_now_ms();
+		if (now >= deadline) {
+			return 0;
+		}
+		res = epoll_wait(sock_hdl->epfd, &ev, 1,
+				 (int)(deadline - now));
+		if (res < 0 && errno == EINTR) {
+			continue;
+		}
+		/* EPOLLERR/EPOLLHUP are reported as ready, the following
+		 * send()/recv() surfaces the actual error */
+		return res;
+	}
+}
 
-	FD_SET(sockfd, &errfd); /* always check for error */
+/**
+ * Receive whatever is available, up to 'length' bytes, either through curl
+ * (TLS) or directly on the (non-blocking) plain socket, waiting until some
+ * data arrives.
+ *
+ * @param sock_hdl - connection handle to read from.
+ * @param buf - data buffer to read into.
+ * @param length - size of buf.
+ * @param tls - flag describing whether HTTP (false) or HTTPS (true) is used.
+ * @param deadline - absolute deadline in milliseconds.
+ * @retval number of bytes read, 0 if the peer closed the connection,
+ * -1 on failure or timeout.
+ */
+static ssize_t sock_recv_some(struct fdo_sock_handle *sock_hdl, uint8_t *buf,
+			      size_t length, bool tls, uint64_t deadline)
+{
+	ssize_t n;
+	size_t nread;
+	CURLcode res;
 
-	if (for_recv) {
-		FD_SET(sockfd, &infd);
-	} else {
-		FD_SET(sockfd, &outfd);
+	for (;;) {
+		if (tls) {
+			nread = 0;
+			res = curl_easy_recv(curl, buf, length, &nread);
+			if (res == CURLE_OK) {
+				return (ssize_t)nread;
+			}
+			if (res != CURLE_AGAIN) {
+				LOG(LOG_ERROR, "Error: %s\n",
+				    curl_easy_strerror(res));
+				return -1;
+			}
+		} else {
+			n = recv(sock_hdl->sockfd, buf, length, 0);
+			if (n >= 0) {
+				return n;
+			}
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				LOG(LOG_ERROR,
+				    "Socket Read Failed, ret=%zd, "
+				    "errno=%d, %d\n",
+				    n, errno, __LINE__);
+				return -1;
+			}
+		}
+
+		if (wait_on_socket(sock_hdl, true, deadline) <= 0) {
+			LOG(LOG_ERROR, "Socket Read timed out\n");
+			return -1;
+		}
 	}
+}
 
-	/* select() returns the number of signalled sockets or -1 */
-	res = select((int)sockfd + 1, &infd, &outfd, &errfd, &tv);
-	return res;
+/**
+ * Receive exactly 'length' bytes over the connection.
+ *
+ * @param sock_hdl - connection handle to read from.
+ * @param buf - data buffer to read into.
+ * @param length - number of bytes to read.
+ * @param tls - flag describing whether HTTP (false) or HTTPS (true) is used.
+ * @param deadline - absolute deadline in milliseconds.
+ * @retval number of bytes read on success, -1 on failure or timeout.
+ */
+static ssize_t sock_recv_all(struct fdo_sock_handle *sock_hdl, uint8_t *buf,
+			     size_t length, bool tls, uint64_t deadline)
+{
+	size_t total = 0;
+	ssize_t n;
+
+	while (total < length) {
+		n = sock_recv_some(sock_hdl, buf + total, length - total, tls,
+				   deadline);
+		if (n <= 0) {
+			if (n == 0) {
+				LOG(LOG_ERROR, "Connection closed by peer\n");
+			}
+			return -1;
+		}
+		total += (size_t)n;
+	}
+	return (ssize_t)total;
 }
-struct fdo_sock_handle {
-	int sockfd;
-};
+
+/**
+ * Send all of 'length' bytes over the connection, either through curl (TLS)
+ * or directly on the (non-blocking) plain socket.
+ *
+ * @param sock_hdl - connection handle to write to.
+ * @param buf - data buffer to write from.
+ * @param length - number of bytes to write.
+ * @param tls - flag describing whether HTTP (false) or HTTPS (true) is used.
+ * @param deadline - absolute deadline in milliseconds.
+ * @retval number of bytes written on success, -1 on failure or timeout.
+ */
+static ssize_t sock_send_all(struct fdo_sock_handle *sock_hdl,
+			     const uint8_t *buf, size_t length, bool tls,
+			     uint64_t deadline)
+{
+	size_t total = 0;
+	ssize_t n;
+	size_t nsent;
+	CURLcode res;
+
+	while (total < length) {
+		if (tls) {
+			nsent = 0;
+			res = curl_easy_send(curl, buf + total, length - total,
+					     &nsent);
+			total += nsent;
+			if (res == CURLE_OK) {
+				continue;
+			}
+			if (res != CURLE_AGAIN) {
+				LOG(LOG_ERROR, "Error: %s\n",
+				    curl_easy_strerror(res));
+				return -1;
+			}
+		} else {
+			n = send(sock_hdl->sockfd, buf + total, length - total,
+				 MSG_NOSIGNAL);
+			if (n > 0) {
+				total += (size_t)n;
+				continue;
+			}
+			if (n < 0 && errno == EINTR) {
+				continue;
+			}
+			if (n == 0 ||
+			    (errno != EAGAIN && errno != EWOULDBLOCK)) {
+				LOG(LOG_ERROR,
+				    "Socket write Failed, ret=%zd, "
+				    "errno=%d, %d\n",
+				    n, errno, __LINE__);
+				return -1;
+			}
+		}
+
+		if (wait_on_socket(sock_hdl, false, deadline) <= 0) {
+			LOG(LOG_ERROR, "Error: timeout.\n");
+			return -1;
+		}
+	}
+	return (ssize_t)total;
+}
+
 /**
- * Read from socket until new-line is encountered.
+ * Find the end of the REST header, i.e. the empty line that separates it
+ * from the body.
  *
- * @param handle - socket struct for read.
+ * @param buf - data received so far.
+ * @param len - number of bytes in buf.
+ * @retval offset of the body in buf, 0 if the header isn't complete yet.
+ */
+static size_t con_header_end(const char *buf, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i + 1 < len; i++) {
+		if (buf[i] != '\n') {
+			continue;
+		}
+		if (buf[i + 1] == '\n') {
+			return i + 2;
+		}
+		if (buf[i + 1] == '\r' && i + 2 < len && buf[i + 2] == '\n') {
+			return i + 3;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Read a line of the received REST header, up to the new-line.
+ *
+ * @param buf - received REST header.
+ * @param len - number of bytes in buf.
+ * @param offset - in/out offset of the line in buf.
  * @param out -  out pointer for REST header line.
  * @param size - out REST header line length.
- * @param tls: flag describing whether HTTP (false) or HTTPS (true) is
- * @param curl_buf: data buffer to read into msg received by curl.
- * @param curl_buf_offset: pointer to track curl_buf.
  * @retval true if line read was successful, false otherwise.
  */
-static bool read_until_new_line(fdo_con_handle handle, char *out, size_t size,
-				bool tls, char *curl_buf, size_t *curl_buf_offset)
+static bool read_until_new_line(const char *buf, size_t len, size_t *offset,
+				char *out, size_t size)
 {
-	size_t sz, n;
+	size_t sz;
 	char c;
-	struct fdo_sock_handle *sock_hdl = handle;
-	int sockfd = sock_hdl->sockfd;
 
 	if (!out || !size) {
 		return false;
@@ -91,21 +320,11 @@ static bool read_until_new_line(fdo_con_handle handle, char *out, size_t size,
 	sz = 0;
 
 	for (;;) {
-
-		if (tls) {
-			c = curl_buf[*curl_buf_offset + sz];
-			n = 1;
-		} else {
-			n = recv(sockfd, (uint8_t *)&c, 1, MSG_WAITALL);
-		}
-
-		if (n <= 0) {
-			LOG(LOG_ERROR,
-			    "Socket Read Failed, ret=%zu, "
-			    "errno=%d, %d\n",
-			    n, errno, __LINE__);
+		if (*offset + sz >= len) {
+			LOG(LOG_ERROR, "No new-line in REST header\n");
 			return false;
 		}
+		c = buf[*offset + sz];
 		if (sz < size) {
 			out[sz++] = c;
 		} else {
@@ -116,9 +335,7 @@ static bool read_until_new_line(fdo_con_handle handle, char *out, size_t size,
 		}
 
 		if (c == '\n') {
-			if (tls) {
-				*curl_buf_offset += sz;
-			}
+			*offset += sz;
 			break;
 		}
 	}
@@ -409,6 +626,13 @@ int fdo_curl_setup(fdo_ip_address_t *ip_addr, uint16_t port)
 			goto err;
 		}
 
+		curlCode = curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS,
+					    con_timeout_ms);
+		if (curlCode != CURLE_OK) {
+			LOG(LOG_ERROR, "CURL_ERROR: Could not set connect timeout.\n");
+			goto err;
+		}
+
 		/* Do not do the transfer - only connect to host */
 		curlCode = curl_easy_setopt(curl, CURLOPT_CONNECT_ONLY, 1L);
 		if (curlCode != CURLE_OK) {
@@ -462,6 +686,8 @@ fdo_con_handle fdo_con_connect(fdo_ip_address_t *ip_addr, uint16_t port,
 {
 	struct fdo_sock_handle *sock_hdl = FDO_CON_INVALID_HANDLE;
 	struct sockaddr_in haddr;
+	int so_error = 0;
+	socklen_t so_error_len = sizeof(so_error);
 
 	if (!ip_addr) {
 		goto end;
@@ -484,6 +710,8 @@ fdo_con_handle fdo_con_connect(fdo_ip_address_t *ip_addr, uint16_t port,
 		LOG(LOG_ERROR, "Out of memory for sock handle\n");
 		goto end;
 	}
+	sock_hdl->sockfd = -1;
+	sock_hdl->epfd = -1;
 
 	haddr.sin_family = AF_INET; // IPV4
 	haddr.sin_port = htons(port);
@@ -542,15 +770,30 @@ fdo_con_handle fdo_con_connect(fdo_ip_address_t *ip_addr, uint16_t port,
 			goto end;
 		}
 	} else {
-		sock_hdl->sockfd = socket(AF_INET, SOCK_STREAM, 0);
+		sock_hdl->sockfd = socket(AF_INET,
+					  SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+					  0);
 		if (sock_hdl->sockfd < 0) {
 			goto end;
 		}
 
 		if (connect(sock_hdl->sockfd, (struct sockaddr *)&haddr,
 				sizeof(haddr)) < 0) {
-			LOG(LOG_ERROR, "Socket Connect failed, trying next IP\n");
-			goto end;
+			if (errno != EINPROGRESS) {
+				LOG(LOG_ERROR, "Socket Connect failed, trying next IP\n");
+				goto end;
+			}
+			/* connection completes asynchronously, wait for it */
+			if (wait_on_socket(sock_hdl, false, con_deadline()) <= 0) {
+				LOG(LOG_ERROR, "Socket Connect timed out, trying next IP\n");
+				goto end;
+			}
+			if (getsockopt(sock_hdl->sockfd, SOL_SOCKET, SO_ERROR,
+				       &so_error, &so_error_len) != 0 ||
+			    so_error != 0) {
+				LOG(LOG_ERROR, "Socket Connect failed, trying next IP\n");
+				goto end;
+			}
 		}
 	}
 #endif
@@ -559,7 +802,12 @@ fdo_con_handle fdo_con_connect(fdo_ip_address_t *ip_addr, uint16_t port,
 
 end:
 	if (sock_hdl) {
-		close(sock_hdl->sockfd);
+		if (sock_hdl->sockfd >= 0) {
+			close(sock_hdl->sockfd);
+		}
+		if (sock_hdl->epfd >= 0) {
+			close(sock_hdl->epfd);
+		}
 		fdo_free(sock_hdl);
 	}
 	return FDO_CON_INVALID_HANDLE;
@@ -597,11 +845,83 @@ int32_t fdo_con_disconnect(fdo_con_handle handle, bool tls)
 		if (sockfd && !close(sockfd)) {
 			ret = 0;
 		}
+		if (sock_hdl->epfd >= 0) {
+			close(sock_hdl->epfd);
+		}
 		fdo_free(sock_hdl);
 	}
 	return ret;
 }
 
+/**
+ * Set the time budget of each network operation (connect, send of a
+ * message, receive of a message header or body).
+ *
+ * @param timeout_ms - time budget in milliseconds, MAX_TIME_OUT if <= 0.
+ */
+void fdo_con_set_timeout(long timeout_ms)
+{
+	con_timeout_ms = (timeout_ms > 0) ? timeout_ms : MAX_TIME_OUT;
+}
+
+/**
+ * Get the pollable file descriptor backing a connection, so that an
+ * external event loop can wait for readiness before calling into the SDK.
+ *
+ * @param handle - connection handler (for ex: socket-id)
+ * @retval -1 on failure, file descriptor on success.
+ */
+int fdo_con_get_fd(fdo_con_handle handle)
+{
+	struct fdo_sock_handle *sock_hdl = handle;
+
+	if (!sock_hdl) {
+		return -1;
+	}
+	return sock_hdl->sockfd;
+}
+
+/**
+ * Wait for the response to the last message sent on a connection to start
+ * arriving, for at most timeout_ms and never past the receive deadline set
+ * by fdo_con_send_message().
+ *
+ * @param handle - connection handler (for ex: socket-id)
+ * @param timeout_ms - longest wait in milliseconds, 0 to only check.
+ * @retval 1 if the response can be read, 0 if not yet, -1 on failure or
+ * once the receive deadline expired.
+ */
+int32_t fdo_con_wait_recv(fdo_con_handle handle, uint32_t timeout_ms)
+{
+	struct fdo_sock_handle *sock_hdl = handle;
+	uint64_t now = con_now_ms();
+	uint64_t deadline;
+	int res;
+
+	if (!sock_hdl || !sock_hdl->rx_deadline) {
+		return -1;
+	}
+	if (now >= sock_hdl->rx_deadline) {
+		LOG(LOG_ERROR, "No response recevied! \n");
+		return -1;
+	}
+	deadline = now + timeout_ms;
+	if (deadline > sock_hdl->rx_deadline) {
+		deadline = sock_hdl->rx_deadline;
+	}
+	/* a zero wait still checks readiness once */
+	if (deadline == now) {
+		deadline++;
+	}
+
+	res = wait_on_socket(sock_hdl, true, deadline);
+	if (res == 0 && con_now_ms() >= sock_hdl->rx_deadline) {
+		LOG(LOG_ERROR, "No response recevied! \n");
+		return -1;
+	}
+	return res;
+}
+
 /**
  * Receive(read) protocol version, message type and length of rest body
  *
@@ -610,8 +930,9 @@ int32_t fdo_con_disconnect(fdo_con_handle handle, bool tls)
  * @param message_type - out message type of incoming FDO message.
  * @param msglen - out Number of received bytes.
  * @param tls: flag describing whether HTTP (false) or HTTPS (true) is
- * @param curl_buf: data buffer to read into msg received by curl.
- * @param curl_buf_offset: pointer to track curl_buf.
+ * @param curl_buf: buffer of REST_MAX_MSGHDR_SIZE bytes to read the header
+ * into, along with the start of the body if it comes with it.
+ * @param curl_buf_offset: out offset of the body in curl_buf.
  * @retval -1 on failure, 0 on success.
  */
 int32_t fdo_con_recv_msg_header(fdo_con_handle handle,
@@ -625,57 +946,49 @@ int32_t fdo_con_recv_msg_header(fdo_con_handle handle,
 	size_t tmplen;
 	size_t hdrlen;
 	rest_ctx_t *rest = NULL;
-
-	if (!protocol_version || !message_type || !msglen) {
+	struct fdo_sock_handle *sock_hdl = handle;
+	size_t nread_total = 0;
+	size_t hdr_end = 0;
+	size_t offset = 0;
+	ssize_t n;
+	uint64_t deadline = con_deadline();
+
+	if (!protocol_version || !message_type || !msglen || !sock_hdl ||
+	    !curl_buf || !curl_buf_offset) {
 		goto err;
 	}
+	sock_hdl->rx_len = 0;
 
-	if (tls) {
-		struct fdo_sock_handle *sock_hdl = handle;
-		int sockfd = sock_hdl->sockfd;
-		CURLcode res;
-		size_t nread;
-		int max_iteration = 100;
-		int itr = 0;
-		size_t nread_total = 0;
-
-		LOG(LOG_INFO,"Reading response.\n");
-
-		do {
-			nread = 0;
-			res = curl_easy_recv(curl, curl_buf + nread_total,
-						REST_MAX_MSGBODY_SIZE - nread_total, &nread);
-			nread_total += nread;
-
-			if (res == CURLE_AGAIN && !wait_on_socket(sockfd, 1, MAX_TIME_OUT)) {
-				LOG(LOG_ERROR,"Error: timeout.\n");
-				goto err;
-			}
-			itr++;
-		} while (res == CURLE_AGAIN && itr < max_iteration);
+	LOG(LOG_INFO, "Reading response.\n");
 
-		if (res != CURLE_OK) {
-			LOG(LOG_ERROR,"Error: %s\n", curl_easy_strerror(res));
+	/* Read in chunks until the whole header is in. The body bytes that
+	 * come along are left in curl_buf for fdo_con_recv_msg_body(). */
+	while (hdr_end == 0) {
+		if (nread_total >= REST_MAX_MSGHDR_SIZE) {
+			LOG(LOG_ERROR, "REST header is too large!\n");
 			goto err;
 		}
-
-		if (nread_total == 0) {
-			LOG(LOG_ERROR,"No response recevied! \n");
+		n = sock_recv_some(sock_hdl, (uint8_t *)curl_buf + nread_total,
+				   REST_MAX_MSGHDR_SIZE - nread_total, tls,
+				   deadline);
+		if (n <= 0) {
+			LOG(LOG_ERROR, "No response recevied! \n");
 			goto err;
 		}
-
-		LOG(LOG_INFO,"Received %" CURL_FORMAT_CURL_OFF_T " bytes.\n",
-			(curl_off_t)nread_total);
+		nread_total += (size_t)n;
+		hdr_end = con_header_end(curl_buf, nread_total);
 	}
 
+	LOG(LOG_DEBUG, "Received %zu bytes with the header.\n", nread_total);
+
 	for (;;) {
 		if (memset_s(tmp, sizeof(tmp), 0) != 0) {
 			LOG(LOG_ERROR, "Memset() failed!\n");
 			goto err;
 		}
 
-		if (!read_until_new_line(handle, tmp, REST_MAX_MSGHDR_SIZE,
-					 tls, curl_buf, curl_buf_offset)) {
+		if (!read_until_new_line(curl_buf, hdr_end, &offset, tmp,
+					 REST_MAX_MSGHDR_SIZE)) {
 			LOG(LOG_ERROR, "read_until_new_line() failed!\n");
 			goto err;
 		}
@@ -726,6 +1039,8 @@ int32_t fdo_con_recv_msg_header(fdo_con_handle handle,
 	*protocol_version = rest->prot_ver;
 	*message_type = rest->msg_type;
 
+	*curl_buf_offset = hdr_end;
+	sock_hdl->rx_len = nread_total;
 	ret = 0;
 
 err:
@@ -739,40 +1054,44 @@ err:
  * @param buf - data buffer to read into.
  * @param length - Number of received bytes.
  * @param tls: flag describing whether HTTP (false) or HTTPS (true) is
- * @param curl_buf: data buffer to read into msg received by curl.
- * @param curl_buf_offset: pointer to track curl_buf.
+ * @param curl_buf: buffer filled by fdo_con_recv_msg_header().
+ * @param curl_buf_offset: offset of the body in curl_buf.
  * @retval -1 on failure, number of bytes read on success.
  */
 int32_t fdo_con_recv_msg_body(fdo_con_handle handle, uint8_t *buf,
 			      size_t length, bool tls, char *curl_buf,
 				  size_t curl_buf_offset)
 {
-	int n;
+	ssize_t n = 0;
+	size_t have = 0;
 	int32_t ret = -1;
-	int sockfd = 0;
 	struct fdo_sock_handle *sock_hdl = handle;
 
 	if (!buf || !length || !sock_hdl) {
 		goto err;
 	}
 
-	sockfd = sock_hdl->sockfd;
-
-	if (tls) {
-		if (memcpy_s(buf, length, curl_buf + curl_buf_offset, length)) {
+	// the start of the body, read along with the header
+	if (curl_buf && sock_hdl->rx_len > curl_buf_offset) {
+		have = sock_hdl->rx_len - curl_buf_offset;
+		if (have > length) {
+			have = length;
+		}
+		if (memcpy_s(buf, length, curl_buf + curl_buf_offset, have)) {
 			LOG(LOG_ERROR, "Failed to copy msg data in byte array\n");
 			goto err;
 		}
-		n = length;
-	} else {
-		n = recv(sockfd, buf, length, MSG_WAITALL);
 	}
 
-	if (n <= 0) {
-		ret = -1;
-		goto err;
+	// the rest goes straight into the caller's buffer
+	if (have < length) {
+		n = sock_recv_all(sock_hdl, buf + have, length - have, tls,
+				  con_deadline());
+		if (n <= 0) {
+			goto err;
+		}
 	}
-	ret = n;
+	ret = (int32_t)(have + (size_t)n);
 err:
 	return ret;
 }
@@ -793,19 +1112,17 @@ int32_t fdo_con_send_message(fdo_con_handle handle, uint32_t protocol_version,
 			     size_t length, bool tls)
 {
 	int ret = -1;
-	int n;
+	ssize_t n;
 	rest_ctx_t *rest = NULL;
 	char rest_hdr[REST_MAX_MSGHDR_SIZE] = {0};
 	size_t header_len = 0;
-	int sockfd = 0;
 	struct fdo_sock_handle *sock_hdl = handle;
+	uint64_t deadline = con_deadline();
 
 	if (!buf || !length || !sock_hdl) {
 		goto err;
 	}
 
-	sockfd = sock_hdl->sockfd;
-
 	rest = get_rest_context();
 
 	if (!rest) {
@@ -835,131 +1152,36 @@ int32_t fdo_con_send_message(fdo_con_handle handle, uint32_t protocol_version,
 
 	/* Send REST header */
 	if (tls) {
-		CURLcode res;
-		size_t nsent_total = 0;
 		LOG(LOG_INFO,"Sending REST header.\n");
-
-		do {
-			size_t nsent;
-			int max_iteration = 100;
-			int itr = 0;
-			do {
-				nsent = 0;
-				res = curl_easy_send(curl, rest_hdr + nsent_total,
-							header_len - nsent_total, &nsent);
-				nsent_total += nsent;
-
-				if (res == CURLE_AGAIN && !wait_on_socket(sockfd, 0, MAX_TIME_OUT)) {
-					LOG(LOG_ERROR,"Error: timeout.\n");
-					goto hdrerr;
-				}
-				itr++;
-			} while (res == CURLE_AGAIN && itr < max_iteration);
-
-			if (res != CURLE_OK) {
-				LOG(LOG_ERROR,"Error: %s\n", curl_easy_strerror(res));
-				goto hdrerr;
-			}
-
-			printf("Sent %" CURL_FORMAT_CURL_OFF_T " bytes.\n",
-				(curl_off_t)nsent);
-
-		} while (nsent_total < header_len);
-		n = nsent_total;
-
-	} else {
-
-		n = send(sockfd, rest_hdr, header_len, 0);
-
-		if (n <= 0) {
-			LOG(LOG_ERROR,
-			    "Socket write Failed, ret=%d, "
-			    "errno=%d, %d\n",
-			    n, errno, __LINE__);
-
-			if (fdo_con_disconnect(handle, tls)) {
-				LOG(LOG_ERROR, "Error during socket close()\n");
-				goto hdrerr;
-			}
-			goto hdrerr;
-
-		} else if ((size_t)n < header_len) {
-			LOG(LOG_ERROR,
-			    "Rest Header write returns %d/%zu bytes\n", n,
-			    header_len);
-			goto hdrerr;
-
-		} else {
-			LOG(LOG_DEBUG,
-			    "Rest Header write returns %d/%zu bytes\n\n", n,
-			    header_len);
+	}
+	n = sock_send_all(sock_hdl, (const uint8_t *)rest_hdr, header_len, tls,
+			  deadline);
+	if (n < 0) {
+		if (!tls && fdo_con_disconnect(handle, tls)) {
+			LOG(LOG_ERROR, "Error during socket close()\n");
 		}
+		goto hdrerr;
 	}
+	LOG(LOG_DEBUG, "Rest Header write returns %zd/%zu bytes\n\n", n,
+	    header_len);
 
 	LOG(LOG_DEBUG, "REST:header(%zu):%s\n", header_len, rest_hdr);
 
 	/* Send REST body */
 	if (tls) {
-
-		CURLcode res;
-		size_t nsent_total = 0;
 		LOG(LOG_INFO,"Sending REST body.\n");
-
-		do {
-			size_t nsent;
-			int max_iteration = 100;
-			int itr = 0;
-			do {
-				nsent = 0;
-				res = curl_easy_send(curl, buf + nsent_total,
-					length - nsent_total, &nsent);
-				nsent_total += nsent;
-
-				if	(res == CURLE_AGAIN && !wait_on_socket(sockfd, 0, MAX_TIME_OUT)) {
-					LOG(LOG_ERROR,"Error: timeout.\n");
-					goto bodyerr;
-				}
-				itr++;
-			} while (res == CURLE_AGAIN && itr < max_iteration);
-
-			if (res != CURLE_OK) {
-				LOG(LOG_ERROR,"Error: %s\n", curl_easy_strerror(res));
-				goto bodyerr;
-			}
-
-			LOG(LOG_INFO,"Sent %" CURL_FORMAT_CURL_OFF_T " bytes.\n",
-				(curl_off_t)nsent);
-
-		} while (nsent_total < length);
-
-		n = nsent_total;
-	} else {
-		n = send(sockfd, buf, length, 0);
-
-		if (n <= 0) {
-			LOG(LOG_ERROR,
-			    "Socket write Failed, ret=%d, "
-			    "errno=%d, %d\n",
-			    n, errno, __LINE__);
-
-			if (fdo_con_disconnect(handle, tls)) {
-				LOG(LOG_ERROR, "Error during socket close()\n");
-				goto bodyerr;
-			}
-			goto bodyerr;
-
-		} else if ((size_t)n < length) {
-			LOG(LOG_ERROR, "Rest Body write returns %d/%zu bytes\n",
-			    n, length);
-			goto bodyerr;
-
-		} else {
-			LOG(LOG_DEBUG,
-			    "Rest Body write returns %d/%zu bytes\n\n", n,
-			    length);
+	}
+	n = sock_send_all(sock_hdl, buf, length, tls, deadline);
+	if (n < 0) {
+		if (!tls && fdo_con_disconnect(handle, tls)) {
+			LOG(LOG_ERROR, "Error during socket close()\n");
 		}
+		goto bodyerr;
 	}
+	LOG(LOG_DEBUG, "Rest Body write returns %zd/%zu bytes\n\n", n,
+	    length);
 
+	sock_hdl->rx_deadline = con_deadline();
 	return n;
 
 hdrerr:
@@ -996,6 +1218,14 @@ void fdo_sleep(int sec)
 	sleep(sec);
 }
 
+/**
+ * Return the current monotonic time in milliseconds.
+ */
+uint64_t fdo_time_ms(void)
+{
+	return con_now_ms();
+}
+
 /**
  * Convert from Network to Host byte order
  *
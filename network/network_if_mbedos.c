@@ -20,6 +20,7 @@
 #include "def.h"
 #include "mbed_wait_api.h"
 #include "platform/mbed_thread.h"
+#include <limits.h>
 #include <lwip/ip4_addr.h>
 #include <lwip/sockets.h>
 
@@ -217,6 +218,44 @@ int32_t fdo_con_disconnect(fdo_con_handle handle, void *ssl)
 	return 0;
 }
 
+/**
+ * Set the time budget of each blocking socket operation, applied to the
+ * sockets connected from now on.
+ *
+ * @param timeout_ms - time budget in milliseconds, MBED_SOCKET_TIMEOUT if <= 0.
+ */
+void fdo_con_set_timeout(long timeout_ms)
+{
+	mos_set_timeout((timeout_ms > 0 && timeout_ms <= INT_MAX) ?
+			(int)timeout_ms : 0);
+}
+
+/**
+ * mbedos sockets are not pollable, a caller waits in the blocking receive.
+ *
+ * @param handle - connection handler (for ex: socket-id)
+ * @retval -1 always.
+ */
+int fdo_con_get_fd(fdo_con_handle handle)
+{
+	(void)handle;
+	return -1;
+}
+
+/**
+ * Sockets are blocking on mbedos, so the response is always reported as
+ * ready and fdo_con_recv_msg_header() waits for it, up to the socket timeout.
+ *
+ * @param handle - connection handler (for ex: socket-id)
+ * @param timeout_ms - unused.
+ * @retval -1 on invalid handle, 1 otherwise.
+ */
+int32_t fdo_con_wait_recv(fdo_con_handle handle, uint32_t timeout_ms)
+{
+	(void)timeout_ms;
+	return handle ? 1 : -1;
+}
+
 /**
  * Receive(read) protocol version, message type and length of rest body
  *
@@ -507,6 +546,14 @@ void fdo_sleep(int sec)
 	thread_sleep_for(sec * 1000);
 }
 
+/**
+ * Return the current monotonic time in milliseconds.
+ */
+uint64_t fdo_time_ms(void)
+{
+	return get_ms_count();
+}
+
 /**
  * Convert from Network to Host byte order
  *
@@ -15,6 +15,14 @@
 
 extern NetworkInterface *getNetinterface(void);
 
+/* socket timeout applied on connect, see fdo_con_set_timeout() */
+static int mos_timeout_ms = MBED_SOCKET_TIMEOUT;
+
+void mos_set_timeout(int timeout_ms)
+{
+	mos_timeout_ms = (timeout_ms > 0) ? timeout_ms : MBED_SOCKET_TIMEOUT;
+}
+
 int mos_resolvedns(char *dn, char *ip)
 {
 	NetworkInterface *net = getNetinterface();
@@ -94,7 +102,7 @@ int mos_socket_con_only(fdo_con_handle *socket, fdo_ip_address_t *ip_addr,
 		return -1;
 	}
 	socket->set_blocking(true);
-	socket->set_timeout(MBED_SOCKET_TIMEOUT);
+	socket->set_timeout(mos_timeout_ms);
 	return r;
 }
 
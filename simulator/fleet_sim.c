@@ -0,0 +1,534 @@
+/*
+ * Copyright 2020 Intel Corporation
+ * SPDX-License-Identifier: Apache 2.0
+ */
+
+/*!
+ * \file
+ * \brief Device fleet simulator. Onboards a batch of virtual devices
+ * concurrently against the configured servers, and reports the onboarding rate,
+ * the errors and the device-side cost of a session.
+ *
+ * The SDK keeps its state in process globals and opens its credential files
+ * relative to the working directory (BLOB_PATH). Every virtual device therefore
+ * runs in its own process, from its own directory <fleet_dir>/dev-<n>, holding
+ * a copy of the template data/ directory. The simulator keeps up to
+ * 'concurrency' of them running, and collects the wall time, CPU time and peak
+ * memory of each session from wait4().
+ *
+ * Every invocation runs one protocol session per device: DI on fresh device
+ * directories with -P di, then TO1/TO2 on the same directories with -P to once
+ * the vouchers have been extended and registered with TO0.
+ */
+
+#define _GNU_SOURCE
+#include "fdo.h"
+#include "fdomodules.h"
+#include "util.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "blob.h"
+#include "safe_lib.h"
+
+#define SIM_PATH_LEN 512
+#define SIM_ERROR_RETRY_COUNT 5
+#define SIM_SESSION_LOG "session.log"
+#define SIM_MANUFACTURER_ADDR "data/manufacturer_addr.bin"
+
+/* Exit status of a device process */
+enum {
+	SIM_EXIT_OK = 0,
+	SIM_EXIT_SETUP,	    /* device directory could not be prepared */
+	SIM_EXIT_INIT,	    /* blob provisioning or fdo_sdk_init failed */
+	SIM_EXIT_STATE,	    /* device not in the state the phase needs */
+	SIM_EXIT_RUN,	    /* fdo_sdk_run failed */
+	SIM_EXIT_MAX
+};
+
+static const char *const sim_exit_names[SIM_EXIT_MAX] = {
+    "ok", "setup failed", "init failed", "wrong state", "protocol failed"};
+
+typedef struct {
+	pid_t pid;
+	int status;
+	bool signaled;
+	uint64_t start_us;
+	uint64_t wall_us;
+	uint64_t cpu_us;
+	long maxrss_kb;
+} sim_session_t;
+
+typedef struct {
+	const char *fleet_dir;
+	const char *template_dir;
+	const char *mfg_addr;
+	unsigned int devices;
+	unsigned int first;
+	unsigned int concurrency;
+	unsigned int rate;
+	bool to_phase;
+	bool self_signed;
+} sim_config_t;
+
+static sim_config_t config = {"fleet", "data", NULL, 100, 0, 8, 0, false,
+			      false};
+
+static uint64_t now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [-P di|to] [-n devices] [-f first] [-c concurrency]\n"
+		"          [-r starts_per_sec] [-d fleet_dir] [-t template_dir]\n"
+		"          [-m manufacturer_url] [-s]\n"
+		"  -P  protocol run by every device: di (default) or to\n"
+		"  -n  number of devices (default 100)\n"
+		"  -f  index of the first device (default 0)\n"
+		"  -c  devices onboarding at the same time (default 8)\n"
+		"  -r  maximum device starts per second, 0 for none (default)\n"
+		"  -d  directory holding the device directories (default fleet)\n"
+		"  -t  template copied to every device's data/ for DI (default data)\n"
+		"  -m  Manufacturer URL written to every device, for DI\n"
+		"  -s  accept self signed certificates\n",
+		prog);
+}
+
+static int error_cb(fdo_sdk_status type, fdo_sdk_error errorcode)
+{
+	static unsigned int errors;
+
+	(void)type;
+	(void)errorcode;
+
+	if (++errors > SIM_ERROR_RETRY_COUNT) {
+		LOG(LOG_INFO, "Sending ABORT from simulator\n");
+		return FDO_ABORT;
+	}
+	return FDO_SUCCESS;
+}
+
+static bool copy_file(const char *src, const char *dst)
+{
+	char buf[4096];
+	ssize_t len;
+	bool ret = false;
+	int in = open(src, O_RDONLY);
+	int out = -1;
+
+	if (in < 0) {
+		return false;
+	}
+	out = open(dst, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (out < 0) {
+		goto end;
+	}
+	while ((len = read(in, buf, sizeof(buf))) > 0) {
+		if (write(out, buf, (size_t)len) != len) {
+			goto end;
+		}
+	}
+	ret = len == 0;
+end:
+	close(in);
+	if (out >= 0) {
+		close(out);
+	}
+	return ret;
+}
+
+/**
+ * Create a fresh device directory: <dir>/data holding a copy of every regular
+ * file of the template, and the Manufacturer URL if one is configured.
+ */
+static bool prepare_device_dir(const char *dir)
+{
+	char data_dir[SIM_PATH_LEN];
+	char src[SIM_PATH_LEN];
+	char dst[SIM_PATH_LEN];
+	struct dirent *entry = NULL;
+	struct stat st;
+	DIR *template = NULL;
+	bool ret = false;
+	FILE *fp = NULL;
+
+	if (snprintf(data_dir, sizeof(data_dir), "%s/data", dir) >=
+	    (int)sizeof(data_dir)) {
+		return false;
+	}
+	if ((mkdir(dir, 0700) != 0 && errno != EEXIST) ||
+	    (mkdir(data_dir, 0700) != 0 && errno != EEXIST)) {
+		return false;
+	}
+
+	template = opendir(config.template_dir);
+	if (!template) {
+		return false;
+	}
+	while ((entry = readdir(template)) != NULL) {
+		if (snprintf(src, sizeof(src), "%s/%s", config.template_dir,
+			     entry->d_name) >= (int)sizeof(src) ||
+		    snprintf(dst, sizeof(dst), "%s/%s", data_dir,
+			     entry->d_name) >= (int)sizeof(dst)) {
+			goto end;
+		}
+		if (stat(src, &st) != 0 || !S_ISREG(st.st_mode)) {
+			continue;
+		}
+		if (!copy_file(src, dst)) {
+			goto end;
+		}
+	}
+
+	if (config.mfg_addr) {
+		if (snprintf(dst, sizeof(dst), "%s/%s", dir,
+			     SIM_MANUFACTURER_ADDR) >= (int)sizeof(dst)) {
+			goto end;
+		}
+		fp = fopen(dst, "w");
+		if (!fp || fputs(config.mfg_addr, fp) == EOF) {
+			goto end;
+		}
+	}
+	ret = true;
+end:
+	if (fp && fclose(fp) == EOF) {
+		ret = false;
+	}
+	closedir(template);
+	return ret;
+}
+
+/**
+ * Run one protocol session from the current directory, the same way
+ * linux-client does.
+ * @return SIM_EXIT_* status of the session
+ */
+static int device_session(void)
+{
+	fdo_sdk_service_info_module *module_info = NULL;
+	fdo_sdk_device_state state;
+	int ret = SIM_EXIT_INIT;
+
+	if (-1 == configure_normal_blob()) {
+		LOG(LOG_ERROR, "Provisioning Normal blob failed!\n");
+		return SIM_EXIT_INIT;
+	}
+
+	module_info = fdo_alloc(FDO_MAX_MODULES * sizeof(*module_info));
+	if (!module_info) {
+		LOG(LOG_ERROR, "Malloc failed!\n");
+		return SIM_EXIT_INIT;
+	}
+	if (strncpy_s(module_info[0].module_name, FDO_MODULE_NAME_LEN,
+		      "fdo_sys", FDO_MODULE_NAME_LEN) != 0) {
+		LOG(LOG_ERROR, "Strcpy failed");
+		goto end;
+	}
+	module_info[0].service_info_callback = fdo_sys;
+
+	if (FDO_SUCCESS !=
+	    fdo_sdk_init(error_cb, FDO_MAX_MODULES, module_info)) {
+		LOG(LOG_ERROR, "fdo_sdk_init failed!!\n");
+		goto end;
+	}
+#if defined SELF_SIGNED_CERTS_SUPPORTED
+	useSelfSignedCerts = config.self_signed;
+#endif
+
+	state = fdo_sdk_get_status();
+	if ((config.to_phase && state != FDO_STATE_PRE_TO1 &&
+	     state != FDO_STATE_RESALE) ||
+	    (!config.to_phase && state != FDO_STATE_PRE_DI)) {
+		LOG(LOG_ERROR, "Device is in state %d\n", state);
+		ret = SIM_EXIT_STATE;
+		goto end;
+	}
+
+	ret = FDO_SUCCESS == fdo_sdk_run() ? SIM_EXIT_OK : SIM_EXIT_RUN;
+end:
+	fdo_free(module_info);
+	fdo_sdk_deinit();
+	return ret;
+}
+
+/**
+ * Start the process onboarding device 'index'. Its output goes to
+ * <device dir>/session.log.
+ * @return pid of the device process, -1 on error
+ */
+static pid_t start_device(unsigned int index)
+{
+	char dir[SIM_PATH_LEN];
+	pid_t pid;
+	int fd;
+
+	if (snprintf(dir, sizeof(dir), "%s/dev-%06u", config.fleet_dir,
+		     index) >= (int)sizeof(dir)) {
+		return -1;
+	}
+
+	fflush(stdout);
+	pid = fork();
+	if (pid != 0) {
+		return pid;
+	}
+
+	if (!config.to_phase && !prepare_device_dir(dir)) {
+		_exit(SIM_EXIT_SETUP);
+	}
+	if (chdir(dir) != 0) {
+		_exit(SIM_EXIT_SETUP);
+	}
+	fd = open(SIM_SESSION_LOG, O_WRONLY | O_CREAT | O_APPEND, 0600);
+	if (fd < 0 || dup2(fd, STDOUT_FILENO) < 0 ||
+	    dup2(fd, STDERR_FILENO) < 0) {
+		_exit(SIM_EXIT_SETUP);
+	}
+	close(fd);
+	setbuf(stdout, NULL);
+	exit(device_session());
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* Nearest-rank percentile of n sorted values */
+static uint64_t percentile(const uint64_t *sorted, size_t n, unsigned int p)
+{
+	size_t rank = (p * n + 99) / 100;
+
+	if (!n) {
+		return 0;
+	}
+	return sorted[rank ? rank - 1 : 0];
+}
+
+static void report(const sim_session_t *sessions, uint64_t elapsed_us)
+{
+	unsigned int outcomes[SIM_EXIT_MAX + 1] = {0};
+	uint64_t *wall = calloc(config.devices, sizeof(*wall));
+	uint64_t *cpu = calloc(config.devices, sizeof(*cpu));
+	uint64_t *rss = calloc(config.devices, sizeof(*rss));
+	size_t ok = 0;
+	unsigned int i;
+
+	if (!wall || !cpu || !rss) {
+		fprintf(stderr, "fleet_sim: out of memory\n");
+		goto end;
+	}
+
+	for (i = 0; i < config.devices; i++) {
+		const sim_session_t *s = &sessions[i];
+
+		if (s->signaled || s->status < 0 || s->status >= SIM_EXIT_MAX) {
+			outcomes[SIM_EXIT_MAX]++;
+			continue;
+		}
+		outcomes[s->status]++;
+		if (s->status == SIM_EXIT_OK) {
+			wall[ok] = s->wall_us;
+			cpu[ok] = s->cpu_us;
+			rss[ok] = (uint64_t)s->maxrss_kb;
+			ok++;
+		}
+	}
+	qsort(wall, ok, sizeof(*wall), compare_u64);
+	qsort(cpu, ok, sizeof(*cpu), compare_u64);
+	qsort(rss, ok, sizeof(*rss), compare_u64);
+
+	printf("%-16s %s\n", "phase", config.to_phase ? "to" : "di");
+	printf("%-16s %u, concurrency %u\n", "devices", config.devices,
+	       config.concurrency);
+	printf("%-16s %.3f s\n", "elapsed", (double)elapsed_us / 1e6);
+	printf("%-16s %.2f onboarded/s\n", "rate",
+	       elapsed_us ? (double)ok * 1e6 / (double)elapsed_us : 0.0);
+	for (i = 0; i < SIM_EXIT_MAX; i++) {
+		printf("%-16s %u (%.1f%%)\n", sim_exit_names[i], outcomes[i],
+		       100.0 * outcomes[i] / config.devices);
+	}
+	printf("%-16s %u (%.1f%%)\n", "crashed", outcomes[SIM_EXIT_MAX],
+	       100.0 * outcomes[SIM_EXIT_MAX] / config.devices);
+	printf("%-16s %10s %10s %10s\n", "per session", "p50", "p99", "max");
+	printf("%-16s %10.1f %10.1f %10.1f\n", "  wall ms",
+	       percentile(wall, ok, 50) / 1e3, percentile(wall, ok, 99) / 1e3,
+	       percentile(wall, ok, 100) / 1e3);
+	printf("%-16s %10.1f %10.1f %10.1f\n", "  cpu ms",
+	       percentile(cpu, ok, 50) / 1e3, percentile(cpu, ok, 99) / 1e3,
+	       percentile(cpu, ok, 100) / 1e3);
+	printf("%-16s %10" PRIu64 " %10" PRIu64 " %10" PRIu64 "\n", "  maxrss KB",
+	       percentile(rss, ok, 50), percentile(rss, ok, 99),
+	       percentile(rss, ok, 100));
+end:
+	free(wall);
+	free(cpu);
+	free(rss);
+}
+
+int main(int argc, char **argv)
+{
+	sim_session_t *sessions = NULL;
+	unsigned int started = 0;
+	unsigned int running = 0;
+	uint64_t begin = 0;
+	int ret = -1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "P:n:f:c:r:d:t:m:sh")) != -1) {
+		switch (opt) {
+		case 'P':
+			config.to_phase = strcmp(optarg, "to") == 0;
+			if (!config.to_phase && strcmp(optarg, "di") != 0) {
+				usage(argv[0]);
+				return -1;
+			}
+			break;
+		case 'n':
+			config.devices = (unsigned int)strtoul(optarg, NULL, 10);
+			break;
+		case 'f':
+			config.first = (unsigned int)strtoul(optarg, NULL, 10);
+			break;
+		case 'c':
+			config.concurrency =
+			    (unsigned int)strtoul(optarg, NULL, 10);
+			break;
+		case 'r':
+			config.rate = (unsigned int)strtoul(optarg, NULL, 10);
+			break;
+		case 'd':
+			config.fleet_dir = optarg;
+			break;
+		case 't':
+			config.template_dir = optarg;
+			break;
+		case 'm':
+			config.mfg_addr = optarg;
+			break;
+		case 's':
+			config.self_signed = true;
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : -1;
+		}
+	}
+	if (!config.devices || !config.concurrency) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	/* devices can only be kept apart if the blobs live in the device dir */
+	if (FDO_CRED_NORMAL[0] == '/') {
+		fprintf(stderr,
+			"fleet_sim: needs a relative BLOB_PATH, built with %s\n",
+			FDO_CRED_NORMAL);
+		return -1;
+	}
+	if (mkdir(config.fleet_dir, 0700) != 0 && errno != EEXIST) {
+		perror("fleet_sim: fleet directory");
+		return -1;
+	}
+
+	sessions = calloc(config.devices, sizeof(*sessions));
+	if (!sessions) {
+		fprintf(stderr, "fleet_sim: out of memory\n");
+		return -1;
+	}
+
+	begin = now_us();
+	while (started < config.devices || running > 0) {
+		struct rusage usage;
+		unsigned int i;
+		int status;
+		pid_t pid;
+
+		if (started < config.devices && running < config.concurrency) {
+			sim_session_t *s = &sessions[started];
+			uint64_t due = config.rate ? begin + (uint64_t)started *
+							     1000000 / config.rate
+						   : 0;
+			uint64_t now = now_us();
+
+			/* wait for the start slot, unless a device finishes */
+			if (due > now && running > 0) {
+				pid = wait4(-1, &status, WNOHANG, &usage);
+				if (pid == 0) {
+					usleep((useconds_t)(due - now < 1000 ?
+								due - now :
+								1000));
+					continue;
+				}
+			} else {
+				if (due > now) {
+					usleep((useconds_t)(due - now));
+				}
+				s->start_us = now_us();
+				s->pid = start_device(config.first + started);
+				if (s->pid < 0) {
+					perror("fleet_sim: fork");
+					s->status = SIM_EXIT_SETUP;
+				} else {
+					running++;
+				}
+				started++;
+				continue;
+			}
+		} else {
+			pid = wait4(-1, &status, 0, &usage);
+		}
+		if (pid < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			perror("fleet_sim: wait");
+			goto end;
+		}
+
+		for (i = 0; i < started; i++) {
+			sim_session_t *s = &sessions[i];
+
+			if (s->pid != pid) {
+				continue;
+			}
+			s->wall_us = now_us() - s->start_us;
+			s->cpu_us =
+			    (uint64_t)usage.ru_utime.tv_sec * 1000000 +
+			    (uint64_t)usage.ru_utime.tv_usec +
+			    (uint64_t)usage.ru_stime.tv_sec * 1000000 +
+			    (uint64_t)usage.ru_stime.tv_usec;
+			s->maxrss_kb = usage.ru_maxrss;
+			s->signaled = WIFSIGNALED(status);
+			s->status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+			running--;
+			break;
+		}
+	}
+
+	report(sessions, now_us() - begin);
+	ret = 0;
+end:
+	free(sessions);
+	return ret;
+}
@@ -206,6 +206,25 @@ void hexdump(const char *message, const void *buffer, size_t size)
 	LOG(LOG_DEBUGNTS, "\n");
 }
 
+#ifdef FDO_ALLOC_STATS
+/* atomic, fdo_alloc() also runs on the KEX_PRECOMPUTE thread */
+static uint64_t alloc_count;
+static uint64_t alloc_bytes;
+
+/**
+ * Internal API
+ */
+void fdo_alloc_stats(uint64_t *allocs, uint64_t *bytes)
+{
+	if (allocs) {
+		*allocs = __atomic_load_n(&alloc_count, __ATOMIC_RELAXED);
+	}
+	if (bytes) {
+		*bytes = __atomic_load_n(&alloc_bytes, __ATOMIC_RELAXED);
+	}
+}
+#endif
+
 /**
  * Internal API
  */
@@ -230,6 +249,10 @@ void *fdo_alloc(size_t size)
 		fdo_free(buf);
 		goto end;
 	}
+#ifdef FDO_ALLOC_STATS
+	__atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&alloc_bytes, size, __ATOMIC_RELAXED);
+#endif
 
 end:
 	return buf;
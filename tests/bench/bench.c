@@ -0,0 +1,198 @@
+/*
+ * Copyright 2020 Intel Corporation
+ * SPDX-License-Identifier: Apache 2.0
+ */
+
+/*!
+ * \file
+ * \brief Micro-benchmark harness. Every benchmark is calibrated to run for at
+ * least the sample time, then timed over several samples. Results are written
+ * as CSV, one line per benchmark and input size:
+ *
+ *   backend,benchmark,size,iterations,ns_per_op,ns_per_op_min,mb_per_s,status
+ *
+ * ns_per_op is the median of the samples, and mb_per_s is derived from it.
+ * Results of two runs, e.g. of the openssl and mbedtls builds, can be joined
+ * on (benchmark, size).
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include "bench.h"
+#include "fdoCryptoHal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(USE_OPENSSL)
+#define BENCH_BACKEND "openssl"
+#elif defined(USE_MBEDTLS)
+#define BENCH_BACKEND "mbedtls"
+#else
+#define BENCH_BACKEND "unknown"
+#endif
+
+#define BENCH_MAX_SAMPLES 32
+
+static uint64_t sample_ns = 100 * 1000000ULL;
+static unsigned int samples = 5;
+static const char *filter;
+static FILE *out;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+void bench_fill(uint8_t *buf, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		buf[i] = (uint8_t)(i * 31 + 7);
+	}
+}
+
+/* Run op 'iterations' times, returning the elapsed time or 0 on failure */
+static uint64_t time_ops(bench_op_t op, void *ctx, uint64_t iterations)
+{
+	uint64_t start = now_ns();
+	uint64_t i;
+
+	for (i = 0; i < iterations; i++) {
+		if (!op(ctx)) {
+			return 0;
+		}
+	}
+	return now_ns() - start + 1;
+}
+
+void bench_skip(const char *name, size_t size, const char *reason)
+{
+	if (filter && !strstr(name, filter)) {
+		return;
+	}
+	fprintf(stderr, "%s/%zu: skipped, %s\n", name, size, reason);
+	fprintf(out, "%s,%s,%zu,0,0,0,0,skipped\n", BENCH_BACKEND, name, size);
+}
+
+bool bench_run(const char *name, size_t size, bench_op_t op, void *ctx)
+{
+	double ns_per_op[BENCH_MAX_SAMPLES];
+	uint64_t iterations = 1;
+	uint64_t elapsed = 0;
+	double median = 0;
+	unsigned int i;
+
+	if (filter && !strstr(name, filter)) {
+		return false;
+	}
+
+	/* warm up and calibrate, doubling until a batch fills a sample */
+	for (;;) {
+		elapsed = time_ops(op, ctx, iterations);
+		if (!elapsed) {
+			goto fail;
+		}
+		if (elapsed >= sample_ns) {
+			break;
+		}
+		iterations *= 2;
+	}
+
+	for (i = 0; i < samples; i++) {
+		elapsed = time_ops(op, ctx, iterations);
+		if (!elapsed) {
+			goto fail;
+		}
+		ns_per_op[i] = (double)elapsed / (double)iterations;
+	}
+	qsort(ns_per_op, samples, sizeof(ns_per_op[0]), compare_double);
+	median = ns_per_op[samples / 2];
+
+	fprintf(out, "%s,%s,%zu,%llu,%.1f,%.1f,%.2f,ok\n", BENCH_BACKEND, name,
+		size, (unsigned long long)iterations, median, ns_per_op[0],
+		median > 0 ? (double)size * 1e3 / median : 0.0);
+	fflush(out);
+	return true;
+
+fail:
+	fprintf(stderr, "%s/%zu: operation failed\n", name, size);
+	fprintf(out, "%s,%s,%zu,0,0,0,0,failed\n", BENCH_BACKEND, name, size);
+	return false;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [-t sample_ms] [-r samples] [-f filter] [-o file]\n"
+		"  -t  minimum time of a sample, in ms (default 100)\n"
+		"  -r  samples per benchmark, the median is reported (default 5)\n"
+		"  -f  only run the benchmarks whose name contains filter\n"
+		"  -o  write the CSV results to file instead of stdout\n"
+		"Run from the directory holding data/ (BLOB_PATH).\n",
+		prog);
+}
+
+int main(int argc, char **argv)
+{
+	int opt;
+
+	out = stdout;
+	while ((opt = getopt(argc, argv, "t:r:f:o:h")) != -1) {
+		switch (opt) {
+		case 't':
+			sample_ns = strtoull(optarg, NULL, 10) * 1000000ULL;
+			break;
+		case 'r':
+			samples = (unsigned int)strtoul(optarg, NULL, 10);
+			break;
+		case 'f':
+			filter = optarg;
+			break;
+		case 'o':
+			out = fopen(optarg, "w");
+			if (!out) {
+				perror(optarg);
+				return -1;
+			}
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : -1;
+		}
+	}
+	if (!sample_ns || !samples || samples > BENCH_MAX_SAMPLES) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	if (0 != crypto_init()) {
+		fprintf(stderr, "crypto_init failed\n");
+		return -1;
+	}
+
+	fprintf(out, "backend,benchmark,size,iterations,ns_per_op,"
+		     "ns_per_op_min,mb_per_s,status\n");
+	bench_cbor();
+	bench_crypto();
+	bench_storage();
+
+	crypto_close();
+	if (out != stdout) {
+		fclose(out);
+	}
+	return 0;
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright 2020 Intel Corporation
+ * SPDX-License-Identifier: Apache 2.0
+ */
+
+/*!
+ * \file
+ * \brief Micro-benchmark harness for the CBOR codec, crypto HAL and storage
+ * primitives.
+ */
+
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* One operation of a benchmark, false on failure */
+typedef bool (*bench_op_t)(void *ctx);
+
+/* Deterministic input bytes: buf[i] = i * 31 + 7 */
+void bench_fill(uint8_t *buf, size_t len);
+
+/*
+ * Time 'op' on 'ctx' and report it as one result line. 'size' is the input
+ * size the operation works on, used for the throughput.
+ * Returns false if the operation failed, or was filtered out.
+ */
+bool bench_run(const char *name, size_t size, bench_op_t op, void *ctx);
+
+/* Report a benchmark that could not be set up */
+void bench_skip(const char *name, size_t size, const char *reason);
+
+void bench_cbor(void);
+void bench_crypto(void);
+void bench_storage(void);
+
+#endif /* __BENCH_H__ */
@@ -0,0 +1,449 @@
+/*
+ * Copyright 2020 Intel Corporation
+ * SPDX-License-Identifier: Apache 2.0
+ */
+
+/*!
+ * \file
+ * \brief CBOR codec benchmarks: fdow_* encoding and fdor_* decoding of
+ * messages shaped like TO2.ProveOVHdr (61), TO2.OVNextEntry (63),
+ * TO2.ProveDevice (64), TO2.DeviceServiceInfo (68) and
+ * TO2.OwnerServiceInfo (69), before encryption.
+ *
+ * The size of a benchmark is the size of the variable part of the message:
+ * the OVHeader for 61, the owner public key for 63, xBKeyExchange for 64 and
+ * the ServiceInfo values for 68/69. The fixed parts use the ECDSA384 sizes.
+ */
+
+#include "bench.h"
+#include "fdoblockio.h"
+#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_CBOR_MAX_SIZE 16384
+#define BENCH_HASH_LEN 48
+#define BENCH_SIG_LEN 96
+#define BENCH_NONCE_LEN 16
+#define BENCH_UEID_LEN 17
+#define BENCH_SVI_VALUE_LEN 256
+#define BENCH_HASH_TYPE -43	/* SHA384 */
+#define BENCH_HMAC_TYPE 6	/* HMAC-SHA384 */
+#define BENCH_SIG_TYPE -35	/* ES384 */
+
+typedef struct {
+	fdow_t fdow;
+	fdow_t inner;
+	size_t size;
+	size_t msg_len;
+	uint8_t *msg;
+} cbor_ctx_t;
+
+typedef struct {
+	const char *name;
+	bool (*encode)(cbor_ctx_t *c);
+	bool (*decode)(fdor_t *fdor);
+} cbor_msg_t;
+
+static uint8_t filler[BENCH_CBOR_MAX_SIZE];
+static uint8_t scratch[BENCH_CBOR_MAX_SIZE];
+/* protected header {1: -35} */
+static uint8_t cose_protected[] = {0xa1, 0x01, 0x38, 0x22};
+static char svi_key[] = "fdo_sys:write";
+
+//==============================================================================
+// Shared encode/decode helpers
+//
+
+static bool write_hash(fdow_t *fdow, int type, size_t len)
+{
+	return fdow_start_array(fdow, 2) && fdow_signed_int(fdow, type) &&
+	       fdow_byte_string(fdow, filler, len) && fdow_end_array(fdow);
+}
+
+static bool read_bstr(fdor_t *fdor)
+{
+	size_t len = 0;
+
+	return fdor_string_length(fdor, &len) && len <= sizeof(scratch) &&
+	       fdor_byte_string(fdor, scratch, len);
+}
+
+static bool read_int(fdor_t *fdor)
+{
+	int value = 0;
+
+	return fdor_signed_int(fdor, &value);
+}
+
+static bool read_hash(fdor_t *fdor)
+{
+	return fdor_start_array(fdor) && read_int(fdor) && read_bstr(fdor) &&
+	       fdor_end_array(fdor);
+}
+
+/*
+ * COSE_Sign1 = [protected, {unprotected}, payload, signature], with the
+ * unprotected header entries written between head and tail.
+ */
+static bool write_cose_sign1_head(fdow_t *fdow, size_t unprotected_items)
+{
+	return fdow_start_array(fdow, 4) &&
+	       fdow_byte_string(fdow, cose_protected, sizeof(cose_protected)) &&
+	       fdow_start_map(fdow, unprotected_items);
+}
+
+static bool write_cose_sign1_tail(fdow_t *fdow, fdow_t *payload)
+{
+	size_t payload_len = 0;
+
+	return fdow_end_map(fdow) &&
+	       fdow_encoded_length(payload, &payload_len) &&
+	       fdow_byte_string(fdow, payload->b.block, payload_len) &&
+	       fdow_byte_string(fdow, filler, BENCH_SIG_LEN) &&
+	       fdow_end_array(fdow);
+}
+
+static bool read_cose_sign1(fdor_t *fdor, bool (*read_unprotected)(fdor_t *),
+			    bool (*read_payload)(fdor_t *))
+{
+	const uint8_t *payload = NULL;
+	size_t payload_len = 0;
+	fdor_t inner;
+	bool ret = false;
+
+	if (!fdor_start_array(fdor) || !read_bstr(fdor) ||
+	    !fdor_start_map(fdor) || !read_unprotected(fdor) ||
+	    !fdor_end_map(fdor) ||
+	    !fdor_byte_string_view(fdor, &payload, &payload_len)) {
+		return false;
+	}
+	if (!fdor_init(&inner) ||
+	    !fdor_view_init(&inner, payload, payload_len)) {
+		return false;
+	}
+	ret = read_payload(&inner);
+	fdor_view_flush(&inner);
+	return ret && read_bstr(fdor) && fdor_end_array(fdor);
+}
+
+static bool read_nothing(fdor_t *fdor)
+{
+	(void)fdor;
+	return true;
+}
+
+//==============================================================================
+// TO2.ProveOVHdr (61)
+//
+
+static bool encode_msg61(cbor_ctx_t *c)
+{
+	fdow_t *p = &c->inner;
+
+	/* payload: [OVHeader, NumOVEntries, HMac, Nonce, SigInfoB,
+	 *           xAKeyExchange, helloDeviceHash, maxOwnerMessageSize]
+	 */
+	if (!fdow_encoder_init(p) || !fdow_start_array(p, 8) ||
+	    !fdow_byte_string(p, filler, c->size) ||
+	    !fdow_unsigned_int(p, 3) ||
+	    !write_hash(p, BENCH_HMAC_TYPE, BENCH_HASH_LEN) ||
+	    !fdow_byte_string(p, filler, BENCH_NONCE_LEN) ||
+	    !write_hash(p, BENCH_SIG_TYPE, 0) ||
+	    !fdow_byte_string(p, filler, 97) ||
+	    !write_hash(p, BENCH_HASH_TYPE, BENCH_HASH_LEN) ||
+	    !fdow_unsigned_int(p, 8192) || !fdow_end_array(p)) {
+		return false;
+	}
+
+	/* unprotected: {256: nonce, 257: owner public key} */
+	return fdow_encoder_init(&c->fdow) &&
+	       write_cose_sign1_head(&c->fdow, 2) &&
+	       fdow_unsigned_int(&c->fdow, 256) &&
+	       fdow_byte_string(&c->fdow, filler, BENCH_NONCE_LEN) &&
+	       fdow_unsigned_int(&c->fdow, 257) &&
+	       fdow_start_array(&c->fdow, 3) &&
+	       fdow_signed_int(&c->fdow, 11) &&
+	       fdow_signed_int(&c->fdow, 1) &&
+	       fdow_byte_string(&c->fdow, filler, 120) &&
+	       fdow_end_array(&c->fdow) &&
+	       write_cose_sign1_tail(&c->fdow, p) &&
+	       fdow_encoded_length(&c->fdow, &c->msg_len);
+}
+
+static bool read_msg61_unprotected(fdor_t *fdor)
+{
+	return read_int(fdor) && read_bstr(fdor) && read_int(fdor) &&
+	       fdor_start_array(fdor) && read_int(fdor) && read_int(fdor) &&
+	       read_bstr(fdor) && fdor_end_array(fdor);
+}
+
+static bool read_msg61_payload(fdor_t *fdor)
+{
+	return fdor_start_array(fdor) && read_bstr(fdor) && read_int(fdor) &&
+	       read_hash(fdor) && read_bstr(fdor) && read_hash(fdor) &&
+	       read_bstr(fdor) && read_hash(fdor) && read_int(fdor) &&
+	       fdor_end_array(fdor);
+}
+
+static bool decode_msg61(fdor_t *fdor)
+{
+	return read_cose_sign1(fdor, read_msg61_unprotected,
+			       read_msg61_payload);
+}
+
+//==============================================================================
+// TO2.OVNextEntry (63)
+//
+
+static bool encode_msg63(cbor_ctx_t *c)
+{
+	fdow_t *p = &c->inner;
+
+	/* OVEntryPayload: [OVEHashPrevEntry, OVEHashHdrInfo, OVEPubKey] */
+	if (!fdow_encoder_init(p) || !fdow_start_array(p, 3) ||
+	    !write_hash(p, BENCH_HASH_TYPE, BENCH_HASH_LEN) ||
+	    !write_hash(p, BENCH_HASH_TYPE, BENCH_HASH_LEN) ||
+	    !fdow_start_array(p, 3) || !fdow_signed_int(p, 11) ||
+	    !fdow_signed_int(p, 1) || !fdow_byte_string(p, filler, c->size) ||
+	    !fdow_end_array(p) || !fdow_end_array(p)) {
+		return false;
+	}
+
+	/* [OVEntryNum, OVEntry] */
+	return fdow_encoder_init(&c->fdow) && fdow_start_array(&c->fdow, 2) &&
+	       fdow_unsigned_int(&c->fdow, 1) &&
+	       write_cose_sign1_head(&c->fdow, 0) &&
+	       write_cose_sign1_tail(&c->fdow, p) &&
+	       fdow_end_array(&c->fdow) &&
+	       fdow_encoded_length(&c->fdow, &c->msg_len);
+}
+
+static bool read_msg63_payload(fdor_t *fdor)
+{
+	return fdor_start_array(fdor) && read_hash(fdor) && read_hash(fdor) &&
+	       fdor_start_array(fdor) && read_int(fdor) && read_int(fdor) &&
+	       read_bstr(fdor) && fdor_end_array(fdor) && fdor_end_array(fdor);
+}
+
+static bool decode_msg63(fdor_t *fdor)
+{
+	return fdor_start_array(fdor) && read_int(fdor) &&
+	       read_cose_sign1(fdor, read_nothing, read_msg63_payload) &&
+	       fdor_end_array(fdor);
+}
+
+//==============================================================================
+// TO2.ProveDevice (64)
+//
+
+static bool encode_msg64(cbor_ctx_t *c)
+{
+	fdow_t *p = &c->inner;
+
+	/* EAT payload: {UEID: ueid, Nonce: nonce, FDO: [xBKeyExchange]} */
+	if (!fdow_encoder_init(p) || !fdow_start_map(p, 3) ||
+	    !fdow_signed_int(p, -258) ||
+	    !fdow_byte_string(p, filler, BENCH_UEID_LEN) ||
+	    !fdow_signed_int(p, 10) ||
+	    !fdow_byte_string(p, filler, BENCH_NONCE_LEN) ||
+	    !fdow_signed_int(p, -257) || !fdow_start_array(p, 1) ||
+	    !fdow_byte_string(p, filler, c->size) || !fdow_end_array(p) ||
+	    !fdow_end_map(p)) {
+		return false;
+	}
+
+	/* unprotected: {EUPHNonce: nonce} */
+	return fdow_encoder_init(&c->fdow) &&
+	       write_cose_sign1_head(&c->fdow, 1) &&
+	       fdow_signed_int(&c->fdow, -259) &&
+	       fdow_byte_string(&c->fdow, filler, BENCH_NONCE_LEN) &&
+	       write_cose_sign1_tail(&c->fdow, p) &&
+	       fdow_encoded_length(&c->fdow, &c->msg_len);
+}
+
+static bool read_msg64_unprotected(fdor_t *fdor)
+{
+	return read_int(fdor) && read_bstr(fdor);
+}
+
+static bool read_msg64_payload(fdor_t *fdor)
+{
+	return fdor_start_map(fdor) && read_int(fdor) && read_bstr(fdor) &&
+	       read_int(fdor) && read_bstr(fdor) && read_int(fdor) &&
+	       fdor_start_array(fdor) && read_bstr(fdor) &&
+	       fdor_end_array(fdor) && fdor_end_map(fdor);
+}
+
+static bool decode_msg64(fdor_t *fdor)
+{
+	return read_cose_sign1(fdor, read_msg64_unprotected,
+			       read_msg64_payload);
+}
+
+//==============================================================================
+// TO2.DeviceServiceInfo (68) and TO2.OwnerServiceInfo (69)
+//
+
+/* ServiceInfo = [[key, value]...], values of up to BENCH_SVI_VALUE_LEN */
+static bool write_serviceinfo(fdow_t *fdow, size_t size)
+{
+	size_t count = (size + BENCH_SVI_VALUE_LEN - 1) / BENCH_SVI_VALUE_LEN;
+	size_t left = size;
+	size_t i;
+
+	if (!fdow_start_array(fdow, count)) {
+		return false;
+	}
+	for (i = 0; i < count; i++) {
+		size_t len = left < BENCH_SVI_VALUE_LEN ? left
+							: BENCH_SVI_VALUE_LEN;
+
+		if (!fdow_start_array(fdow, 2) ||
+		    !fdow_text_string(fdow, svi_key, sizeof(svi_key) - 1) ||
+		    !fdow_byte_string(fdow, filler, len) ||
+		    !fdow_end_array(fdow)) {
+			return false;
+		}
+		left -= len;
+	}
+	return fdow_end_array(fdow);
+}
+
+static bool read_serviceinfo(fdor_t *fdor)
+{
+	size_t count = 0;
+	size_t i;
+
+	if (!fdor_array_length(fdor, &count) || !fdor_start_array(fdor)) {
+		return false;
+	}
+	for (i = 0; i < count; i++) {
+		size_t key_len = 0;
+
+		if (!fdor_start_array(fdor) ||
+		    !fdor_string_length(fdor, &key_len) ||
+		    key_len >= sizeof(scratch) ||
+		    !fdor_text_string(fdor, (char *)scratch, key_len) ||
+		    !read_bstr(fdor) || !fdor_end_array(fdor)) {
+			return false;
+		}
+	}
+	return fdor_end_array(fdor);
+}
+
+static bool encode_msg68(cbor_ctx_t *c)
+{
+	/* [IsMoreServiceInfo, ServiceInfo] */
+	return fdow_encoder_init(&c->fdow) && fdow_start_array(&c->fdow, 2) &&
+	       fdow_boolean(&c->fdow, false) &&
+	       write_serviceinfo(&c->fdow, c->size) &&
+	       fdow_end_array(&c->fdow) &&
+	       fdow_encoded_length(&c->fdow, &c->msg_len);
+}
+
+static bool decode_msg68(fdor_t *fdor)
+{
+	bool more = false;
+
+	return fdor_start_array(fdor) && fdor_boolean(fdor, &more) &&
+	       read_serviceinfo(fdor) && fdor_end_array(fdor);
+}
+
+static bool encode_msg69(cbor_ctx_t *c)
+{
+	/* [IsMoreServiceInfo, IsDone, ServiceInfo] */
+	return fdow_encoder_init(&c->fdow) && fdow_start_array(&c->fdow, 3) &&
+	       fdow_boolean(&c->fdow, false) &&
+	       fdow_boolean(&c->fdow, true) &&
+	       write_serviceinfo(&c->fdow, c->size) &&
+	       fdow_end_array(&c->fdow) &&
+	       fdow_encoded_length(&c->fdow, &c->msg_len);
+}
+
+static bool decode_msg69(fdor_t *fdor)
+{
+	bool more = false;
+	bool done = false;
+
+	return fdor_start_array(fdor) && fdor_boolean(fdor, &more) &&
+	       fdor_boolean(fdor, &done) && read_serviceinfo(fdor) &&
+	       fdor_end_array(fdor);
+}
+
+//==============================================================================
+// Benchmarks
+//
+
+static const cbor_msg_t messages[] = {
+    {"cbor_encode_msg61", encode_msg61, decode_msg61},
+    {"cbor_encode_msg63", encode_msg63, decode_msg63},
+    {"cbor_encode_msg64", encode_msg64, decode_msg64},
+    {"cbor_encode_msg68", encode_msg68, decode_msg68},
+    {"cbor_encode_msg69", encode_msg69, decode_msg69},
+};
+
+static const char *const decode_names[] = {
+    "cbor_decode_msg61", "cbor_decode_msg63", "cbor_decode_msg64",
+    "cbor_decode_msg68", "cbor_decode_msg69",
+};
+
+static const size_t sizes[] = {128, 1024, 8192};
+
+static const cbor_msg_t *current_msg;
+
+static bool op_encode(void *ctx)
+{
+	return current_msg->encode((cbor_ctx_t *)ctx);
+}
+
+static bool op_decode(void *ctx)
+{
+	cbor_ctx_t *c = (cbor_ctx_t *)ctx;
+	fdor_t fdor;
+	bool ret = false;
+
+	if (!fdor_init(&fdor) || !fdor_view_init(&fdor, c->msg, c->msg_len)) {
+		return false;
+	}
+	ret = current_msg->decode(&fdor);
+	fdor_view_flush(&fdor);
+	return ret;
+}
+
+void bench_cbor(void)
+{
+	cbor_ctx_t c;
+	size_t m, s;
+
+	memset(&c, 0, sizeof(c));
+	bench_fill(filler, sizeof(filler));
+
+	if (!fdow_init(&c.fdow) || !fdow_init(&c.inner) ||
+	    !fdo_block_alloc_with_size(&c.fdow.b, 2 * BENCH_CBOR_MAX_SIZE) ||
+	    !fdo_block_alloc_with_size(&c.inner.b, 2 * BENCH_CBOR_MAX_SIZE)) {
+		bench_skip("cbor", 0, "allocation failed");
+		goto end;
+	}
+
+	for (m = 0; m < sizeof(messages) / sizeof(messages[0]); m++) {
+		current_msg = &messages[m];
+		for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+			c.size = sizes[s];
+			bench_run(current_msg->name, c.size, op_encode, &c);
+
+			/* decode the message as it was last encoded */
+			if (!current_msg->encode(&c)) {
+				bench_skip(decode_names[m], c.size,
+					   "encoding failed");
+				continue;
+			}
+			c.msg = c.fdow.b.block;
+			bench_run(decode_names[m], c.size, op_decode, &c);
+		}
+	}
+end:
+	fdow_flush(&c.fdow);
+	fdow_flush(&c.inner);
+}
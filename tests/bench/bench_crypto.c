@@ -0,0 +1,181 @@
+/*
+ * Copyright 2020 Intel Corporation
+ * SPDX-License-Identifier: Apache 2.0
+ */
+
+/*!
+ * \file
+ * \brief Crypto HAL benchmarks: signature verification, device signing,
+ * AES encryption/decryption and HMAC, in the mode and key sizes the SDK was
+ * built for (DA and AES_MODE).
+ */
+
+#include "bench.h"
+#include "bench_vectors.h"
+#include "fdoCryptoHal.h"
+#include "fdotypes.h"
+#include <stdio.h>
+
+#define BENCH_CRYPTO_MAX_SIZE 16384
+#define BENCH_SIG_MAX_LEN 256
+#define BENCH_AAD_LEN 16
+
+typedef struct {
+	size_t size;
+	int pk_alg;
+	const uint8_t *pubkey;
+	uint32_t pubkey_len;
+	const uint8_t *sig;
+	uint32_t sig_len;
+} verify_ctx_t;
+
+typedef struct {
+	size_t size;
+	uint8_t key[FDO_AES_KEY_LENGTH];
+	uint8_t iv[AES_IV_LEN];
+	uint8_t tag[AES_TAG_LEN];
+	uint8_t aad[BENCH_AAD_LEN];
+} aes_ctx_t;
+
+static uint8_t clear_text[BENCH_CRYPTO_MAX_SIZE];
+static uint8_t cipher_text[BENCH_CRYPTO_MAX_SIZE + FDO_AES_BLOCK_SIZE];
+static uint8_t decrypted[BENCH_CRYPTO_MAX_SIZE + FDO_AES_BLOCK_SIZE];
+static uint8_t hmac_key[FDO_HMAC_KEY_LENGTH];
+
+static const size_t sizes[] = {64, 1024, 16384};
+
+static bool op_verify(void *ctx)
+{
+	verify_ctx_t *v = (verify_ctx_t *)ctx;
+
+	return 0 == crypto_hal_sig_verify(FDO_CRYPTO_PUB_KEY_ENCODING_X509,
+					  v->pk_alg, clear_text,
+					  (uint32_t)v->size, v->sig, v->sig_len,
+					  v->pubkey, v->pubkey_len, NULL, 0);
+}
+
+static bool op_sign(void *ctx)
+{
+	uint8_t sig[BENCH_SIG_MAX_LEN];
+	size_t sig_len = sizeof(sig);
+
+	return 0 == crypto_hal_ecdsa_sign(clear_text, *(size_t *)ctx, sig,
+					  &sig_len);
+}
+
+static bool op_encrypt(void *ctx)
+{
+	aes_ctx_t *a = (aes_ctx_t *)ctx;
+	uint32_t cipher_len = sizeof(cipher_text);
+
+	return 0 == crypto_hal_aes_encrypt(clear_text, (uint32_t)a->size,
+					   cipher_text, &cipher_len,
+					   FDO_AES_BLOCK_SIZE, a->iv, a->key,
+					   sizeof(a->key), a->tag,
+					   sizeof(a->tag), a->aad,
+					   sizeof(a->aad));
+}
+
+static bool op_decrypt(void *ctx)
+{
+	aes_ctx_t *a = (aes_ctx_t *)ctx;
+	uint32_t clear_len = sizeof(decrypted);
+
+	return 0 == crypto_hal_aes_decrypt(decrypted, &clear_len, cipher_text,
+					   (uint32_t)a->size,
+					   FDO_AES_BLOCK_SIZE, a->iv, a->key,
+					   sizeof(a->key), a->tag,
+					   sizeof(a->tag), a->aad,
+					   sizeof(a->aad));
+}
+
+static bool op_hmac(void *ctx)
+{
+	uint8_t hmac[FDO_SHA_DIGEST_SIZE_USED];
+
+	return 0 == crypto_hal_hmac(FDO_CRYPTO_HMAC_TYPE_USED, clear_text,
+				    *(size_t *)ctx, hmac, sizeof(hmac),
+				    hmac_key, sizeof(hmac_key));
+}
+
+static void bench_verify(void)
+{
+	static const struct {
+		const char *name;
+		int pk_alg;
+		const uint8_t *pubkey;
+		uint32_t pubkey_len;
+		const uint8_t *sigs[3];
+		uint32_t sig_len;
+	} curves[] = {
+	    {"crypto_sig_verify_p256",
+	     FDO_CRYPTO_PUB_KEY_ALGO_ECDSAp256,
+	     bench_p256_pubkey,
+	     sizeof(bench_p256_pubkey),
+	     {bench_p256_sig_64, bench_p256_sig_1024, bench_p256_sig_16384},
+	     sizeof(bench_p256_sig_64)},
+	    {"crypto_sig_verify_p384",
+	     FDO_CRYPTO_PUB_KEY_ALGO_ECDSAp384,
+	     bench_p384_pubkey,
+	     sizeof(bench_p384_pubkey),
+	     {bench_p384_sig_64, bench_p384_sig_1024, bench_p384_sig_16384},
+	     sizeof(bench_p384_sig_64)},
+	};
+	verify_ctx_t v;
+	size_t c, s;
+
+	for (c = 0; c < sizeof(curves) / sizeof(curves[0]); c++) {
+		for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+			v.size = sizes[s];
+			v.pk_alg = curves[c].pk_alg;
+			v.pubkey = curves[c].pubkey;
+			v.pubkey_len = curves[c].pubkey_len;
+			v.sig = curves[c].sigs[s];
+			v.sig_len = curves[c].sig_len;
+			bench_run(curves[c].name, v.size, op_verify, &v);
+		}
+	}
+}
+
+void bench_crypto(void)
+{
+	aes_ctx_t a;
+	size_t size;
+	size_t s;
+
+	bench_fill(clear_text, sizeof(clear_text));
+	bench_fill(hmac_key, sizeof(hmac_key));
+	bench_fill(a.key, sizeof(a.key));
+	bench_fill(a.iv, sizeof(a.iv));
+	bench_fill(a.aad, sizeof(a.aad));
+
+	bench_verify();
+
+	for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		size = sizes[s];
+		/* signs with the device key, present after DI */
+		if (!op_sign(&size)) {
+			bench_skip("crypto_ecdsa_sign", size,
+				   "no device private key");
+			continue;
+		}
+		bench_run("crypto_ecdsa_sign", size, op_sign, &size);
+	}
+
+	for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		a.size = sizes[s];
+		bench_run("crypto_aes_encrypt", a.size, op_encrypt, &a);
+		/* decrypt what was last encrypted, with its tag */
+		if (!op_encrypt(&a)) {
+			bench_skip("crypto_aes_decrypt", a.size,
+				   "encryption failed");
+			continue;
+		}
+		bench_run("crypto_aes_decrypt", a.size, op_decrypt, &a);
+	}
+
+	for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		size = sizes[s];
+		bench_run("crypto_hmac", size, op_hmac, &size);
+	}
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2020 Intel Corporation
+ * SPDX-License-Identifier: Apache 2.0
+ */
+
+/*!
+ * \file
+ * \brief Storage benchmarks: fdo_blob_write() and fdo_blob_read() for every
+ * blob flag the platform supports. Normal and secure blobs need the platform
+ * HMAC/AES keys, so the benchmarks run from a directory where linux-client has
+ * provisioned them (data/ under BLOB_PATH).
+ */
+
+#include "bench.h"
+#include "storage_al.h"
+#include <stdio.h>
+
+#define BENCH_STORAGE_MAX_SIZE 8192
+
+typedef struct {
+	const char *blob;
+	fdo_sdk_blob_flags flags;
+	uint32_t size;
+} storage_ctx_t;
+
+static uint8_t data[BENCH_STORAGE_MAX_SIZE];
+static uint8_t read_back[BENCH_STORAGE_MAX_SIZE];
+
+static const uint32_t sizes[] = {64, 1024, 8192};
+
+static bool op_write(void *ctx)
+{
+	storage_ctx_t *st = (storage_ctx_t *)ctx;
+
+	return (int32_t)st->size ==
+	       fdo_blob_write(st->blob, st->flags, data, st->size);
+}
+
+static bool op_read(void *ctx)
+{
+	storage_ctx_t *st = (storage_ctx_t *)ctx;
+
+	return (int32_t)st->size ==
+	       fdo_blob_read(st->blob, st->flags, read_back, st->size);
+}
+
+void bench_storage(void)
+{
+	static const struct {
+		const char *write_name;
+		const char *read_name;
+		const char *blob;
+		fdo_sdk_blob_flags flags;
+	} blobs[] = {
+	    {"storage_write_raw", "storage_read_raw", "data/bench_raw.blob",
+	     FDO_SDK_RAW_DATA},
+	    {"storage_write_normal", "storage_read_normal",
+	     "data/bench_normal.blob", FDO_SDK_NORMAL_DATA},
+	    {"storage_write_secure", "storage_read_secure",
+	     "data/bench_secure.blob", FDO_SDK_SECURE_DATA},
+	};
+	storage_ctx_t st;
+	size_t b, s;
+
+	bench_fill(data, sizeof(data));
+
+	for (b = 0; b < sizeof(blobs) / sizeof(blobs[0]); b++) {
+		st.blob = blobs[b].blob;
+		st.flags = blobs[b].flags;
+		for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+			st.size = sizes[s];
+			if (!op_write(&st)) {
+				bench_skip(blobs[b].write_name, st.size,
+					   "blob write failed, platform keys "
+					   "not provisioned?");
+				bench_skip(blobs[b].read_name, st.size,
+					   "blob write failed");
+				continue;
+			}
+			bench_run(blobs[b].write_name, st.size, op_write, &st);
+			bench_run(blobs[b].read_name, st.size, op_read, &st);
+		}
+		if (remove(st.blob) != 0) {
+			fprintf(stderr, "%s: not removed\n", st.blob);
+		}
+	}
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2020 Intel Corporation
+ * SPDX-License-Identifier: Apache 2.0
+ */
+
+/*!
+ * \file
+ * \brief Fixed signature verification inputs for the crypto benchmarks:
+ * X.509 (SubjectPublicKeyInfo DER) public keys for P-256 and P-384, and raw
+ * r||s signatures over bench_fill() messages of 64, 1024 and 16384 bytes.
+ */
+
+#ifndef __BENCH_VECTORS_H__
+#define __BENCH_VECTORS_H__
+
+#include <stdint.h>
+
+static const uint8_t bench_p256_pubkey[] = {
+	0x30, 0x59, 0x30, 0x13, 0x06, 0x07, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x02,
+	0x01, 0x06, 0x08, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x03, 0x01, 0x07, 0x03,
+	0x42, 0x00, 0x04, 0x78, 0x19, 0x22, 0xf1, 0x29, 0x5e, 0x3f, 0xd8, 0xbc,
+	0x14, 0xf2, 0x5e, 0xd2, 0xee, 0xdf, 0x84, 0xe3, 0x20, 0xed, 0x70, 0x62,
+	0x9e, 0x77, 0xb2, 0x07, 0x46, 0x7a, 0xa2, 0x22, 0x08, 0x78, 0xfb, 0xca,
+	0x3e, 0x98, 0x00, 0x5c, 0x2c, 0x86, 0x1a, 0x0a, 0xff, 0x37, 0x02, 0x21,
+	0xe1, 0x84, 0xc7, 0x0c, 0x72, 0x9b, 0x6f, 0x16, 0x88, 0x78, 0xbf, 0x82,
+	0x04, 0xe7, 0x54, 0xc9, 0x7f, 0xef, 0xca,
+};
+
+static const uint8_t bench_p256_sig_64[] = {
+	0x56, 0x75, 0xec, 0xdf, 0xe4, 0x33, 0x18, 0xfa, 0xa9, 0xab, 0xb3, 0xf0,
+	0xc7, 0x0c, 0xe2, 0xef, 0x66, 0x02, 0x6b, 0x3e, 0xfe, 0x27, 0x86, 0x81,
+	0x79, 0x34, 0xf7, 0x8a, 0x45, 0x5d, 0x2a, 0x83, 0x81, 0x81, 0x69, 0xb3,
+	0x96, 0xd4, 0x54, 0x4f, 0x57, 0x6d, 0x2b, 0x42, 0xb7, 0x0a, 0x19, 0x96,
+	0x9c, 0xce, 0x1f, 0x4a, 0xcf, 0x8f, 0x06, 0xa6, 0xe9, 0x17, 0xef, 0xb2,
+	0x68, 0xaa, 0xb6, 0x2c,
+};
+
+static const uint8_t bench_p256_sig_1024[] = {
+	0x2a, 0x78, 0x89, 0x75, 0xef, 0x3a, 0x9c, 0x0b, 0x7d, 0xbc, 0xc6, 0x02,
+	0x29, 0x70, 0xf1, 0x46, 0xfb, 0xd8, 0x7b, 0xc4, 0xb9, 0xd9, 0xa5, 0xed,
+	0x33, 0xbd, 0x1f, 0x6c, 0x59, 0x21, 0x33, 0x3c, 0x26, 0x3b, 0x19, 0x03,
+	0x0c, 0x42, 0x75, 0x8a, 0x56, 0x46, 0x0a, 0x63, 0xd7, 0xe5, 0xbc, 0xf0,
+	0x1f, 0xca, 0x9b, 0x77, 0xa5, 0xb8, 0xf8, 0xcc, 0x66, 0x3b, 0xd4, 0x13,
+	0x7e, 0xbe, 0x24, 0xb0,
+};
+
+static const uint8_t bench_p256_sig_16384[] = {
+	0xb2, 0x8d, 0xc6, 0xf1, 0x26, 0xc8, 0x2b, 0xb8, 0xd8, 0xd0, 0xc3, 0x42,
+	0x4e, 0x73, 0x9d, 0x01, 0x78, 0x3a, 0x27, 0x11, 0x17, 0xfc, 0x39, 0x9e,
+	0x44, 0xc1, 0x48, 0x15, 0x3d, 0x5e, 0x9d, 0x47, 0x99, 0x6f, 0x8f, 0xdf,
+	0x2e, 0x71, 0xba, 0xe3, 0x25, 0x43, 0x7d, 0x79, 0xbf, 0xf0, 0x6f, 0x08,
+	0xc2, 0xd4, 0xb3, 0x60, 0x81, 0x9e, 0xcc, 0xe7, 0xba, 0x9b, 0xda, 0x00,
+	0x4a, 0x52, 0x64, 0xba,
+};
+
+static const uint8_t bench_p384_pubkey[] = {
+	0x30, 0x76, 0x30, 0x10, 0x06, 0x07, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x02,
+	0x01, 0x06, 0x05, 0x2b, 0x81, 0x04, 0x00, 0x22, 0x03, 0x62, 0x00, 0x04,
+	0x6c, 0x7e, 0x68, 0x1f, 0xd5, 0x4e, 0x0a, 0xbb, 0x49, 0x4d, 0xef, 0x67,
+	0xd7, 0x2d, 0xfb, 0x2b, 0xa9, 0x62, 0x3e, 0x03, 0x94, 0xb2, 0x12, 0xd8,
+	0x69, 0x19, 0x84, 0x10, 0xc0, 0x14, 0xec, 0x38, 0x80, 0xb4, 0xa2, 0x41,
+	0xd0, 0x3c, 0x63, 0x07, 0xd0, 0x07, 0xb1, 0xc5, 0x3f, 0x80, 0xd8, 0x32,
+	0x4b, 0xed, 0x12, 0x18, 0x8c, 0x2e, 0xde, 0x4b, 0x7f, 0xd0, 0x98, 0x4b,
+	0x41, 0x00, 0xc6, 0xcd, 0xa3, 0xed, 0xa2, 0x08, 0x3b, 0xd9, 0x74, 0xac,
+	0xee, 0x42, 0x93, 0x1f, 0xb3, 0xee, 0xef, 0xf4, 0x72, 0xd3, 0x57, 0xc0,
+	0x8c, 0xc8, 0xf3, 0x72, 0x2c, 0x1e, 0xec, 0xc7, 0x15, 0x05, 0xb5, 0xdc,
+};
+
+static const uint8_t bench_p384_sig_64[] = {
+	0x57, 0x2f, 0x3c, 0x06, 0x5f, 0x3a, 0x6b, 0xe2, 0x2b, 0xae, 0x70, 0x75,
+	0x8d, 0xb6, 0x41, 0xa6, 0xeb, 0xf9, 0x00, 0xac, 0xe0, 0xcb, 0x67, 0xc6,
+	0xf9, 0xeb, 0x63, 0x92, 0x43, 0x16, 0x60, 0x7a, 0x08, 0x1b, 0x8f, 0x45,
+	0xc8, 0x93, 0xd9, 0x8a, 0x21, 0xb8, 0x7b, 0xc9, 0x74, 0xc6, 0xc5, 0x51,
+	0x09, 0xb3, 0x41, 0x26, 0x54, 0x2e, 0xf0, 0x0d, 0xe9, 0x74, 0x9f, 0x2e,
+	0x94, 0x2a, 0x23, 0xa6, 0x93, 0xb5, 0x26, 0x12, 0xc1, 0x65, 0x69, 0x01,
+	0x32, 0xf7, 0x18, 0x4e, 0x02, 0xb6, 0x7c, 0xa2, 0x9c, 0xa0, 0x26, 0x59,
+	0x1a, 0x70, 0x92, 0x63, 0x34, 0xd8, 0x85, 0x4f, 0x6e, 0xbb, 0x07, 0x4b,
+};
+
+static const uint8_t bench_p384_sig_1024[] = {
+	0xec, 0x32, 0xd8, 0x66, 0x40, 0x05, 0x00, 0x46, 0x0a, 0x53, 0x35, 0x28,
+	0x06, 0x15, 0xbc, 0x35, 0xdf, 0x70, 0xf7, 0xd1, 0x6d, 0x04, 0xbf, 0x63,
+	0x8e, 0x51, 0xeb, 0x0f, 0x54, 0x65, 0x9a, 0x97, 0x98, 0x30, 0x17, 0x68,
+	0x45, 0xb9, 0x18, 0x64, 0x56, 0xf7, 0x5b, 0xaa, 0x9a, 0x7b, 0x1f, 0x15,
+	0x82, 0xb7, 0x8d, 0xcf, 0x3f, 0x74, 0x3b, 0xe3, 0x82, 0xc5, 0x95, 0xb7,
+	0x49, 0x5b, 0x12, 0xa3, 0x2b, 0xc8, 0x4f, 0x93, 0x7e, 0xdc, 0x6f, 0xc5,
+	0x1c, 0x71, 0xc2, 0x57, 0xdf, 0xfc, 0xf0, 0x99, 0xad, 0xc8, 0x8d, 0xfb,
+	0x80, 0x2d, 0x7a, 0x58, 0x19, 0xa9, 0x44, 0x04, 0xe2, 0xb8, 0xef, 0x3a,
+};
+
+static const uint8_t bench_p384_sig_16384[] = {
+	0x99, 0x9f, 0x10, 0x57, 0xd1, 0xca, 0x5a, 0x2a, 0x0b, 0x23, 0x43, 0xe0,
+	0x1c, 0x46, 0x6e, 0xe4, 0x0b, 0x95, 0x03, 0x35, 0x48, 0xd5, 0x0b, 0x18,
+	0x22, 0x6c, 0x11, 0xe6, 0x2c, 0x2f, 0xc4, 0x1f, 0xb3, 0x86, 0xa1, 0xca,
+	0xed, 0x30, 0x7a, 0x18, 0x75, 0xaa, 0x68, 0x38, 0xe4, 0x16, 0xca, 0xfa,
+	0x58, 0x24, 0x0b, 0xb2, 0x27, 0xf7, 0x4c, 0x58, 0xde, 0x6f, 0x26, 0x65,
+	0x7c, 0xfa, 0x11, 0xb6, 0x6d, 0xeb, 0xbe, 0x10, 0xd2, 0x9f, 0x08, 0xb4,
+	0xaf, 0x32, 0x5f, 0xeb, 0x4a, 0x19, 0xaa, 0x0e, 0xf1, 0xed, 0xa1, 0x40,
+	0x19, 0xce, 0x77, 0x78, 0xcd, 0xd3, 0x48, 0x9b, 0x62, 0x90, 0xf7, 0x17,
+};
+
+#endif /* __BENCH_VECTORS_H__ */
@@ -515,6 +515,22 @@ static void ec_sig_verification(int curve)
 
 			TEST_ASSERT_EQUAL(0, result);
 
+			/* the same signature verifies over a precomputed digest */
+			uint8_t digest[SHA384_DIGEST_SIZE] = {0};
+			size_t digest_length = (curve == 256) ? SHA256_DIGEST_SIZE
+							      : SHA384_DIGEST_SIZE;
+			result = crypto_hal_hash(
+			    (curve == 256) ? FDO_CRYPTO_HASH_TYPE_SHA_256
+					   : FDO_CRYPTO_HASH_TYPE_SHA_384,
+			    testdata->bytes, testdata->byte_sz, digest,
+			    digest_length);
+			TEST_ASSERT_EQUAL(0, result);
+			result = crypto_hal_sig_verify_digest(
+			    pk->pkenc, pk->pkalg, digest, digest_length,
+			    sigtestdata, siglen, pk->key1->bytes,
+			    pk->key1->byte_sz, NULL, 0);
+			TEST_ASSERT_EQUAL(0, result);
+
 			/* force a failure by using wrong size signature */
 			result = crypto_hal_sig_verify(
 			    pk->pkenc, pk->pkalg, testdata->bytes,
@@ -35,6 +35,7 @@ void test_read_secure_device_credentials(void);
 void test_load_credential(void);
 void test_read_write_Device_credentials(void);
 void test_store_credential(void);
+void test_store_credentials(void);
 
 /*** Wrapper Functions ***/
 bool __real_fdor_next_block(fdor_t *fdor, uint32_t *typep);
@@ -454,3 +455,55 @@ void test_store_credential(void)
 	fdo_free(module_info);
 }
 
+#ifdef TARGET_OS_FREERTOS
+TEST_CASE("store_credentials", "[credentials][fdo]")
+#else
+void test_store_credentials(void)
+#endif
+{
+#if !defined (AES_MODE_GCM_ENABLED) || AES_BITS != 256
+	TEST_IGNORE();
+#endif
+	int ret = -1;
+
+	fdo_sdk_service_info_module *module_info = NULL;
+	module_info = fdo_sv_info_modules_init();
+	TEST_ASSERT_NOT_NULL(module_info);
+	ret = fdo_sdk_init(NULL, FDO_MAX_MODULES, module_info);
+	TEST_ASSERT_EQUAL(FDO_SUCCESS, ret);
+
+	configure_blobs();
+
+	ret = load_device_secret();
+	TEST_ASSERT_EQUAL_INT(0, ret);
+
+	fdo_dev_cred_t *ocred = app_get_credentials();
+	TEST_ASSERT_NOT_NULL(ocred);
+
+	// Negative Case
+	ret = store_credentials(NULL, FDO_CRED_STORE_SECRET);
+	TEST_ASSERT_EQUAL(-1, ret);
+
+	// state only, the secret blob is left as it is
+	ocred->ST = FDO_DEVICE_STATE_READYN;
+	ret = store_credentials(ocred, 0);
+	TEST_ASSERT_EQUAL(0, ret);
+
+	// everything, sealed with a new storage key
+	ret = store_credentials(ocred, FDO_CRED_STORE_SECRET |
+					   FDO_CRED_STORE_ROTATE_KEY);
+	TEST_ASSERT_EQUAL(0, ret);
+
+	// what was stored reads back, into fresh credentials
+	ret = load_device_secret();
+	TEST_ASSERT_EQUAL_INT(0, ret);
+	ocred = app_alloc_credentials();
+	TEST_ASSERT_NOT_NULL(ocred);
+	fdo_dev_cred_init(ocred);
+	ret = load_credential(ocred);
+	TEST_ASSERT_EQUAL_INT(0, ret);
+	TEST_ASSERT_EQUAL_INT(FDO_DEVICE_STATE_READYN, ocred->ST);
+
+	fdo_sdk_deinit();
+	fdo_free(module_info);
+}
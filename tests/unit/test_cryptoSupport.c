@@ -122,6 +122,8 @@ void test_fdo_device_sign_invalid_message(void);
 void test_fdo_device_sign_invalid_message_len(void);
 void testcrypto_hal_hash(void);
 void testcrypto_hal_hash_SHA384(void);
+void test_fdo_crypto_hash_incremental(void);
+void test_fdo_ov_verify_init_suite(void);
 void test_fdo_cryptoHASH_invalid_message(void);
 void test_fdo_cryptoHASH_invalid_message_len(void);
 void test_fdo_cryptoHASH_invalid_hash(void);
@@ -2714,6 +2716,86 @@ TEST_CASE("fdo_crypto_hash_SHA384", "[crypto_support][fdo]")
 	fdo_hash_free(hash1);
 }
 
+#ifndef TARGET_OS_FREERTOS
+void test_fdo_crypto_hash_incremental(void)
+#else
+TEST_CASE("fdo_crypto_hash_incremental", "[crypto_support][fdo]")
+#endif
+{
+	int ret;
+	int result_memcmp = 1;
+	uint8_t *message = test_buff1;
+	size_t message_len = TEST_BUFF_SZ;
+	void *ctx = NULL;
+	fdo_hash_t *hash1 =
+	    fdo_hash_alloc(FDO_CRYPTO_HASH_TYPE_USED, FDO_SHA_DIGEST_SIZE_USED);
+	fdo_hash_t *hash2 =
+	    fdo_hash_alloc(FDO_CRYPTO_HASH_TYPE_USED, FDO_SHA_DIGEST_SIZE_USED);
+
+	TEST_ASSERT_NOT_NULL(hash1);
+	TEST_ASSERT_NOT_NULL(hash2);
+
+	ret = fdo_crypto_hash(message, message_len, hash1->hash->bytes,
+			      hash1->hash->byte_sz);
+	TEST_ASSERT_EQUAL(0, ret);
+
+	/* Positive test case: the same digest when fed in two ranges */
+	ctx = fdo_crypto_hash_init();
+	TEST_ASSERT_NOT_NULL(ctx);
+	ret = fdo_crypto_hash_update(ctx, message, 3);
+	TEST_ASSERT_EQUAL(0, ret);
+	ret = fdo_crypto_hash_update(ctx, message + 3, message_len - 3);
+	TEST_ASSERT_EQUAL(0, ret);
+	ret = fdo_crypto_hash_final(ctx, hash2->hash->bytes,
+				    hash2->hash->byte_sz);
+	TEST_ASSERT_EQUAL(0, ret);
+	ret = memcmp_s(hash1->hash->bytes, hash1->hash->byte_sz,
+		       hash2->hash->bytes, hash2->hash->byte_sz,
+		       &result_memcmp);
+	TEST_ASSERT_EQUAL(0, ret);
+	TEST_ASSERT_EQUAL(0, result_memcmp);
+
+	/* Negative test cases */
+	ctx = fdo_crypto_hash_init();
+	TEST_ASSERT_NOT_NULL(ctx);
+	ret = fdo_crypto_hash_update(ctx, NULL, message_len);
+	TEST_ASSERT_EQUAL(-1, ret);
+	ret = fdo_crypto_hash_update(NULL, message, message_len);
+	TEST_ASSERT_EQUAL(-1, ret);
+	/* releases the context without a digest */
+	ret = fdo_crypto_hash_final(ctx, NULL, 0);
+	TEST_ASSERT_EQUAL(-1, ret);
+	ret = fdo_crypto_hash_final(NULL, hash2->hash->bytes,
+				    hash2->hash->byte_sz);
+	TEST_ASSERT_EQUAL(-1, ret);
+
+	fdo_hash_free(hash1);
+	fdo_hash_free(hash2);
+}
+
+#ifndef TARGET_OS_FREERTOS
+void test_fdo_ov_verify_init_suite(void)
+#else
+TEST_CASE("fdo_ov_verify_init_suite", "[crypto_support][fdo]")
+#endif
+{
+	fdo_public_key_t pubkey = {0};
+	void *ctx = NULL;
+
+	/* Only keys of the build's crypto suite can be verified */
+	pubkey.pkalg = FDO_PK_ALGO;
+	ctx = fdo_ov_verify_init(&pubkey);
+	TEST_ASSERT_NOT_NULL(ctx);
+	/* releases the context */
+	(void)fdo_crypto_hash_final(ctx, NULL, 0);
+
+	pubkey.pkalg = (FDO_PK_ALGO == FDO_CRYPTO_PUB_KEY_ALGO_ECDSAp256) ?
+			   FDO_CRYPTO_PUB_KEY_ALGO_ECDSAp384 :
+			   FDO_CRYPTO_PUB_KEY_ALGO_ECDSAp256;
+	TEST_ASSERT_NULL(fdo_ov_verify_init(&pubkey));
+	TEST_ASSERT_NULL(fdo_ov_verify_init(NULL));
+}
+
 #ifndef TARGET_OS_FREERTOS
 void test_fdo_cryptoHASH_invalid_message(void)
 #else
@@ -18,6 +18,7 @@
 #include "crypto_utils.h"
 #include "fdoCryptoHal.h"
 #include "fdoCrypto.h"
+#include "fdobufpool.h"
 
 #ifdef TARGET_OS_LINUX
 /*
@@ -39,6 +40,8 @@ int __wrap_crypto_hal_hmac(uint8_t hmac_type, uint8_t *buffer,
 			   size_t key_length);
 void test_aes_encrypt_packet(void);
 void test_aes_decrypt_packet(void);
+void test_aes_decrypt_packet_to_buf(void);
+void test_fdo_encrypted_packet_unwind(void);
 
 /*** Unity functions. ***/
 /**
@@ -315,3 +318,161 @@ void test_aes_decrypt_packet(void)
 	fdo_free(keyset);
 	fdo_byte_array_free(cleartext_decrypted);
 }
+
+#ifdef TARGET_OS_FREERTOS
+TEST_CASE("aes_decrypt_packet_to_buf", "[crypto_utils][fdo]")
+#else
+void test_aes_decrypt_packet_to_buf(void)
+#endif
+{
+	int ret = -1;
+	int diff = 1;
+	size_t i = 0;
+	size_t clear_sz = 0;
+	uint8_t aad[16] = {0};
+	uint8_t clear_buf[PLAIN_TEXT_SIZE] = {0};
+	fdo_encrypted_packet_t *cipher_txt =
+	    fdo_alloc(sizeof(fdo_encrypted_packet_t));
+	fdo_byte_array_t *cleartext = getcleartext(PLAIN_TEXT_SIZE);
+	fdo_byte_array_t *cleartext_decrypted =
+	    fdo_byte_array_alloc(PLAIN_TEXT_SIZE);
+
+	TEST_ASSERT_NOT_NULL(cipher_txt);
+	TEST_ASSERT_NOT_NULL(cleartext);
+	TEST_ASSERT_NOT_NULL(cleartext_decrypted);
+
+	ret = random_init();
+	TEST_ASSERT_EQUAL_MESSAGE(0, ret, "Entropy setup Failed");
+	ret = fdo_kex_init();
+	TEST_ASSERT_EQUAL_INT(0, ret);
+
+	ret = aes_encrypt_packet(cipher_txt, cleartext->bytes, PLAIN_TEXT_SIZE,
+				 aad, sizeof(aad));
+	TEST_ASSERT_EQUAL_MESSAGE(0, ret, "AES Encryption Failed");
+
+	/* Negative Test Case: the buffer is too small, and left untouched */
+	clear_sz = PLAIN_TEXT_SIZE - 1;
+	ret = aes_decrypt_packet_to_buf(cipher_txt, clear_buf, &clear_sz, aad,
+					sizeof(aad));
+	TEST_ASSERT_EQUAL_INT(-1, ret);
+	TEST_ASSERT_EQUAL(PLAIN_TEXT_SIZE - 1, clear_sz);
+	for (i = 0; i < sizeof(clear_buf); i++) {
+		TEST_ASSERT_EQUAL_UINT8(0, clear_buf[i]);
+	}
+
+	/* Positive Test Case */
+	clear_sz = sizeof(clear_buf);
+	ret = aes_decrypt_packet_to_buf(cipher_txt, clear_buf, &clear_sz, aad,
+					sizeof(aad));
+	TEST_ASSERT_EQUAL_INT(0, ret);
+	TEST_ASSERT_EQUAL(PLAIN_TEXT_SIZE, clear_sz);
+	ret = memcmp_s(clear_buf, sizeof(clear_buf), cleartext->bytes,
+		       PLAIN_TEXT_SIZE, &diff);
+	TEST_ASSERT_EQUAL_INT(0, ret);
+	TEST_ASSERT_EQUAL_INT(0, diff);
+
+	/* Negative Test Case: a tampered tag fails the decryption, and no
+	 * unauthenticated text is left in the clear text buffer */
+	cipher_txt->tag[0] ^= 0xff;
+	ret = memset_s(cleartext_decrypted->bytes,
+		       cleartext_decrypted->byte_sz, 0xa5);
+	TEST_ASSERT_EQUAL_INT(0, ret);
+	ret = aes_decrypt_packet(cipher_txt, cleartext_decrypted, aad,
+				 sizeof(aad));
+	TEST_ASSERT_EQUAL_INT(-1, ret);
+	for (i = 0; i < cleartext_decrypted->byte_sz; i++) {
+		TEST_ASSERT_EQUAL_UINT8(0, cleartext_decrypted->bytes[i]);
+	}
+
+	ret = fdo_kex_close();
+	TEST_ASSERT_EQUAL_INT(0, ret);
+
+	fdo_byte_array_free(cleartext);
+	fdo_byte_array_free(cleartext_decrypted);
+	if (cipher_txt->em_body) {
+		fdo_byte_array_free(cipher_txt->em_body);
+	}
+	fdo_free(cipher_txt);
+}
+
+#ifdef TARGET_OS_FREERTOS
+TEST_CASE("fdo_encrypted_packet_unwind", "[crypto_utils][fdo]")
+#else
+void test_fdo_encrypted_packet_unwind(void)
+#endif
+{
+	int ret = -1;
+	int diff = 1;
+	bool bret = false;
+	size_t msg_sz = 0;
+	size_t read_sz = 0;
+	uint8_t *cipher_block = NULL;
+	uint8_t read_buf[PLAIN_TEXT_SIZE] = {0};
+	fdow_t fdow = {0};
+	fdor_t fdor = {0};
+	fdo_encrypted_packet_t *pkt = NULL;
+	fdo_byte_array_t *cleartext = getcleartext(PLAIN_TEXT_SIZE);
+
+	TEST_ASSERT_NOT_NULL(cleartext);
+
+	ret = random_init();
+	TEST_ASSERT_EQUAL_MESSAGE(0, ret, "Entropy setup Failed");
+	ret = fdo_kex_init();
+	TEST_ASSERT_EQUAL_INT(0, ret);
+
+	// encrypt a bstr the way a message is sent
+	TEST_ASSERT_TRUE(fdow_init(&fdow));
+	TEST_ASSERT_TRUE(fdo_block_alloc_pooled(&fdow.b, BUFF_SIZE_4K_BYTES));
+	TEST_ASSERT_TRUE(fdow_encoder_init(&fdow));
+	TEST_ASSERT_TRUE(fdow_byte_string(&fdow, cleartext->bytes,
+					  PLAIN_TEXT_SIZE));
+	TEST_ASSERT_TRUE(fdo_encrypted_packet_windup(&fdow, 0));
+	TEST_ASSERT_TRUE(fdow_encoded_length(&fdow, &msg_sz));
+
+	// and receive it into a pooled fdor buffer
+	TEST_ASSERT_TRUE(fdor_init(&fdor));
+	TEST_ASSERT_TRUE(fdo_block_alloc_pooled(&fdor.b, BUFF_SIZE_4K_BYTES));
+	ret = memcpy_s(fdor.b.block, fdor.b.block_size, fdow.b.block, msg_sz);
+	TEST_ASSERT_EQUAL_INT(0, ret);
+	fdor.b.block_size = msg_sz;
+	TEST_ASSERT_TRUE(fdor_parser_init(&fdor));
+
+	/* Positive Test Case: the cipher is read as a view, and the fdor
+	 * buffer is replaced by the cleartext */
+	pkt = fdo_encrypted_packet_read(&fdor);
+	TEST_ASSERT_NOT_NULL(pkt);
+	TEST_ASSERT_TRUE(pkt->em_body->bytes > fdor.b.block &&
+			 pkt->em_body->bytes < fdor.b.block + msg_sz);
+	cipher_block = fdor.b.block;
+	TEST_ASSERT_TRUE(fdo_encrypted_packet_unwind(&fdor, pkt,
+						     BUFF_SIZE_4K_BYTES));
+	TEST_ASSERT_TRUE(fdor.b.block != cipher_block);
+	TEST_ASSERT_TRUE(fdor_string_length(&fdor, &read_sz));
+	TEST_ASSERT_EQUAL(PLAIN_TEXT_SIZE, read_sz);
+	TEST_ASSERT_TRUE(fdor_byte_string(&fdor, read_buf, read_sz));
+	ret = memcmp_s(read_buf, sizeof(read_buf), cleartext->bytes,
+		       PLAIN_TEXT_SIZE, &diff);
+	TEST_ASSERT_EQUAL_INT(0, ret);
+	TEST_ASSERT_EQUAL_INT(0, diff);
+
+	/* Negative Test Case: a tampered cipher fails the decryption, and the
+	 * fdor buffer is left as it was */
+	ret = memcpy_s(fdor.b.block, BUFF_SIZE_4K_BYTES, fdow.b.block, msg_sz);
+	TEST_ASSERT_EQUAL_INT(0, ret);
+	fdor.b.block_size = msg_sz;
+	TEST_ASSERT_TRUE(fdor_parser_init(&fdor));
+	pkt = fdo_encrypted_packet_read(&fdor);
+	TEST_ASSERT_NOT_NULL(pkt);
+	pkt->em_body->bytes[0] ^= 0xff;
+	cipher_block = fdor.b.block;
+	bret = fdo_encrypted_packet_unwind(&fdor, pkt, BUFF_SIZE_4K_BYTES);
+	TEST_ASSERT_FALSE(bret);
+	TEST_ASSERT_TRUE(fdor.b.block == cipher_block);
+
+	ret = fdo_kex_close();
+	TEST_ASSERT_EQUAL_INT(0, ret);
+
+	fdor_flush(&fdor);
+	fdow_flush(&fdow);
+	fdo_byte_array_free(cleartext);
+}
@@ -18,6 +18,8 @@
 
 /*** Unity Declarations ***/
 void test_encode_decode(void);
+void test_decode_string_view(void);
+void test_decode_item_view(void);
 
 void test_encode_decode(void) {
 
@@ -95,4 +97,102 @@ void test_encode_decode(void) {
 	LOG(LOG_INFO, "\nDecoding finished successfully\n");
 	fdow_flush(fdow);
 	fdor_flush(fdor);
-}
\ No newline at end of file
+}
+void test_decode_string_view(void) {
+
+	fdow_t fdow = {0};
+	fdor_t fdor = {0};
+	uint8_t bytes[300];
+	const char text[] = "fdo_sys:write";
+	const uint8_t *bytes_view = NULL;
+	const char *text_view = NULL;
+	size_t length = 0;
+	size_t encoded_length = 0;
+	int cmp = 1;
+
+	memset_s(bytes, sizeof(bytes), 0xa5);
+	TEST_ASSERT_TRUE(fdow_init(&fdow));
+	TEST_ASSERT_TRUE(fdo_block_alloc(&fdow.b));
+	TEST_ASSERT_TRUE(fdow_encoder_init(&fdow));
+	TEST_ASSERT_TRUE(fdow_start_array(&fdow, 2));
+	TEST_ASSERT_TRUE(fdow_text_string(&fdow, (char *)text, sizeof(text) - 1));
+	TEST_ASSERT_TRUE(fdow_byte_string(&fdow, bytes, sizeof(bytes)));
+	TEST_ASSERT_TRUE(fdow_end_array(&fdow));
+	TEST_ASSERT_TRUE(fdow_encoded_length(&fdow, &encoded_length));
+
+	// the decoder borrows the encoder's buffer, and the views point into it
+	TEST_ASSERT_TRUE(fdor_init(&fdor));
+	TEST_ASSERT_TRUE(fdor_view_init(&fdor, fdow.b.block, encoded_length));
+	TEST_ASSERT_TRUE(fdor_start_array(&fdor));
+	TEST_ASSERT_FALSE(fdor_byte_string_view(&fdor, &bytes_view, &length));
+	TEST_ASSERT_TRUE(fdor_text_string_view(&fdor, &text_view, &length));
+	TEST_ASSERT_EQUAL_UINT(sizeof(text) - 1, length);
+	TEST_ASSERT_TRUE((const uint8_t *)text_view > fdow.b.block &&
+		(const uint8_t *)text_view + length < fdow.b.block + encoded_length);
+	memcmp_s(text_view, length, text, length, &cmp);
+	TEST_ASSERT_EQUAL_INT(0, cmp);
+	TEST_ASSERT_TRUE(fdor_byte_string_view(&fdor, &bytes_view, &length));
+	TEST_ASSERT_EQUAL_UINT(sizeof(bytes), length);
+	TEST_ASSERT_TRUE(bytes_view + length == fdow.b.block + encoded_length);
+	memcmp_s(bytes_view, length, bytes, sizeof(bytes), &cmp);
+	TEST_ASSERT_EQUAL_INT(0, cmp);
+	TEST_ASSERT_TRUE(fdor_end_array(&fdor));
+
+	fdor_view_flush(&fdor);
+	TEST_ASSERT_NOT_NULL(fdow.b.block);
+	fdow_flush(&fdow);
+}
+void test_decode_item_view(void) {
+
+	fdow_t fdow = {0};
+	fdor_t fdor = {0};
+	uint8_t bytes[40];
+	const uint8_t *item = NULL;
+	size_t item_length = 0;
+	size_t encoded_length = 0;
+	size_t tagged_offset = 0;
+	uint64_t tag = 0;
+	int value = 0;
+
+	memset_s(bytes, sizeof(bytes), 0x3c);
+	TEST_ASSERT_TRUE(fdow_init(&fdow));
+	TEST_ASSERT_TRUE(fdo_block_alloc(&fdow.b));
+	TEST_ASSERT_TRUE(fdow_encoder_init(&fdow));
+	TEST_ASSERT_TRUE(fdow_start_array(&fdow, 3));
+	TEST_ASSERT_TRUE(fdow_signed_int(&fdow, 7));
+	TEST_ASSERT_TRUE(fdow_tag(&fdow, 18));
+	TEST_ASSERT_TRUE(fdow_start_array(&fdow, 2));
+	TEST_ASSERT_TRUE(fdow_byte_string(&fdow, bytes, sizeof(bytes)));
+	TEST_ASSERT_TRUE(fdow_signed_int(&fdow, 1000));
+	TEST_ASSERT_TRUE(fdow_end_array(&fdow));
+	TEST_ASSERT_TRUE(fdow_signed_int(&fdow, 9));
+	TEST_ASSERT_TRUE(fdow_end_array(&fdow));
+	TEST_ASSERT_TRUE(fdow_encoded_length(&fdow, &encoded_length));
+	// outer array header, then 7, then the tagged item, then 9
+	tagged_offset = 2;
+
+	TEST_ASSERT_TRUE(fdor_init(&fdor));
+	TEST_ASSERT_TRUE(fdor_view_init(&fdor, fdow.b.block, encoded_length));
+	TEST_ASSERT_TRUE(fdor_start_array(&fdor));
+	TEST_ASSERT_TRUE(fdor_item_view(&fdor, &item, &item_length));
+	TEST_ASSERT_TRUE(item == fdow.b.block + 1);
+	TEST_ASSERT_EQUAL_UINT(1, item_length);
+	TEST_ASSERT_TRUE(fdor_signed_int(&fdor, &value));
+
+	// the tagged item spans its tag and contents, and is not consumed
+	TEST_ASSERT_TRUE(fdor_item_view(&fdor, &item, &item_length));
+	TEST_ASSERT_TRUE(item == fdow.b.block + tagged_offset);
+	TEST_ASSERT_EQUAL_UINT(encoded_length - tagged_offset - 1, item_length);
+	TEST_ASSERT_TRUE(fdor_tag(&fdor, &tag));
+	TEST_ASSERT_EQUAL_UINT64(18, tag);
+	TEST_ASSERT_TRUE(fdor_next(&fdor));
+	TEST_ASSERT_TRUE(fdor_signed_int(&fdor, &value));
+	TEST_ASSERT_EQUAL_INT(9, value);
+
+	// nothing left in the array
+	TEST_ASSERT_FALSE(fdor_item_view(&fdor, &item, &item_length));
+	TEST_ASSERT_TRUE(fdor_end_array(&fdor));
+
+	fdor_view_flush(&fdor);
+	fdow_flush(&fdow);
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2020 Intel Corporation
+ * SPDX-License-Identifier: Apache 2.0
+ */
+
+/*!
+ * \file
+ * \brief Unit tests for the message buffer pool of FDO library.
+ */
+
+#include "unity.h"
+#include "fdobufpool.h"
+#include "fdoblockio.h"
+#include "util.h"
+
+/*** Unity Declarations ***/
+void test_fdo_buf_pool_reuse(void);
+void test_fdo_buf_pool_block(void);
+void test_fdo_buf_pool_cap(void);
+void test_fdo_buf_pool_no_cap(void);
+
+#ifdef TARGET_OS_FREERTOS
+TEST_CASE("fdo_buf_pool_reuse", "[fdo_buf_pool][fdo]")
+#else
+void test_fdo_buf_pool_reuse(void)
+#endif
+{
+	uint8_t *small = NULL;
+	uint8_t *large = NULL;
+	uint8_t *buf = NULL;
+
+	TEST_ASSERT_NULL(fdo_buf_pool_get(0));
+
+	small = fdo_buf_pool_get(256);
+	TEST_ASSERT_NOT_NULL(small);
+	large = fdo_buf_pool_get(4096);
+	TEST_ASSERT_NOT_NULL(large);
+	TEST_ASSERT_TRUE(fdo_buf_pool_peak() >= 256 + 4096);
+	small[0] = 0xa5;
+	large[4095] = 0x5a;
+	fdo_buf_pool_put(small);
+	fdo_buf_pool_put(large);
+
+	// the smallest buffer that fits is reused, and comes back cleared
+	buf = fdo_buf_pool_get(200);
+	TEST_ASSERT_EQUAL_PTR(small, buf);
+	TEST_ASSERT_EQUAL_UINT8(0, buf[0]);
+	fdo_buf_pool_put(buf);
+	buf = fdo_buf_pool_get(1000);
+	TEST_ASSERT_EQUAL_PTR(large, buf);
+	TEST_ASSERT_EQUAL_UINT8(0, buf[4095]);
+	fdo_buf_pool_put(buf);
+
+	// a buffer that isn't from the pool is freed
+	buf = fdo_alloc(16);
+	TEST_ASSERT_NOT_NULL(buf);
+	fdo_buf_pool_put(buf);
+
+	fdo_buf_pool_drain();
+}
+
+#ifdef TARGET_OS_FREERTOS
+TEST_CASE("fdo_buf_pool_block", "[fdo_buf_pool][fdo]")
+#else
+void test_fdo_buf_pool_block(void)
+#endif
+{
+	fdow_t fdow = {0};
+	uint8_t *block = NULL;
+
+	TEST_ASSERT_TRUE(fdow_init(&fdow));
+	TEST_ASSERT_TRUE(fdo_block_alloc_pooled(&fdow.b, 512));
+	TEST_ASSERT_EQUAL(512, fdow.b.block_size);
+	block = fdow.b.block;
+
+	// flushing gives the block back to the pool
+	fdow_flush(&fdow);
+	TEST_ASSERT_NULL(fdow.b.block);
+	TEST_ASSERT_TRUE(fdow_init(&fdow));
+	TEST_ASSERT_TRUE(fdo_block_alloc_pooled(&fdow.b, 512));
+	TEST_ASSERT_EQUAL_PTR(block, fdow.b.block);
+	fdow_flush(&fdow);
+
+	fdo_buf_pool_drain();
+}
+
+#ifdef TARGET_OS_FREERTOS
+TEST_CASE("fdo_buf_pool_cap", "[fdo_buf_pool][fdo]")
+#else
+void test_fdo_buf_pool_cap(void)
+#endif
+{
+	uint8_t *a = NULL;
+	uint8_t *b = NULL;
+	uint8_t *c = NULL;
+
+	fdo_buf_pool_drain();
+	fdo_buf_pool_set_cap(1024);
+
+	// a buffer larger than the pool is refused
+	TEST_ASSERT_NULL(fdo_buf_pool_get(2048));
+
+	a = fdo_buf_pool_get(512);
+	TEST_ASSERT_NOT_NULL(a);
+	b = fdo_buf_pool_get(256);
+	TEST_ASSERT_NOT_NULL(b);
+
+	// the unused buffer is freed to make room under the ceiling
+	fdo_buf_pool_put(a);
+	c = fdo_buf_pool_get(600);
+	TEST_ASSERT_NOT_NULL(c);
+
+	// with every byte in use, the pool is exhausted
+	TEST_ASSERT_NULL(fdo_buf_pool_get(300));
+	fdo_buf_pool_put(b);
+	b = fdo_buf_pool_get(300);
+	TEST_ASSERT_NOT_NULL(b);
+
+	fdo_buf_pool_put(b);
+	fdo_buf_pool_put(c);
+	fdo_buf_pool_drain();
+	fdo_buf_pool_set_cap(BUFFER_POOL_SZ);
+}
+
+#ifdef TARGET_OS_FREERTOS
+TEST_CASE("fdo_buf_pool_no_cap", "[fdo_buf_pool][fdo]")
+#else
+void test_fdo_buf_pool_no_cap(void)
+#endif
+{
+	uint8_t *bufs[FDO_BUF_POOL_SLOTS + 2] = {NULL};
+	int i;
+
+	fdo_buf_pool_drain();
+	fdo_buf_pool_set_cap(0);
+
+	// without a ceiling, running out of slots falls back to fdo_alloc
+	for (i = 0; i < FDO_BUF_POOL_SLOTS + 2; i++) {
+		bufs[i] = fdo_buf_pool_get(64);
+		TEST_ASSERT_NOT_NULL(bufs[i]);
+		if (i > 0) {
+			TEST_ASSERT_TRUE(bufs[i] != bufs[i - 1]);
+		}
+	}
+	for (i = 0; i < FDO_BUF_POOL_SLOTS + 2; i++) {
+		fdo_buf_pool_put(bufs[i]);
+	}
+
+	fdo_buf_pool_drain();
+	fdo_buf_pool_set_cap(BUFFER_POOL_SZ);
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2020 Intel Corporation
+ * SPDX-License-Identifier: Apache 2.0
+ */
+
+/*!
+ * \file
+ * \brief Unit tests for the retry scheduler of FDO library.
+ */
+
+#include "unity.h"
+#include "fdoretry.h"
+#include "fdoCryptoHal.h"
+#include "fdotypes.h"
+#include "util.h"
+
+/*** Unity Declarations ***/
+void test_fdo_retry_delay(void);
+void test_fdo_retry_health(void);
+
+#ifdef TARGET_OS_FREERTOS
+TEST_CASE("fdo_retry_delay", "[fdo_retry][fdo]")
+#else
+void test_fdo_retry_delay(void)
+#endif
+{
+	fdo_retry_t retry;
+	uint64_t delay = 0;
+	uint32_t failures;
+	unsigned int draws;
+
+	random_init();
+	fdo_retry_init(&retry, 3600);
+
+	// backoff doubles from the base delay, up to the cap, with full jitter
+	for (failures = 1; failures <= 16; failures++) {
+		delay = fdo_retry_delay(&retry, failures, 3, 0);
+		TEST_ASSERT_TRUE(delay >= FDO_RETRY_MIN_DELAY_SEC);
+		TEST_ASSERT_TRUE(delay <= 3600);
+		if (failures < 10) {
+			TEST_ASSERT_TRUE(delay <= (uint64_t)3 << (failures - 1));
+		}
+	}
+
+	// the draw covers the whole interval, not only its upper half
+	for (draws = 0; draws < 64; draws++) {
+		if (fdo_retry_delay(&retry, 16, 3, 0) < 1800) {
+			break;
+		}
+	}
+	TEST_ASSERT_TRUE(draws < 64);
+
+	// RVDelaysec is honored, within 25%
+	delay = fdo_retry_delay(&retry, 5, 3, 100);
+	TEST_ASSERT_TRUE(delay >= 75);
+	TEST_ASSERT_TRUE(delay <= 125);
+
+	// RVDelaysec above the cap is ignored
+	delay = fdo_retry_delay(&retry, 1, 120, 100000);
+	TEST_ASSERT_TRUE(delay >= FDO_RETRY_MIN_DELAY_SEC);
+	TEST_ASSERT_TRUE(delay <= 120);
+}
+
+#ifdef TARGET_OS_FREERTOS
+TEST_CASE("fdo_retry_health", "[fdo_retry][fdo]")
+#else
+void test_fdo_retry_health(void)
+#endif
+{
+	fdo_retry_t retry;
+	fdo_rvto2addr_t rvto2addr = {0};
+	fdo_rvto2addr_entry_t entries[3] = {{0}};
+	fdo_rvto2addr_entry_t *entry = NULL;
+	uint32_t ids[3];
+	int i;
+
+	fdo_retry_init(&retry, 3600);
+	for (i = 0; i < 3; i++) {
+		entries[i].rvdns = fdo_string_alloc_with_str("owner.example.com");
+		TEST_ASSERT_NOT_NULL(entries[i].rvdns);
+		entries[i].rvport = 8040 + i;
+		entries[i].next = i < 2 ? &entries[i + 1] : NULL;
+		ids[i] = fdo_retry_endpoint_id(NULL, 0, entries[i].rvdns,
+					       entries[i].rvport);
+		TEST_ASSERT_NOT_EQUAL(0, ids[i]);
+	}
+	TEST_ASSERT_NOT_EQUAL(ids[0], ids[1]);
+	rvto2addr.num_rvto2addr = 3;
+	rvto2addr.rv_to2addr_entry = &entries[0];
+
+	// 1st entry failed twice, 2nd once: 3rd, 2nd, 1st
+	fdo_retry_report(&retry, ids[0], false);
+	fdo_retry_report(&retry, ids[0], false);
+	fdo_retry_report(&retry, ids[1], false);
+	TEST_ASSERT_EQUAL_UINT32(2, fdo_retry_failures(&retry, ids[0]));
+	fdo_retry_sort_rvto2addr(&retry, &rvto2addr);
+	entry = rvto2addr.rv_to2addr_entry;
+	TEST_ASSERT_EQUAL_PTR(&entries[2], entry);
+	TEST_ASSERT_EQUAL_PTR(&entries[1], entry->next);
+	TEST_ASSERT_EQUAL_PTR(&entries[0], entry->next->next);
+	TEST_ASSERT_NULL(entry->next->next->next);
+
+	// a success makes it healthy again, equally healthy keep their order
+	fdo_retry_report(&retry, ids[0], true);
+	TEST_ASSERT_EQUAL_UINT32(0, fdo_retry_failures(&retry, ids[0]));
+	fdo_retry_sort_rvto2addr(&retry, &rvto2addr);
+	entry = rvto2addr.rv_to2addr_entry;
+	TEST_ASSERT_EQUAL_PTR(&entries[2], entry);
+	TEST_ASSERT_EQUAL_PTR(&entries[0], entry->next);
+	TEST_ASSERT_EQUAL_PTR(&entries[1], entry->next->next);
+
+	for (i = 0; i < 3; i++) {
+		fdo_string_free(entries[i].rvdns);
+	}
+}
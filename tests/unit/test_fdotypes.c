@@ -58,16 +58,21 @@ void test_fdo_cose_write(void);
 void test_fdo_siginfo_read(void);
 void test_fdo_siginfo_write(void);
 void test_fdo_signature_verification(void);
-void test_fdo_kv_alloc_with_str(void);
 void test_fdo_service_info_add_kv_str(void);
 void test_fdo_service_info_add_kv_int(void);
 void test_fdo_service_info_add_kv_bool(void);
 void test_fdo_service_info_add_kv_bin(void);
-void test_fdo_service_info_add_kv(void);
+void test_fdo_service_info_table(void);
 void test_fdo_serviceinfo_invalid_modname_add(void);
+void test_fdo_serviceinfo_module_lookup(void);
+void test_fdo_serviceinfo_fit_mtu(void);
+void test_fdo_serviceinfo_encoding_reuse(void);
 void test_fdo_compare_hashes(void);
 void test_fdo_compare_byte_arrays(void);
 void test_fdo_compare_rvLists(void);
+void test_fdo_byte_view(void);
+void test_fdo_eat_sigstructure(void);
+void test_fdo_inline_bytes(void);
 
 
 /*** Unity functions. ***/
@@ -1303,18 +1308,6 @@ void test_fdo_signature_verification(void)
 	fdo_free(sg.bytes);
 }
 
-#ifdef TARGET_OS_FREERTOS
-TEST_CASE("fdo_kv_alloc_with_str", "[fdo_types][fdo]")
-#else
-void test_fdo_kv_alloc_with_str(void)
-#endif
-{
-	fdo_key_value_t *ret;
-
-	ret = fdo_kv_alloc_with_str(NULL, NULL);
-	TEST_ASSERT_NULL(ret);
-}
-
 #ifdef TARGET_OS_FREERTOS
 TEST_CASE("fdo_service_info_add_kv_str", "[fdo_types][fdo]")
 #else
@@ -1462,24 +1455,72 @@ void test_fdo_service_info_add_kv_bin(void)
 }
 
 #ifdef TARGET_OS_FREERTOS
-TEST_CASE("fdo_service_info_add_kv", "[fdo_types][fdo]")
+TEST_CASE("fdo_service_info_table", "[fdo_types][fdo]")
 #else
-void test_fdo_service_info_add_kv(void)
+void test_fdo_service_info_table(void)
 #endif
 {
-	fdo_service_info_t si = {
-	    0,
-	};
-	fdo_key_value_t kvs = {
-	    0,
-	};
-	bool ret;
+	fdo_service_info_t *si = NULL;
+	fdo_key_value_t *kv = NULL;
+	char key[16] = "devmod:k00";
+	char long_val[1000] = {0};
+	size_t i;
+	size_t arena_used = 0;
 
-	ret = fdo_service_info_add_kv(NULL, NULL);
-	TEST_ASSERT_FALSE(ret);
+	TEST_ASSERT_NULL(fdo_service_info_fetch(NULL, "devmod:os"));
+	TEST_ASSERT_NULL(fdo_service_info_get(NULL, 0));
 
-	ret = fdo_service_info_add_kv(&si, &kvs);
-	TEST_ASSERT_TRUE(ret);
+	si = fdo_service_info_alloc();
+	TEST_ASSERT_NOT_NULL(si);
+	TEST_ASSERT_NULL(fdo_service_info_get(si, 0));
+
+	// more keys and bytes than initially fit, so both the table and arena grow
+	memset_s(long_val, sizeof(long_val) - 1, 'a');
+	for (i = 0; i < 40; i++) {
+		key[8] = (char)('0' + i / 10);
+		key[9] = (char)('0' + i % 10);
+		TEST_ASSERT_TRUE(fdo_service_info_add_kv_int(si, key, (int)i));
+	}
+	TEST_ASSERT_TRUE(fdo_service_info_add_kv_str(si, "devmod:sn", long_val));
+	TEST_ASSERT_EQUAL_UINT(41, si->numKV);
+
+	// entries are kept in insertion order, and keys looked up case-insensitively
+	for (i = 0; i < 40; i++) {
+		kv = fdo_service_info_get(si, i);
+		TEST_ASSERT_NOT_NULL(kv);
+		TEST_ASSERT_EQUAL_INT(FDO_KV_VAL_INT, kv->type);
+		TEST_ASSERT_EQUAL_INT((int)i, kv->val.int_val);
+	}
+	TEST_ASSERT_NULL(fdo_service_info_get(si, 41));
+	kv = fdo_service_info_fetch(si, "DEVMOD:K17");
+	TEST_ASSERT_EQUAL_PTR(fdo_service_info_get(si, 17), kv);
+	TEST_ASSERT_EQUAL_STRING("devmod:k17", (char *)si->arena + kv->key_offset);
+	TEST_ASSERT_NULL(fdo_service_info_fetch(si, "devmod:k40"));
+	kv = fdo_service_info_fetch(si, "devmod:sn");
+	TEST_ASSERT_NOT_NULL(kv);
+	TEST_ASSERT_EQUAL_UINT(sizeof(long_val) - 1, kv->val.buf.len);
+	TEST_ASSERT_EQUAL_MEMORY(long_val, si->arena + kv->val.buf.offset,
+				 sizeof(long_val) - 1);
+
+	// a shorter value is written in place, and the type of a key can change
+	arena_used = si->arena_used;
+	TEST_ASSERT_TRUE(fdo_service_info_add_kv_str(si, "Devmod:SN", "short"));
+	TEST_ASSERT_EQUAL_UINT(arena_used, si->arena_used);
+	TEST_ASSERT_TRUE(fdo_service_info_add_kv_bool(si, "devmod:k03", true));
+	TEST_ASSERT_EQUAL_UINT(41, si->numKV);
+	kv = fdo_service_info_fetch(si, "devmod:sn");
+	TEST_ASSERT_EQUAL_INT(FDO_KV_VAL_STR, kv->type);
+	TEST_ASSERT_EQUAL_UINT(5, kv->val.buf.len);
+	TEST_ASSERT_EQUAL_MEMORY("short", si->arena + kv->val.buf.offset, 5);
+	kv = fdo_service_info_get(si, 3);
+	TEST_ASSERT_EQUAL_INT(FDO_KV_VAL_BOOL, kv->type);
+	TEST_ASSERT_TRUE(kv->val.bool_val);
+
+	// an empty key is not added
+	TEST_ASSERT_FALSE(fdo_service_info_add_kv_bool(si, "", true));
+	TEST_ASSERT_EQUAL_UINT(41, si->numKV);
+
+	fdo_service_info_free(si);
 }
 
 #ifdef TARGET_OS_FREERTOS
@@ -1502,6 +1543,9 @@ void test_fdo_serviceinfo_invalid_modname_add(void)
 	ret = fdo_serviceinfo_invalid_modname_add("testmod2", &serviceinfo_invalid_modnames);
 	TEST_ASSERT_TRUE(ret);
 	TEST_ASSERT_NOT_NULL(serviceinfo_invalid_modnames->next);
+	TEST_ASSERT_EQUAL_STRING("testmod1", serviceinfo_invalid_modnames->bytes);
+	TEST_ASSERT_EQUAL_STRING("testmod2", serviceinfo_invalid_modnames->next->bytes);
+	TEST_ASSERT_NULL(serviceinfo_invalid_modnames->next->next);
 
 	ret = fdo_serviceinfo_invalid_modname_add("testmod1", NULL);
 	TEST_ASSERT_FALSE(ret);
@@ -1509,6 +1553,168 @@ void test_fdo_serviceinfo_invalid_modname_add(void)
 	fdo_serviceinfo_invalid_modname_free(serviceinfo_invalid_modnames);
 }
 
+#ifdef TARGET_OS_FREERTOS
+TEST_CASE("fdo_serviceinfo_module_lookup", "[fdo_types][fdo]")
+#else
+void test_fdo_serviceinfo_module_lookup(void)
+#endif
+{
+	fdo_sdk_service_info_module_list_t modules[3] = {0};
+	fdo_sdk_service_info_module_list_t duplicate = {0};
+
+	strncpy_s(modules[0].module.module_name, FDO_MODULE_NAME_LEN, "fdo_sys", 7);
+	strncpy_s(modules[1].module.module_name, FDO_MODULE_NAME_LEN, "testmod1", 8);
+	strncpy_s(modules[2].module.module_name, FDO_MODULE_NAME_LEN, "testmod2", 8);
+	strncpy_s(duplicate.module.module_name, FDO_MODULE_NAME_LEN, "testmod1", 8);
+	modules[0].next = &modules[1];
+	modules[1].next = &modules[2];
+	modules[1].module.active = true;
+	modules[2].module.active = true;
+
+	// without a registry, the list is traversed
+	TEST_ASSERT_EQUAL_PTR(&modules[2],
+		fdo_serviceinfo_module_lookup(&modules[0], "testmod2"));
+	TEST_ASSERT_EQUAL_PTR(&modules[1], fdo_serviceinfo_active_module(&modules[0]));
+
+	TEST_ASSERT_TRUE(fdo_serviceinfo_module_index_add(&modules[0], &modules[0]));
+	TEST_ASSERT_NOT_NULL(modules[0].index);
+	TEST_ASSERT_TRUE(fdo_serviceinfo_module_index_add(&modules[0], &modules[1]));
+	TEST_ASSERT_TRUE(fdo_serviceinfo_module_index_add(&modules[0], &modules[2]));
+	TEST_ASSERT_FALSE(fdo_serviceinfo_module_index_add(&modules[0], &duplicate));
+	TEST_ASSERT_FALSE(fdo_serviceinfo_module_index_add(NULL, &duplicate));
+
+	TEST_ASSERT_EQUAL_PTR(&modules[0],
+		fdo_serviceinfo_module_lookup(&modules[0], "fdo_sys"));
+	TEST_ASSERT_EQUAL_PTR(&modules[1],
+		fdo_serviceinfo_module_lookup(&modules[0], "testmod1"));
+	TEST_ASSERT_EQUAL_PTR(&modules[2],
+		fdo_serviceinfo_module_lookup(&modules[0], "testmod2"));
+	TEST_ASSERT_NULL(fdo_serviceinfo_module_lookup(&modules[0], "testmod"));
+	TEST_ASSERT_NULL(fdo_serviceinfo_module_lookup(&modules[0], ""));
+	TEST_ASSERT_NULL(fdo_serviceinfo_module_lookup(&modules[0], NULL));
+
+	// only one module can be active
+	TEST_ASSERT_EQUAL_PTR(&modules[1], fdo_serviceinfo_active_module(&modules[0]));
+	TEST_ASSERT_FALSE(modules[2].module.active);
+	TEST_ASSERT_TRUE(fdo_serviceinfo_deactivate_modules(&modules[0]));
+	TEST_ASSERT_NULL(fdo_serviceinfo_active_module(&modules[0]));
+
+	fdo_serviceinfo_module_index_free(&modules[0]);
+	TEST_ASSERT_NULL(modules[0].index);
+}
+
+#ifdef TARGET_OS_FREERTOS
+TEST_CASE("fdo_serviceinfo_fit_mtu", "[fdo_types][fdo]")
+#else
+void test_fdo_serviceinfo_fit_mtu(void)
+#endif
+{
+	fdo_service_info_t *si = NULL;
+	fdow_t fdow = {0};
+	char long_val[301] = {0};
+	size_t mtu = 100;
+	size_t encoded_length = 0;
+	size_t sent = 0;
+	int rounds = 0;
+
+	memset_s(long_val, sizeof(long_val) - 1, 'a');
+	si = fdo_service_info_alloc();
+	TEST_ASSERT_NOT_NULL(si);
+	TEST_ASSERT_TRUE(fdo_service_info_add_kv_str(si, "devmod:os", "Linux"));
+	TEST_ASSERT_TRUE(fdo_service_info_add_kv_str(si, "devmod:sn", long_val));
+	TEST_ASSERT_TRUE(fdo_service_info_add_kv_bool(si, "devmod:active", true));
+	TEST_ASSERT_TRUE(fdo_service_info_add_kv_int(si, "devmod:nummodules", 1));
+	TEST_ASSERT_FALSE(fdo_serviceinfo_fit_mtu(NULL, mtu));
+
+	// every message fits, and the long value is split across messages
+	do {
+		TEST_ASSERT_TRUE(fdo_serviceinfo_fit_mtu(si, mtu));
+		TEST_ASSERT_TRUE(fdow_init(&fdow));
+		TEST_ASSERT_TRUE(fdo_block_alloc_with_size(&fdow.b, 2 * mtu));
+		TEST_ASSERT_TRUE(fdow_encoder_init(&fdow));
+		TEST_ASSERT_TRUE(fdo_serviceinfo_write(&fdow, si, mtu));
+		TEST_ASSERT_TRUE(fdow_encoded_length(&fdow, &encoded_length));
+		TEST_ASSERT_TRUE(encoded_length < mtu);
+		fdow_flush(&fdow);
+
+		if (si->sv_index_begin <= 1 && si->sv_index_end >= 2) {
+			if (si->sv_index_end == 2 && si->sv_val_index) {
+				sent += si->sv_val_index;
+			} else {
+				sent += sizeof(long_val) - 1 -
+					(si->sv_index_begin == 1 ? si->sv_val_offset : 0);
+			}
+		}
+		rounds++;
+	} while ((si->sv_index_end != si->numKV || si->sv_val_index != 0) && rounds < 10);
+
+	TEST_ASSERT_TRUE(rounds > 3 && rounds < 10);
+	TEST_ASSERT_EQUAL_UINT(sizeof(long_val) - 1, sent);
+
+	// a value that cannot be split must fit on its own
+	fdo_service_info_free(si);
+	si = fdo_service_info_alloc();
+	TEST_ASSERT_NOT_NULL(si);
+	TEST_ASSERT_TRUE(fdo_service_info_add_kv_int(si, "devmod:nummodules", 1));
+	TEST_ASSERT_FALSE(fdo_serviceinfo_fit_mtu(si, 10));
+	fdo_service_info_free(si);
+}
+
+#ifdef TARGET_OS_FREERTOS
+TEST_CASE("fdo_serviceinfo_encoding_reuse", "[fdo_types][fdo]")
+#else
+void test_fdo_serviceinfo_encoding_reuse(void)
+#endif
+{
+	fdo_service_info_t *si = NULL;
+	fdow_t fdow = {0};
+	uint8_t first[100] = {0};
+	size_t first_length = 0;
+	size_t encoded_length = 0;
+	size_t arena_used = 0;
+	size_t mtu = 100;
+	int attempt;
+
+	si = fdo_service_info_alloc();
+	TEST_ASSERT_NOT_NULL(si);
+	TEST_ASSERT_TRUE(fdo_service_info_add_kv_bool(si, "devmod:active", true));
+	TEST_ASSERT_TRUE(fdo_service_info_add_kv_str(si, "devmod:os", "Linux"));
+	TEST_ASSERT_TRUE(fdo_service_info_add_kv_int(si, "devmod:nummodules", 1));
+
+	// a retry sends the same ServiceInfo, from the encoding kept by the 1st attempt
+	for (attempt = 0; attempt < 2; attempt++) {
+		si->sv_index_begin = 0;
+		si->sv_index_end = 0;
+		si->sv_val_index = 0;
+		si->sv_val_offset = 0;
+		TEST_ASSERT_TRUE(fdo_serviceinfo_fit_mtu(si, mtu));
+		TEST_ASSERT_EQUAL_UINT(3, si->sv_index_end);
+		TEST_ASSERT_TRUE(fdow_init(&fdow));
+		TEST_ASSERT_TRUE(fdo_block_alloc_with_size(&fdow.b, mtu));
+		TEST_ASSERT_TRUE(fdow_encoder_init(&fdow));
+		TEST_ASSERT_TRUE(fdo_serviceinfo_write(&fdow, si, mtu));
+		TEST_ASSERT_TRUE(fdow_encoded_length(&fdow, &encoded_length));
+		if (attempt == 0) {
+			TEST_ASSERT_EQUAL_UINT(6, fdo_service_info_fetch(si, "devmod:os")->enc_len);
+			TEST_ASSERT_EQUAL_UINT(1, fdo_service_info_fetch(si, "devmod:active")->enc_len);
+			first_length = encoded_length;
+			TEST_ASSERT_EQUAL_INT(0, memcpy_s(first, sizeof(first), fdow.b.block,
+				encoded_length));
+			arena_used = si->arena_used;
+		} else {
+			TEST_ASSERT_EQUAL_UINT(first_length, encoded_length);
+			TEST_ASSERT_EQUAL_MEMORY(first, fdow.b.block, encoded_length);
+			TEST_ASSERT_EQUAL_UINT(arena_used, si->arena_used);
+		}
+		fdow_flush(&fdow);
+	}
+
+	// changing a value drops its encoding
+	TEST_ASSERT_TRUE(fdo_service_info_add_kv_str(si, "devmod:os", "Zephyr"));
+	TEST_ASSERT_EQUAL_UINT(0, fdo_service_info_fetch(si, "devmod:os")->enc_len);
+	fdo_service_info_free(si);
+}
+
 #ifdef TARGET_OS_FREERTOS
 TEST_CASE("fdo_compare_hashes", "[fdo_types][fdo]")
 #else
@@ -1621,3 +1827,139 @@ void test_fdo_compare_rvLists(void)
 	TEST_ASSERT_EQUAL(fdo_compare_rv_lists(NULL, &list2), false);
 	TEST_ASSERT_EQUAL(fdo_compare_rv_lists(&list1, NULL), false);
 }
+
+#ifdef TARGET_OS_FREERTOS
+TEST_CASE("fdo_byte_view", "[fdo_types][fdo]")
+#else
+void test_fdo_byte_view(void)
+#endif
+{
+	fdow_t fdow = {0};
+	fdor_t fdor = {0};
+	uint8_t bytes[64];
+	fdo_byte_view_t view = {0};
+	fdo_byte_array_t *dup = NULL;
+	size_t encoded_length = 0;
+	int cmp = 1;
+
+	memset_s(bytes, sizeof(bytes), 0x5a);
+	TEST_ASSERT_TRUE(fdow_init(&fdow));
+	TEST_ASSERT_TRUE(fdo_block_alloc(&fdow.b));
+	TEST_ASSERT_TRUE(fdow_encoder_init(&fdow));
+	TEST_ASSERT_TRUE(fdow_start_array(&fdow, 2));
+	TEST_ASSERT_TRUE(fdow_signed_int(&fdow, 1));
+	TEST_ASSERT_TRUE(fdow_byte_string(&fdow, bytes, sizeof(bytes)));
+	TEST_ASSERT_TRUE(fdow_end_array(&fdow));
+	TEST_ASSERT_TRUE(fdow_encoded_length(&fdow, &encoded_length));
+
+	TEST_ASSERT_TRUE(fdor_init(&fdor));
+	TEST_ASSERT_TRUE(fdor_view_init(&fdor, fdow.b.block, encoded_length));
+	TEST_ASSERT_TRUE(fdor_start_array(&fdor));
+	// not a bstr
+	TEST_ASSERT_FALSE(fdo_byte_view_read(&fdor, &view));
+	TEST_ASSERT_TRUE(fdor_next(&fdor));
+	TEST_ASSERT_TRUE(fdo_byte_view_read(&fdor, &view));
+	TEST_ASSERT_TRUE(fdor_end_array(&fdor));
+	fdor_view_flush(&fdor);
+
+	// the view refers to the encoded buffer, nothing was copied
+	TEST_ASSERT_EQUAL_UINT(sizeof(bytes), view.byte_sz);
+	TEST_ASSERT_TRUE(view.bytes + view.byte_sz ==
+			 fdow.b.block + encoded_length);
+
+	// materialised on demand, the copy outlives the buffer
+	dup = fdo_byte_view_dup(&view);
+	TEST_ASSERT_NOT_NULL(dup);
+	TEST_ASSERT_TRUE(dup->bytes != view.bytes);
+	fdow_flush(&fdow);
+	TEST_ASSERT_EQUAL_UINT(sizeof(bytes), dup->byte_sz);
+	memcmp_s(dup->bytes, dup->byte_sz, bytes, sizeof(bytes), &cmp);
+	TEST_ASSERT_EQUAL_INT(0, cmp);
+	fdo_byte_array_free(dup);
+
+	TEST_ASSERT_FALSE(fdo_byte_view_read(NULL, &view));
+	TEST_ASSERT_NULL(fdo_byte_view_dup(NULL));
+}
+
+#ifdef TARGET_OS_FREERTOS
+TEST_CASE("fdo_eat_sigstructure", "[fdo_types][fdo]")
+#else
+void test_fdo_eat_sigstructure(void)
+#endif
+{
+	// [ "Signature1", bstr({1: -7}), h'', bstr .size 300 ]
+	const uint8_t head[] = {0x84, 0x6a, 'S', 'i', 'g', 'n', 'a', 't', 'u',
+				'r', 'e', '1', 0x43, 0xa1, 0x01, 0x26, 0x40,
+				0x59, 0x01, 0x2c};
+	fdo_eat_protected_header_t eat_ph = {0};
+	fdo_byte_array_t *payload = NULL;
+	fdo_byte_array_t *sig_structure = NULL;
+	int cmp = 1;
+
+	eat_ph.ph_sig_alg = FDO_CRYPTO_SIG_TYPE_ECSDAp256;
+	payload = fdo_byte_array_alloc(300);
+	TEST_ASSERT_NOT_NULL(payload);
+	memset_s(payload->bytes, payload->byte_sz, 0x5a);
+
+	TEST_ASSERT_TRUE(fdo_eat_write_sigstructure(&eat_ph, payload, NULL,
+						    &sig_structure));
+	TEST_ASSERT_NOT_NULL(sig_structure);
+	TEST_ASSERT_EQUAL_UINT(sizeof(head) + payload->byte_sz,
+			       sig_structure->byte_sz);
+	memcmp_s(sig_structure->bytes, sizeof(head), head, sizeof(head), &cmp);
+	TEST_ASSERT_EQUAL_INT(0, cmp);
+	memcmp_s(sig_structure->bytes + sizeof(head), payload->byte_sz,
+		 payload->bytes, payload->byte_sz, &cmp);
+	TEST_ASSERT_EQUAL_INT(0, cmp);
+
+	fdo_byte_array_free(sig_structure);
+	fdo_byte_array_free(payload);
+	TEST_ASSERT_FALSE(fdo_eat_write_sigstructure(NULL, NULL, NULL,
+						     &sig_structure));
+}
+
+#ifdef TARGET_OS_FREERTOS
+TEST_CASE("fdo_inline_bytes", "[fdo_types][fdo]")
+#else
+void test_fdo_inline_bytes(void)
+#endif
+{
+	uint8_t data[FDO_INLINE_BYTES_MAX + 1];
+	fdo_byte_array_t *ba = NULL;
+	fdo_string_t *str = NULL;
+	fdo_hash_t *hp = NULL;
+	int cmp = 1;
+
+	memset_s(data, sizeof(data), 0x5a);
+
+	// small payloads follow their struct in the same allocation
+	ba = fdo_byte_array_alloc_with_byte_array(data, FDO_GUID_BYTES);
+	TEST_ASSERT_NOT_NULL(ba);
+	TEST_ASSERT_TRUE(ba->bytes == (uint8_t *)(ba + 1));
+	memcmp_s(ba->bytes, ba->byte_sz, data, FDO_GUID_BYTES, &cmp);
+	TEST_ASSERT_EQUAL_INT(0, cmp);
+	// and move to a buffer of their own when resized
+	TEST_ASSERT_TRUE(fdo_byte_array_resize(ba, sizeof(data)));
+	TEST_ASSERT_FALSE(ba->bytes == (uint8_t *)(ba + 1));
+	TEST_ASSERT_EQUAL_UINT(sizeof(data), ba->byte_sz);
+	fdo_byte_array_free(ba);
+
+	ba = fdo_byte_array_alloc(sizeof(data));
+	TEST_ASSERT_NOT_NULL(ba);
+	TEST_ASSERT_FALSE(ba->bytes == (uint8_t *)(ba + 1));
+	fdo_byte_array_free(ba);
+
+	hp = fdo_hash_alloc(FDO_CRYPTO_HASH_TYPE_SHA_384, BUFF_SIZE_48_BYTES);
+	TEST_ASSERT_NOT_NULL(hp);
+	TEST_ASSERT_TRUE(hp->hash == (fdo_byte_array_t *)(hp + 1));
+	TEST_ASSERT_EQUAL_UINT(BUFF_SIZE_48_BYTES, hp->hash->byte_sz);
+	fdo_hash_free(hp);
+
+	str = fdo_string_alloc_with_str("devmod");
+	TEST_ASSERT_NOT_NULL(str);
+	TEST_ASSERT_TRUE(str->bytes == (char *)(str + 1));
+	TEST_ASSERT_EQUAL_STRING("devmod", str->bytes);
+	TEST_ASSERT_TRUE(fdo_string_resize_with(str, 3, "sys"));
+	TEST_ASSERT_FALSE(str->bytes == (char *)(str + 1));
+	fdo_string_free(str);
+}
@@ -24,7 +24,10 @@
 /* Declaring internal structure here */
 struct fdo_sock_handle {
 	int sockfd;
-} g_handle;
+	int epfd;
+	size_t rx_len;
+	uint64_t rx_deadline;
+} g_handle = {0, -1, 0, 0};
 
 /*** Unity Declarations. ***/
 void set_up(void);
@@ -40,6 +43,10 @@ void test_fdo_con_disconnect(void);
 void test_fdo_con_recv_message(void);
 void test_fdo_con_send_message(void);
 void test_read_until_new_line(void);
+void test_fdo_con_recv_msg_header_split(void);
+void test_fdo_con_recv_msg_header_body(void);
+void test_fdo_con_recv_msg_header_lf(void);
+void test_fdo_con_recv_msg_header_oversize(void);
 
 /*** Unity functions. ***/
 /**
@@ -59,6 +66,10 @@ void tear_down(void)
 
 static int return_socket = -1;
 static int recv_configured = 1;
+/* When set, recv() returns these chunks in turn, then 0 (peer closed) */
+static const char *recv_chunks[4];
+static size_t recv_chunk_next;
+static size_t recv_chunk_off;
 /*** Wrapper functions (function stubbing). ***/
 
 #ifdef TARGET_OS_FREERTOS
@@ -77,16 +88,48 @@ int __wrap_lwip_recv_r(int domain, int type, int protocol)
 ssize_t __wrap_recv(int sockfd, void *buf, size_t len, int flags)
 #endif
 {
+	const char *chunk = NULL;
+	size_t n = 0;
+
 	(void)sockfd;
-	(void)buf;
-	(void)len;
 	(void)flags;
+	if (recv_chunks[0]) {
+		if (recv_chunk_next >= sizeof(recv_chunks) / sizeof(recv_chunks[0]) ||
+		    !recv_chunks[recv_chunk_next])
+			return 0;
+		chunk = recv_chunks[recv_chunk_next] + recv_chunk_off;
+		n = strnlen_s(chunk, RSIZE_MAX_STR);
+		if (n > len)
+			n = len;
+		if (memcpy_s(buf, len, chunk, n) != 0)
+			return -1;
+		recv_chunk_off += n;
+		if (!chunk[n]) {
+			recv_chunk_next++;
+			recv_chunk_off = 0;
+		}
+		return (ssize_t)n;
+	}
 	if (recv_configured == 0)
 		return -1;
 	else
 		return 33;
 }
 
+/**
+ * Make recv() return the given chunks in turn, NULL to go back to the
+ * fixed behaviour.
+ */
+static void set_recv_chunks(const char *c0, const char *c1, const char *c2)
+{
+	recv_chunks[0] = c0;
+	recv_chunks[1] = c1;
+	recv_chunks[2] = c2;
+	recv_chunks[3] = NULL;
+	recv_chunk_next = 0;
+	recv_chunk_off = 0;
+}
+
 #ifdef TARGET_OS_FREERTOS
 int __wrap_lwip_send_r(int domain, int type, int protocol)
 #else
@@ -278,3 +321,136 @@ TEST_CASE("read_until_new_line", "[OS][HAL][fdo]")
 	recv_configured = 1;
 	free(prot_ctx);
 }
+
+#ifndef TARGET_OS_FREERTOS
+void test_fdo_con_recv_msg_header_split(void)
+#else
+TEST_CASE("fdo_con_recv_msg_header_split", "[OS][HAL][fdo]")
+#endif
+{
+	struct fdo_sock_handle handle = {100, -1, 0, 0};
+	char curl_buf[REST_MAX_MSGHDR_SIZE] = {0};
+	size_t offset = 0;
+	uint32_t protver = 0;
+	uint32_t msgtype = 0;
+	uint32_t msglen = 0;
+	uint8_t body[4] = {0};
+	int diff = 1;
+
+	TEST_ASSERT_EQUAL_INT(0, fdo_con_setup(NULL, NULL, 0));
+
+	// the header is split across chunks, the body comes with the last one
+	set_recv_chunks("HTTP/1.1 200 OK\r\nContent-Le",
+			"ngth: 4\r\nMessage-Type: 11\r\n",
+			"\r\nabcd");
+	TEST_ASSERT_EQUAL_INT(0, fdo_con_recv_msg_header(&handle, &protver,
+			      &msgtype, &msglen, false, curl_buf, &offset));
+	TEST_ASSERT_EQUAL_UINT32(4, msglen);
+	TEST_ASSERT_EQUAL_UINT32(11, msgtype);
+
+	// the whole body is taken from the header chunk, recv() isn't called
+	recv_chunks[0] = "unexpected";
+	recv_chunk_next = 0;
+	TEST_ASSERT_EQUAL_INT(4, fdo_con_recv_msg_body(&handle, body,
+			      sizeof(body), false, curl_buf, offset));
+	TEST_ASSERT_EQUAL_INT(0, memcmp_s(body, sizeof(body), "abcd", 4, &diff));
+	TEST_ASSERT_EQUAL_INT(0, diff);
+
+	set_recv_chunks(NULL, NULL, NULL);
+	fdo_con_teardown();
+}
+
+#ifndef TARGET_OS_FREERTOS
+void test_fdo_con_recv_msg_header_body(void)
+#else
+TEST_CASE("fdo_con_recv_msg_header_body", "[OS][HAL][fdo]")
+#endif
+{
+	struct fdo_sock_handle handle = {100, -1, 0, 0};
+	char curl_buf[REST_MAX_MSGHDR_SIZE] = {0};
+	size_t offset = 0;
+	uint32_t protver = 0;
+	uint32_t msgtype = 0;
+	uint32_t msglen = 0;
+	uint8_t body[6] = {0};
+	int diff = 1;
+
+	TEST_ASSERT_EQUAL_INT(0, fdo_con_setup(NULL, NULL, 0));
+
+	// the start of the body comes with the header, the rest after it
+	set_recv_chunks("HTTP/1.1 200 OK\r\nContent-Length: 6\r\n"
+			"Message-Type: 11\r\n\r\nab",
+			"cdef", NULL);
+	TEST_ASSERT_EQUAL_INT(0, fdo_con_recv_msg_header(&handle, &protver,
+			      &msgtype, &msglen, false, curl_buf, &offset));
+	TEST_ASSERT_EQUAL_UINT32(6, msglen);
+	TEST_ASSERT_EQUAL_INT(6, fdo_con_recv_msg_body(&handle, body,
+			      sizeof(body), false, curl_buf, offset));
+	TEST_ASSERT_EQUAL_INT(0,
+			      memcmp_s(body, sizeof(body), "abcdef", 6, &diff));
+	TEST_ASSERT_EQUAL_INT(0, diff);
+
+	set_recv_chunks(NULL, NULL, NULL);
+	fdo_con_teardown();
+}
+
+#ifndef TARGET_OS_FREERTOS
+void test_fdo_con_recv_msg_header_lf(void)
+#else
+TEST_CASE("fdo_con_recv_msg_header_lf", "[OS][HAL][fdo]")
+#endif
+{
+	struct fdo_sock_handle handle = {100, -1, 0, 0};
+	char curl_buf[REST_MAX_MSGHDR_SIZE] = {0};
+	size_t offset = 0;
+	uint32_t protver = 0;
+	uint32_t msgtype = 0;
+	uint32_t msglen = 0;
+	uint8_t body[2] = {0};
+	int diff = 1;
+
+	TEST_ASSERT_EQUAL_INT(0, fdo_con_setup(NULL, NULL, 0));
+
+	// lines ended with a bare LF
+	set_recv_chunks("HTTP/1.1 200 OK\nContent-Length: 2\n"
+			"Message-Type: 13\n\nxy",
+			NULL, NULL);
+	TEST_ASSERT_EQUAL_INT(0, fdo_con_recv_msg_header(&handle, &protver,
+			      &msgtype, &msglen, false, curl_buf, &offset));
+	TEST_ASSERT_EQUAL_UINT32(2, msglen);
+	TEST_ASSERT_EQUAL_UINT32(13, msgtype);
+	TEST_ASSERT_EQUAL_INT(2, fdo_con_recv_msg_body(&handle, body,
+			      sizeof(body), false, curl_buf, offset));
+	TEST_ASSERT_EQUAL_INT(0, memcmp_s(body, sizeof(body), "xy", 2, &diff));
+	TEST_ASSERT_EQUAL_INT(0, diff);
+
+	set_recv_chunks(NULL, NULL, NULL);
+	fdo_con_teardown();
+}
+
+#ifndef TARGET_OS_FREERTOS
+void test_fdo_con_recv_msg_header_oversize(void)
+#else
+TEST_CASE("fdo_con_recv_msg_header_oversize", "[OS][HAL][fdo]")
+#endif
+{
+	struct fdo_sock_handle handle = {100, -1, 0, 0};
+	char curl_buf[REST_MAX_MSGHDR_SIZE] = {0};
+	static char big[REST_MAX_MSGHDR_SIZE + 64];
+	size_t offset = 0;
+	uint32_t protver = 0;
+	uint32_t msgtype = 0;
+	uint32_t msglen = 0;
+
+	TEST_ASSERT_EQUAL_INT(0, fdo_con_setup(NULL, NULL, 0));
+
+	// no end of header within REST_MAX_MSGHDR_SIZE bytes
+	TEST_ASSERT_EQUAL_INT(0, memset_s(big, sizeof(big) - 1, 'a'));
+	big[sizeof(big) - 1] = 0;
+	set_recv_chunks("HTTP/1.1 200 OK\r\nX-Filler: ", big, "\r\n\r\n");
+	TEST_ASSERT_EQUAL_INT(-1, fdo_con_recv_msg_header(&handle, &protver,
+			      &msgtype, &msglen, false, curl_buf, &offset));
+
+	set_recv_chunks(NULL, NULL, NULL);
+	fdo_con_teardown();
+}
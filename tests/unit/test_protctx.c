@@ -42,6 +42,7 @@ int __wrap_fdo_socket_read(int sock, uint8_t *buf, ssize_t nbytes, void *ssl);
 ssize_t __wrap_recv(int sockfd, void *buf, size_t len, int flags);
 int __wrap_socket(int domain, int type, int protocol);
 void test_fdo_prot_ctx_run(void);
+void test_fdo_prot_ov_checkpoint(void);
 errno_t __wrap_strncpy_s(char *dest, rsize_t dmax, const char *src,
 			 rsize_t slen);
 errno_t __wrap_strcat_s(char *dest, rsize_t dmax, const char *src);
@@ -249,6 +250,13 @@ TEST_CASE("fdo_prot_ctx_run", "[protctx][fdo]")
 	prot_ctx->protrun = NULL;
 	ret = fdo_prot_ctx_run(prot_ctx);
 	TEST_ASSERT_EQUAL_INT(-1, ret);
+
+	// protrun NULL, stepped: the exchange is ended on error
+	ret = fdo_prot_ctx_step(prot_ctx, fdo_time_ms() + 10);
+	TEST_ASSERT_EQUAL_INT(-1, ret);
+	TEST_ASSERT_EQUAL_INT(FDO_PROT_CTX_IDLE, prot_ctx->phase);
+	TEST_ASSERT_NULL(prot_ctx->curl_buf);
+	TEST_ASSERT_EQUAL_INT(-1, fdo_prot_ctx_get_fd(prot_ctx));
 	prot_ctx->protrun = &fdo_prot_dummy;
 
 	// snprintf_s_si failed when host_dns present
@@ -289,3 +297,63 @@ TEST_CASE("fdo_prot_ctx_run", "[protctx][fdo]")
 	free(prot_ctx);
 #endif
 }
+
+static fdo_hash_t *checkpoint_hash(uint8_t seed)
+{
+	fdo_hash_t *h =
+	    fdo_hash_alloc(FDO_CRYPTO_HASH_TYPE_USED, FDO_SHA_DIGEST_SIZE_USED);
+	size_t i;
+
+	TEST_ASSERT_NOT_NULL(h);
+	for (i = 0; i < h->hash->byte_sz; i++) {
+		h->hash->bytes[i] = (uint8_t)(seed + i);
+	}
+	return h;
+}
+
+#ifndef TARGET_OS_FREERTOS
+void test_fdo_prot_ov_checkpoint(void)
+#else
+TEST_CASE("fdo_prot_ov_checkpoint", "[protctx][fdo]")
+#endif
+{
+	fdo_prot_t ps = {0};
+	fdo_hash_t *hdr = checkpoint_hash(1);
+	fdo_hash_t *other_hdr = checkpoint_hash(2);
+	fdo_hash_t *entry0 = checkpoint_hash(3);
+	fdo_hash_t *entry1 = checkpoint_hash(4);
+
+	g_malloc_fail = false;
+
+	// nothing is verified before the first attempt
+	fdo_prot_ov_checkpoint_start(&ps, hdr, 2);
+	TEST_ASSERT_FALSE(fdo_prot_ov_checkpoint_verified(&ps, 0, hdr, entry0));
+
+	// entries are recorded in order only
+	fdo_prot_ov_checkpoint_add(&ps, 1, entry0, entry1);
+	TEST_ASSERT_EQUAL_INT(1, ps.ov_checkpoint.num_hashes);
+	fdo_prot_ov_checkpoint_add(&ps, 0, hdr, entry0);
+	fdo_prot_ov_checkpoint_add(&ps, 1, entry0, entry1);
+	TEST_ASSERT_EQUAL_INT(3, ps.ov_checkpoint.num_hashes);
+
+	// a retry with the same voucher keeps them
+	fdo_prot_ov_checkpoint_start(&ps, hdr, 2);
+	TEST_ASSERT_TRUE(fdo_prot_ov_checkpoint_verified(&ps, 0, hdr, entry0));
+	TEST_ASSERT_TRUE(fdo_prot_ov_checkpoint_verified(&ps, 1, entry0, entry1));
+	TEST_ASSERT_FALSE(fdo_prot_ov_checkpoint_verified(&ps, 1, hdr, entry1));
+	TEST_ASSERT_FALSE(fdo_prot_ov_checkpoint_verified(&ps, 0, hdr, entry1));
+	TEST_ASSERT_FALSE(fdo_prot_ov_checkpoint_verified(&ps, 2, entry1, entry1));
+
+	// another voucher drops them
+	fdo_prot_ov_checkpoint_start(&ps, other_hdr, 2);
+	TEST_ASSERT_EQUAL_INT(1, ps.ov_checkpoint.num_hashes);
+	TEST_ASSERT_FALSE(fdo_prot_ov_checkpoint_verified(&ps, 0, hdr, entry0));
+
+	fdo_prot_ov_checkpoint_free(&ps);
+	TEST_ASSERT_NULL(ps.ov_checkpoint.hashes);
+	TEST_ASSERT_EQUAL_INT(0, ps.ov_checkpoint.num_hashes);
+	fdo_hash_free(hdr);
+	fdo_hash_free(other_hdr);
+	fdo_hash_free(entry0);
+	fdo_hash_free(entry1);
+}
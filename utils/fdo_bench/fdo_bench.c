@@ -0,0 +1,692 @@
+/*
+ * Copyright 2020 Intel Corporation
+ * SPDX-License-Identifier: Apache 2.0
+ */
+
+/*!
+ * \file
+ * \brief Onboarding benchmark. Onboards devices one after the other against a
+ * loopback stand-in of the Manufacturer, Rendezvous and Owner servers
+ * (fdo_standin.c), and reports the time, the round trips, the bytes on the
+ * wire and the allocations of DI, TO1 and TO2.
+ *
+ * The stand-in runs in a child process, and every run onboards a fresh device
+ * directory <work_dir>/run-<n>, made of a copy of the template data/ directory:
+ * DI from one device process, then TO1 and TO2 from another, the same way
+ * linux-client is run. The device drives the SDK with fdo_sdk_step, so that
+ * the time and the allocations can be split between the protocols. A step
+ * that parses a response and builds the next message is counted in the phase
+ * of that next message, and so is the wait for its response.
+ *
+ * With -S, only the stand-in is run, on the given port, for fdo-fleet-sim or
+ * linux-client to onboard against. Its counters are printed on SIGINT or
+ * SIGTERM.
+ */
+
+#define _GNU_SOURCE
+#include "fdo.h"
+#include "fdomodules.h"
+#include "util.h"
+#include "fdo_standin.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "blob.h"
+#include "safe_lib.h"
+
+#define BENCH_PATH_LEN 512
+#define BENCH_ERROR_RETRY_COUNT 5
+#define BENCH_SESSION_LOG "session.log"
+#define BENCH_MANUFACTURER_ADDR "data/manufacturer_addr.bin"
+/* the protocols as a whole, after DI, TO1 and TO2 */
+#define BENCH_TOTAL STANDIN_PHASES
+
+static const char *const bench_phase_names[STANDIN_PHASES + 1] = {
+    "DI", "TO1", "TO2", "onboarding"};
+
+/* Measurements of one run, written by its device processes */
+typedef struct {
+	bool ok;
+	uint64_t us[STANDIN_PHASES];
+	uint64_t allocs[STANDIN_PHASES];
+	uint64_t alloc_bytes[STANDIN_PHASES];
+	uint64_t round_trips[STANDIN_PHASES];
+	uint64_t bytes[STANDIN_PHASES];
+} bench_run_t;
+
+typedef struct {
+	const char *work_dir;
+	const char *template_dir;
+	unsigned int runs;
+	unsigned int timeout_ms;
+	bool serve_only;
+	uint16_t port;
+	standin_config_t server;
+} bench_config_t;
+
+static bench_config_t config = {"bench", "data", 20, 2000, false, 0,
+				{1, 0, 0, 0, 1}};
+
+static volatile sig_atomic_t stop_requested;
+static standin_stats_t *stats;
+
+static uint64_t now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [-n runs] [-e entries] [-s si_bytes] [-l latency_ms]\n"
+		"          [-p loss_pct] [-r seed] [-T timeout_ms] [-d work_dir]\n"
+		"          [-t template_dir] [-S -P port]\n"
+		"  -n  devices onboarded, one after the other (default 20)\n"
+		"  -e  entries of every ownership voucher (default 1)\n"
+		"  -s  bytes written to every device with fdo_sys in TO2 (default 0)\n"
+		"  -l  latency added to every response, in ms (default 0)\n"
+		"  -p  percentage of requests left unanswered (default 0)\n"
+		"  -r  seed of the request losses (default 1)\n"
+		"  -T  device network timeout, in ms (default 2000)\n"
+		"  -d  directory holding the device directories (default bench)\n"
+		"  -t  template copied to every device's data/ (default data)\n"
+		"  -S  only run the stand-in server, on port -P, until interrupted\n",
+		prog);
+}
+
+static void stop_handler(int sig)
+{
+	(void)sig;
+	stop_requested = 1;
+}
+
+static int error_cb(fdo_sdk_status type, fdo_sdk_error errorcode)
+{
+	static unsigned int errors;
+
+	(void)type;
+	(void)errorcode;
+
+	if (++errors > BENCH_ERROR_RETRY_COUNT) {
+		LOG(LOG_INFO, "Sending ABORT from benchmark\n");
+		return FDO_ABORT;
+	}
+	return FDO_SUCCESS;
+}
+
+static bool copy_file(const char *src, const char *dst)
+{
+	char buf[4096];
+	ssize_t len;
+	bool ret = false;
+	int in = open(src, O_RDONLY);
+	int out = -1;
+
+	if (in < 0) {
+		return false;
+	}
+	out = open(dst, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (out < 0) {
+		goto end;
+	}
+	while ((len = read(in, buf, sizeof(buf))) > 0) {
+		if (write(out, buf, (size_t)len) != len) {
+			goto end;
+		}
+	}
+	ret = len == 0;
+end:
+	close(in);
+	if (out >= 0) {
+		close(out);
+	}
+	return ret;
+}
+
+/**
+ * Create a fresh device directory: <dir>/data holding a copy of every regular
+ * file of the template, and the URL of the stand-in as Manufacturer.
+ */
+static bool prepare_device_dir(const char *dir, uint16_t port)
+{
+	char data_dir[BENCH_PATH_LEN];
+	char src[BENCH_PATH_LEN];
+	char dst[BENCH_PATH_LEN];
+	struct dirent *entry = NULL;
+	struct stat st;
+	DIR *template = NULL;
+	bool ret = false;
+	FILE *fp = NULL;
+
+	if (snprintf(data_dir, sizeof(data_dir), "%s/data", dir) >=
+	    (int)sizeof(data_dir)) {
+		return false;
+	}
+	if ((mkdir(dir, 0700) != 0 && errno != EEXIST) ||
+	    (mkdir(data_dir, 0700) != 0 && errno != EEXIST)) {
+		return false;
+	}
+
+	template = opendir(config.template_dir);
+	if (!template) {
+		return false;
+	}
+	while ((entry = readdir(template)) != NULL) {
+		if (snprintf(src, sizeof(src), "%s/%s", config.template_dir,
+			     entry->d_name) >= (int)sizeof(src) ||
+		    snprintf(dst, sizeof(dst), "%s/%s", data_dir,
+			     entry->d_name) >= (int)sizeof(dst)) {
+			goto end;
+		}
+		if (stat(src, &st) != 0 || !S_ISREG(st.st_mode)) {
+			continue;
+		}
+		if (!copy_file(src, dst)) {
+			goto end;
+		}
+	}
+
+	if (snprintf(dst, sizeof(dst), "%s/%s", dir, BENCH_MANUFACTURER_ADDR) >=
+	    (int)sizeof(dst)) {
+		goto end;
+	}
+	fp = fopen(dst, "w");
+	if (!fp || fprintf(fp, "http://127.0.0.1:%u", port) < 0) {
+		goto end;
+	}
+	ret = true;
+end:
+	if (fp && fclose(fp) == EOF) {
+		ret = false;
+	}
+	closedir(template);
+	return ret;
+}
+
+static void alloc_snapshot(uint64_t *allocs, uint64_t *bytes)
+{
+#ifdef FDO_ALLOC_STATS
+	fdo_alloc_stats(allocs, bytes);
+#else
+	*allocs = 0;
+	*bytes = 0;
+#endif
+}
+
+/*
+ * Charge the time and the allocations since the last snapshot to a phase,
+ * and take a new snapshot.
+ */
+static void charge(bench_run_t *run, int phase, uint64_t *us, uint64_t *allocs,
+		   uint64_t *bytes)
+{
+	uint64_t now = now_us();
+	uint64_t a = 0;
+	uint64_t b = 0;
+
+	alloc_snapshot(&a, &b);
+	run->us[phase] += now - *us;
+	run->allocs[phase] += a - *allocs;
+	run->alloc_bytes[phase] += b - *bytes;
+	*us = now;
+	*allocs = a;
+	*bytes = b;
+}
+
+/**
+ * Run one protocol session from the current directory, DI or TO1/TO2, and
+ * charge its cost to the phases of its messages.
+ * @return true if the session succeeded
+ */
+static bool device_session(bench_run_t *run, bool to_phase)
+{
+	fdo_sdk_service_info_module *module_info = NULL;
+	fdo_sdk_device_state state;
+	fdo_sdk_status status = FDO_ERROR;
+	int phase = to_phase ? STANDIN_TO1 : STANDIN_DI;
+	uint64_t us = now_us();
+	uint64_t allocs = 0;
+	uint64_t bytes = 0;
+	bool ret = false;
+
+	alloc_snapshot(&allocs, &bytes);
+	if (-1 == configure_normal_blob()) {
+		LOG(LOG_ERROR, "Provisioning Normal blob failed!\n");
+		return false;
+	}
+
+	module_info = fdo_alloc(FDO_MAX_MODULES * sizeof(*module_info));
+	if (!module_info) {
+		LOG(LOG_ERROR, "Malloc failed!\n");
+		return false;
+	}
+	if (strncpy_s(module_info[0].module_name, FDO_MODULE_NAME_LEN,
+		      "fdo_sys", FDO_MODULE_NAME_LEN) != 0) {
+		LOG(LOG_ERROR, "Strcpy failed");
+		goto end;
+	}
+	module_info[0].service_info_callback = fdo_sys;
+
+	if (FDO_SUCCESS !=
+	    fdo_sdk_init(error_cb, FDO_MAX_MODULES, module_info)) {
+		LOG(LOG_ERROR, "fdo_sdk_init failed!!\n");
+		goto end;
+	}
+	fdo_sdk_set_timeout(config.timeout_ms);
+
+	state = fdo_sdk_get_status();
+	if ((to_phase && state != FDO_STATE_PRE_TO1) ||
+	    (!to_phase && state != FDO_STATE_PRE_DI)) {
+		LOG(LOG_ERROR, "Device is in state %d\n", state);
+		goto end;
+	}
+
+	for (;;) {
+		uint32_t wait_ms = 0;
+		int fd = -1;
+		int type;
+
+		status = fdo_sdk_step(0, &wait_ms, &fd);
+		if (status != FDO_IN_PROGRESS) {
+			break;
+		}
+		if (fd >= 0) {
+			struct pollfd pfd = {fd, POLLIN, 0};
+
+			if (poll(&pfd, 1, (int)wait_ms) < 0 && errno != EINTR) {
+				break;
+			}
+		} else if (wait_ms) {
+			struct timespec ts = {wait_ms / 1000,
+					      (long)(wait_ms % 1000) * 1000000};
+
+			nanosleep(&ts, NULL);
+		}
+
+		/* the request just answered, or dropped, by the stand-in */
+		type = __atomic_load_n(&stats->last_type, __ATOMIC_ACQUIRE);
+		if (type >= 0 && standin_phase(type) >= 0 &&
+		    (standin_phase(type) == STANDIN_DI) == !to_phase) {
+			phase = standin_phase(type);
+		}
+		charge(run, phase, &us, &allocs, &bytes);
+	}
+	ret = status == FDO_SUCCESS;
+end:
+	fdo_free(module_info);
+	fdo_sdk_deinit();
+	charge(run, phase, &us, &allocs, &bytes);
+	return ret;
+}
+
+/**
+ * Run a device process, from dir, and wait for it.
+ * @return true if its session succeeded
+ */
+static bool run_device(const char *dir, bench_run_t *run, bool to_phase)
+{
+	pid_t pid;
+	int status = 0;
+	int fd;
+
+	fflush(stdout);
+	pid = fork();
+	if (pid < 0) {
+		return false;
+	}
+	if (pid == 0) {
+		if (chdir(dir) != 0) {
+			_exit(EXIT_FAILURE);
+		}
+		fd = open(BENCH_SESSION_LOG, O_WRONLY | O_CREAT | O_APPEND, 0600);
+		if (fd < 0 || dup2(fd, STDOUT_FILENO) < 0 ||
+		    dup2(fd, STDERR_FILENO) < 0) {
+			_exit(EXIT_FAILURE);
+		}
+		close(fd);
+		setbuf(stdout, NULL);
+		exit(device_session(run, to_phase) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+	while (waitpid(pid, &status, 0) < 0) {
+		if (errno != EINTR) {
+			return false;
+		}
+	}
+	return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+/* Add the server counters of every message of a phase */
+static void phase_stats(int phase, standin_msg_stats_t *sum)
+{
+	int type;
+
+	memset(sum, 0, sizeof(*sum));
+	for (type = 0; type < STANDIN_MSG_TYPES; type++) {
+		const standin_msg_stats_t *m = &stats->msg[type];
+
+		if (standin_phase(type) != phase) {
+			continue;
+		}
+		sum->requests += m->requests;
+		sum->dropped += m->dropped;
+		sum->bytes_in += m->bytes_in;
+		sum->bytes_out += m->bytes_out;
+	}
+}
+
+/* Onboard the device of run 'index', and fill in its server counters */
+static bool run_once(unsigned int index, uint16_t port, bench_run_t *run)
+{
+	standin_msg_stats_t before[STANDIN_PHASES];
+	standin_msg_stats_t after;
+	char dir[BENCH_PATH_LEN];
+	int phase;
+
+	if (snprintf(dir, sizeof(dir), "%s/run-%06u", config.work_dir, index) >=
+		(int)sizeof(dir) ||
+	    !prepare_device_dir(dir, port)) {
+		fprintf(stderr, "fdo_bench: can't prepare %s\n", dir);
+		return false;
+	}
+
+	for (phase = 0; phase < STANDIN_PHASES; phase++) {
+		phase_stats(phase, &before[phase]);
+	}
+	run->ok = run_device(dir, run, false) && run_device(dir, run, true);
+	for (phase = 0; phase < STANDIN_PHASES; phase++) {
+		phase_stats(phase, &after);
+		run->round_trips[phase] = after.requests - before[phase].requests;
+		run->bytes[phase] = after.bytes_in + after.bytes_out -
+				    before[phase].bytes_in - before[phase].bytes_out;
+	}
+	return run->ok;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* Nearest-rank percentile of n sorted values */
+static uint64_t percentile(const uint64_t *sorted, size_t n, unsigned int p)
+{
+	size_t rank = (p * n + 99) / 100;
+
+	if (!n) {
+		return 0;
+	}
+	return sorted[rank ? rank - 1 : 0];
+}
+
+/* Sorted values of a phase, or of all phases, over the successful runs */
+static size_t collect(const bench_run_t *runs, size_t offset, int phase,
+		      uint64_t *values, uint64_t *total)
+{
+	size_t n = 0;
+	unsigned int i;
+	int p;
+
+	*total = 0;
+	for (i = 0; i < config.runs; i++) {
+		const uint64_t *v = (const uint64_t *)((const char *)&runs[i] + offset);
+
+		if (!runs[i].ok) {
+			continue;
+		}
+		values[n] = 0;
+		for (p = 0; p < STANDIN_PHASES; p++) {
+			if (phase == BENCH_TOTAL || phase == p) {
+				values[n] += v[p];
+			}
+		}
+		*total += values[n];
+		n++;
+	}
+	qsort(values, n, sizeof(*values), compare_u64);
+	return n;
+}
+
+static void dump_server_stats(void)
+{
+	int type;
+
+	printf("%-5s %10s %8s %8s %12s %12s %10s\n", "msg", "requests",
+	       "dropped", "failed", "bytes in", "bytes out", "server ms");
+	for (type = 0; type < STANDIN_MSG_TYPES; type++) {
+		const standin_msg_stats_t *m = &stats->msg[type];
+
+		if (!m->requests) {
+			continue;
+		}
+		printf("%-5d %10" PRIu64 " %8" PRIu64 " %8" PRIu64 " %12" PRIu64
+		       " %12" PRIu64 " %10.1f\n",
+		       type, m->requests, m->dropped, m->failed, m->bytes_in,
+		       m->bytes_out, (double)m->server_us / 1e3);
+	}
+}
+
+static void report(const bench_run_t *runs)
+{
+	uint64_t *values = calloc(config.runs, sizeof(*values));
+	uint64_t total = 0;
+	size_t ok = 0;
+	int phase;
+
+	if (!values) {
+		fprintf(stderr, "fdo_bench: out of memory\n");
+		return;
+	}
+
+	ok = collect(runs, offsetof(bench_run_t, us), BENCH_TOTAL, values, &total);
+	printf("%-16s %u, %u voucher entries, %zu ServiceInfo bytes\n", "runs",
+	       config.runs, config.server.ov_entries, config.server.si_bytes);
+	printf("%-16s %u ms latency, %u%% loss, %u ms timeout\n", "network",
+	       config.server.latency_ms, config.server.loss_pct,
+	       config.timeout_ms);
+	printf("%-16s %zu\n", "failed", config.runs - ok);
+
+	printf("%-16s %10s %10s %12s %8s %8s %10s %10s %10s %12s\n", "phase",
+	       "p50 ms", "p99 ms", "total ms", "rt p50", "rt", "bytes p50",
+	       "bytes", "allocs p50", "alloc B p50");
+	for (phase = 0; phase <= BENCH_TOTAL; phase++) {
+		uint64_t rt_total = 0;
+		uint64_t bytes_total = 0;
+		uint64_t us_p50, us_p99, us_total;
+		uint64_t rt_p50, bytes_p50, allocs_p50, alloc_bytes_p50;
+
+		collect(runs, offsetof(bench_run_t, us), phase, values, &us_total);
+		us_p50 = percentile(values, ok, 50);
+		us_p99 = percentile(values, ok, 99);
+		collect(runs, offsetof(bench_run_t, round_trips), phase, values,
+			&rt_total);
+		rt_p50 = percentile(values, ok, 50);
+		collect(runs, offsetof(bench_run_t, bytes), phase, values,
+			&bytes_total);
+		bytes_p50 = percentile(values, ok, 50);
+		collect(runs, offsetof(bench_run_t, allocs), phase, values, &total);
+		allocs_p50 = percentile(values, ok, 50);
+		collect(runs, offsetof(bench_run_t, alloc_bytes), phase, values,
+			&total);
+		alloc_bytes_p50 = percentile(values, ok, 50);
+
+		printf("%-16s %10.1f %10.1f %12.1f %8" PRIu64 " %8" PRIu64
+		       " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %12" PRIu64 "\n",
+		       bench_phase_names[phase], (double)us_p50 / 1e3,
+		       (double)us_p99 / 1e3, (double)us_total / 1e3, rt_p50,
+		       rt_total, bytes_p50, bytes_total, allocs_p50,
+		       alloc_bytes_p50);
+	}
+	printf("\n");
+	dump_server_stats();
+	free(values);
+}
+
+/* Run the stand-in in a child process, stopped with SIGTERM */
+static pid_t start_server(int listen_fd)
+{
+	pid_t pid;
+
+	fflush(stdout);
+	pid = fork();
+	if (pid != 0) {
+		return pid;
+	}
+	signal(SIGINT, SIG_IGN);
+	signal(SIGTERM, stop_handler);
+	_exit(standin_serve(listen_fd, &config.server, stats, &stop_requested) == 0 ?
+		      EXIT_SUCCESS :
+		      EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+	bench_run_t *runs = NULL;
+	size_t runs_size = 0;
+	uint16_t port = 0;
+	pid_t server = -1;
+	unsigned int i;
+	int listen_fd = -1;
+	int ret = -1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:e:s:l:p:r:T:d:t:SP:h")) != -1) {
+		switch (opt) {
+		case 'n':
+			config.runs = (unsigned int)strtoul(optarg, NULL, 0);
+			break;
+		case 'e':
+			config.server.ov_entries =
+			    (unsigned int)strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			config.server.si_bytes = strtoul(optarg, NULL, 0);
+			break;
+		case 'l':
+			config.server.latency_ms =
+			    (unsigned int)strtoul(optarg, NULL, 0);
+			break;
+		case 'p':
+			config.server.loss_pct =
+			    (unsigned int)strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			config.server.seed = (unsigned int)strtoul(optarg, NULL, 0);
+			break;
+		case 'T':
+			config.timeout_ms = (unsigned int)strtoul(optarg, NULL, 0);
+			break;
+		case 'd':
+			config.work_dir = optarg;
+			break;
+		case 't':
+			config.template_dir = optarg;
+			break;
+		case 'S':
+			config.serve_only = true;
+			break;
+		case 'P':
+			config.port = (uint16_t)strtoul(optarg, NULL, 0);
+			break;
+		case 'h':
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : -1;
+		}
+	}
+	if (!config.runs || config.server.loss_pct > 100 ||
+	    (config.serve_only && !config.port)) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	stats = mmap(NULL, sizeof(*stats), PROT_READ | PROT_WRITE,
+		     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (stats == MAP_FAILED) {
+		stats = NULL;
+		goto end;
+	}
+	listen_fd = standin_listen(config.port, &port);
+	if (listen_fd < 0) {
+		fprintf(stderr, "fdo_bench: can't listen on port %u: %s\n",
+			config.port, strerror(errno));
+		goto end;
+	}
+
+	if (config.serve_only) {
+		signal(SIGINT, stop_handler);
+		signal(SIGTERM, stop_handler);
+		printf("serving on http://127.0.0.1:%u\n", port);
+		fflush(stdout);
+		ret = standin_serve(listen_fd, &config.server, stats,
+				    &stop_requested);
+		dump_server_stats();
+		goto end;
+	}
+
+	/* devices can only be kept apart if the blobs live in the device dir */
+	if (FDO_CRED_NORMAL[0] == '/') {
+		fprintf(stderr,
+			"fdo_bench: needs a relative BLOB_PATH, built with %s\n",
+			FDO_CRED_NORMAL);
+		goto end;
+	}
+	if (mkdir(config.work_dir, 0700) != 0 && errno != EEXIST) {
+		perror("fdo_bench: work directory");
+		goto end;
+	}
+
+	/* shared with the device processes, which fill in their run */
+	runs_size = config.runs * sizeof(*runs);
+	runs = mmap(NULL, runs_size, PROT_READ | PROT_WRITE,
+		    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (runs == MAP_FAILED) {
+		runs = NULL;
+		goto end;
+	}
+	server = start_server(listen_fd);
+	if (server < 0) {
+		goto end;
+	}
+
+	for (i = 0; i < config.runs; i++) {
+		if (!run_once(i, port, &runs[i])) {
+			fprintf(stderr, "fdo_bench: run %u failed, see %s/run-%06u/%s\n",
+				i, config.work_dir, i, BENCH_SESSION_LOG);
+		}
+	}
+	report(runs);
+	ret = 0;
+end:
+	if (server > 0) {
+		kill(server, SIGTERM);
+		waitpid(server, NULL, 0);
+	}
+	if (listen_fd >= 0) {
+		close(listen_fd);
+	}
+	if (runs) {
+		munmap(runs, runs_size);
+	}
+	if (stats) {
+		munmap(stats, sizeof(*stats));
+	}
+	return ret;
+}
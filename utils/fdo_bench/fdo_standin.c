@@ -0,0 +1,1851 @@
+/*
+ * Copyright 2020 Intel Corporation
+ * SPDX-License-Identifier: Apache 2.0
+ */
+
+/*!
+ * \file
+ * \brief Loopback stand-in for the Manufacturer, Rendezvous and Owner servers,
+ * used to benchmark onboarding end-to-end.
+ *
+ * One local port serves DI (msg 10-13), TO1 (msg 30-33) and TO2 (msg 60-71),
+ * over plain HTTP. The server is the Manufacturer, the Rendezvous server and
+ * the Owner of every device it initializes, so no TO0 or voucher extension is
+ * needed between DI and TO1: a single EC key signs the voucher entries, the
+ * to1d and the Owner proofs, and is handed to the device as Owner2Key. TO2
+ * assigns a new GUID, so the device ends in the resale state, and can't be
+ * onboarded again.
+ *
+ * The crypto suite is the one the SDK is built with (ECDSA256/384 with ECDH and
+ * AES-GCM). The server checks what it needs to carry on the protocol, not what
+ * the device proves to it: the device attestation and the EAT signature aren't
+ * verified.
+ *
+ * Requests are served one at a time. Responses are held for the configured
+ * latency, and dropped requests are never answered: their connection is
+ * kept open until the device gives up on it, as with a lost packet.
+ */
+
+#define _GNU_SOURCE
+#include "fdo_standin.h"
+#include "fdotypes.h"
+#include "fdoprot.h"
+#include "util.h"
+#include "fdoCryptoCommons.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/ecdsa.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <openssl/x509.h>
+
+#if defined(ECDSA256_DA)
+#define STANDIN_CURVE NID_X9_62_prime256v1
+#define STANDIN_MD EVP_sha256
+#define STANDIN_KEX_RANDOM_SZ 16
+#else
+#define STANDIN_CURVE NID_secp384r1
+#define STANDIN_MD EVP_sha384
+#define STANDIN_KEX_RANDOM_SZ 48
+#endif
+#if SEK_KEY_SIZE == 16
+#define STANDIN_GCM EVP_aes_128_gcm
+#else
+#define STANDIN_GCM EVP_aes_256_gcm
+#endif
+
+#define STANDIN_HASH_SZ FDO_SHA_DIGEST_SIZE_USED
+#define STANDIN_COORD_SZ FDO_SHA_DIGEST_SIZE_USED
+#define STANDIN_GCM_IV_SZ 12
+#define STANDIN_GCM_TAG_SZ 16
+#define STANDIN_MAX_HEADER_SZ (16 * 1024)
+#define STANDIN_MAX_BODY_SZ (1024 * 1024)
+#define STANDIN_IO_TIMEOUT_MS 5000
+#define STANDIN_STOP_POLL_MS 200
+#define STANDIN_MAX_PENDING 256
+#define STANDIN_MAX_SESSIONS 64
+#define STANDIN_MSG_ERROR 255
+#define STANDIN_DEVICE_INFO "fdo-standin"
+#define STANDIN_SI_FILE "fdo_standin.bin"
+/* fdo_sys:write chunk, below the 8 KB fdo_sys accepts */
+#define STANDIN_SI_CHUNK 4096
+/* encoding of a ServiceInfoKV around the bytes of its value */
+#define STANDIN_SI_KV_OVERHEAD 32
+
+/* Encoded CBOR, grown as needed */
+typedef struct {
+	uint8_t *buf;
+	size_t len;
+	size_t cap;
+	bool failed;
+} cbor_out_t;
+
+/* CBOR being decoded, in place */
+typedef struct {
+	const uint8_t *p;
+	const uint8_t *end;
+} cbor_in_t;
+
+typedef struct {
+	uint8_t guid[FDO_GUID_BYTES];
+	cbor_out_t ovheader; /* OVHeader */
+	cbor_out_t hmac;     /* HMac item, as sent by the device in msg 12 */
+	cbor_out_t *entries; /* OVEntries, built by the first TO2 */
+	bool registered;     /* DI completed */
+} standin_device_t;
+
+typedef struct {
+	uint32_t token; /* Authorization of the session, 0 if unused */
+	size_t device;
+	uint8_t nonce_to1proof[FDO_NONCE_BYTES];
+	uint8_t nonce_prove_ov[FDO_NONCE_BYTES];
+	uint8_t nonce_prove_dv[FDO_NONCE_BYTES];
+	uint8_t nonce_setup_dv[FDO_NONCE_BYTES];
+	uint8_t hello_hash[STANDIN_HASH_SZ];
+	EC_KEY *kex;
+	uint8_t owner_random[STANDIN_KEX_RANDOM_SZ];
+	uint8_t sek[SEK_KEY_SIZE];
+	bool have_sek;
+	size_t max_owner_si;
+	size_t si_sent;
+	bool si_started;
+} standin_session_t;
+
+typedef struct {
+	int fd;
+	uint64_t due_us; /* UINT64_MAX if the request is dropped */
+	char *buf;
+	size_t len;
+} standin_pending_t;
+
+typedef struct {
+	char *buf;
+	size_t len;
+	size_t cap;
+	size_t header_len;
+	size_t content_length;
+	bool has_content_length;
+} http_msg_t;
+
+typedef struct {
+	const standin_config_t *config;
+	standin_stats_t *stats;
+	uint16_t port;
+	unsigned int seed;
+	EC_KEY *key;
+	uint8_t *key_der;
+	int key_der_len;
+	standin_device_t *devices;
+	size_t num_devices;
+	standin_session_t sessions[STANDIN_MAX_SESSIONS];
+	uint32_t next_token;
+	standin_pending_t pending[STANDIN_MAX_PENDING];
+	size_t num_pending;
+} standin_t;
+
+static uint64_t now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+/* ======================= CBOR ======================= */
+
+/* Make room for len more bytes */
+static bool co_reserve(cbor_out_t *out, size_t len)
+{
+	uint8_t *buf = NULL;
+	size_t cap = out->cap ? out->cap : 256;
+
+	if (out->failed) {
+		return false;
+	}
+	while (cap < out->len + len) {
+		cap *= 2;
+	}
+	if (cap != out->cap) {
+		buf = realloc(out->buf, cap);
+		if (!buf) {
+			out->failed = true;
+			return false;
+		}
+		out->buf = buf;
+		out->cap = cap;
+	}
+	return true;
+}
+
+static void co_put(cbor_out_t *out, const void *data, size_t len)
+{
+	if (co_reserve(out, len) && len) {
+		memcpy(out->buf + out->len, data, len);
+		out->len += len;
+	}
+}
+
+static void co_head(cbor_out_t *out, int major, uint64_t val)
+{
+	uint8_t head[9];
+	size_t len = 1;
+	int i;
+
+	if (val < 24) {
+		head[0] = (uint8_t)(major << 5 | (int)val);
+	} else {
+		int bytes = val <= 0xff ? 1 : val <= 0xffff ? 2 : val <= 0xffffffff ? 4 : 8;
+
+		head[0] = (uint8_t)(major << 5 | (bytes == 1 ? 24 : bytes == 2 ? 25 :
+						 bytes == 4 ? 26 : 27));
+		for (i = bytes; i > 0; i--) {
+			head[len++] = (uint8_t)(val >> (8 * (i - 1)));
+		}
+	}
+	co_put(out, head, len);
+}
+
+static void co_uint(cbor_out_t *out, uint64_t val)
+{
+	co_head(out, 0, val);
+}
+
+static void co_int(cbor_out_t *out, int64_t val)
+{
+	if (val < 0) {
+		co_head(out, 1, (uint64_t)(-1 - val));
+	} else {
+		co_head(out, 0, (uint64_t)val);
+	}
+}
+
+static void co_bstr(cbor_out_t *out, const void *data, size_t len)
+{
+	co_head(out, 2, len);
+	co_put(out, data, len);
+}
+
+static void co_tstr(cbor_out_t *out, const char *str)
+{
+	co_head(out, 3, strlen(str));
+	co_put(out, str, strlen(str));
+}
+
+static void co_array(cbor_out_t *out, size_t items)
+{
+	co_head(out, 4, items);
+}
+
+static void co_map(cbor_out_t *out, size_t items)
+{
+	co_head(out, 5, items);
+}
+
+static void co_tag(cbor_out_t *out, uint64_t tag)
+{
+	co_head(out, 6, tag);
+}
+
+static void co_simple(cbor_out_t *out, uint8_t simple)
+{
+	co_put(out, &simple, 1);
+}
+
+static void co_free(cbor_out_t *out)
+{
+	free(out->buf);
+	memset(out, 0, sizeof(*out));
+}
+
+static bool ci_head(cbor_in_t *in, int *major, uint64_t *val)
+{
+	int info;
+	int bytes;
+
+	if (in->p >= in->end) {
+		return false;
+	}
+	*major = *in->p >> 5;
+	info = *in->p & 0x1f;
+	in->p++;
+	if (info < 24) {
+		*val = (uint64_t)info;
+		return true;
+	}
+	if (info > 27) {
+		/* indefinite lengths aren't used by the SDK */
+		return false;
+	}
+	bytes = 1 << (info - 24);
+	if (in->end - in->p < bytes) {
+		return false;
+	}
+	*val = 0;
+	while (bytes--) {
+		*val = *val << 8 | *in->p++;
+	}
+	return true;
+}
+
+static bool ci_expect(cbor_in_t *in, int major, uint64_t *val)
+{
+	int got = 0;
+
+	return ci_head(in, &got, val) && got == major;
+}
+
+static bool ci_uint(cbor_in_t *in, uint64_t *val)
+{
+	return ci_expect(in, 0, val);
+}
+
+static bool ci_int(cbor_in_t *in, int64_t *val)
+{
+	int major = 0;
+	uint64_t raw = 0;
+
+	if (!ci_head(in, &major, &raw) || (major != 0 && major != 1) ||
+	    raw > INT64_MAX) {
+		return false;
+	}
+	*val = major == 0 ? (int64_t)raw : -1 - (int64_t)raw;
+	return true;
+}
+
+static bool ci_string(cbor_in_t *in, int major, const uint8_t **data, size_t *len)
+{
+	uint64_t val = 0;
+
+	if (!ci_expect(in, major, &val) || val > (uint64_t)(in->end - in->p)) {
+		return false;
+	}
+	*data = in->p;
+	*len = (size_t)val;
+	in->p += val;
+	return true;
+}
+
+static bool ci_bstr(cbor_in_t *in, const uint8_t **data, size_t *len)
+{
+	return ci_string(in, 2, data, len);
+}
+
+static bool ci_array(cbor_in_t *in, size_t *items)
+{
+	uint64_t val = 0;
+
+	if (!ci_expect(in, 4, &val)) {
+		return false;
+	}
+	*items = (size_t)val;
+	return true;
+}
+
+static bool ci_map(cbor_in_t *in, size_t *items)
+{
+	uint64_t val = 0;
+
+	if (!ci_expect(in, 5, &val)) {
+		return false;
+	}
+	*items = (size_t)val;
+	return true;
+}
+
+static bool ci_bool(cbor_in_t *in, bool *val)
+{
+	if (in->p >= in->end || (*in->p != 0xf4 && *in->p != 0xf5)) {
+		return false;
+	}
+	*val = *in->p++ == 0xf5;
+	return true;
+}
+
+static bool ci_skip(cbor_in_t *in, int depth)
+{
+	int major = 0;
+	uint64_t val = 0;
+	uint64_t i;
+
+	if (depth > 16 || !ci_head(in, &major, &val)) {
+		return false;
+	}
+	switch (major) {
+	case 2:
+	case 3:
+		if (val > (uint64_t)(in->end - in->p)) {
+			return false;
+		}
+		in->p += val;
+		return true;
+	case 4:
+	case 5:
+		for (i = 0; i < (major == 5 ? val * 2 : val); i++) {
+			if (!ci_skip(in, depth + 1)) {
+				return false;
+			}
+		}
+		return true;
+	case 6:
+		return ci_skip(in, depth + 1);
+	default:
+		return true;
+	}
+}
+
+/* View of the next item, which is skipped */
+static bool ci_item(cbor_in_t *in, const uint8_t **data, size_t *len)
+{
+	const uint8_t *start = in->p;
+
+	if (!ci_skip(in, 0)) {
+		return false;
+	}
+	*data = start;
+	*len = (size_t)(in->p - start);
+	return true;
+}
+
+/* ======================= Crypto ======================= */
+
+static bool hash(const uint8_t *data, size_t len, const uint8_t *data2,
+		 size_t len2, uint8_t *out)
+{
+	EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+	bool ret = false;
+
+	if (ctx && EVP_DigestInit_ex(ctx, STANDIN_MD(), NULL) &&
+	    EVP_DigestUpdate(ctx, data, len) &&
+	    (!len2 || EVP_DigestUpdate(ctx, data2, len2)) &&
+	    EVP_DigestFinal_ex(ctx, out, NULL)) {
+		ret = true;
+	}
+	EVP_MD_CTX_free(ctx);
+	return ret;
+}
+
+/* Hash = [hashtype, hash] */
+static void write_hash(cbor_out_t *out, const uint8_t *digest)
+{
+	co_array(out, 2);
+	co_int(out, FDO_CRYPTO_HASH_TYPE_USED);
+	co_bstr(out, digest, STANDIN_HASH_SZ);
+}
+
+/* PublicKey = [pkType, pkEnc, pkBody], of the server key */
+static void write_public_key(standin_t *s, cbor_out_t *out)
+{
+	co_array(out, 3);
+	co_int(out, FDO_PK_ALGO);
+	co_int(out, FDO_CRYPTO_PUB_KEY_ENCODING_X509);
+	co_bstr(out, s->key_der, (size_t)s->key_der_len);
+}
+
+/* SigInfo = [sgType, Info] */
+static void write_siginfo(cbor_out_t *out)
+{
+	co_array(out, 2);
+	co_int(out, FDO_SIG_TYPE);
+	co_bstr(out, NULL, 0);
+}
+
+/*
+ * COSE_Sign1 signed by the server key, with an empty unprotected header, or
+ * the given one.
+ */
+static bool write_sign1(standin_t *s, cbor_out_t *out, const cbor_out_t *uph,
+			const cbor_out_t *payload)
+{
+	cbor_out_t ph = {0};
+	cbor_out_t sig_structure = {0};
+	uint8_t digest[STANDIN_HASH_SZ];
+	uint8_t sig[2 * STANDIN_COORD_SZ];
+	ECDSA_SIG *ecdsa = NULL;
+	const BIGNUM *r = NULL;
+	const BIGNUM *sig_s = NULL;
+	bool ret = false;
+
+	co_map(&ph, 1);
+	co_int(&ph, FDO_COSE_ALG_KEY);
+	co_int(&ph, FDO_SIG_TYPE);
+
+	co_array(&sig_structure, 4);
+	co_tstr(&sig_structure, "Signature1");
+	co_bstr(&sig_structure, ph.buf, ph.len);
+	co_bstr(&sig_structure, NULL, 0);
+	co_bstr(&sig_structure, payload->buf, payload->len);
+	if (ph.failed || sig_structure.failed || payload->failed ||
+	    !hash(sig_structure.buf, sig_structure.len, NULL, 0, digest)) {
+		goto end;
+	}
+	ecdsa = ECDSA_do_sign(digest, sizeof(digest), s->key);
+	if (!ecdsa) {
+		goto end;
+	}
+	ECDSA_SIG_get0(ecdsa, &r, &sig_s);
+	if (BN_bn2binpad(r, sig, STANDIN_COORD_SZ) != STANDIN_COORD_SZ ||
+	    BN_bn2binpad(sig_s, sig + STANDIN_COORD_SZ, STANDIN_COORD_SZ) !=
+		STANDIN_COORD_SZ) {
+		goto end;
+	}
+
+	co_tag(out, FDO_COSE_TAG_SIGN1);
+	co_array(out, 4);
+	co_bstr(out, ph.buf, ph.len);
+	if (uph) {
+		co_put(out, uph->buf, uph->len);
+	} else {
+		co_map(out, 0);
+	}
+	co_bstr(out, payload->buf, payload->len);
+	co_bstr(out, sig, sizeof(sig));
+	ret = !out->failed;
+end:
+	ECDSA_SIG_free(ecdsa);
+	co_free(&ph);
+	co_free(&sig_structure);
+	return ret;
+}
+
+/* Enc_structure of COSE_Encrypt0, the AAD of AES-GCM */
+static void write_enc_structure(cbor_out_t *out, const uint8_t *ph, size_t ph_len)
+{
+	co_array(out, 3);
+	co_tstr(out, "Encrypt0");
+	co_bstr(out, ph, ph_len);
+	co_bstr(out, NULL, 0);
+}
+
+/* EncryptedMessage = COSE_Encrypt0 of the plaintext, with the session key */
+static bool encrypt_msg(const standin_session_t *ss, const cbor_out_t *plain,
+			cbor_out_t *out)
+{
+	EVP_CIPHER_CTX *ctx = NULL;
+	cbor_out_t ph = {0};
+	cbor_out_t aad = {0};
+	uint8_t iv[STANDIN_GCM_IV_SZ];
+	uint8_t *cipher = NULL;
+	int len = 0;
+	int final_len = 0;
+	bool ret = false;
+
+	co_map(&ph, 1);
+	co_int(&ph, FDO_COSE_ENCRYPT0_AESPLAINTYPE_KEY);
+	co_int(&ph, COSE_ENC_TYPE);
+	write_enc_structure(&aad, ph.buf, ph.len);
+	cipher = malloc(plain->len + STANDIN_GCM_TAG_SZ);
+	ctx = EVP_CIPHER_CTX_new();
+	if (!ss->have_sek || ph.failed || aad.failed || plain->failed || !cipher ||
+	    !ctx || RAND_bytes(iv, sizeof(iv)) != 1) {
+		goto end;
+	}
+	if (!EVP_EncryptInit_ex(ctx, STANDIN_GCM(), NULL, NULL, NULL) ||
+	    !EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, sizeof(iv), NULL) ||
+	    !EVP_EncryptInit_ex(ctx, NULL, NULL, ss->sek, iv) ||
+	    !EVP_EncryptUpdate(ctx, NULL, &len, aad.buf, (int)aad.len) ||
+	    !EVP_EncryptUpdate(ctx, cipher, &len, plain->buf, (int)plain->len) ||
+	    !EVP_EncryptFinal_ex(ctx, cipher + len, &final_len) ||
+	    !EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, STANDIN_GCM_TAG_SZ,
+				 cipher + len + final_len)) {
+		goto end;
+	}
+
+	co_tag(out, FDO_COSE_TAG_ENCRYPT0);
+	co_array(out, 3);
+	co_bstr(out, ph.buf, ph.len);
+	co_map(out, 1);
+	co_int(out, FDO_COSE_ENCRYPT0_AESIV_KEY);
+	co_bstr(out, iv, sizeof(iv));
+	co_bstr(out, cipher, (size_t)(len + final_len) + STANDIN_GCM_TAG_SZ);
+	ret = !out->failed;
+end:
+	EVP_CIPHER_CTX_free(ctx);
+	free(cipher);
+	co_free(&ph);
+	co_free(&aad);
+	return ret;
+}
+
+/*
+ * Decrypt an EncryptedMessage of the device into 'plain', which the caller
+ * frees.
+ */
+static bool decrypt_msg(const standin_session_t *ss, const uint8_t *body,
+			size_t body_len, cbor_out_t *plain)
+{
+	cbor_in_t in = {body, body + body_len};
+	EVP_CIPHER_CTX *ctx = NULL;
+	cbor_out_t aad = {0};
+	const uint8_t *ph = NULL;
+	const uint8_t *iv = NULL;
+	const uint8_t *payload = NULL;
+	uint8_t tag[STANDIN_GCM_TAG_SZ];
+	size_t ph_len = 0;
+	size_t iv_len = 0;
+	size_t payload_len = 0;
+	size_t items = 0;
+	uint64_t val = 0;
+	int64_t key = 0;
+	int len = 0;
+	bool ret = false;
+
+	if (!ss->have_sek || !ci_expect(&in, 6, &val) || val != FDO_COSE_TAG_ENCRYPT0 ||
+	    !ci_array(&in, &items) || items != 3 || !ci_bstr(&in, &ph, &ph_len) ||
+	    !ci_map(&in, &items)) {
+		return false;
+	}
+	while (items--) {
+		if (!ci_int(&in, &key)) {
+			return false;
+		}
+		if (key == FDO_COSE_ENCRYPT0_AESIV_KEY) {
+			if (!ci_bstr(&in, &iv, &iv_len)) {
+				return false;
+			}
+		} else if (!ci_skip(&in, 0)) {
+			return false;
+		}
+	}
+	if (!iv || iv_len != STANDIN_GCM_IV_SZ || !ci_bstr(&in, &payload, &payload_len) ||
+	    payload_len < STANDIN_GCM_TAG_SZ) {
+		return false;
+	}
+	payload_len -= STANDIN_GCM_TAG_SZ;
+	memcpy(tag, payload + payload_len, sizeof(tag));
+
+	write_enc_structure(&aad, ph, ph_len);
+	plain->len = 0;
+	ctx = EVP_CIPHER_CTX_new();
+	if (aad.failed || !co_reserve(plain, payload_len + 1) || !ctx) {
+		goto end;
+	}
+	if (!EVP_DecryptInit_ex(ctx, STANDIN_GCM(), NULL, NULL, NULL) ||
+	    !EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN, (int)iv_len, NULL) ||
+	    !EVP_DecryptInit_ex(ctx, NULL, NULL, ss->sek, iv) ||
+	    !EVP_DecryptUpdate(ctx, NULL, &len, aad.buf, (int)aad.len) ||
+	    !EVP_DecryptUpdate(ctx, plain->buf, &len, payload, (int)payload_len) ||
+	    !EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, sizeof(tag), tag) ||
+	    EVP_DecryptFinal_ex(ctx, plain->buf + len, &len) <= 0) {
+		goto end;
+	}
+	plain->len = payload_len;
+	ret = true;
+end:
+	EVP_CIPHER_CTX_free(ctx);
+	co_free(&aad);
+	return ret;
+}
+
+/*
+ * xA = [len][Ax][len][Ay][len][OwnerRandom], of an ephemeral key of the
+ * session, as parsed by the SDK.
+ */
+static bool write_kex_paramA(standin_session_t *ss, cbor_out_t *out)
+{
+	uint8_t xA[3 * 2 + 2 * STANDIN_COORD_SZ + STANDIN_KEX_RANDOM_SZ];
+	uint8_t coord[STANDIN_COORD_SZ];
+	BIGNUM *x = BN_new();
+	BIGNUM *y = BN_new();
+	size_t len = 0;
+	bool ret = false;
+	int i;
+
+	EC_KEY_free(ss->kex);
+	ss->kex = EC_KEY_new_by_curve_name(STANDIN_CURVE);
+	if (!x || !y || !ss->kex || !EC_KEY_generate_key(ss->kex) ||
+	    !EC_POINT_get_affine_coordinates(EC_KEY_get0_group(ss->kex),
+					     EC_KEY_get0_public_key(ss->kex), x, y,
+					     NULL) ||
+	    RAND_bytes(ss->owner_random, sizeof(ss->owner_random)) != 1) {
+		goto end;
+	}
+	/* the device strips the leading zeros of the random through a BIGNUM */
+	ss->owner_random[0] |= 0x80;
+
+	for (i = 0; i < 2; i++) {
+		int coord_len = BN_bn2bin(i ? y : x, coord);
+
+		xA[len++] = (uint8_t)(coord_len >> 8);
+		xA[len++] = (uint8_t)coord_len;
+		memcpy(xA + len, coord, (size_t)coord_len);
+		len += (size_t)coord_len;
+	}
+	xA[len++] = 0;
+	xA[len++] = sizeof(ss->owner_random);
+	memcpy(xA + len, ss->owner_random, sizeof(ss->owner_random));
+	len += sizeof(ss->owner_random);
+	co_bstr(out, xA, len);
+	ret = true;
+end:
+	BN_free(x);
+	BN_free(y);
+	return ret;
+}
+
+/*
+ * Derive the session key from xB = [len][Bx][len][By][len][DeviceRandom]:
+ * SEK = HMAC-SHA256(Shx||DeviceRandom||OwnerRandom, KDFInput), as the SDK does.
+ */
+static bool derive_sek(standin_session_t *ss, const uint8_t *xB, size_t xB_len)
+{
+	static const char kdf_label[] = "FIDO-KDF";
+	static const char context[] = "AutomaticOnboardTunnel";
+	const uint8_t *field[3] = {NULL};
+	size_t field_len[3] = {0};
+	uint8_t kdf_input[1 + sizeof(kdf_label) + sizeof(context) - 1 + 2];
+	uint8_t shse[STANDIN_COORD_SZ + 2 * STANDIN_KEX_RANDOM_SZ + 16];
+	uint8_t okm[EVP_MAX_MD_SIZE];
+	unsigned int okm_len = 0;
+	const EC_GROUP *group = NULL;
+	EC_POINT *point = NULL;
+	BIGNUM *x = BN_new();
+	BIGNUM *y = BN_new();
+	size_t ofs = 0;
+	size_t len = 0;
+	bool ret = false;
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		if (xB_len - ofs < 2) {
+			goto end;
+		}
+		field_len[i] = (size_t)xB[ofs] << 8 | xB[ofs + 1];
+		ofs += 2;
+		if (xB_len - ofs < field_len[i]) {
+			goto end;
+		}
+		field[i] = xB + ofs;
+		ofs += field_len[i];
+	}
+	if (!ss->kex || !x || !y || field_len[0] > STANDIN_COORD_SZ ||
+	    field_len[2] > sizeof(shse) - STANDIN_COORD_SZ - STANDIN_KEX_RANDOM_SZ) {
+		goto end;
+	}
+
+	group = EC_KEY_get0_group(ss->kex);
+	point = EC_POINT_new(group);
+	if (!point || !BN_bin2bn(field[0], (int)field_len[0], x) ||
+	    !BN_bin2bn(field[1], (int)field_len[1], y) ||
+	    !EC_POINT_set_affine_coordinates(group, point, x, y, NULL) ||
+	    !EC_POINT_mul(group, point, NULL, point,
+			  EC_KEY_get0_private_key(ss->kex), NULL) ||
+	    !EC_POINT_get_affine_coordinates(group, point, x, NULL, NULL)) {
+		goto end;
+	}
+	len = (size_t)BN_bn2bin(x, shse);
+	memcpy(shse + len, field[2], field_len[2]);
+	len += field_len[2];
+	memcpy(shse + len, ss->owner_random, sizeof(ss->owner_random));
+	len += sizeof(ss->owner_random);
+
+	ofs = 0;
+	kdf_input[ofs++] = 1;
+	memcpy(kdf_input + ofs, kdf_label, sizeof(kdf_label) - 1);
+	ofs += sizeof(kdf_label) - 1;
+	kdf_input[ofs++] = 0;
+	memcpy(kdf_input + ofs, context, sizeof(context) - 1);
+	ofs += sizeof(context) - 1;
+	kdf_input[ofs++] = (uint8_t)((SEK_KEY_SIZE * 8) >> 8);
+	kdf_input[ofs++] = (uint8_t)(SEK_KEY_SIZE * 8);
+	/* one round of HMAC-SHA256 covers SEK_KEY_SIZE */
+	if (!HMAC(EVP_sha256(), shse, (int)len, kdf_input, ofs, okm, &okm_len) ||
+	    okm_len < SEK_KEY_SIZE) {
+		goto end;
+	}
+	memcpy(ss->sek, okm, SEK_KEY_SIZE);
+	ss->have_sek = true;
+	ret = true;
+end:
+	OPENSSL_cleanse(shse, sizeof(shse));
+	OPENSSL_cleanse(okm, sizeof(okm));
+	EC_POINT_free(point);
+	BN_free(x);
+	BN_free(y);
+	return ret;
+}
+
+/* ======================= Protocol ======================= */
+
+int standin_phase(int type)
+{
+	if (type >= FDO_DI_APP_START && type <= FDO_DI_DONE) {
+		return STANDIN_DI;
+	} else if (type >= FDO_TO1_TYPE_HELLO_FDO && type <= FDO_TO1_TYPE_FDO_REDIRECT) {
+		return STANDIN_TO1;
+	} else if (type >= FDO_TO2_HELLO_DEVICE && type <= FDO_TO2_DONE2) {
+		return STANDIN_TO2;
+	}
+	return -1;
+}
+
+static standin_device_t *find_device(standin_t *s, const uint8_t *guid, size_t len)
+{
+	size_t i;
+
+	if (len != FDO_GUID_BYTES) {
+		return NULL;
+	}
+	for (i = 0; i < s->num_devices; i++) {
+		if (s->devices[i].registered &&
+		    memcmp(s->devices[i].guid, guid, FDO_GUID_BYTES) == 0) {
+			return &s->devices[i];
+		}
+	}
+	return NULL;
+}
+
+/*
+ * RendezvousInfo = [[RVIP, RVDevPort, RVProtocol]], pointing TO1 at this
+ * server over HTTP.
+ */
+static void write_rendezvous_info(standin_t *s, cbor_out_t *out)
+{
+	static const uint8_t localhost[4] = {127, 0, 0, 1};
+	cbor_out_t value = {0};
+
+	co_array(out, 1);
+	co_array(out, 3);
+
+	co_array(out, 2);
+	co_int(out, RVIPADDRESS);
+	co_bstr(&value, localhost, sizeof(localhost));
+	co_bstr(out, value.buf, value.len);
+
+	value.len = 0;
+	co_array(out, 2);
+	co_int(out, RVDEVPORT);
+	co_uint(&value, s->port);
+	co_bstr(out, value.buf, value.len);
+
+	value.len = 0;
+	co_array(out, 2);
+	co_int(out, RVPROTOCOL);
+	co_uint(&value, RVPROTHTTP);
+	co_bstr(out, value.buf, value.len);
+
+	out->failed |= value.failed;
+	co_free(&value);
+}
+
+/* DI.AppStart -> DI.SetCredentials: OVHeader of a new device */
+static bool on_msg10(standin_t *s, standin_session_t *ss, const uint8_t *body,
+		  size_t len, cbor_out_t *out)
+{
+	standin_device_t *devices = NULL;
+	standin_device_t *dev = NULL;
+	uint8_t digest[STANDIN_HASH_SZ];
+
+	devices = realloc(s->devices, (s->num_devices + 1) * sizeof(*devices));
+	if (!devices) {
+		return false;
+	}
+	s->devices = devices;
+	dev = &devices[s->num_devices];
+	memset(dev, 0, sizeof(*dev));
+	if (RAND_bytes(dev->guid, sizeof(dev->guid)) != 1 ||
+	    !hash(body, len, NULL, 0, digest)) {
+		return false;
+	}
+	ss->device = s->num_devices++;
+
+	/* there is no device certificate chain, DeviceMfgInfo stands in for it */
+	co_array(&dev->ovheader, 6);
+	co_int(&dev->ovheader, FDO_PROT_SPEC_VERSION);
+	co_bstr(&dev->ovheader, dev->guid, sizeof(dev->guid));
+	write_rendezvous_info(s, &dev->ovheader);
+	co_tstr(&dev->ovheader, STANDIN_DEVICE_INFO);
+	write_public_key(s, &dev->ovheader);
+	write_hash(&dev->ovheader, digest);
+	if (dev->ovheader.failed) {
+		return false;
+	}
+
+	co_array(out, 1);
+	co_bstr(out, dev->ovheader.buf, dev->ovheader.len);
+	return true;
+}
+
+/* DI.SetHMAC -> DI.Done */
+static bool on_msg12(standin_t *s, standin_session_t *ss, const uint8_t *body,
+		  size_t len, cbor_out_t *out)
+{
+	cbor_in_t in = {body, body + len};
+	standin_device_t *dev = NULL;
+	const uint8_t *hmac = NULL;
+	size_t hmac_len = 0;
+	size_t items = 0;
+
+	if (ss->device >= s->num_devices || !ci_array(&in, &items) || items != 1 ||
+	    !ci_item(&in, &hmac, &hmac_len)) {
+		return false;
+	}
+	dev = &s->devices[ss->device];
+	dev->hmac.len = 0;
+	co_put(&dev->hmac, hmac, hmac_len);
+	dev->registered = !dev->hmac.failed;
+
+	co_array(out, 0);
+	return dev->registered;
+}
+
+/* TO1.HelloRV -> TO1.HelloRVAck */
+static bool on_msg30(standin_t *s, standin_session_t *ss, const uint8_t *body,
+		  size_t len, cbor_out_t *out)
+{
+	cbor_in_t in = {body, body + len};
+	standin_device_t *dev = NULL;
+	const uint8_t *guid = NULL;
+	size_t guid_len = 0;
+	size_t items = 0;
+
+	if (!ci_array(&in, &items) || items != 2 || !ci_bstr(&in, &guid, &guid_len)) {
+		return false;
+	}
+	dev = find_device(s, guid, guid_len);
+	if (!dev || RAND_bytes(ss->nonce_to1proof, FDO_NONCE_BYTES) != 1) {
+		return false;
+	}
+	ss->device = (size_t)(dev - s->devices);
+
+	co_array(out, 2);
+	co_bstr(out, ss->nonce_to1proof, FDO_NONCE_BYTES);
+	write_siginfo(out);
+	return true;
+}
+
+/*
+ * TO1.ProveToRV -> TO1.RVRedirect: to1d, a COSE_Sign1 over
+ * [[[RVIP, RVDNS, Port, Protocol]], to0dHash]. The EAT isn't verified.
+ */
+static bool on_msg32(standin_t *s, standin_session_t *ss, const uint8_t *body,
+		  size_t len, cbor_out_t *out)
+{
+	static const uint8_t localhost[4] = {127, 0, 0, 1};
+	standin_device_t *dev = NULL;
+	cbor_out_t payload = {0};
+	uint8_t digest[STANDIN_HASH_SZ];
+	bool ret = false;
+
+	(void)body;
+	(void)len;
+	if (ss->device >= s->num_devices) {
+		return false;
+	}
+	dev = &s->devices[ss->device];
+	if (!hash(dev->ovheader.buf, dev->ovheader.len, NULL, 0, digest)) {
+		return false;
+	}
+
+	co_array(&payload, 2);
+	co_array(&payload, 1);
+	co_array(&payload, 4);
+	co_bstr(&payload, localhost, sizeof(localhost));
+	co_simple(&payload, 0xf6);
+	co_uint(&payload, s->port);
+	co_uint(&payload, PROTHTTP);
+	write_hash(&payload, digest);
+	ret = write_sign1(s, out, NULL, &payload);
+	co_free(&payload);
+	return ret;
+}
+
+/*
+ * OVEntries of a device, all signed by and naming the server key:
+ * COSE_Sign1 over [OVEHashPrevEntry, OVEHashHdrInfo, OVEExtra, OVEPubKey].
+ */
+static bool build_entries(standin_t *s, standin_device_t *dev)
+{
+	cbor_out_t hdrinfo = {0};
+	cbor_out_t payload = {0};
+	uint8_t prev[STANDIN_HASH_SZ];
+	uint8_t hdr[STANDIN_HASH_SZ];
+	unsigned int n = s->config->ov_entries;
+	unsigned int i;
+	bool ret = false;
+
+	dev->entries = calloc(n, sizeof(*dev->entries));
+	co_put(&hdrinfo, dev->guid, sizeof(dev->guid));
+	co_put(&hdrinfo, STANDIN_DEVICE_INFO, strlen(STANDIN_DEVICE_INFO));
+	if (!dev->entries || hdrinfo.failed ||
+	    !hash(hdrinfo.buf, hdrinfo.len, NULL, 0, hdr) ||
+	    !hash(dev->ovheader.buf, dev->ovheader.len, dev->hmac.buf, dev->hmac.len,
+		  prev)) {
+		goto end;
+	}
+	for (i = 0; i < n; i++) {
+		payload.len = 0;
+		co_array(&payload, 4);
+		write_hash(&payload, prev);
+		write_hash(&payload, hdr);
+		co_simple(&payload, 0xf6);
+		write_public_key(s, &payload);
+		if (!write_sign1(s, &dev->entries[i], NULL, &payload) ||
+		    !hash(dev->entries[i].buf, dev->entries[i].len, NULL, 0, prev)) {
+			goto end;
+		}
+	}
+	ret = true;
+end:
+	if (!ret && dev->entries) {
+		for (i = 0; i < n; i++) {
+			co_free(&dev->entries[i]);
+		}
+		free(dev->entries);
+		dev->entries = NULL;
+	}
+	co_free(&hdrinfo);
+	co_free(&payload);
+	return ret;
+}
+
+/* TO2.HelloDevice -> TO2.ProveOVHdr */
+static bool on_msg60(standin_t *s, standin_session_t *ss, const uint8_t *body,
+		  size_t len, cbor_out_t *out)
+{
+	cbor_in_t in = {body, body + len};
+	standin_device_t *dev = NULL;
+	cbor_out_t uph = {0};
+	cbor_out_t payload = {0};
+	const uint8_t *guid = NULL;
+	const uint8_t *nonce = NULL;
+	size_t guid_len = 0;
+	size_t nonce_len = 0;
+	size_t items = 0;
+	uint64_t max_size = 0;
+	bool ret = false;
+
+	if (!ci_array(&in, &items) || items != 6 || !ci_uint(&in, &max_size) ||
+	    !ci_bstr(&in, &guid, &guid_len) || !ci_bstr(&in, &nonce, &nonce_len) ||
+	    nonce_len != FDO_NONCE_BYTES) {
+		return false;
+	}
+	dev = find_device(s, guid, guid_len);
+	if (!dev || (!dev->entries && !build_entries(s, dev)) ||
+	    !hash(body, len, NULL, 0, ss->hello_hash) ||
+	    RAND_bytes(ss->nonce_prove_dv, FDO_NONCE_BYTES) != 1) {
+		return false;
+	}
+	ss->device = (size_t)(dev - s->devices);
+	memcpy(ss->nonce_prove_ov, nonce, FDO_NONCE_BYTES);
+
+	co_map(&uph, 2);
+	co_int(&uph, FDO_COSE_SIGN1_CUPHNONCE_KEY);
+	co_bstr(&uph, ss->nonce_prove_dv, FDO_NONCE_BYTES);
+	co_int(&uph, FDO_COSE_SIGN1_CUPHOWNERPUBKEY_KEY);
+	write_public_key(s, &uph);
+
+	co_array(&payload, 8);
+	co_bstr(&payload, dev->ovheader.buf, dev->ovheader.len);
+	co_uint(&payload, s->config->ov_entries);
+	co_put(&payload, dev->hmac.buf, dev->hmac.len);
+	co_bstr(&payload, ss->nonce_prove_ov, FDO_NONCE_BYTES);
+	write_siginfo(&payload);
+	if (!write_kex_paramA(ss, &payload)) {
+		goto end;
+	}
+	write_hash(&payload, ss->hello_hash);
+	co_uint(&payload, 0);
+	ret = write_sign1(s, out, &uph, &payload);
+end:
+	co_free(&uph);
+	co_free(&payload);
+	return ret;
+}
+
+/* TO2.GetOVNextEntry -> TO2.OVNextEntry */
+static bool on_msg62(standin_t *s, standin_session_t *ss, const uint8_t *body,
+		  size_t len, cbor_out_t *out)
+{
+	cbor_in_t in = {body, body + len};
+	standin_device_t *dev = NULL;
+	size_t items = 0;
+	uint64_t entry = 0;
+
+	if (ss->device >= s->num_devices || !ci_array(&in, &items) || items != 1 ||
+	    !ci_uint(&in, &entry)) {
+		return false;
+	}
+	dev = &s->devices[ss->device];
+	if (!dev->entries || entry >= s->config->ov_entries) {
+		return false;
+	}
+
+	co_array(out, 2);
+	co_uint(out, entry);
+	co_put(out, dev->entries[entry].buf, dev->entries[entry].len);
+	return true;
+}
+
+/*
+ * TO2.ProveDevice -> TO2.SetupDevice. The EAT signature isn't verified, only
+ * NonceTO2SetupDv and xB are taken from it.
+ */
+static bool on_msg64(standin_t *s, standin_session_t *ss, const uint8_t *body,
+		  size_t len, cbor_out_t *out)
+{
+	cbor_in_t in = {body, body + len};
+	cbor_in_t eat = {NULL, NULL};
+	cbor_out_t payload = {0};
+	cbor_out_t plain = {0};
+	const uint8_t *ph = NULL;
+	const uint8_t *nonce = NULL;
+	const uint8_t *eat_payload = NULL;
+	const uint8_t *xB = NULL;
+	uint8_t guid[FDO_GUID_BYTES];
+	size_t ph_len = 0;
+	size_t nonce_len = 0;
+	size_t eat_payload_len = 0;
+	size_t xB_len = 0;
+	size_t items = 0;
+	uint64_t tag = 0;
+	int64_t key = 0;
+	bool ret = false;
+
+	if (!ci_expect(&in, 6, &tag) || tag != FDO_COSE_TAG_SIGN1 ||
+	    !ci_array(&in, &items) || items != 4 || !ci_bstr(&in, &ph, &ph_len) ||
+	    !ci_map(&in, &items)) {
+		return false;
+	}
+	while (items--) {
+		if (!ci_int(&in, &key)) {
+			return false;
+		}
+		if (key == FDO_EAT_EUPHNONCE_KEY) {
+			if (!ci_bstr(&in, &nonce, &nonce_len)) {
+				return false;
+			}
+		} else if (!ci_skip(&in, 0)) {
+			return false;
+		}
+	}
+	if (!nonce || nonce_len != FDO_NONCE_BYTES ||
+	    !ci_bstr(&in, &eat_payload, &eat_payload_len)) {
+		return false;
+	}
+	memcpy(ss->nonce_setup_dv, nonce, FDO_NONCE_BYTES);
+
+	eat.p = eat_payload;
+	eat.end = eat_payload + eat_payload_len;
+	if (!ci_map(&eat, &items)) {
+		return false;
+	}
+	while (items--) {
+		if (!ci_int(&eat, &key)) {
+			return false;
+		}
+		if (key == FDO_EATFDO) {
+			size_t payloads = 0;
+
+			if (!ci_array(&eat, &payloads) || payloads != 1 ||
+			    !ci_bstr(&eat, &xB, &xB_len)) {
+				return false;
+			}
+		} else if (!ci_skip(&eat, 0)) {
+			return false;
+		}
+	}
+	if (!xB || !derive_sek(ss, xB, xB_len) || RAND_bytes(guid, sizeof(guid)) != 1) {
+		return false;
+	}
+
+	/* a new GUID, for the device to take the resale path */
+	co_array(&payload, 4);
+	write_rendezvous_info(s, &payload);
+	co_bstr(&payload, guid, sizeof(guid));
+	co_bstr(&payload, ss->nonce_setup_dv, FDO_NONCE_BYTES);
+	write_public_key(s, &payload);
+	ret = write_sign1(s, &plain, NULL, &payload) && encrypt_msg(ss, &plain, out);
+	co_free(&payload);
+	co_free(&plain);
+	return ret;
+}
+
+/* TO2.DeviceServiceInfoReady -> TO2.OwnerServiceInfoReady */
+static bool on_msg66(standin_t *s, standin_session_t *ss, const uint8_t *body,
+		  size_t len, cbor_out_t *out)
+{
+	cbor_out_t plain = {0};
+	cbor_out_t reply = {0};
+	cbor_in_t in = {NULL, NULL};
+	size_t items = 0;
+	uint64_t max_si = 0;
+	bool ret = false;
+
+	(void)s;
+	if (!decrypt_msg(ss, body, len, &plain)) {
+		goto end;
+	}
+	in.p = plain.buf;
+	in.end = plain.buf + plain.len;
+	/* the replacement HMac is dropped, the voucher isn't extended */
+	if (!ci_array(&in, &items) || items != 2 || !ci_skip(&in, 0) ||
+	    !ci_uint(&in, &max_si)) {
+		goto end;
+	}
+	ss->max_owner_si = max_si ? (size_t)max_si : MIN_SERVICEINFO_SZ;
+	ss->si_sent = 0;
+	ss->si_started = false;
+
+	/* maxDeviceServiceInfoSz: the default */
+	co_array(&reply, 1);
+	co_simple(&reply, 0xf6);
+	ret = encrypt_msg(ss, &reply, out);
+end:
+	co_free(&plain);
+	co_free(&reply);
+	return ret;
+}
+
+static void write_si_kv(cbor_out_t *out, const char *key, const cbor_out_t *val)
+{
+	co_array(out, 2);
+	co_tstr(out, key);
+	co_bstr(out, val->buf, val->len);
+}
+
+/*
+ * TO2.DeviceServiceInfo -> TO2.OwnerServiceInfo. The Owner ServiceInfo writes
+ * a file of si_bytes to the device with fdo_sys, in as few messages as
+ * maxOwnerServiceInfoSz allows.
+ */
+static bool on_msg68(standin_t *s, standin_session_t *ss, const uint8_t *body,
+		  size_t len, cbor_out_t *out)
+{
+	cbor_out_t plain = {0};
+	cbor_out_t reply = {0};
+	cbor_out_t kvs = {0};
+	cbor_out_t val = {0};
+	cbor_in_t in = {NULL, NULL};
+	size_t si_bytes = s->config->si_bytes;
+	size_t num_kvs = 0;
+	size_t items = 0;
+	bool device_more = false;
+	bool ret = false;
+
+	if (!decrypt_msg(ss, body, len, &plain)) {
+		goto end;
+	}
+	in.p = plain.buf;
+	in.end = plain.buf + plain.len;
+	if (!ci_array(&in, &items) || items != 2 || !ci_bool(&in, &device_more)) {
+		goto end;
+	}
+
+	if (!device_more && si_bytes && !ss->si_started) {
+		val.len = 0;
+		co_simple(&val, 0xf5);
+		write_si_kv(&kvs, "fdo_sys:active", &val);
+		val.len = 0;
+		co_tstr(&val, STANDIN_SI_FILE);
+		write_si_kv(&kvs, "fdo_sys:filedesc", &val);
+		num_kvs = 2;
+		ss->si_started = true;
+	}
+	while (!device_more && ss->si_sent < si_bytes) {
+		/* room left, below maxOwnerServiceInfoSz */
+		size_t room = ss->max_owner_si > kvs.len + STANDIN_SI_KV_OVERHEAD ?
+			      ss->max_owner_si - kvs.len - STANDIN_SI_KV_OVERHEAD : 0;
+		size_t chunk = si_bytes - ss->si_sent;
+		size_t i;
+
+		if (chunk > room) {
+			chunk = room;
+		}
+		if (chunk > STANDIN_SI_CHUNK) {
+			chunk = STANDIN_SI_CHUNK;
+		}
+		if (!chunk) {
+			break;
+		}
+		val.len = 0;
+		co_head(&val, 2, chunk);
+		for (i = 0; i < chunk; i++) {
+			uint8_t byte = (uint8_t)(ss->si_sent + i);
+
+			co_put(&val, &byte, 1);
+		}
+		write_si_kv(&kvs, "fdo_sys:write", &val);
+		num_kvs++;
+		ss->si_sent += chunk;
+	}
+
+	/* [IsMoreServiceInfo, IsDone, ServiceInfo] */
+	co_array(&reply, 3);
+	co_simple(&reply, !device_more && ss->si_sent < si_bytes ? 0xf5 : 0xf4);
+	co_simple(&reply, !device_more && ss->si_sent >= si_bytes ? 0xf5 : 0xf4);
+	co_array(&reply, num_kvs);
+	co_put(&reply, kvs.buf, kvs.len);
+	ret = !kvs.failed && !val.failed && encrypt_msg(ss, &reply, out);
+end:
+	co_free(&plain);
+	co_free(&reply);
+	co_free(&kvs);
+	co_free(&val);
+	return ret;
+}
+
+/* TO2.Done -> TO2.Done2 */
+static bool on_msg70(standin_t *s, standin_session_t *ss, const uint8_t *body,
+		  size_t len, cbor_out_t *out)
+{
+	cbor_out_t plain = {0};
+	cbor_out_t reply = {0};
+	cbor_in_t in = {NULL, NULL};
+	const uint8_t *nonce = NULL;
+	size_t nonce_len = 0;
+	size_t items = 0;
+	bool ret = false;
+
+	(void)s;
+	if (!decrypt_msg(ss, body, len, &plain)) {
+		goto end;
+	}
+	in.p = plain.buf;
+	in.end = plain.buf + plain.len;
+	if (!ci_array(&in, &items) || items != 1 || !ci_bstr(&in, &nonce, &nonce_len) ||
+	    nonce_len != FDO_NONCE_BYTES ||
+	    memcmp(nonce, ss->nonce_prove_dv, FDO_NONCE_BYTES) != 0) {
+		goto end;
+	}
+
+	co_array(&reply, 1);
+	co_bstr(&reply, ss->nonce_setup_dv, FDO_NONCE_BYTES);
+	ret = encrypt_msg(ss, &reply, out);
+end:
+	co_free(&plain);
+	co_free(&reply);
+	return ret;
+}
+
+/*
+ * Session of a request, from its Authorization header. The first message of
+ * a protocol starts a new session, keeping the token the device may have
+ * cached from a previous attempt.
+ */
+static standin_session_t *get_session(standin_t *s, int type, uint32_t token)
+{
+	standin_session_t *ss = NULL;
+
+	if (type == FDO_DI_APP_START || type == FDO_TO1_TYPE_HELLO_FDO ||
+	    type == FDO_TO2_HELLO_DEVICE) {
+		if (!token) {
+			token = ++s->next_token;
+			if (!token) {
+				token = ++s->next_token;
+			}
+		}
+		ss = &s->sessions[token % STANDIN_MAX_SESSIONS];
+		EC_KEY_free(ss->kex);
+		OPENSSL_cleanse(ss, sizeof(*ss));
+		ss->token = token;
+		ss->device = SIZE_MAX;
+		return ss;
+	}
+	ss = &s->sessions[token % STANDIN_MAX_SESSIONS];
+	return token && ss->token == token ? ss : NULL;
+}
+
+/*
+ * Build the response to a request.
+ * @return true with the response body in 'out', false if an error is to be
+ * returned
+ */
+static bool handle(standin_t *s, standin_session_t *ss, int type, const uint8_t *body,
+		   size_t len, cbor_out_t *out)
+{
+	bool ret = false;
+
+	switch (type) {
+	case FDO_DI_APP_START:
+		ret = on_msg10(s, ss, body, len, out);
+		break;
+	case FDO_DI_SET_HMAC:
+		ret = on_msg12(s, ss, body, len, out);
+		break;
+	case FDO_TO1_TYPE_HELLO_FDO:
+		ret = on_msg30(s, ss, body, len, out);
+		break;
+	case FDO_TO1_TYPE_PROVE_TO_FDO:
+		ret = on_msg32(s, ss, body, len, out);
+		break;
+	case FDO_TO2_HELLO_DEVICE:
+		ret = on_msg60(s, ss, body, len, out);
+		break;
+	case FDO_TO2_GET_OP_NEXT_ENTRY:
+		ret = on_msg62(s, ss, body, len, out);
+		break;
+	case FDO_TO2_PROVE_DEVICE:
+		ret = on_msg64(s, ss, body, len, out);
+		break;
+	case FDO_TO2_NEXT_DEVICE_SERVICE_INFO:
+		ret = on_msg66(s, ss, body, len, out);
+		break;
+	case FDO_TO2_GET_NEXT_OWNER_SERVICE_INFO:
+		ret = on_msg68(s, ss, body, len, out);
+		break;
+	case FDO_TO2_DONE:
+		ret = on_msg70(s, ss, body, len, out);
+		break;
+	default:
+		break;
+	}
+	return ret && !out->failed;
+}
+
+/* ======================= HTTP ======================= */
+
+/**
+ * Wait until fd is readable, for at most STANDIN_IO_TIMEOUT_MS.
+ * @return true if ready, false on timeout or error
+ */
+static bool wait_readable(int fd)
+{
+	struct pollfd pfd = {fd, POLLIN, 0};
+	int ret;
+
+	do {
+		ret = poll(&pfd, 1, STANDIN_IO_TIMEOUT_MS);
+	} while (ret < 0 && errno == EINTR);
+	return ret > 0;
+}
+
+static bool send_all(int fd, const char *buf, size_t len)
+{
+	while (len > 0) {
+		ssize_t sent = send(fd, buf, len, MSG_NOSIGNAL);
+
+		if (sent < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		buf += sent;
+		len -= (size_t)sent;
+	}
+	return true;
+}
+
+static bool http_reserve(http_msg_t *msg, size_t cap)
+{
+	char *buf = NULL;
+
+	if (cap <= msg->cap) {
+		return true;
+	}
+	buf = realloc(msg->buf, cap);
+	if (!buf) {
+		return false;
+	}
+	msg->buf = buf;
+	msg->cap = cap;
+	return true;
+}
+
+/* Value of a header of the request, NULL if it isn't present */
+static const char *http_header(const http_msg_t *msg, const char *name)
+{
+	const char *line = msg->buf;
+	const char *end = msg->buf + msg->header_len;
+	size_t name_len = strlen(name);
+
+	while (line < end) {
+		const char *eol = memchr(line, '\n', (size_t)(end - line));
+
+		if (!eol) {
+			break;
+		}
+		if ((size_t)(eol - line) > name_len &&
+		    strncasecmp(line, name, name_len) == 0 && line[name_len] == ':') {
+			line += name_len + 1;
+			while (*line == ' ') {
+				line++;
+			}
+			return line;
+		}
+		line = eol + 1;
+	}
+	return NULL;
+}
+
+/**
+ * Read one request from fd.
+ * @return true if a complete request was read
+ */
+static bool http_read(int fd, http_msg_t *msg)
+{
+	const char *header_end = NULL;
+	const char *value = NULL;
+
+	if (!http_reserve(msg, 4096)) {
+		return false;
+	}
+	for (;;) {
+		ssize_t got;
+
+		if (msg->header_len && msg->len >= msg->header_len + msg->content_length) {
+			return true;
+		}
+		if (msg->len == msg->cap) {
+			if (msg->header_len || !http_reserve(msg, msg->cap * 2) ||
+			    msg->cap > STANDIN_MAX_HEADER_SZ) {
+				return false;
+			}
+		}
+		if (!wait_readable(fd)) {
+			return false;
+		}
+		got = recv(fd, msg->buf + msg->len, msg->cap - msg->len, 0);
+		if (got < 0) {
+			if (errno == EINTR || errno == EAGAIN) {
+				continue;
+			}
+			return false;
+		}
+		if (got == 0) {
+			return false;
+		}
+		msg->len += (size_t)got;
+
+		if (!msg->header_len) {
+			header_end = memmem(msg->buf, msg->len, "\r\n\r\n", 4);
+			if (header_end) {
+				msg->header_len = (size_t)(header_end - msg->buf) + 4;
+				value = http_header(msg, "Content-Length");
+				msg->content_length = value ? strtoul(value, NULL, 10) : 0;
+				if (msg->content_length > STANDIN_MAX_BODY_SZ ||
+				    !http_reserve(msg, msg->header_len +
+							   msg->content_length + 1)) {
+					return false;
+				}
+			}
+		}
+	}
+}
+
+/*
+ * Message type of a request line of the form
+ * 'POST /fdo/101/msg/<type> HTTP/1.1', -1 if it isn't an FDO message.
+ */
+static int http_msg_type(const http_msg_t *msg)
+{
+	const char *eol = memchr(msg->buf, '\n', msg->header_len);
+	const char *path = NULL;
+	char *end = NULL;
+	long type;
+
+	if (!eol) {
+		return -1;
+	}
+	path = memmem(msg->buf, (size_t)(eol - msg->buf), "/msg/", 5);
+	if (!path) {
+		return -1;
+	}
+	type = strtol(path + 5, &end, 10);
+	if (end == path + 5 || type < 0 || type >= STANDIN_MSG_TYPES) {
+		return -1;
+	}
+	return (int)type;
+}
+
+/* Token of the Authorization header, "Bearer <token>", 0 if there is none */
+static uint32_t http_token(const http_msg_t *msg)
+{
+	const char *value = http_header(msg, "Authorization");
+
+	if (!value) {
+		return 0;
+	}
+	if (strncasecmp(value, "Bearer ", 7) == 0) {
+		value += 7;
+	}
+	return (uint32_t)strtoul(value, NULL, 10);
+}
+
+static bool http_response(int type, uint32_t token, const cbor_out_t *body,
+			  standin_pending_t *reply)
+{
+	char header[256];
+	int header_len;
+
+	if (body) {
+		header_len = snprintf(header, sizeof(header),
+				      "HTTP/1.1 200 OK\r\n"
+				      "Content-Type: application/cbor\r\n"
+				      "Content-Length: %zu\r\n"
+				      "Message-Type: %d\r\n"
+				      "Authorization: Bearer %u\r\n\r\n",
+				      body->len, type, token);
+	} else {
+		header_len = snprintf(header, sizeof(header),
+				      "HTTP/1.1 500 Internal Server Error\r\n"
+				      "Content-Length: 0\r\n\r\n");
+	}
+	if (header_len < 0 || (size_t)header_len >= sizeof(header)) {
+		return false;
+	}
+	reply->len = (size_t)header_len + (body ? body->len : 0);
+	reply->buf = malloc(reply->len);
+	if (!reply->buf) {
+		return false;
+	}
+	memcpy(reply->buf, header, (size_t)header_len);
+	if (body && body->len) {
+		memcpy(reply->buf + header_len, body->buf, body->len);
+	}
+	return true;
+}
+
+/* ======================= Server ======================= */
+
+static void finish(standin_pending_t *p)
+{
+	if (p->buf) {
+		send_all(p->fd, p->buf, p->len);
+	}
+	close(p->fd);
+	free(p->buf);
+	p->buf = NULL;
+	p->fd = -1;
+}
+
+/*
+ * Serve the request of a new connection. The response is sent right away,
+ * or queued until its latency has elapsed, or forever if it is dropped.
+ */
+static void serve(standin_t *s, int fd)
+{
+	const standin_config_t *config = s->config;
+	http_msg_t request = {0};
+	cbor_out_t body = {0};
+	standin_pending_t reply = {fd, 0, NULL, 0};
+	standin_session_t *ss = NULL;
+	standin_msg_stats_t *stats = NULL;
+	uint64_t start = now_us();
+	uint32_t token = 0;
+	bool ok = false;
+	int type = -1;
+
+	if (!http_read(fd, &request) || (type = http_msg_type(&request)) < 0) {
+		close(fd);
+		goto end;
+	}
+	stats = &s->stats->msg[type];
+	stats->requests++;
+	stats->bytes_in += request.len;
+
+	if (type == STANDIN_MSG_ERROR) {
+		/* the device reports an error, and doesn't wait for an answer */
+		fprintf(stderr, "fdo_standin: error message from the device: %.*s\n",
+			(int)(request.len - request.header_len),
+			request.buf + request.header_len);
+		__atomic_store_n(&s->stats->last_type, type, __ATOMIC_RELEASE);
+		close(fd);
+		goto end;
+	}
+
+	token = http_token(&request);
+	ss = get_session(s, type, token);
+	if (ss) {
+		ok = handle(s, ss, type, (const uint8_t *)request.buf + request.header_len,
+			    request.content_length, &body);
+	}
+	if (!ok) {
+		fprintf(stderr, "fdo_standin: failed to serve message %d\n", type);
+		stats->failed++;
+	}
+	if (!http_response(type + 1, ss ? ss->token : 0, ok ? &body : NULL, &reply)) {
+		close(fd);
+		goto end;
+	}
+	stats->server_us += now_us() - start;
+
+	if (config->loss_pct && (unsigned int)rand_r(&s->seed) % 100 < config->loss_pct) {
+		stats->dropped++;
+		free(reply.buf);
+		reply.buf = NULL;
+		reply.due_us = UINT64_MAX;
+	} else {
+		stats->bytes_out += reply.len;
+		reply.due_us = start + (uint64_t)config->latency_ms * 1000;
+	}
+	__atomic_store_n(&s->stats->last_type, type, __ATOMIC_RELEASE);
+
+	if (reply.buf && !config->latency_ms) {
+		finish(&reply);
+	} else if (s->num_pending < STANDIN_MAX_PENDING) {
+		s->pending[s->num_pending++] = reply;
+	} else {
+		/* too many held connections: answer or drop this one now */
+		finish(&reply);
+	}
+end:
+	free(request.buf);
+	co_free(&body);
+}
+
+/**
+ * Listen on 127.0.0.1:port, or on a free port if port is 0.
+ * @return the listening socket, -1 on error
+ */
+int standin_listen(uint16_t port, uint16_t *bound_port)
+{
+	struct sockaddr_in addr;
+	socklen_t addr_len = sizeof(addr);
+	int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	int one = 1;
+
+	if (fd < 0) {
+		return -1;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+	    bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+	    listen(fd, 64) != 0 ||
+	    getsockname(fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+		close(fd);
+		return -1;
+	}
+	if (bound_port) {
+		*bound_port = ntohs(addr.sin_port);
+	}
+	return fd;
+}
+
+/**
+ * Serve the devices connecting to listen_fd, until *stop is set.
+ * @return 0 once stopped, -1 on error
+ */
+int standin_serve(int listen_fd, const standin_config_t *config,
+		  standin_stats_t *stats, volatile sig_atomic_t *stop)
+{
+	struct pollfd fds[1 + STANDIN_MAX_PENDING];
+	struct sockaddr_in addr;
+	socklen_t addr_len = sizeof(addr);
+	standin_t *s = calloc(1, sizeof(*s));
+	unsigned char *der = NULL;
+	int ret = -1;
+	size_t i;
+
+	if (!s) {
+		return -1;
+	}
+	s->config = config;
+	s->stats = stats;
+	s->seed = config->seed;
+	stats->last_type = -1;
+	if (getsockname(listen_fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+		goto end;
+	}
+	s->port = ntohs(addr.sin_port);
+	if (!config->ov_entries || config->ov_entries > MAX_NO_OVENTRIES) {
+		fprintf(stderr, "fdo_standin: 1 to %d voucher entries are supported\n",
+			MAX_NO_OVENTRIES);
+		goto end;
+	}
+
+	s->key = EC_KEY_new_by_curve_name(STANDIN_CURVE);
+	if (!s->key || !EC_KEY_generate_key(s->key)) {
+		goto end;
+	}
+	s->key_der_len = i2d_EC_PUBKEY(s->key, NULL);
+	if (s->key_der_len <= 0) {
+		goto end;
+	}
+	s->key_der = malloc((size_t)s->key_der_len);
+	der = s->key_der;
+	if (!s->key_der || i2d_EC_PUBKEY(s->key, &der) != s->key_der_len) {
+		goto end;
+	}
+
+	while (!*stop) {
+		uint64_t now = now_us();
+		uint64_t next = now + STANDIN_STOP_POLL_MS * 1000;
+		size_t n = 0;
+		int ready;
+
+		/* send the responses that are due, and wait for the next one */
+		for (i = 0; i < s->num_pending;) {
+			standin_pending_t *p = &s->pending[i];
+
+			if (p->due_us <= now) {
+				finish(p);
+				s->pending[i] = s->pending[--s->num_pending];
+				continue;
+			}
+			if (p->due_us < next) {
+				next = p->due_us;
+			}
+			i++;
+		}
+
+		fds[n].fd = listen_fd;
+		fds[n++].events = POLLIN;
+		for (i = 0; i < s->num_pending; i++) {
+			/* a dropped request is held until the device closes it */
+			fds[n].fd = s->pending[i].fd;
+			fds[n++].events = s->pending[i].buf ? 0 : POLLIN;
+		}
+		ready = poll(fds, n, (int)((next - now + 999) / 1000));
+		if (ready < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			goto end;
+		}
+		for (i = n - 1; i > 0; i--) {
+			if (fds[i].revents) {
+				finish(&s->pending[i - 1]);
+				s->pending[i - 1] = s->pending[--s->num_pending];
+			}
+		}
+		if (fds[0].revents & POLLIN) {
+			int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+
+			if (fd >= 0) {
+				serve(s, fd);
+			}
+		}
+	}
+	ret = 0;
+end:
+	for (i = 0; i < s->num_pending; i++) {
+		finish(&s->pending[i]);
+	}
+	for (i = 0; i < STANDIN_MAX_SESSIONS; i++) {
+		EC_KEY_free(s->sessions[i].kex);
+	}
+	for (i = 0; i < s->num_devices; i++) {
+		co_free(&s->devices[i].ovheader);
+		co_free(&s->devices[i].hmac);
+		if (s->devices[i].entries) {
+			unsigned int j;
+
+			for (j = 0; j < config->ov_entries; j++) {
+				co_free(&s->devices[i].entries[j]);
+			}
+			free(s->devices[i].entries);
+		}
+	}
+	free(s->devices);
+	free(s->key_der);
+	EC_KEY_free(s->key);
+	OPENSSL_cleanse(s, sizeof(*s));
+	free(s);
+	return ret;
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2020 Intel Corporation
+ * SPDX-License-Identifier: Apache 2.0
+ */
+
+/*!
+ * \file
+ * \brief Loopback stand-in for the Manufacturer, Rendezvous and Owner servers.
+ */
+
+#ifndef __FDO_STANDIN_H__
+#define __FDO_STANDIN_H__
+
+#include <signal.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define STANDIN_MSG_TYPES 256
+
+/* Protocol phase of a message type */
+enum { STANDIN_DI, STANDIN_TO1, STANDIN_TO2, STANDIN_PHASES };
+
+typedef struct {
+	unsigned int ov_entries; /* OVEntries of every voucher */
+	size_t si_bytes;	 /* file written to the device with fdo_sys */
+	unsigned int latency_ms; /* added to every response */
+	unsigned int loss_pct;	 /* requests left unanswered */
+	unsigned int seed;
+} standin_config_t;
+
+typedef struct {
+	uint64_t requests;
+	uint64_t dropped;   /* left unanswered on purpose */
+	uint64_t failed;    /* answered with an HTTP error */
+	uint64_t bytes_in;  /* device -> server, headers included */
+	uint64_t bytes_out; /* server -> device, headers included */
+	uint64_t server_us; /* time spent building the responses */
+} standin_msg_stats_t;
+
+/*
+ * Counters of the server, updated once a request has been read and its
+ * response built, before the response is sent (or dropped). They can live in
+ * shared memory, to be read by other processes.
+ */
+typedef struct {
+	standin_msg_stats_t msg[STANDIN_MSG_TYPES];
+	int last_type; /* type of the last request, -1 before the first one */
+} standin_stats_t;
+
+int standin_phase(int type);
+int standin_listen(uint16_t port, uint16_t *bound_port);
+int standin_serve(int listen_fd, const standin_config_t *config,
+		  standin_stats_t *stats, volatile sig_atomic_t *stop);
+
+#endif /* __FDO_STANDIN_H__ */